@@ -86,6 +86,7 @@ man_pages = [
     ('man1/flux-jobs', 'flux-jobs', 'list jobs submitted to Flux', [author], 1),
     ('man1/flux-keygen', 'flux-keygen', 'generate keys for Flux security', [author], 1),
     ('man1/flux-kvs', 'flux-kvs', 'Flux key-value store utility', [author], 1),
+    ('man1/flux-latency', 'flux-latency', 'display service latency histograms', [author], 1),
     ('man1/flux-logger', 'flux-logger', 'create a Flux log entry', [author], 1),
     ('man1/flux-mini', 'flux-mini', 'Minimal Job Submission Tool', [author], 1),
     ('man1/flux-module', 'flux-module', 'manage Flux extension modules', [author], 1),
@@ -299,6 +300,13 @@ man_pages = [
     ('man3/idset_create', 'idset_next', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
     ('man3/idset_create', 'idset_count', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
     ('man3/idset_create', 'idset_equal', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_union', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_intersect', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_difference', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_add', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_subtract', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_retain', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
+    ('man3/idset_create', 'idset_has_intersection', 'Manipulate numerically sorted sets of non-negative integers', [author], 3),
     ('man3/idset_encode','idset_encode', 'Convert idset to string and string to idset', [author], 3),
     ('man3/idset_encode','idset_decode', 'Convert idset to string and string to idset', [author], 3),
     ('man3/idset_encode','idset_ndecode', 'Convert idset to string and string to idset', [author], 3),
@@ -60,7 +60,14 @@ class JobListRPC(RPC):
 #
 # pylint: disable=dangerous-default-value
 def job_list(
-    flux_handle, max_entries=1000, attrs=[], userid=os.getuid(), states=0, results=0
+    flux_handle,
+    max_entries=1000,
+    attrs=[],
+    userid=os.getuid(),
+    states=0,
+    results=0,
+    since=0.0,
+    after_id=None,
 ):
     payload = {
         "max_entries": int(max_entries),
@@ -69,6 +76,10 @@ def job_list(
         "states": states,
         "results": results,
     }
+    if since:
+        payload["since"] = float(since)
+    if after_id is not None:
+        payload["after_id"] = int(after_id)
     return JobListRPC(flux_handle, "job-info.list", payload)
 
 
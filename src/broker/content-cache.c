@@ -14,12 +14,17 @@
 #include "config.h"
 #endif
 #include <inttypes.h>
+#include <stdbool.h>
 #include <czmq.h>
+#include <jansson.h>
 #include <flux/core.h>
 #include "src/common/libutil/errno_safe.h"
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/blobvec.h"
 #include "src/common/libutil/iterators.h"
 #include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/histogram.h"
 
 #include "attr.h"
 #include "content-cache.h"
@@ -38,6 +43,7 @@ static const uint32_t default_cache_purge_large_entry = 256;
 static const uint32_t default_blob_size_limit = 1048576*1024;
 
 static const uint32_t default_flush_batch_limit = 256;
+static const uint32_t default_flush_batch_bytes = 1024*1024*16;
 
 struct cache_entry {
     flux_t *h;
@@ -49,9 +55,16 @@ struct cache_entry {
                                     /*   or to backing store (rank 0) */
     uint8_t load_pending:1;
     uint8_t store_pending:1;
+    uint8_t lru_large:1;            /* counted in cache->lru_large */
     zlist_t *load_requests;
     zlist_t *store_requests;
+    zlist_t *load_batches;
+    zlist_t *store_batches;
+    int batch_refs;                 /* references held by batch requests */
     int lastused;
+
+    struct cache_entry *lru_prev;   /* LRU list of valid, clean entries */
+    struct cache_entry *lru_next;   /*   (only these may be purged) */
 };
 
 struct content_cache {
@@ -63,10 +76,12 @@ struct content_cache {
     char *backing_name;
     char hash_name[BLOBREF_MAX_STRING_SIZE];
     zlist_t *flush_requests;
+    zlist_t *batches;               /* batch requests awaiting response */
     int epoch;
 
     uint32_t blob_size_limit;
     uint32_t flush_batch_limit;
+    uint32_t flush_batch_bytes;
     uint32_t flush_batch_count;
 
     uint32_t purge_target_entries;
@@ -77,11 +92,49 @@ struct content_cache {
     uint32_t acct_size;             /* total size of all cache entries */
     uint32_t acct_valid;            /* count of valid cache entries */
     uint32_t acct_dirty;            /* count of dirty cache entries */
+
+    struct cache_entry *lru_first;  /* most recently used */
+    struct cache_entry *lru_last;   /* least recently used */
+    int lru_large;                  /* entries on LRU list that were
+                                     *   large when last used */
+
+    struct {
+        int64_t load_hit;           /* load satisfied from cache */
+        int64_t load_miss;          /* load sent upstream/to backing store */
+        int64_t purge_scan;         /* entries examined by purge */
+        int64_t purge_drop;         /* entries dropped by purge */
+    } stats;
+    struct histogram *load_latency; /* usec, upstream/backing load RPC */
+    struct histogram *store_latency;/* usec, upstream/backing store RPC */
 };
 
 static void flush_respond (content_cache_t *cache);
 static int cache_flush (content_cache_t *cache);
 
+/* Track latency of load and store RPCs sent upstream or to the
+ * backing store, that is, the extra time spent by requests that miss.
+ * This is best effort: if the start time cannot be attached to 'f',
+ * the sample is simply not recorded.
+ */
+static void latency_start (flux_future_t *f)
+{
+    struct timespec *tp;
+
+    if (!(tp = malloc (sizeof (*tp))))
+        return;
+    monotime (tp);
+    if (flux_future_aux_set (f, "t_start", tp, free) < 0)
+        free (tp);
+}
+
+static void latency_record (struct histogram *hist, flux_future_t *f)
+{
+    struct timespec *tp;
+
+    if ((tp = flux_future_aux_get (f, "t_start")))
+        (void)histogram_add (hist, monotime_since (*tp) * 1000);
+}
+
 static void request_list_destroy (zlist_t **l)
 {
     const flux_msg_t *msg;
@@ -169,6 +222,8 @@ static void cache_entry_destroy (void *arg)
                       __FUNCTION__);
         request_list_destroy (&e->load_requests);
         request_list_destroy (&e->store_requests);
+        zlist_destroy (&e->load_batches);
+        zlist_destroy (&e->store_batches);
         free (e);
     }
 }
@@ -216,6 +271,52 @@ done:
     return rc;
 }
 
+/* Unlink entry from the LRU list, if it is on it.
+ */
+static void lru_remove (content_cache_t *cache, struct cache_entry *e)
+{
+    if (e->lru_prev)
+        e->lru_prev->lru_next = e->lru_next;
+    else if (cache->lru_first == e)
+        cache->lru_first = e->lru_next;
+    else
+        return; /* not on list */
+    if (e->lru_next)
+        e->lru_next->lru_prev = e->lru_prev;
+    else
+        cache->lru_last = e->lru_prev;
+    e->lru_prev = e->lru_next = NULL;
+    if (e->lru_large) {
+        cache->lru_large--;
+        e->lru_large = 0;
+    }
+}
+
+/* Mark entry as used in the current epoch.  Valid, clean entries are
+ * (re-)inserted at the front of the LRU list so that the list remains
+ * ordered by 'lastused', and cache_purge() can take victims from the tail.
+ * Invalid or dirty entries are kept off the list since they cannot be
+ * dropped, as are entries referenced by a pending batch request.
+ * Call this whenever the entry is accessed or its state changes.
+ */
+static void lru_update (content_cache_t *cache, struct cache_entry *e)
+{
+    lru_remove (cache, e);
+    e->lastused = cache->epoch;
+    if (e->valid && !e->dirty && e->batch_refs == 0) {
+        e->lru_next = cache->lru_first;
+        if (cache->lru_first)
+            cache->lru_first->lru_prev = e;
+        else
+            cache->lru_last = e;
+        cache->lru_first = e;
+        if (e->len >= cache->purge_large_entry) {
+            e->lru_large = 1;
+            cache->lru_large++;
+        }
+    }
+}
+
 /* Insert a cache entry, by blobref.
  * Returns 0 on success, -1 on failure with errno set.
  * Side effect: destroys entry on failure.
@@ -234,6 +335,7 @@ static int insert_entry (content_cache_t *cache, struct cache_entry *e)
     }
     if (e->dirty)
         cache->acct_dirty++;
+    lru_update (cache, e);
     return 0;
 }
 
@@ -253,15 +355,207 @@ static void remove_entry (content_cache_t *cache, struct cache_entry *e)
 {
     assert (!e->load_requests || zlist_size (e->load_requests) == 0);
     assert (!e->store_requests || zlist_size (e->store_requests) == 0);
+    assert (e->batch_refs == 0);
     if (e->valid) {
         cache->acct_size -= e->len;
         cache->acct_valid--;
     }
     if (e->dirty)
         cache->acct_dirty--;
+    lru_remove (cache, e);
     zhash_delete (cache->entries, e->blobref);
 }
 
+/* Batch requests
+ *
+ * A content.load-batch or content.store-batch request is answered with
+ * a single response, once every blob it refers to has been resolved.
+ * While a batch holds a reference to an entry, the entry is kept off the
+ * LRU list so it cannot be purged before the response is sent.
+ *
+ * A batch that must wait for an entry to be loaded (or stored upstream)
+ * is placed on the entry's load_batches (or store_batches) list, at most
+ * once per entry.  'pending' counts those waits, plus one reference held
+ * by the request handler while the batch is being set up.
+ */
+
+struct cache_batch {
+    content_cache_t *cache;
+    const flux_msg_t *msg;
+    bool store;                     /* store-batch (else load-batch) */
+    int count;
+    int pending;
+    struct cache_entry **entries;   /* entries[i] is NULL on error */
+    int *errnums;
+};
+
+/* Array of entries associated with an upstream batch RPC.
+ */
+struct entry_vec {
+    int count;
+    struct cache_entry *entries[];
+};
+
+static void cache_batch_destroy (struct cache_batch *b)
+{
+    if (b) {
+        int saved_errno = errno;
+        int i;
+        for (i = 0; i < b->count; i++) {
+            struct cache_entry *e = b->entries[i];
+            if (e && --e->batch_refs == 0)
+                lru_update (b->cache, e);
+        }
+        flux_msg_decref (b->msg);
+        free (b->entries);
+        free (b->errnums);
+        free (b);
+        errno = saved_errno;
+    }
+}
+
+static struct cache_batch *cache_batch_create (content_cache_t *cache,
+                                               const flux_msg_t *msg,
+                                               bool store,
+                                               int count)
+{
+    struct cache_batch *b;
+
+    if (!(b = calloc (1, sizeof (*b)))
+        || !(b->entries = calloc (count, sizeof (b->entries[0])))
+        || !(b->errnums = calloc (count, sizeof (b->errnums[0])))) {
+        cache_batch_destroy (b);
+        errno = ENOMEM;
+        return NULL;
+    }
+    b->cache = cache;
+    b->msg = flux_msg_incref (msg);
+    b->store = store;
+    b->count = count;
+    b->pending = 1;
+    if (zlist_append (cache->batches, b) < 0) {
+        cache_batch_destroy (b);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return b;
+}
+
+/* Set batch slot 'index' to entry 'e', taking a reference on it.
+ */
+static void cache_batch_set (struct cache_batch *b,
+                             int index,
+                             struct cache_entry *e)
+{
+    b->entries[index] = e;
+    if (e->batch_refs++ == 0)
+        lru_remove (b->cache, e);
+}
+
+/* Make batch wait on a list of batches attached to an entry.
+ * Returns 1 if batch was added, 0 if it was already waiting,
+ * or -1 on failure with errno set.
+ */
+static int cache_batch_wait (struct cache_batch *b, zlist_t **l)
+{
+    if (*l && zlist_tail (*l) == b)
+        return 0;
+    if ((!*l && !(*l = zlist_new ())) || zlist_append (*l, b) < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    b->pending++;
+    return 1;
+}
+
+static void cache_batch_respond (struct cache_batch *b)
+{
+    flux_t *h = b->cache->h;
+    const char *type = b->store ? "store-batch" : "load-batch";
+    blobvec_t *bv;
+    const void *buf;
+    int len;
+    int i;
+
+    if (!(bv = blobvec_create ()))
+        goto error;
+    for (i = 0; i < b->count; i++) {
+        struct cache_entry *e = b->entries[i];
+        int rc;
+
+        if (!e)
+            rc = blobvec_append_error (bv, b->errnums[i]);
+        else if (b->store)
+            rc = blobvec_append (bv, e->blobref, strlen (e->blobref) + 1);
+        else
+            rc = blobvec_append (bv, e->data, e->len);
+        if (rc < 0)
+            goto error;
+    }
+    if (blobvec_encode (bv, &buf, &len) < 0)
+        goto error;
+    if (flux_respond_raw (h, b->msg, buf, len) < 0)
+        flux_log_error (h, "content %s: flux_respond_raw", type);
+    blobvec_destroy (bv);
+    return;
+error:
+    if (flux_respond_error (h, b->msg, errno, NULL) < 0)
+        flux_log_error (h, "content %s: flux_respond_error", type);
+    blobvec_destroy (bv);
+}
+
+/* Drop a pending reference on batch.  Respond and destroy it
+ * once all its entries have been resolved.
+ */
+static void cache_batch_release (struct cache_batch *b)
+{
+    if (--b->pending == 0) {
+        cache_batch_respond (b);
+        zlist_remove (b->cache->batches, b);
+        cache_batch_destroy (b);
+    }
+}
+
+/* Resolve all batches waiting on entry 'e', then destroy the list.
+ * If 'errnum' is nonzero, each batch slot that refers to 'e' is failed.
+ */
+static void batch_list_resolve (zlist_t **l,
+                                struct cache_entry *e,
+                                int errnum)
+{
+    struct cache_batch *b;
+    int i;
+
+    if (*l) {
+        while ((b = zlist_pop (*l))) {
+            if (errnum) {
+                for (i = 0; i < b->count; i++) {
+                    if (b->entries[i] == e) {
+                        b->entries[i] = NULL;
+                        b->errnums[i] = errnum;
+                        e->batch_refs--;
+                    }
+                }
+            }
+            cache_batch_release (b);
+        }
+        zlist_destroy (l);
+    }
+}
+
+static struct entry_vec *entry_vec_create (struct cache_entry **ents, int n)
+{
+    struct entry_vec *ev;
+
+    if (!(ev = malloc (sizeof (*ev) + n * sizeof (ev->entries[0])))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    memcpy (ev->entries, ents, n * sizeof (ev->entries[0]));
+    ev->count = n;
+    return ev;
+}
+
 /* Load operation
  *
  * If a cache entry is already present and valid, response is immediate.
@@ -271,21 +565,22 @@ static void remove_entry (content_cache_t *cache, struct cache_entry *e)
  * Once the response is received, identical responses are sent to all
  * parked requests, and cache entry is made valid or removed if there was
  * an error such as ENOENT.
+ *
+ * A content.load-batch request is handled the same way, except that all
+ * the entries it faults in are requested from the next level of the TBON
+ * in a single content.load-batch request.  The rank 0 backing store is
+ * still asked for each entry individually.
  */
 
-static void cache_load_continuation (flux_future_t *f, void *arg)
+static void cache_load_complete (content_cache_t *cache,
+                                 struct cache_entry *e,
+                                 const void *data,
+                                 int len,
+                                 int errnum)
 {
-    content_cache_t *cache = arg;
-    struct cache_entry *e = flux_future_aux_get (f, "entry");
-    const void *data = NULL;
-    int len = 0;
-
     e->load_pending = 0;
-    if (flux_content_load_get (f, &data, &len) < 0) {
-        if (errno == ENOSYS && cache->rank == 0)
-            errno = ENOENT;
-        if (errno != ENOENT)
-            flux_log_error (cache->h, "content load");
+    if (errnum != 0 && !e->valid) { // entry may have been stored meanwhile
+        errno = errnum;
         goto error;
     }
     if (cache_entry_fill (e, data, len) < 0) {
@@ -297,13 +592,13 @@ static void cache_load_continuation (flux_future_t *f, void *arg)
         cache->acct_valid++;
         cache->acct_size += len;
     }
-    e->lastused = cache->epoch;
+    lru_update (cache, e);
     request_list_respond_raw (&e->load_requests,
                               cache->h,
                               e->data,
                               e->len,
                               "load");
-    flux_future_destroy (f);
+    batch_list_resolve (&e->load_batches, e, 0);
     return;
 error:
     request_list_respond_error (&e->load_requests,
@@ -311,7 +606,49 @@ error:
                                 errno,
                                 NULL,
                                 "load");
+    batch_list_resolve (&e->load_batches, e, errno);
     remove_entry (cache, e);
+}
+
+static void cache_load_continuation (flux_future_t *f, void *arg)
+{
+    content_cache_t *cache = arg;
+    struct cache_entry *e = flux_future_aux_get (f, "entry");
+    const void *data = NULL;
+    int len = 0;
+    int errnum = 0;
+
+    latency_record (cache->load_latency, f);
+    if (flux_content_load_get (f, &data, &len) < 0) {
+        if (errno == ENOSYS && cache->rank == 0)
+            errno = ENOENT;
+        if (errno != ENOENT)
+            flux_log_error (cache->h, "content load");
+        errnum = errno;
+    }
+    cache_load_complete (cache, e, data, len, errnum);
+    flux_future_destroy (f);
+}
+
+static void cache_load_batch_continuation (flux_future_t *f, void *arg)
+{
+    content_cache_t *cache = arg;
+    struct entry_vec *ev = flux_future_aux_get (f, "entries");
+    int i;
+
+    latency_record (cache->load_latency, f);
+    for (i = 0; i < ev->count; i++) {
+        const void *data = NULL;
+        int len = 0;
+        int errnum = 0;
+
+        if (flux_content_load_batch_get (f, i, &data, &len) < 0) {
+            if (errno != ENOENT)
+                flux_log_error (cache->h, "content load-batch");
+            errnum = errno;
+        }
+        cache_load_complete (cache, ev->entries[i], data, len, errnum);
+    }
     flux_future_destroy (f);
 }
 
@@ -335,9 +672,12 @@ static int cache_load (content_cache_t *cache, struct cache_entry *e)
         goto done;
     }
     if (flux_future_aux_set (f, "entry", e, NULL) < 0) {
+        saved_errno = errno;
         flux_log_error (cache->h, "content load flux_future_aux_set");
+        flux_future_destroy (f);
         goto done;
     }
+    latency_start (f);
     if (flux_future_then (f, -1., cache_load_continuation, cache) < 0) {
         saved_errno = errno;
         flux_log_error (cache->h, "content load");
@@ -352,6 +692,75 @@ done:
     return rc;
 }
 
+/* Request multiple entries from the upstream peer in one message.
+ */
+static int cache_load_batch (content_cache_t *cache,
+                             struct cache_entry **ents,
+                             int n)
+{
+    flux_future_t *f = NULL;
+    const char **refs;
+    struct entry_vec *ev = NULL;
+    int i;
+
+    assert (cache->rank > 0);
+
+    if (!(refs = calloc (n, sizeof (refs[0])))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    for (i = 0; i < n; i++)
+        refs[i] = ents[i]->blobref;
+    if (!(f = flux_content_load_batch (cache->h,
+                                       refs,
+                                       n,
+                                       CONTENT_FLAG_UPSTREAM))) {
+        flux_log_error (cache->h, "%s: RPC", __FUNCTION__);
+        goto error;
+    }
+    if (!(ev = entry_vec_create (ents, n))
+        || flux_future_aux_set (f, "entries", ev, free) < 0) {
+        flux_log_error (cache->h, "content load-batch flux_future_aux_set");
+        free (ev);
+        goto error;
+    }
+    latency_start (f);
+    if (flux_future_then (f, -1., cache_load_batch_continuation, cache) < 0) {
+        flux_log_error (cache->h, "content load-batch");
+        goto error;
+    }
+    for (i = 0; i < n; i++)
+        ents[i]->load_pending = 1;
+    free (refs);
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (free, refs);
+    flux_future_destroy (f);
+    return -1;
+}
+
+/* Start loading entries collected by a load-batch request.
+ * Entries that cannot be requested are completed with an error.
+ */
+static void cache_load_many (content_cache_t *cache,
+                             struct cache_entry **ents,
+                             int n)
+{
+    int i;
+
+    if (cache->rank == 0 || n == 1) {
+        for (i = 0; i < n; i++) {
+            if (cache_load (cache, ents[i]) < 0)
+                cache_load_complete (cache, ents[i], NULL, 0, errno);
+        }
+    }
+    else if (n > 1 && cache_load_batch (cache, ents, n) < 0) {
+        int errnum = errno;
+        for (i = 0; i < n; i++)
+            cache_load_complete (cache, ents[i], NULL, 0, errnum);
+    }
+}
+
 void content_load_request (flux_t *h, flux_msg_handler_t *mh,
                            const flux_msg_t *msg, void *arg)
 {
@@ -387,9 +796,11 @@ void content_load_request (flux_t *h, flux_msg_handler_t *mh,
             flux_log_error (h, "content load");
             goto error;
         }
+        cache->stats.load_miss++;
         return; /* RPC continuation will respond to msg */
     }
-    e->lastused = cache->epoch;
+    cache->stats.load_hit++;
+    lru_update (cache, e);
     data = e->data;
     len = e->len;
     if (flux_respond_raw (h, msg, data, len) < 0)
@@ -400,6 +811,85 @@ error:
         flux_log_error (h, "content load: flux_respond_error");
 }
 
+/* N.B. errors affecting a single blob are returned in that blob's slot
+ * of the response.  Only a malformed request fails the whole batch.
+ */
+static void content_load_batch_request (flux_t *h, flux_msg_handler_t *mh,
+                                        const flux_msg_t *msg, void *arg)
+{
+    content_cache_t *cache = arg;
+    const void *buf;
+    int len;
+    blobvec_t *req = NULL;
+    struct cache_batch *b = NULL;
+    struct cache_entry **load = NULL;
+    int nload = 0;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0)
+        goto error;
+    if (!(req = blobvec_decode (buf, len)))
+        goto error;
+    if (blobvec_count (req) == 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(load = calloc (blobvec_count (req), sizeof (load[0])))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (!(b = cache_batch_create (cache, msg, false, blobvec_count (req))))
+        goto error;
+    for (i = 0; i < b->count; i++) {
+        const char *blobref;
+        int blobref_size;
+        struct cache_entry *e;
+        int rc;
+
+        if (blobvec_get (req, i, (const void **)&blobref, &blobref_size) < 0
+            || !blobref
+            || blobref[blobref_size - 1] != '\0') {
+            b->errnums[i] = EPROTO;
+            continue;
+        }
+        if (!(e = lookup_entry (cache, blobref))) {
+            if (cache->rank == 0 && !cache->backing) {
+                b->errnums[i] = ENOENT;
+                continue;
+            }
+            if (!(e = cache_entry_create (h, blobref))
+                                            || insert_entry (cache, e) < 0) {
+                flux_log_error (h, "content load-batch");
+                b->errnums[i] = errno;
+                continue; /* insert destroys 'e' on failure */
+            }
+        }
+        if (!e->valid) {
+            if ((rc = cache_batch_wait (b, &e->load_batches)) < 0) {
+                flux_log_error (h, "content load-batch");
+                b->errnums[i] = errno;
+                continue;
+            }
+            if (rc == 1 && !e->load_pending)
+                load[nload++] = e;
+            cache->stats.load_miss++;
+        }
+        else
+            cache->stats.load_hit++;
+        cache_batch_set (b, i, e);
+    }
+    cache_load_many (cache, load, nload);
+    cache_batch_release (b);
+    blobvec_destroy (req);
+    free (load);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "content load-batch: flux_respond_error");
+    blobvec_destroy (req);
+    free (load);
+}
+
 /* Store operation
  *
  * If a cache entry is already valid and not dirty, response is immediate.
@@ -417,6 +907,10 @@ error:
  * while holding the invariant that after a store RPC returns, the entry may
  * be loaded from any rank.  The optional content.backing service can
  * offload rank 0 hash entries at a slower pace.
+ *
+ * A content.store-batch request is handled the same way, except that on
+ * ranks > 0, all the dirty entries it creates are written through to the
+ * next level of the TBON in a single content.store-batch request.
  */
 
 /* If cache has been flushed, respond to flush requests, if any.
@@ -435,46 +929,95 @@ static void cache_resume_flush (content_cache_t *cache)
         (void)cache_flush (cache); /* resume flushing */
 }
 
-static void cache_store_continuation (flux_future_t *f, void *arg)
+/* Fail all requests waiting for entry to be stored.
+ * The entry remains dirty.
+ */
+static void cache_store_fail (content_cache_t *cache,
+                              struct cache_entry *e,
+                              int errnum)
 {
-    content_cache_t *cache = arg;
-    struct cache_entry *e = flux_future_aux_get (f, "entry");
-    const char *blobref;
+    request_list_respond_error (&e->store_requests,
+                                cache->h,
+                                errnum,
+                                NULL,
+                                "store");
+    batch_list_resolve (&e->store_batches, e, errnum);
+}
 
+static void cache_store_complete (content_cache_t *cache,
+                                  struct cache_entry *e,
+                                  const char *blobref,
+                                  int errnum)
+{
     e->store_pending = 0;
     assert (cache->flush_batch_count > 0);
     cache->flush_batch_count--;
-    if (flux_content_store_get (f, &blobref) < 0) {
-        if (cache->rank == 0 && errno == ENOSYS)
-            flux_log (cache->h, LOG_DEBUG, "content store: %s",
-                      "backing store service unavailable");
-        else
-            flux_log_error (cache->h, "content store");
+    if (errnum != 0)
         goto error;
-    }
     if (strcmp (blobref, e->blobref)) {
         flux_log (cache->h, LOG_ERR, "content store: wrong blobref");
-        errno = EIO;
+        errnum = EIO;
         goto error;
     }
     if (e->dirty) {
         cache->acct_dirty--;
         e->dirty = 0;
+        lru_update (cache, e);
     }
     request_list_respond_raw (&e->store_requests,
                               cache->h,
                               e->blobref,
                               strlen (e->blobref) + 1,
                               "store");
-    flux_future_destroy (f);
-    cache_resume_flush (cache);
+    batch_list_resolve (&e->store_batches, e, 0);
     return;
 error:
-    request_list_respond_error (&e->store_requests,
-                                cache->h,
-                                errno,
-                                NULL,
-                                "store");
+    cache_store_fail (cache, e, errnum);
+}
+
+static void log_store_error (content_cache_t *cache, const char *type)
+{
+    if (cache->rank == 0 && errno == ENOSYS)
+        flux_log (cache->h, LOG_DEBUG, "content %s: %s",
+                  type, "backing store service unavailable");
+    else
+        flux_log_error (cache->h, "content %s", type);
+}
+
+static void cache_store_continuation (flux_future_t *f, void *arg)
+{
+    content_cache_t *cache = arg;
+    struct cache_entry *e = flux_future_aux_get (f, "entry");
+    const char *blobref = NULL;
+    int errnum = 0;
+
+    latency_record (cache->store_latency, f);
+    if (flux_content_store_get (f, &blobref) < 0) {
+        log_store_error (cache, "store");
+        errnum = errno;
+    }
+    cache_store_complete (cache, e, blobref, errnum);
+    flux_future_destroy (f);
+    cache_resume_flush (cache);
+}
+
+static void cache_store_batch_continuation (flux_future_t *f, void *arg)
+{
+    content_cache_t *cache = arg;
+    struct entry_vec *ev = flux_future_aux_get (f, "entries");
+    int i;
+
+    latency_record (cache->store_latency, f);
+    for (i = 0; i < ev->count; i++) {
+        const char *blobref = NULL;
+        int errnum = 0;
+
+        if (flux_content_store_batch_get (f, i, &blobref) < 0) {
+            log_store_error (cache, "store-batch");
+            errnum = errno;
+        }
+        cache_store_complete (cache, ev->entries[i], blobref, errnum);
+    }
     flux_future_destroy (f);
     cache_resume_flush (cache);
 }
@@ -501,9 +1044,12 @@ static int cache_store (content_cache_t *cache, struct cache_entry *e)
         goto done;
     }
     if (flux_future_aux_set (f, "entry", e, NULL) < 0) {
+        saved_errno = errno;
         flux_log_error (cache->h, "content store: flux_future_aux_set");
+        flux_future_destroy (f);
         goto done;
     }
+    latency_start (f);
     if (flux_future_then (f, -1., cache_store_continuation, cache) < 0) {
         saved_errno = errno;
         flux_log_error (cache->h, "content store");
@@ -519,71 +1065,202 @@ done:
     return rc;
 }
 
-static void content_store_request (flux_t *h, flux_msg_handler_t *mh,
-                                   const flux_msg_t *msg, void *arg)
+/* Write through multiple entries to the upstream peer in one message.
+ */
+static int cache_store_batch (content_cache_t *cache,
+                              struct cache_entry **ents,
+                              int n)
 {
-    content_cache_t *cache = arg;
-    const void *data;
-    int len;
-    struct cache_entry *e = NULL;
-    char blobref[BLOBREF_MAX_STRING_SIZE];
+    flux_future_t *f = NULL;
+    const void **bufs;
+    int *lens;
+    struct entry_vec *ev = NULL;
+    int i;
 
-    if (flux_request_decode_raw (msg, NULL, &data, &len) < 0)
+    assert (cache->rank > 0);
+
+    bufs = calloc (n, sizeof (bufs[0]));
+    lens = calloc (n, sizeof (lens[0]));
+    if (!bufs || !lens) {
+        errno = ENOMEM;
+        goto error;
+    }
+    for (i = 0; i < n; i++) {
+        assert (ents[i]->valid);
+        bufs[i] = ents[i]->data;
+        lens[i] = ents[i]->len;
+    }
+    if (!(f = flux_content_store_batch (cache->h,
+                                        bufs,
+                                        lens,
+                                        n,
+                                        CONTENT_FLAG_UPSTREAM))) {
+        flux_log_error (cache->h, "content store-batch");
+        goto error;
+    }
+    if (!(ev = entry_vec_create (ents, n))
+        || flux_future_aux_set (f, "entries", ev, free) < 0) {
+        flux_log_error (cache->h, "content store-batch: flux_future_aux_set");
+        free (ev);
+        goto error;
+    }
+    latency_start (f);
+    if (flux_future_then (f, -1., cache_store_batch_continuation, cache) < 0) {
+        flux_log_error (cache->h, "content store-batch");
         goto error;
+    }
+    for (i = 0; i < n; i++)
+        ents[i]->store_pending = 1;
+    cache->flush_batch_count += n;
+    free (bufs);
+    free (lens);
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (free, bufs);
+    ERRNO_SAFE_WRAP (free, lens);
+    flux_future_destroy (f);
+    return -1;
+}
+
+/* Store entries that are not already being stored.  On ranks > 0 more
+ * than one entry is sent upstream in a single content.store-batch request.
+ * On failure, requests waiting on the entries are failed, and -1 is
+ * returned with errno set.
+ */
+/* Return the number of leading entries of 'ents' that fit in one
+ * content.store-batch request of at most 'flush_batch_bytes' of blob
+ * data (at least one).
+ */
+static int cache_store_chunk (content_cache_t *cache,
+                              struct cache_entry **ents,
+                              int n)
+{
+    size_t bytes = ents[0]->len;
+    int count = 1;
+
+    while (count < n && bytes + ents[count]->len <= cache->flush_batch_bytes)
+        bytes += ents[count++]->len;
+    return count;
+}
+
+static int cache_store_many (content_cache_t *cache,
+                             struct cache_entry **ents,
+                             int n)
+{
+    int saved_errno = 0;
+    int rc = 0;
+    int i;
+
+    if (cache->rank == 0 || n == 1) {
+        for (i = 0; i < n; i++) {
+            if (cache_store (cache, ents[i]) < 0) {
+                saved_errno = errno;
+                cache_store_fail (cache, ents[i], errno);
+                rc = -1;
+            }
+        }
+    }
+    else {
+        while (n > 0) {
+            int count = cache_store_chunk (cache, ents, n);
+
+            if (count == 1) {
+                if (cache_store (cache, ents[0]) < 0) {
+                    saved_errno = errno;
+                    cache_store_fail (cache, ents[0], errno);
+                    rc = -1;
+                }
+            }
+            else if (cache_store_batch (cache, ents, count) < 0) {
+                saved_errno = errno;
+                for (i = 0; i < count; i++)
+                    cache_store_fail (cache, ents[i], saved_errno);
+                rc = -1;
+            }
+            ents += count;
+            n -= count;
+        }
+    }
+    if (rc < 0)
+        errno = saved_errno;
+    return rc;
+}
+
+/* Add blob to the cache, making its entry valid (responding to any queued
+ * load requests) and, if it was not valid before, dirty.
+ * Returns entry on success, NULL on failure with errno set.
+ */
+static struct cache_entry *cache_store_entry (content_cache_t *cache,
+                                              const void *data,
+                                              int len)
+{
+    char blobref[BLOBREF_MAX_STRING_SIZE];
+    struct cache_entry *e;
+
     if (len > cache->blob_size_limit) {
         errno = EFBIG;
-        goto error;
+        return NULL;
     }
     if (blobref_hash (cache->hash_name, (uint8_t *)data, len, blobref,
                       sizeof (blobref)) < 0)
-        goto error;
-
+        return NULL;
     if (!(e = lookup_entry (cache, blobref))) {
-        if (!(e = cache_entry_create (h, blobref)))
-            goto error;
+        if (!(e = cache_entry_create (cache->h, blobref)))
+            return NULL;
         if (insert_entry (cache, e) < 0)
-            goto error; /* insert destroys 'e' on failure */
+            return NULL; /* insert destroys 'e' on failure */
     }
     if (!e->valid) {
         if (cache_entry_fill (e, data, len) < 0)
-            goto error;
-        if (!e->valid) {
-            e->valid = 1;
-            cache->acct_valid++;
-            cache->acct_size += len;
+            return NULL;
+        e->valid = 1;
+        cache->acct_valid++;
+        cache->acct_size += len;
+        if (!e->dirty) {
+            e->dirty = 1;
+            cache->acct_dirty++;
         }
         request_list_respond_raw (&e->load_requests,
                                   cache->h,
                                   e->data,
                                   e->len,
                                   "load");
-        if (!e->dirty) {
-            e->dirty = 1;
-            cache->acct_dirty++;
-        }
+        batch_list_resolve (&e->load_batches, e, 0);
     }
-    e->lastused = cache->epoch;
-    if (e->dirty) {
-        if (cache->rank > 0 || cache->backing) {
-            if (cache_store (cache, e) < 0)
+    /* When a backing store module is unloaded, it will clear
+     * cache->backing then attempt to store all its blobs.  Any of
+     * those still in cache need to be marked dirty.
+     */
+    else if (!e->dirty && cache->rank == 0 && !cache->backing) {
+        e->dirty = 1;
+        cache->acct_dirty++;
+    }
+    lru_update (cache, e);
+    return e;
+}
+
+static void content_store_request (flux_t *h, flux_msg_handler_t *mh,
+                                   const flux_msg_t *msg, void *arg)
+{
+    content_cache_t *cache = arg;
+    const void *data;
+    int len;
+    struct cache_entry *e;
+
+    if (flux_request_decode_raw (msg, NULL, &data, &len) < 0)
+        goto error;
+    if (!(e = cache_store_entry (cache, data, len)))
+        goto error;
+    if (e->dirty && (cache->rank > 0 || cache->backing)) {
+        if (cache_store (cache, e) < 0)
+            goto error;
+        if (cache->rank > 0) {  /* write-through */
+            if (request_list_add (&e->store_requests, msg) < 0)
                 goto error;
-            if (cache->rank > 0) {  /* write-through */
-                if (request_list_add (&e->store_requests, msg) < 0)
-                    goto error;
-                return;
-            }
-        }
-    } else {
-        /* When a backing store module is unloaded, it will clear
-         * cache->backing then attempt to store all its blobs.  Any of
-         * those still in cache need to be marked dirty.
-         */
-        if (cache->rank == 0 && !cache->backing) {
-            e->dirty = 1;
-            cache->acct_dirty++;
+            return;
         }
     }
-    if (flux_respond_raw (h, msg, blobref, strlen (blobref) + 1) < 0)
+    if (flux_respond_raw (h, msg, e->blobref, strlen (e->blobref) + 1) < 0)
         flux_log_error (h, "content store: flux_respond_raw");
     return;
 error:
@@ -591,16 +1268,93 @@ error:
         flux_log_error (h, "content store: flux_respond_error");
 }
 
+/* N.B. errors affecting a single blob are returned in that blob's slot
+ * of the response.  Only a malformed request fails the whole batch.
+ */
+static void content_store_batch_request (flux_t *h, flux_msg_handler_t *mh,
+                                         const flux_msg_t *msg, void *arg)
+{
+    content_cache_t *cache = arg;
+    const void *buf;
+    int len;
+    blobvec_t *req = NULL;
+    struct cache_batch *b = NULL;
+    struct cache_entry **store = NULL;
+    int nstore = 0;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &len) < 0)
+        goto error;
+    if (!(req = blobvec_decode (buf, len)))
+        goto error;
+    if (blobvec_count (req) == 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(store = calloc (blobvec_count (req), sizeof (store[0])))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (!(b = cache_batch_create (cache, msg, true, blobvec_count (req))))
+        goto error;
+    for (i = 0; i < b->count; i++) {
+        const void *data;
+        int size;
+        struct cache_entry *e;
+        int rc;
+
+        if (blobvec_get (req, i, &data, &size) < 0) {
+            b->errnums[i] = EPROTO;
+            continue;
+        }
+        if (!(e = cache_store_entry (cache, data, size))) {
+            b->errnums[i] = errno;
+            continue;
+        }
+        if (e->dirty && cache->rank > 0) { /* write-through */
+            if ((rc = cache_batch_wait (b, &e->store_batches)) < 0) {
+                flux_log_error (h, "content store-batch");
+                b->errnums[i] = errno;
+                continue;
+            }
+            if (rc == 1 && !e->store_pending)
+                store[nstore++] = e;
+        }
+        else if (e->dirty && cache->backing) { /* write-back */
+            if (cache_store (cache, e) < 0) {
+                b->errnums[i] = errno;
+                continue;
+            }
+        }
+        cache_batch_set (b, i, e);
+    }
+    (void)cache_store_many (cache, store, nstore);
+    cache_batch_release (b);
+    blobvec_destroy (req);
+    free (store);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "content store-batch: flux_respond_error");
+    blobvec_destroy (req);
+    free (store);
+}
+
 /* Backing store is enabled/disabled by modules that provide the
  * 'content.backing' service.  At module load time, the backing module
  * informs the content service of its availability, and entries are
  * asynchronously duplicated on the backing store and made eligible for
  * dropping from the rank 0 cache.
+ *
+ * On ranks > 0, flush sends dirty entries upstream in content.store-batch
+ * requests of up to 'flush_batch_limit' entries, closing a request early
+ * once it holds 'flush_batch_bytes' of blob data.
  */
 
 static int cache_flush (content_cache_t *cache)
 {
     struct cache_entry *e;
+    struct cache_entry **batch = NULL;
     const char *key;
     int saved_errno = 0;
     int count = 0;
@@ -611,19 +1365,36 @@ static int cache_flush (content_cache_t *cache)
         return 0;
 
     flux_log (cache->h, LOG_DEBUG, "content flush begin");
+    if (cache->rank > 0) {
+        int n = cache->flush_batch_limit - cache->flush_batch_count;
+        if (!(batch = calloc (n, sizeof (batch[0])))) {
+            errno = ENOMEM;
+            return -1;
+        }
+    }
     FOREACH_ZHASH (cache->entries, key, e) {
         if (!e->dirty || e->store_pending)
             continue;
-        if (cache_store (cache, e) < 0) {
+        if (batch)
+            batch[count] = e;
+        else if (cache_store (cache, e) < 0) {
             saved_errno = errno;
             rc = -1;
         }
         count++;
-        if (cache->flush_batch_count >= cache->flush_batch_limit)
+        if (cache->flush_batch_count + (batch ? count : 0)
+                                            >= cache->flush_batch_limit)
             break;
     }
+    if (batch && count > 0) {
+        if (cache_store_many (cache, batch, count) < 0) {
+            saved_errno = errno;
+            rc = -1;
+        }
+    }
     flux_log (cache->h, LOG_DEBUG, "content flush +%d (dirty=%d pending=%d)",
               count, cache->acct_dirty, cache->flush_batch_count);
+    free (batch);
     if (rc < 0)
         errno = saved_errno;
     return rc;
@@ -703,44 +1474,32 @@ error:
 }
 
 /* Forcibly drop all entries from the cache that can be dropped
- * without data loss.
- * N.B. this walks the entire cache in one go.
+ * without data loss.  Those are exactly the entries on the LRU list.
  */
 
 static void content_dropcache_request (flux_t *h, flux_msg_handler_t *mh,
                                        const flux_msg_t *msg, void *arg)
 {
     content_cache_t *cache = arg;
-    zlist_t *keys = NULL;
-    char *key;
     struct cache_entry *e;
     int orig_size;
 
     if (flux_request_decode (msg, NULL, NULL) < 0)
         goto error;
     orig_size = zhash_size (cache->entries);
-    if (!(keys = zhash_keys (cache->entries))) {
-        errno = ENOMEM;
-        goto error;
-    }
-    while ((key = zlist_pop (keys))) {
-        e = zhash_lookup (cache->entries, key);
-        assert (e != NULL);
-        if (e->valid && !e->dirty)
-            remove_entry (cache, e);
-        free (key);
+    while ((e = cache->lru_last)) {
+        assert (e->valid && !e->dirty);
+        remove_entry (cache, e);
     }
     flux_log (h, LOG_DEBUG, "content dropcache %d/%d",
               orig_size - (int)zhash_size (cache->entries), orig_size);
     if (flux_respond (h, msg, NULL) < 0)
         flux_log_error (h, "content dropcache");
-    zlist_destroy (&keys);
     return;
 error:
     flux_log (h, LOG_DEBUG, "content dropcache: %s", flux_strerror (errno));
     if (flux_respond_error (h, msg, errno, NULL) < 0)
         flux_log_error (h, "content dropcache");
-    zlist_destroy (&keys);
 }
 
 /* Return stats about the cache.
@@ -750,19 +1509,36 @@ static void content_stats_request (flux_t *h, flux_msg_handler_t *mh,
                                    const flux_msg_t *msg, void *arg)
 {
     content_cache_t *cache = arg;
+    json_t *load = NULL;
+    json_t *store = NULL;
 
     if (flux_request_decode (msg, NULL, NULL) < 0)
         goto error;
-    if (flux_respond_pack (h, msg, "{ s:i s:i s:i s:i}",
+    if (!(load = histogram_encode (cache->load_latency))
+        || !(store = histogram_encode (cache->store_latency)))
+        goto error;
+    if (flux_respond_pack (h, msg,
+                           "{ s:i s:i s:i s:i s:I s:I s:I s:I s:{s:O s:O} }",
                            "count", zhash_size (cache->entries),
                            "valid", cache->acct_valid,
                            "dirty", cache->acct_dirty,
-                           "size", cache->acct_size) < 0)
+                           "size", cache->acct_size,
+                           "load-hit", cache->stats.load_hit,
+                           "load-miss", cache->stats.load_miss,
+                           "purge-scan", cache->stats.purge_scan,
+                           "purge-drop", cache->stats.purge_drop,
+                           "latency",
+                             "load", load,
+                             "store", store) < 0)
         flux_log_error (h, "content stats");
+    json_decref (load);
+    json_decref (store);
     return;
 error:
     if (flux_respond_error (h, msg, errno, NULL) < 0)
         flux_log_error (h, "content stats");
+    json_decref (load);
+    json_decref (store);
 }
 
 /* Flush all dirty entries by walking the entire cache, issuing store
@@ -825,50 +1601,46 @@ error:
         flux_log_error (h, "content flush");
 }
 
-/* Heartbeat drives periodic cache purge
+/* Heartbeat drives periodic cache purge.
+ * Victims are taken from the tail of the LRU list (least recently used
+ * first), which holds only valid, clean entries.  The walk stops as soon
+ * as the cache is within the purge targets, or an entry is encountered
+ * that was used within the last 'purge_old_entry' epochs, since all
+ * entries ahead of it on the list were used more recently.  Once the
+ * entry count is within target, only large entries are dropped, so the
+ * walk also stops when no large entries are left to visit.  An entry is
+ * classified as large when it was last used.
  */
 
-static int cache_purge (content_cache_t *cache)
+static void cache_purge (content_cache_t *cache)
 {
-    int after_entries = zhash_size (cache->entries);
-    int after_size = cache->acct_size;
-    struct cache_entry *e;
-    zlist_t *purge = NULL;
-    int rc = -1;
-    const char *key;
+    struct cache_entry *e = cache->lru_last;
+    int large = cache->lru_large;
+    int count = 0;
 
-    if (cache->acct_dirty == zhash_size (cache->entries))
-        return 0;
+    while (e && (cache->acct_size > cache->purge_target_size
+                || zhash_size (cache->entries) > cache->purge_target_entries)) {
+        struct cache_entry *prev = e->lru_prev;
+        bool over_entries = zhash_size (cache->entries)
+                            > cache->purge_target_entries;
 
-    FOREACH_ZHASH (cache->entries, key, e) {
-        if (after_size <= cache->purge_target_size
-                        && after_entries <= cache->purge_target_entries)
-            break;
-        if (!e->valid || e->dirty)
-            continue;
         if (cache->epoch - e->lastused < cache->purge_old_entry)
-            continue;
-        if (after_entries <= cache->purge_target_entries
-                    && e->len < cache->purge_large_entry)
-            continue;
-        if ((!purge && !(purge = zlist_new ()))
-                    || zlist_append (purge, e) < 0) {
-            errno = ENOMEM;
-            goto done;
+            break;
+        if (!over_entries && large == 0)
+            break;
+        cache->stats.purge_scan++;
+        if (e->lru_large)
+            large--;
+        if (over_entries || e->lru_large) {
+            remove_entry (cache, e);
+            count++;
         }
-        after_size -= e->len;
-        after_entries--;
+        e = prev;
     }
-    if (purge) {
-        flux_log (cache->h, LOG_DEBUG, "content purge: %d entries",
-                  (int)zlist_size (purge));
-        while ((e = zlist_pop (purge)))
-            remove_entry (cache, e);
+    if (count > 0) {
+        cache->stats.purge_drop += count;
+        flux_log (cache->h, LOG_DEBUG, "content purge: %d entries", count);
     }
-    rc = 0;
-done:
-    zlist_destroy (&purge);
-    return rc;
 }
 
 static void heartbeat_event (flux_t *h, flux_msg_handler_t *mh,
@@ -897,6 +1669,18 @@ static const struct flux_msg_handler_spec htab[] = {
         content_store_request,
         FLUX_ROLE_USER
     },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "content.load-batch",
+        content_load_batch_request,
+        FLUX_ROLE_USER
+    },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "content.store-batch",
+        content_store_batch_request,
+        FLUX_ROLE_USER
+    },
     {
         FLUX_MSGTYPE_REQUEST,
         "content.unregister-backing",
@@ -1029,6 +1813,9 @@ int content_cache_register_attrs (content_cache_t *cache, attr_t *attr)
     if (attr_add_active_uint32 (attr, "content.flush-batch-limit",
                 &cache->flush_batch_limit, 0) < 0)
         return -1;
+    if (attr_add_active_uint32 (attr, "content.flush-batch-bytes",
+                &cache->flush_batch_bytes, 0) < 0)
+        return -1;
     if (attr_add_active_uint32 (attr, "content.blob-size-limit",
                 &cache->blob_size_limit, FLUX_ATTRFLAG_IMMUTABLE) < 0)
         return -1;
@@ -1051,14 +1838,23 @@ int content_cache_register_attrs (content_cache_t *cache, attr_t *attr)
 void content_cache_destroy (content_cache_t *cache)
 {
     if (cache) {
+        struct cache_batch *b;
+
         if (cache->h) {
             (void)flux_event_unsubscribe (cache->h, "hb");
             flux_msg_handler_delvec (cache->handlers);
         }
         if (cache->backing_name)
             free (cache->backing_name);
+        if (cache->batches) {
+            while ((b = zlist_pop (cache->batches)))
+                cache_batch_destroy (b);
+            zlist_destroy (&cache->batches);
+        }
         zhash_destroy (&cache->entries);
         request_list_destroy (&cache->flush_requests);
+        histogram_destroy (cache->load_latency);
+        histogram_destroy (cache->store_latency);
         free (cache);
     }
 }
@@ -1070,7 +1866,10 @@ content_cache_t *content_cache_create (void)
         errno = ENOMEM;
         return NULL;
     }
-    if (!(cache->entries = zhash_new ())) {
+    if (!(cache->entries = zhash_new ())
+        || !(cache->batches = zlist_new ())
+        || !(cache->load_latency = histogram_create ())
+        || !(cache->store_latency = histogram_create ())) {
         content_cache_destroy (cache);
         errno = ENOMEM;
         return NULL;
@@ -1078,6 +1877,7 @@ content_cache_t *content_cache_create (void)
     cache->rank = FLUX_NODEID_ANY;
     cache->blob_size_limit = default_blob_size_limit;
     cache->flush_batch_limit = default_flush_batch_limit;
+    cache->flush_batch_bytes = default_flush_batch_bytes;
     cache->purge_target_entries = default_cache_purge_target_entries;
     cache->purge_target_size = default_cache_purge_target_size;
     cache->purge_old_entry = default_cache_purge_old_entry;
@@ -0,0 +1,240 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* flux latency - dump latency histograms from service stats
+ *
+ * Each service reports histograms, in microseconds, in the "latency"
+ * object of its SERVICE.stats.get response.  If more than one rank is
+ * queried, histograms with the same name are merged.
+ */
+
+#include <czmq.h>
+#include <jansson.h>
+#include <inttypes.h>
+#include <flux/idset.h>
+#include "builtin.h"
+#include "src/common/libutil/histogram.h"
+
+static const char *default_services[] = { "kvs", "content", "job-manager",
+                                          NULL };
+
+struct latency {
+    char *name;
+    struct histogram *hist;
+};
+
+static struct optparse_option latency_opts[] = {
+    { .name = "rank", .key = 'r', .has_arg = 1, .arginfo = "IDSET",
+      .usage = "Query ranks in IDSET (or \"all\") and merge the results",
+    },
+    { .name = "json", .key = 'j', .has_arg = 0,
+      .usage = "Dump histograms as JSON",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static void latency_destroy (void **item)
+{
+    if (item && *item) {
+        struct latency *l = *item;
+        histogram_destroy (l->hist);
+        free (l->name);
+        free (l);
+        *item = NULL;
+    }
+}
+
+/* Merge histogram 'o' into the entry for 'name', creating it if needed.
+ */
+static void latency_add (zlistx_t *l, const char *name, json_t *o)
+{
+    struct latency *lat;
+    struct histogram *hist;
+
+    if (!(hist = histogram_decode (o)))
+        log_err_exit ("%s: error decoding histogram", name);
+    lat = zlistx_first (l);
+    while (lat) {
+        if (!strcmp (lat->name, name))
+            break;
+        lat = zlistx_next (l);
+    }
+    if (!lat) {
+        lat = xzmalloc (sizeof (*lat));
+        lat->name = xstrdup (name);
+        lat->hist = hist;
+        if (!zlistx_add_end (l, lat))
+            log_msg_exit ("out of memory");
+        return;
+    }
+    if (histogram_merge (lat->hist, hist) < 0)
+        log_err_exit ("%s: error merging histogram", name);
+    histogram_destroy (hist);
+}
+
+/* Process a SERVICE.stats.get response.  A service that is not loaded
+ * on the rank (ENOSYS) or has no latency stats is skipped.
+ */
+static void latency_get (zlistx_t *l, const char *service, flux_future_t *f)
+{
+    json_t *latency = NULL;
+    const char *key;
+    json_t *o;
+    char name[256];
+
+    if (flux_rpc_get_unpack (f, "{s?o}", "latency", &latency) < 0) {
+        if (errno == ENOSYS)
+            return;
+        log_err_exit ("%s.stats.get", service);
+    }
+    if (!latency)
+        return;
+    json_object_foreach (latency, key, o) {
+        snprintf (name, sizeof (name), "%s.%s", service, key);
+        latency_add (l, name, o);
+    }
+}
+
+static void print_table (zlistx_t *l)
+{
+    struct latency *lat;
+
+    printf ("%-24s %8s %8s %8s %8s %8s %8s %8s\n",
+            "NAME", "COUNT", "MIN", "P50", "P90", "P99", "P99.9", "MAX");
+    lat = zlistx_first (l);
+    while (lat) {
+        const struct histogram *h = lat->hist;
+        printf ("%-24s %8ju %8ju %8ju %8ju %8ju %8ju %8ju\n",
+                lat->name,
+                (uintmax_t)histogram_count (h),
+                (uintmax_t)histogram_min (h),
+                (uintmax_t)histogram_percentile (h, 50),
+                (uintmax_t)histogram_percentile (h, 90),
+                (uintmax_t)histogram_percentile (h, 99),
+                (uintmax_t)histogram_percentile (h, 99.9),
+                (uintmax_t)histogram_max (h));
+        lat = zlistx_next (l);
+    }
+}
+
+static void print_json (zlistx_t *l)
+{
+    struct latency *lat;
+    json_t *o;
+    json_t *hist;
+    char *s;
+
+    if (!(o = json_object ()))
+        log_msg_exit ("out of memory");
+    lat = zlistx_first (l);
+    while (lat) {
+        if (!(hist = histogram_encode (lat->hist))
+            || json_object_set_new (o, lat->name, hist) < 0)
+            log_msg_exit ("out of memory");
+        lat = zlistx_next (l);
+    }
+    if (!(s = json_dumps (o, JSON_COMPACT)))
+        log_msg_exit ("out of memory");
+    printf ("%s\n", s);
+    free (s);
+    json_decref (o);
+}
+
+static struct idset *get_ranks (optparse_t *p, flux_t *h)
+{
+    const char *arg = optparse_get_str (p, "rank", NULL);
+    struct idset *ranks;
+    uint32_t size;
+
+    if (!arg)
+        return NULL;
+    if (!strcmp (arg, "all")) {
+        if (flux_get_size (h, &size) < 0)
+            log_err_exit ("flux_get_size");
+        if (!(ranks = idset_create (size, 0))
+            || idset_range_set (ranks, 0, size - 1) < 0)
+            log_err_exit ("idset_create");
+    }
+    else if (!(ranks = idset_decode (arg)) || idset_count (ranks) == 0)
+        log_msg_exit ("invalid --rank argument: %s", arg);
+    return ranks;
+}
+
+static int cmd_latency (optparse_t *p, int ac, char *av[])
+{
+    int n = optparse_option_index (p);
+    flux_t *h = builtin_get_flux_handle (p);
+    const char **services = default_services;
+    struct idset *ranks;
+    zlistx_t *futures;
+    zlistx_t *l;
+    flux_future_t *f;
+    int i;
+
+    log_init ("flux-latency");
+
+    if (n < ac)
+        services = (const char **)&av[n];
+    if (!(futures = zlistx_new ()) || !(l = zlistx_new ()))
+        log_msg_exit ("out of memory");
+    zlistx_set_destructor (l, latency_destroy);
+
+    ranks = get_ranks (p, h);
+    for (i = 0; services[i] != NULL; i++) {
+        char *topic = xasprintf ("%s.stats.get", services[i]);
+        unsigned int rank = ranks ? idset_first (ranks) : FLUX_NODEID_ANY;
+
+        do {
+            if (!(f = flux_rpc (h, topic, NULL, rank, 0)))
+                log_err_exit ("%s", topic);
+            if (flux_future_aux_set (f, "service", (void *)services[i], NULL)
+                < 0 || !zlistx_add_end (futures, f))
+                log_msg_exit ("out of memory");
+            if (ranks)
+                rank = idset_next (ranks, rank);
+        } while (ranks && rank != IDSET_INVALID_ID);
+        free (topic);
+    }
+    f = zlistx_first (futures);
+    while (f) {
+        latency_get (l, flux_future_aux_get (f, "service"), f);
+        flux_future_destroy (f);
+        f = zlistx_next (futures);
+    }
+
+    if (optparse_hasopt (p, "json"))
+        print_json (l);
+    else
+        print_table (l);
+
+    zlistx_destroy (&l);
+    zlistx_destroy (&futures);
+    idset_destroy (ranks);
+    flux_close (h);
+    return (0);
+}
+
+int subcommand_latency_register (optparse_t *p)
+{
+    optparse_err_t e;
+
+    e = optparse_reg_subcommand (p,
+        "latency",
+        cmd_latency,
+        "[OPTIONS...] [SERVICE...]",
+        "Display latency histograms (in microseconds) of Flux services",
+        0,
+        latency_opts);
+    return (e == OPTPARSE_SUCCESS ? 0 : -1);
+}
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
@@ -8,6 +8,19 @@
  * SPDX-License-Identifier: LGPL-3.0
 \************************************************************/
 
+/* buffer.c - single-threaded ring buffer
+ *
+ * Unread data occupies 'used' bytes starting at 'start' in 'data', and
+ * wraps around the end of the 'alloc' byte allocation at most once, so
+ * it can always be described by at most two iovecs.  The allocation
+ * grows on demand up to the size given at creation, at which point the
+ * data is made contiguous again.
+ *
+ * A flux_buffer_t is only ever used from one reactor thread, so there
+ * is no locking.  Data moves between the ring and file descriptors
+ * with readv(2)/writev(2) directly, without an intermediate copy.
+ */
+
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
@@ -17,13 +30,15 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
 
 #include "buffer.h"
 #include "buffer_private.h"
 
-#include "src/common/liblsd/cbuf.h"
-
 #define FLUX_BUFFER_MIN   4096
+#define FLUX_BUFFER_CHUNK 1000
 #define FLUX_BUFFER_MAGIC 0xeb4feb4f
 
 enum {
@@ -37,7 +52,10 @@ struct flux_buffer {
     int magic;
     int size;
     bool readonly;
-    cbuf_t cbuf;
+    char *data;                 /* ring */
+    int alloc;                  /* allocated size of ring, <= size */
+    int start;                  /* offset of first unread byte */
+    int used;                   /* count of unread bytes */
     char *buf;                  /* internal buffer for user reads */
     int buflen;
     int cb_type;
@@ -49,7 +67,7 @@ struct flux_buffer {
 flux_buffer_t *flux_buffer_create (int size)
 {
     flux_buffer_t *fb = NULL;
-    int minsize = FLUX_BUFFER_MIN;
+    int minsize;
 
     if (size <= 0) {
         errno = EINVAL;
@@ -70,11 +88,11 @@ flux_buffer_t *flux_buffer_create (int size)
     fb->readonly = false;
 
     /* buffer can grow to size specified by user */
-    if (!(fb->cbuf = cbuf_create (minsize, fb->size)))
-        goto cleanup;
-
-    if (cbuf_opt_set (fb->cbuf, CBUF_OPT_OVERWRITE, CBUF_NO_DROP) < 0)
+    if (!(fb->data = malloc (minsize))) {
+        errno = ENOMEM;
         goto cleanup;
+    }
+    fb->alloc = minsize;
 
     /* +1 for possible NUL on line reads */
     fb->buflen = minsize + 1;
@@ -98,12 +116,148 @@ void flux_buffer_destroy (void *data)
     flux_buffer_t *fb = data;
     if (fb && fb->magic == FLUX_BUFFER_MAGIC) {
         fb->magic = ~FLUX_BUFFER_MAGIC;
-        cbuf_destroy (fb->cbuf);
+        free (fb->data);
         free (fb->buf);
         free (fb);
     }
 }
 
+/* Describe up to 'len' bytes of unread data in 'iov'.
+ * Returns the iovec count (0, 1, or 2).
+ */
+static int ring_data_iov (flux_buffer_t *fb, int len, struct iovec iov[2])
+{
+    int first;
+
+    if (len > fb->used)
+        len = fb->used;
+    if (len <= 0)
+        return 0;
+    first = fb->alloc - fb->start;
+    if (first > len)
+        first = len;
+    iov[0].iov_base = fb->data + fb->start;
+    iov[0].iov_len = first;
+    if (first == len)
+        return 1;
+    iov[1].iov_base = fb->data;
+    iov[1].iov_len = len - first;
+    return 2;
+}
+
+/* Describe up to 'len' bytes of free space following the unread data
+ * in 'iov', without growing the ring.  Returns the iovec count.
+ */
+static int ring_space_iov (flux_buffer_t *fb, int len, struct iovec iov[2])
+{
+    int in;
+    int first;
+
+    if (len > fb->alloc - fb->used)
+        len = fb->alloc - fb->used;
+    if (len <= 0)
+        return 0;
+    in = (fb->start + fb->used) % fb->alloc;
+    first = fb->alloc - in;
+    if (first > len)
+        first = len;
+    iov[0].iov_base = fb->data + in;
+    iov[0].iov_len = first;
+    if (first == len)
+        return 1;
+    iov[1].iov_base = fb->data;
+    iov[1].iov_len = len - first;
+    return 2;
+}
+
+/* Grow the ring so that 'len' more bytes fit, if the buffer size allows.
+ * Unread data is moved to the start of the new allocation.  Failure to
+ * grow is not an error, the caller gets less space.
+ */
+static void ring_grow (flux_buffer_t *fb, int len)
+{
+    struct iovec iov[2];
+    int need = fb->used + len;
+    int newalloc = fb->alloc;
+    char *newdata;
+    int i, n, off = 0;
+
+    if (need <= fb->alloc || fb->alloc == fb->size)
+        return;
+    while (newalloc < need && newalloc < fb->size)
+        newalloc = newalloc * 2;
+    if (newalloc > fb->size)
+        newalloc = fb->size;
+    if (!(newdata = malloc (newalloc)))
+        return;
+    n = ring_data_iov (fb, fb->used, iov);
+    for (i = 0; i < n; i++) {
+        memcpy (newdata + off, iov[i].iov_base, iov[i].iov_len);
+        off += iov[i].iov_len;
+    }
+    free (fb->data);
+    fb->data = newdata;
+    fb->alloc = newalloc;
+    fb->start = 0;
+}
+
+static void ring_consume (flux_buffer_t *fb, int len)
+{
+    assert (len <= fb->used);
+    fb->used -= len;
+    if (fb->used == 0)
+        fb->start = 0;
+    else
+        fb->start = (fb->start + len) % fb->alloc;
+}
+
+/* Copy 'len' bytes of unread data to 'dst' (len <= fb->used).
+ */
+static void ring_copy_out (flux_buffer_t *fb, char *dst, int len)
+{
+    struct iovec iov[2];
+    int i, n;
+
+    n = ring_data_iov (fb, len, iov);
+    for (i = 0; i < n; i++) {
+        memcpy (dst, iov[i].iov_base, iov[i].iov_len);
+        dst += iov[i].iov_len;
+    }
+}
+
+/* Copy 'len' bytes from 'src' into free space (len <= free space).
+ */
+static void ring_copy_in (flux_buffer_t *fb, const char *src, int len)
+{
+    struct iovec iov[2];
+    int i, n;
+
+    n = ring_space_iov (fb, len, iov);
+    for (i = 0; i < n; i++) {
+        memcpy (iov[i].iov_base, src, iov[i].iov_len);
+        src += iov[i].iov_len;
+    }
+    fb->used += len;
+}
+
+/* Return the length of the first line in the unread data, including
+ * its newline, or 0 if there is no complete line.
+ */
+static int ring_line_length (flux_buffer_t *fb)
+{
+    struct iovec iov[2];
+    int i, n, off = 0;
+    char *nl;
+
+    n = ring_data_iov (fb, fb->used, iov);
+    for (i = 0; i < n; i++) {
+        if ((nl = memchr (iov[i].iov_base, '\n', iov[i].iov_len)))
+            return off + (nl - (char *)iov[i].iov_base) + 1;
+        off += iov[i].iov_len;
+    }
+    return 0;
+}
+
 int flux_buffer_size (flux_buffer_t *fb)
 {
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
@@ -121,7 +275,7 @@ int flux_buffer_bytes (flux_buffer_t *fb)
         return -1;
     }
 
-    return cbuf_used (fb->cbuf);
+    return fb->used;
 }
 
 int flux_buffer_space (flux_buffer_t *fb)
@@ -131,7 +285,7 @@ int flux_buffer_space (flux_buffer_t *fb)
         return -1;
     }
 
-    return cbuf_free (fb->cbuf);
+    return fb->size - fb->used;
 }
 
 int flux_buffer_readonly (flux_buffer_t *fb)
@@ -257,30 +411,73 @@ void check_read_cb (flux_buffer_t *fb)
             fb->cb (fb, fb->cb_arg);
 }
 
-int flux_buffer_drop (flux_buffer_t *fb, int len)
+int flux_buffer_peek_iov (flux_buffer_t *fb, int len, struct iovec iov[2])
 {
-    int ret;
+    if (!fb || fb->magic != FLUX_BUFFER_MAGIC || !iov || len < -1) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (len == -1)
+        len = fb->used;
+    return ring_data_iov (fb, len, iov);
+}
 
-    if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
+int flux_buffer_reserve_iov (flux_buffer_t *fb, int len, struct iovec iov[2])
+{
+    int n;
+
+    if (!fb || fb->magic != FLUX_BUFFER_MAGIC || !iov || len < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (fb->readonly) {
+        errno = EROFS;
+        return -1;
+    }
+    if (len == 0)
+        return 0;
+    ring_grow (fb, len);
+    if ((n = ring_space_iov (fb, len, iov)) == 0) {
+        errno = ENOSPC;
+        return -1;
+    }
+    return n;
+}
+
+int flux_buffer_commit (flux_buffer_t *fb, int len)
+{
+    if (!fb
+        || fb->magic != FLUX_BUFFER_MAGIC
+        || len < 0
+        || len > fb->alloc - fb->used) {
         errno = EINVAL;
         return -1;
     }
+    fb->used += len;
+    check_read_cb (fb);
+    return len;
+}
 
-    if ((ret = cbuf_drop (fb->cbuf, len)) < 0)
+int flux_buffer_drop (flux_buffer_t *fb, int len)
+{
+    if (!fb || fb->magic != FLUX_BUFFER_MAGIC || len < -1) {
+        errno = EINVAL;
         return -1;
+    }
+
+    if (len == -1 || len > fb->used)
+        len = fb->used;
+    ring_consume (fb, len);
 
     check_write_cb (fb);
 
-    return ret;
+    return len;
 }
 
 /* check if internal buffer can hold data from user */
 static int return_buffer_check (flux_buffer_t *fb)
 {
-    int used = cbuf_used (fb->cbuf);
-
-    if (used < 0)
-        return -1;
+    int used = fb->used;
 
     assert (used <= fb->size);
 
@@ -306,8 +503,6 @@ static int return_buffer_check (flux_buffer_t *fb)
 
 const void *flux_buffer_peek (flux_buffer_t *fb, int len, int *lenp)
 {
-    int ret;
-
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
         errno = EINVAL;
         return NULL;
@@ -316,56 +511,37 @@ const void *flux_buffer_peek (flux_buffer_t *fb, int len, int *lenp)
     if (return_buffer_check (fb) < 0)
         return NULL;
 
-    if (len < 0)
-        len = cbuf_used (fb->cbuf);
+    if (len < 0 || len > fb->used)
+        len = fb->used;
 
-    if (len > fb->buflen)
-        len = fb->buflen;
-
-    if ((ret = cbuf_peek (fb->cbuf, fb->buf, len)) < 0)
-        return NULL;
-    fb->buf[ret] = '\0';
+    ring_copy_out (fb, fb->buf, len);
+    fb->buf[len] = '\0';
 
     if (lenp)
-        (*lenp) = ret;
+        (*lenp) = len;
 
     return fb->buf;
 }
 
 const void *flux_buffer_read (flux_buffer_t *fb, int len, int *lenp)
 {
-    int ret;
+    const void *ptr;
 
-    if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
-        errno = EINVAL;
-        return NULL;
-    }
-
-    if (return_buffer_check (fb) < 0)
+    if (!(ptr = flux_buffer_peek (fb, len, &len)))
         return NULL;
 
-    if (len < 0)
-        len = cbuf_used (fb->cbuf);
-
-    if (len > fb->buflen)
-        len = fb->buflen;
-
-    if ((ret = cbuf_read (fb->cbuf, fb->buf, len)) < 0)
-        return NULL;
-    fb->buf[ret] = '\0';
+    ring_consume (fb, len);
 
     if (lenp)
-        (*lenp) = ret;
+        (*lenp) = len;
 
     check_write_cb (fb);
 
-    return fb->buf;
+    return ptr;
 }
 
 int flux_buffer_write (flux_buffer_t *fb, const void *data, int len)
 {
-    int ret;
-
     if (!fb
         || fb->magic != FLUX_BUFFER_MAGIC
         || !data
@@ -379,54 +555,74 @@ int flux_buffer_write (flux_buffer_t *fb, const void *data, int len)
         return -1;
     }
 
-    if ((ret = cbuf_write (fb->cbuf, (void *)data, len, NULL)) < 0)
-        return -1;
+    if (len > 0) {
+        ring_grow (fb, len);
+        if (len > fb->alloc - fb->used)
+            len = fb->alloc - fb->used;
+        if (len == 0) {
+            errno = ENOSPC;
+            return -1;
+        }
+        ring_copy_in (fb, data, len);
+    }
 
     check_read_cb (fb);
 
-    return ret;
+    return len;
 }
 
 int flux_buffer_lines (flux_buffer_t *fb)
 {
+    struct iovec iov[2];
+    int i, n;
+    int lines = 0;
+
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
         errno = EINVAL;
         return -1;
     }
 
-    return cbuf_lines_used (fb->cbuf);
+    n = ring_data_iov (fb, fb->used, iov);
+    for (i = 0; i < n; i++) {
+        const char *p = iov[i].iov_base;
+        const char *end = p + iov[i].iov_len;
+        while ((p = memchr (p, '\n', end - p))) {
+            lines++;
+            p++;
+        }
+    }
+    return lines;
 }
 
 bool flux_buffer_has_line (flux_buffer_t *fb)
 {
-    char buf[1];
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
         errno = EINVAL;
         return false;
     }
-    return (cbuf_peek_line (fb->cbuf, buf, 0, 1) > 0);
+    return (ring_line_length (fb) > 0);
 }
 
 int flux_buffer_drop_line (flux_buffer_t *fb)
 {
-    int ret;
+    int len;
 
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
         errno = EINVAL;
         return -1;
     }
 
-    if ((ret = cbuf_drop_line (fb->cbuf, fb->buflen, 1)) < 0)
-        return -1;
+    len = ring_line_length (fb);
+    ring_consume (fb, len);
 
     check_write_cb (fb);
 
-    return ret;
+    return len;
 }
 
 const void *flux_buffer_peek_line (flux_buffer_t *fb, int *lenp)
 {
-    int ret;
+    int len;
 
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
         errno = EINVAL;
@@ -436,11 +632,12 @@ const void *flux_buffer_peek_line (flux_buffer_t *fb, int *lenp)
     if (return_buffer_check (fb) < 0)
         return NULL;
 
-    if ((ret = cbuf_peek_line (fb->cbuf, fb->buf, fb->buflen, 1)) < 0)
-        return NULL;
+    len = ring_line_length (fb);
+    ring_copy_out (fb, fb->buf, len);
+    fb->buf[len] = '\0';
 
     if (lenp)
-        (*lenp) = ret;
+        (*lenp) = len;
 
     return fb->buf;
 }
@@ -466,25 +663,20 @@ const void *flux_buffer_peek_trimmed_line (flux_buffer_t *fb, int *lenp)
 
 const void *flux_buffer_read_line (flux_buffer_t *fb, int *lenp)
 {
-    int ret;
+    const void *ptr;
+    int len;
 
-    if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
-        errno = EINVAL;
-        return NULL;
-    }
-
-    if (return_buffer_check (fb) < 0)
+    if (!(ptr = flux_buffer_peek_line (fb, &len)))
         return NULL;
 
-    if ((ret = cbuf_read_line (fb->cbuf, fb->buf, fb->buflen, 1)) < 0)
-        return NULL;
+    ring_consume (fb, len);
 
     if (lenp)
-        (*lenp) = ret;
+        (*lenp) = len;
 
     check_write_cb (fb);
 
-    return fb->buf;
+    return ptr;
 }
 
 const void *flux_buffer_read_trimmed_line (flux_buffer_t *fb, int *lenp)
@@ -508,7 +700,7 @@ const void *flux_buffer_read_trimmed_line (flux_buffer_t *fb, int *lenp)
 
 int flux_buffer_write_line (flux_buffer_t *fb, const char *data)
 {
-    int ret;
+    int len, total;
 
     if (!fb
         || fb->magic != FLUX_BUFFER_MAGIC
@@ -522,36 +714,66 @@ int flux_buffer_write_line (flux_buffer_t *fb, const char *data)
         return -1;
     }
 
-    if ((ret = cbuf_write_line (fb->cbuf, (char *)data, NULL)) < 0)
+    /* Reserve space for the trailing newline if needed.
+     * The line is written in full or not at all.
+     */
+    len = total = strlen (data);
+    if (len == 0 || data[len - 1] != '\n')
+        total++;
+    ring_grow (fb, total);
+    if (total > fb->alloc - fb->used) {
+        errno = ENOSPC;
         return -1;
+    }
+    ring_copy_in (fb, data, len);
+    if (total > len)
+        ring_copy_in (fb, "\n", 1);
 
     check_read_cb (fb);
 
+    return total;
+}
+
+static int peek_to_fd (flux_buffer_t *fb, int fd, int len)
+{
+    struct iovec iov[2];
+    int n;
+    ssize_t ret;
+
+    if (len == -1)
+        len = fb->used;
+    if (!(n = ring_data_iov (fb, len, iov)))
+        return 0;
+    do {
+        ret = writev (fd, iov, n);
+    } while (ret < 0 && errno == EINTR);
     return ret;
 }
 
 int flux_buffer_peek_to_fd (flux_buffer_t *fb, int fd, int len)
 {
-    if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
+    if (!fb || fb->magic != FLUX_BUFFER_MAGIC || fd < 0 || len < -1) {
         errno = EINVAL;
         return -1;
     }
 
-    return cbuf_peek_to_fd (fb->cbuf, fd, len);
+    return peek_to_fd (fb, fd, len);
 }
 
 int flux_buffer_read_to_fd (flux_buffer_t *fb, int fd, int len)
 {
     int ret;
 
-    if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
+    if (!fb || fb->magic != FLUX_BUFFER_MAGIC || fd < 0 || len < -1) {
         errno = EINVAL;
         return -1;
     }
 
-    if ((ret = cbuf_read_to_fd (fb->cbuf, fd, len)) < 0)
+    if ((ret = peek_to_fd (fb, fd, len)) < 0)
         return -1;
 
+    ring_consume (fb, ret);
+
     check_write_cb (fb);
 
     return ret;
@@ -559,9 +781,11 @@ int flux_buffer_read_to_fd (flux_buffer_t *fb, int fd, int len)
 
 int flux_buffer_write_from_fd (flux_buffer_t *fb, int fd, int len)
 {
-    int ret;
+    struct iovec iov[2];
+    int n;
+    ssize_t ret = 0;
 
-    if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
+    if (!fb || fb->magic != FLUX_BUFFER_MAGIC || fd < 0 || len < -1) {
         errno = EINVAL;
         return -1;
     }
@@ -571,8 +795,27 @@ int flux_buffer_write_from_fd (flux_buffer_t *fb, int fd, int len)
         return -1;
     }
 
-    if ((ret = cbuf_write_from_fd (fb->cbuf, fd, len, NULL)) < 0)
-        return -1;
+    /* Use the free space already allocated, or if there is none,
+     * try to grab another chunk.
+     */
+    if (len == -1) {
+        len = fb->alloc - fb->used;
+        if (len == 0)
+            len = FLUX_BUFFER_CHUNK;
+    }
+    if (len > 0) {
+        ring_grow (fb, len);
+        if (!(n = ring_space_iov (fb, len, iov))) {
+            errno = ENOSPC;
+            return -1;
+        }
+        do {
+            ret = readv (fd, iov, n);
+        } while (ret < 0 && errno == EINTR);
+        if (ret < 0)
+            return -1;
+        fb->used += ret;
+    }
 
     check_read_cb (fb);
 
@@ -11,6 +11,8 @@
 #ifndef FLUX_BUFFER_PRIVATE_H
 #define FLUX_BUFFER_PRIVATE_H
 
+#include <sys/uio.h>
+
 #include "buffer.h"
 
 typedef void (*flux_buffer_cb) (flux_buffer_t *fb, void *arg);
@@ -61,4 +63,23 @@ int flux_buffer_set_high_write_cb (flux_buffer_t *fb,
                                    int high,
                                    void *arg);
 
+/* Fill [iov] with up to [len] bytes of stored data without consuming
+ * it (-1 for all).  Returns the number of iovecs used (0, 1, or 2).
+ * The data may be passed to writev(2) and then consumed with
+ * flux_buffer_drop().
+ */
+int flux_buffer_peek_iov (flux_buffer_t *fb, int len, struct iovec iov[2]);
+
+/* Fill [iov] with up to [len] bytes of free space, growing the buffer if
+ * needed.  Returns the number of iovecs used (1 or 2), or -1 with errno
+ * set to ENOSPC if the buffer is full.  Data stored into the space, for
+ * example with readv(2), is made visible with flux_buffer_commit().
+ */
+int flux_buffer_reserve_iov (flux_buffer_t *fb, int len, struct iovec iov[2]);
+
+/* Add [len] bytes, previously stored in space obtained from
+ * flux_buffer_reserve_iov(), to the buffer.  Returns [len] or -1 on error.
+ */
+int flux_buffer_commit (flux_buffer_t *fb, int len);
+
 #endif /* !_FLUX_BUFFER_PRIVATE_H */
@@ -8,7 +8,7 @@
  * SPDX-License-Identifier: LGPL-3.0
 \************************************************************/
 
-/* A flux messages consist of a list of zeromq frames:
+/* On the wire, a flux message consists of a list of zeromq frames:
  *
  * [route]
  * [route]
@@ -21,6 +21,13 @@
  * PROTO frame
  *
  * See also: RFC 3
+ *
+ * In memory, the PROTO frame is kept decoded in a fixed struct, the
+ * route stack is an array of identity strings (inline for a few hops),
+ * short topic strings are stored inline, and the payload is a single
+ * reference counted buffer that is shared by message copies.
+ * Frames are only materialized at the boundaries: flux_msg_encode(),
+ * flux_msg_decode(), flux_msg_sendzsock() and flux_msg_recvzsock().
  */
 
 #if HAVE_CONFIG_H
@@ -28,6 +35,7 @@
 #endif
 #include <errno.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 #include <arpa/inet.h>
 #include <assert.h>
@@ -41,14 +49,6 @@
 
 #include "message.h"
 
-struct flux_msg {
-    zmsg_t *zmsg;
-    json_t *json;
-    char *lasterr;
-    struct aux_item *aux;
-    int refcount;
-};
-
 /* Begin manual codec
  * PROTO consists of 4 byte prelude followed by a fixed length
  * array of u32's in network byte order.
@@ -70,145 +70,251 @@ struct flux_msg {
 #define PROTO_U32_COUNT     4
 #define PROTO_SIZE          4 + (PROTO_U32_COUNT * 4)
 
-/* Helpful aliases */
-#define PROTO_IND_NODEID    PROTO_IND_AUX1 // request
-#define PROTO_IND_MATCHTAG  PROTO_IND_AUX2 // request, response
-#define PROTO_IND_SEQUENCE  PROTO_IND_AUX1 // event
-#define PROTO_IND_ERRNUM    PROTO_IND_AUX1 // response, keepalive
-#define PROTO_IND_STATUS    PROTO_IND_AUX2 // keepalive
+struct proto {
+    uint8_t type;
+    uint8_t flags;
+    uint32_t userid;
+    uint32_t rolemask;
+    uint32_t aux1;
+    uint32_t aux2;
+};
 
-static int proto_set_u32 (uint8_t *data, int len, int index, uint32_t val);
+/* Message type specific uses of aux1 and aux2:
+ *   aux1: nodeid (request), sequence (event), errnum (response, keepalive)
+ *   aux2: matchtag (request, response), status (keepalive)
+ */
 
-static int proto_set_type (uint8_t *data, int len, int type)
+static void proto_set_u32 (uint8_t *data, int index, uint32_t val)
+{
+    uint32_t x = htonl (val);
+    int offset = PROTO_OFF_U32_ARRAY + index * 4;
+
+    memcpy (&data[offset], &x, sizeof (x));
+}
+static uint32_t proto_get_u32 (const uint8_t *data, int index)
+{
+    uint32_t x;
+    int offset = PROTO_OFF_U32_ARRAY + index * 4;
+
+    memcpy (&x, &data[offset], sizeof (x));
+    return ntohl (x);
+}
+static void proto_encode (const struct proto *p, uint8_t *data)
+{
+    data[PROTO_OFF_MAGIC] = PROTO_MAGIC;
+    data[PROTO_OFF_VERSION] = PROTO_VERSION;
+    data[PROTO_OFF_TYPE] = p->type;
+    data[PROTO_OFF_FLAGS] = p->flags;
+    proto_set_u32 (data, PROTO_IND_USERID, p->userid);
+    proto_set_u32 (data, PROTO_IND_ROLEMASK, p->rolemask);
+    proto_set_u32 (data, PROTO_IND_AUX1, p->aux1);
+    proto_set_u32 (data, PROTO_IND_AUX2, p->aux2);
+}
+static int proto_decode (struct proto *p, const uint8_t *data, size_t len)
+{
+    if (len != PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
+                          || data[PROTO_OFF_VERSION] != PROTO_VERSION)
+        return -1;
+    p->type = data[PROTO_OFF_TYPE];
+    p->flags = data[PROTO_OFF_FLAGS];
+    p->userid = proto_get_u32 (data, PROTO_IND_USERID);
+    p->rolemask = proto_get_u32 (data, PROTO_IND_ROLEMASK);
+    p->aux1 = proto_get_u32 (data, PROTO_IND_AUX1);
+    p->aux2 = proto_get_u32 (data, PROTO_IND_AUX2);
+    return 0;
+}
+static int proto_set_type (struct proto *p, int type)
 {
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION)
-        return -1;
     switch (type) {
         case FLUX_MSGTYPE_REQUEST:
-            if (proto_set_u32 (data, len, PROTO_IND_NODEID,
-                               FLUX_NODEID_ANY) < 0)
-                return -1;
-            if (proto_set_u32 (data, len, PROTO_IND_MATCHTAG,
-                               FLUX_MATCHTAG_NONE) < 0)
-                return -1;
+            p->aux1 = FLUX_NODEID_ANY;
+            p->aux2 = FLUX_MATCHTAG_NONE;
             break;
         case FLUX_MSGTYPE_RESPONSE:
             /* N.B. don't clobber matchtag from request on set_type */
-            if (proto_set_u32 (data, len, PROTO_IND_ERRNUM, 0) < 0)
-                return -1;
+            p->aux1 = 0;
             break;
         case FLUX_MSGTYPE_EVENT:
-            if (proto_set_u32 (data, len, PROTO_IND_SEQUENCE, 0) < 0)
-                return -1;
-            if (proto_set_u32 (data, len, PROTO_IND_AUX2, 0) < 0)
-                return -1;
+            p->aux1 = 0;
+            p->aux2 = 0;
             break;
         case FLUX_MSGTYPE_KEEPALIVE:
-            if (proto_set_u32 (data, len, PROTO_IND_STATUS, 0) < 0)
-                return -1;
-            if (proto_set_u32 (data, len, PROTO_IND_ERRNUM, 0) < 0)
-                return -1;
+            p->aux2 = 0;
+            p->aux1 = 0;
             break;
         default:
             return -1;
     }
-    data[PROTO_OFF_TYPE] = type;
+    p->type = type;
     return 0;
 }
-static int proto_get_type (uint8_t *data, int len, int *type)
+static void proto_init (struct proto *p, uint8_t flags)
 {
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION)
-        return -1;
-    *type = data[PROTO_OFF_TYPE];
-    return 0;
+    memset (p, 0, sizeof (*p));
+    p->flags = flags;
+    p->userid = FLUX_USERID_UNKNOWN;
+    p->rolemask = FLUX_ROLE_NONE;
 }
-static int proto_set_flags (uint8_t *data, int len, uint8_t flags)
+/* End manual codec
+ */
+
+/* Payloads are immutable once created, so they may be shared by
+ * flux_msg_copy() rather than duplicated.
+ */
+struct payload {
+    int refcount;
+    int size;
+    uint8_t data[];
+};
+
+#define MSG_ROUTES_INLINE   4
+#define MSG_TOPIC_INLINE    48
+
+struct flux_msg {
+    struct proto proto;
+    char **routes;      /* routes[0] is closest to the delimiter */
+    int routes_len;
+    int routes_size;
+    char *topic;        /* NULL, topic_inline, or malloc'ed */
+    struct payload *payload;
+    json_t *json;
+    char *lasterr;
+    struct aux_item *aux;
+    int refcount;
+    char *routes_inline[MSG_ROUTES_INLINE];
+    char topic_inline[MSG_TOPIC_INLINE];
+};
+
+/* A message frame, as it would appear on the wire.
+ */
+struct msg_iovec {
+    const void *data;
+    size_t size;
+};
+
+#define MSG_IOV_INLINE      16
+
+static struct payload *payload_create (const void *buf, int size)
 {
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION)
-        return -1;
-    data[PROTO_OFF_FLAGS] = flags;
-    return 0;
+    struct payload *p;
+
+    if (!(p = malloc (sizeof (*p) + size))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    p->refcount = 1;
+    p->size = size;
+    if (size > 0)
+        memcpy (p->data, buf, size);
+    return p;
 }
-static int proto_get_flags (uint8_t *data, int len, uint8_t *val)
+
+static void payload_decref (struct payload *p)
 {
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION)
-        return -1;
-    *val = data[PROTO_OFF_FLAGS];
-    return 0;
+    if (p && --p->refcount == 0)
+        free (p);
 }
-static int proto_set_u32 (uint8_t *data, int len, int index, uint32_t val)
+
+static struct payload *payload_incref (struct payload *p)
 {
-    uint32_t x = htonl (val);
-    int offset = PROTO_OFF_U32_ARRAY + index * 4;
+    p->refcount++;
+    return p;
+}
 
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION
-                         || index < 0 || index >= PROTO_U32_COUNT)
-        return -1;
-    memcpy (&data[offset], &x, sizeof (x));
-    return 0;
+static void msg_topic_clear (flux_msg_t *msg)
+{
+    if (msg->topic != msg->topic_inline)
+        free (msg->topic);
+    msg->topic = NULL;
 }
-static int proto_get_u32 (uint8_t *data, int len, int index, uint32_t *val)
+
+/* Set topic to 'len' bytes of 's' (not including any \0 terminator).
+ * 's' may point to the current topic.
+ */
+static int msg_topic_set (flux_msg_t *msg, const char *s, size_t len)
 {
-    uint32_t x;
-    int offset = PROTO_OFF_U32_ARRAY + index * 4;
+    char *cpy;
 
-    if (len < PROTO_SIZE || data[PROTO_OFF_MAGIC] != PROTO_MAGIC
-                         || data[PROTO_OFF_VERSION] != PROTO_VERSION
-                         || index < 0 || index >= PROTO_U32_COUNT)
+    if (len < sizeof (msg->topic_inline))
+        cpy = msg->topic_inline;
+    else if (!(cpy = malloc (len + 1))) {
+        errno = ENOMEM;
         return -1;
-    memcpy (&x, &data[offset], sizeof (x));
-    *val = ntohl (x);
+    }
+    memmove (cpy, s, len);
+    cpy[len] = '\0';
+    if (msg->topic != cpy)
+        msg_topic_clear (msg);
+    msg->topic = cpy;
     return 0;
 }
-static void proto_init (uint8_t *data, int len, uint8_t flags)
+
+static void msg_routes_clear (flux_msg_t *msg)
 {
-    int n;
-    assert (len >= PROTO_SIZE);
-    memset (data, 0, len);
-    data[PROTO_OFF_MAGIC] = PROTO_MAGIC;
-    data[PROTO_OFF_VERSION] = PROTO_VERSION;
-    data[PROTO_OFF_FLAGS] = flags;
-    n = proto_set_u32 (data, len, PROTO_IND_USERID, FLUX_USERID_UNKNOWN);
-    assert (n == 0);
-    n = proto_set_u32 (data, len, PROTO_IND_ROLEMASK, FLUX_ROLE_NONE);
-    assert (n == 0);
+    while (msg->routes_len > 0)
+        free (msg->routes[--msg->routes_len]);
 }
-/* End manual codec
+
+/* Push 'len' bytes of 'id' onto the top of the route stack.
  */
+static int msg_route_push (flux_msg_t *msg, const char *id, size_t len)
+{
+    char *cpy;
+
+    if (msg->routes_len == msg->routes_size) {
+        int new_size = msg->routes_size * 2;
+        char **new_routes;
+
+        if (msg->routes == msg->routes_inline) {
+            if ((new_routes = malloc (new_size * sizeof (new_routes[0]))))
+                memcpy (new_routes,
+                        msg->routes,
+                        msg->routes_len * sizeof (new_routes[0]));
+        }
+        else
+            new_routes = realloc (msg->routes,
+                                  new_size * sizeof (new_routes[0]));
+        if (!new_routes) {
+            errno = ENOMEM;
+            return -1;
+        }
+        msg->routes = new_routes;
+        msg->routes_size = new_size;
+    }
+    if (!(cpy = strndup (id, len))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    msg->routes[msg->routes_len++] = cpy;
+    return 0;
+}
 
 static flux_msg_t *flux_msg_create_common (void)
 {
     flux_msg_t *msg;
 
-    if (!(msg = calloc (1, sizeof (*msg))))
+    if (!(msg = malloc (sizeof (*msg))))
         return NULL;
+    /* N.B. the inline arrays need not be zeroed
+     */
+    memset (msg, 0, offsetof (struct flux_msg, routes_inline));
+    msg->routes = msg->routes_inline;
+    msg->routes_size = MSG_ROUTES_INLINE;
     msg->refcount = 1;
     return msg;
 }
 
 flux_msg_t *flux_msg_create (int type)
 {
-    uint8_t proto[PROTO_SIZE];
     flux_msg_t *msg;
 
     if (!(msg = flux_msg_create_common ()))
         return NULL;
-    proto_init (proto, PROTO_SIZE, 0);
-    if (proto_set_type (proto, PROTO_SIZE, type) < 0) {
+    proto_init (&msg->proto, 0);
+    if (proto_set_type (&msg->proto, type) < 0) {
         errno = EINVAL;
         goto error;
     }
-    if (!(msg->zmsg = zmsg_new ())) {
-        errno = ENOMEM;
-        goto error;
-    }
-    if (zmsg_addmem (msg->zmsg, proto, PROTO_SIZE) < 0)
-        goto error;
     return msg;
 error:
     flux_msg_destroy (msg);
@@ -220,7 +326,11 @@ void flux_msg_destroy (flux_msg_t *msg)
     if (msg && --msg->refcount == 0) {
         int saved_errno = errno;
         json_decref (msg->json);
-        zmsg_destroy (&msg->zmsg);
+        msg_routes_clear (msg);
+        if (msg->routes != msg->routes_inline)
+            free (msg->routes);
+        msg_topic_clear (msg);
+        payload_decref (msg->payload);
         aux_destroy (&msg->aux);
         free (msg->lasterr);
         free (msg);
@@ -275,20 +385,128 @@ void *flux_msg_aux_get (const flux_msg_t *msg, const char *name)
     return aux_get (msg->aux, name);
 }
 
+int flux_msg_frames (const flux_msg_t *msg)
+{
+    int n = 1; // PROTO
+
+    if ((msg->proto.flags & FLUX_MSGFLAG_ROUTE))
+        n += msg->routes_len + 1;
+    if ((msg->proto.flags & FLUX_MSGFLAG_TOPIC))
+        n++;
+    if ((msg->proto.flags & FLUX_MSGFLAG_PAYLOAD))
+        n++;
+    return n;
+}
+
+/* Get frame 'index' of 'msg', in wire order.
+ * 'proto' is the encoded PROTO frame.
+ */
+static void msg_frame_get (const flux_msg_t *msg,
+                           const uint8_t *proto,
+                           int index,
+                           struct msg_iovec *iov)
+{
+    if ((msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
+        if (index < msg->routes_len) {
+            const char *id = msg->routes[msg->routes_len - 1 - index];
+            iov->data = id;
+            iov->size = strlen (id);
+            return;
+        }
+        index -= msg->routes_len;
+        if (index == 0) {
+            iov->data = NULL;
+            iov->size = 0;
+            return;
+        }
+        index--;
+    }
+    if ((msg->proto.flags & FLUX_MSGFLAG_TOPIC)) {
+        if (index == 0) {
+            iov->data = msg->topic;
+            iov->size = strlen (msg->topic) + 1;
+            return;
+        }
+        index--;
+    }
+    if ((msg->proto.flags & FLUX_MSGFLAG_PAYLOAD)) {
+        if (index == 0) {
+            iov->data = msg->payload->data;
+            iov->size = msg->payload->size;
+            return;
+        }
+        index--;
+    }
+    assert (index == 0);
+    iov->data = proto;
+    iov->size = PROTO_SIZE;
+}
+
+/* Build a message from frames received on the wire.
+ */
+static flux_msg_t *msg_from_iovec (const struct msg_iovec *iov, int iovcnt)
+{
+    flux_msg_t *msg;
+    int i = 0;
+
+    if (!(msg = flux_msg_create_common ()))
+        return NULL;
+    if (iovcnt < 1 || proto_decode (&msg->proto,
+                                    iov[iovcnt - 1].data,
+                                    iov[iovcnt - 1].size) < 0)
+        goto eproto;
+    if ((msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
+        int j;
+        while (i < iovcnt - 1 && iov[i].size > 0)
+            i++;
+        if (i == iovcnt - 1)
+            goto eproto;
+        for (j = i - 1; j >= 0; j--) {
+            if (msg_route_push (msg, iov[j].data, iov[j].size) < 0)
+                goto error;
+        }
+        i++;
+    }
+    if ((msg->proto.flags & FLUX_MSGFLAG_TOPIC)) {
+        const char *s = iov[i].data;
+        if (i == iovcnt - 1 || iov[i].size == 0
+                            || s[iov[i].size - 1] != '\0')
+            goto eproto;
+        if (msg_topic_set (msg, s, iov[i].size - 1) < 0)
+            goto error;
+        i++;
+    }
+    if ((msg->proto.flags & FLUX_MSGFLAG_PAYLOAD)) {
+        if (i == iovcnt - 1)
+            goto eproto;
+        if (!(msg->payload = payload_create (iov[i].data, iov[i].size)))
+            goto error;
+        i++;
+    }
+    if (i != iovcnt - 1)
+        goto eproto;
+    return msg;
+eproto:
+    errno = EPROTO;
+error:
+    flux_msg_destroy (msg);
+    return NULL;
+}
+
 size_t flux_msg_encode_size (const flux_msg_t *msg)
 {
-    zframe_t *zf;
+    struct msg_iovec iov;
     size_t size = 0;
+    int frames = flux_msg_frames (msg);
+    int i;
 
-    zf = zmsg_first (msg->zmsg);
-    while (zf) {
-        size_t n = zframe_size (zf);
-        if (n < 255)
+    for (i = 0; i < frames; i++) {
+        msg_frame_get (msg, NULL, i, &iov);
+        if (iov.size < 255)
             size += 1;
         else
             size += 1 + 4;
-        size += n;
-        zf = zmsg_next (msg->zmsg);
+        size += iov.size;
     }
     return size;
 }
@@ -296,26 +514,33 @@ size_t flux_msg_encode_size (const flux_msg_t *msg)
 
 int flux_msg_encode (const flux_msg_t *msg, void *buf, size_t size)
 {
+    uint8_t proto[PROTO_SIZE];
     uint8_t *p = buf;
-    zframe_t *zf;
+    struct msg_iovec iov;
+    int frames = flux_msg_frames (msg);
+    int i;
+
+    proto_encode (&msg->proto, proto);
+    for (i = 0; i < frames; i++) {
+        size_t n;
 
-    zf = zmsg_first (msg->zmsg);
-    while (zf) {
-        size_t n = zframe_size (zf);
+        msg_frame_get (msg, proto, i, &iov);
+        n = iov.size;
         if (n < 0xff) {
             if (size - (p - (uint8_t *)buf) < n + 1)
                 goto nospace;
             *p++ = (uint8_t)n;
         } else {
+            uint32_t x = htonl (n);
             if (size - (p - (uint8_t *)buf) < n + 1 + 4)
                 goto nospace;
             *p++ = 0xff;
-            *(uint32_t *)p = htonl (n);
+            memcpy (p, &x, sizeof (x));
             p += 4;
         }
-        memcpy (p, zframe_data (zf), n);
+        if (n > 0)
+            memcpy (p, iov.data, n);
         p += n;
-        zf = zmsg_next (msg->zmsg);
     }
     return 0;
 nospace:
@@ -323,48 +548,65 @@ nospace:
     return -1;
 }
 
-flux_msg_t *flux_msg_decode (const void *buf, size_t size)
+/* Parse frames from 'buf'.  If 'iov' is NULL, just count them.
+ * Returns frame count on success, -1 on failure with errno set.
+ */
+static int decode_frames (const void *buf, size_t size, struct msg_iovec *iov)
 {
-    flux_msg_t *msg;
     uint8_t const *p = buf;
-    zframe_t *zf;
+    int count = 0;
 
-    if (!(msg = flux_msg_create_common ()))
-        return NULL;
-    if (!(msg->zmsg = zmsg_new ()))
-        goto nomem;
     while (p - (uint8_t *)buf < size) {
         size_t n = *p++;
         if (n == 0xff) {
+            uint32_t x;
             if (size - (p - (uint8_t *)buf) < 4) {
                 errno = EINVAL;
-                goto error;
+                return -1;
             }
-            n = ntohl (*(uint32_t *)p);
+            memcpy (&x, p, sizeof (x));
+            n = ntohl (x);
             p += 4;
         }
         if (size - (p - (uint8_t *)buf) < n) {
             errno = EINVAL;
-            goto error;
+            return -1;
+        }
+        if (iov) {
+            iov[count].data = p;
+            iov[count].size = n;
         }
-        if (!(zf = zframe_new (p, n)))
-            goto nomem;
-        if (zmsg_append (msg->zmsg, &zf) < 0)
-            goto nomem;
+        count++;
         p += n;
     }
+    return count;
+}
+
+flux_msg_t *flux_msg_decode (const void *buf, size_t size)
+{
+    struct msg_iovec iov_inline[MSG_IOV_INLINE];
+    struct msg_iovec *iov = iov_inline;
+    flux_msg_t *msg;
+    int count;
+
+    if ((count = decode_frames (buf, size, NULL)) < 0)
+        return NULL;
+    if (count > MSG_IOV_INLINE) {
+        if (!(iov = calloc (count, sizeof (iov[0])))) {
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+    (void)decode_frames (buf, size, iov);
+    msg = msg_from_iovec (iov, count);
+    if (iov != iov_inline)
+        ERRNO_SAFE_WRAP (free, iov);
     return msg;
-nomem:
-    errno = ENOMEM;
-error:
-    flux_msg_destroy (msg);
-    return NULL;
 }
 
 int flux_msg_set_type (flux_msg_t *msg, int type)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_type (zframe_data (zf), zframe_size (zf), type) < 0) {
+    if (!msg || proto_set_type (&msg->proto, type) < 0) {
         errno = EINVAL;
         return -1;
     }
@@ -373,11 +615,11 @@ int flux_msg_set_type (flux_msg_t *msg, int type)
 
 int flux_msg_get_type (const flux_msg_t *msg, int *type)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), type) < 0) {
-        errno = EPROTO;
+    if (!msg || !type) {
+        errno = EINVAL;
         return -1;
     }
+    *type = msg->proto.type;
     return 0;
 }
 
@@ -393,11 +635,17 @@ int flux_msg_set_flags (flux_msg_t *msg, uint8_t fl)
         errno = EINVAL;
         return -1;
     }
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_flags (zframe_data (zf), zframe_size (zf), fl) < 0) {
-        errno = EINVAL;
-        return -1;
-    }
+    /* The topic and payload flags always reflect message content.
+     * Clearing the route flag drops the route stack.
+     */
+    fl &= ~(uint8_t)(FLUX_MSGFLAG_TOPIC | FLUX_MSGFLAG_PAYLOAD);
+    if (msg->topic)
+        fl |= FLUX_MSGFLAG_TOPIC;
+    if (msg->payload)
+        fl |= FLUX_MSGFLAG_PAYLOAD;
+    if (!(fl & FLUX_MSGFLAG_ROUTE))
+        msg_routes_clear (msg);
+    msg->proto.flags = fl;
     return 0;
 }
 
@@ -407,11 +655,7 @@ int flux_msg_get_flags (const flux_msg_t *msg, uint8_t *fl)
         errno = EINVAL;
         return -1;
     }
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_flags (zframe_data (zf), zframe_size (zf), fl) < 0) {
-        errno = EPROTO;
-        return -1;
-    }
+    *fl = msg->proto.flags;
     return 0;
 }
 
@@ -473,77 +717,41 @@ bool flux_msg_is_noresponse (const flux_msg_t *msg)
 
 int flux_msg_set_userid (flux_msg_t *msg, uint32_t userid)
 {
-    zframe_t *zf;
-
     if (!msg) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_USERID,
-                              userid) < 0) {
-        errno = EINVAL;
-        return -1;
-    }
+    msg->proto.userid = userid;
     return 0;
 }
 
 int flux_msg_get_userid (const flux_msg_t *msg, uint32_t *userid)
 {
-    zframe_t *zf;
-
     if (!msg || !userid) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_USERID,
-                              userid) < 0) {
-        errno = EPROTO;
-        return -1;
-    }
+    *userid = msg->proto.userid;
     return 0;
 }
 
 int flux_msg_set_rolemask (flux_msg_t *msg, uint32_t rolemask)
 {
-    zframe_t *zf;
-
     if (!msg) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_set_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_ROLEMASK,
-                              rolemask) < 0) {
-        errno = EINVAL;
-        return -1;
-    }
+    msg->proto.rolemask = rolemask;
     return 0;
 }
 
 int flux_msg_get_rolemask (const flux_msg_t *msg, uint32_t *rolemask)
 {
-    zframe_t *zf;
-
     if (!msg || !rolemask) {
         errno = EINVAL;
         return -1;
     }
-    zf = zmsg_last (msg->zmsg);
-    if (!zf || proto_get_u32 (zframe_data (zf),
-                              zframe_size (zf),
-                              PROTO_IND_ROLEMASK,
-                              rolemask) < 0) {
-        errno = EPROTO;
-        return -1;
-    }
+    *rolemask = msg->proto.rolemask;
     return 0;
 }
 
@@ -597,22 +805,13 @@ int flux_msg_authorize (const flux_msg_t *msg, uint32_t userid)
 
 int flux_msg_set_nodeid (flux_msg_t *msg, uint32_t nodeid)
 {
-    zframe_t *zf;
-    int type;
-
     if (!msg)
         goto error;
     if (nodeid == FLUX_NODEID_UPSTREAM) /* should have been resolved earlier */
         goto error;
-    if (!(zf = zmsg_last (msg->zmsg)))
-        goto error;
-    if (proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0)
-        goto error;
-    if (type != FLUX_MSGTYPE_REQUEST)
-        goto error;
-    if (proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                       PROTO_IND_NODEID, nodeid) < 0)
+    if (msg->proto.type != FLUX_MSGTYPE_REQUEST)
         goto error;
+    msg->proto.aux1 = nodeid;
     return 0;
 error:
     errno = EINVAL;
@@ -621,24 +820,13 @@ error:
 
 int flux_msg_get_nodeid (const flux_msg_t *msg, uint32_t *nodeidp)
 {
-    zframe_t *zf;
-    int type;
-    uint32_t nodeid;
-
     if (!msg || !nodeidp) {
         errno = EINVAL;
         return -1;
     }
-    if (!(zf = zmsg_last (msg->zmsg)))
-        goto error;
-    if (proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0)
-        goto error;
-    if (type != FLUX_MSGTYPE_REQUEST)
+    if (msg->proto.type != FLUX_MSGTYPE_REQUEST)
         goto error;
-    if (proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                       PROTO_IND_NODEID, &nodeid) < 0)
-        goto error;
-    *nodeidp = nodeid;
+    *nodeidp = msg->proto.aux1;
     return 0;
 error:
     return EPROTO;
@@ -647,125 +835,85 @@ error:
 
 int flux_msg_set_errnum (flux_msg_t *msg, int e)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_RESPONSE && type != FLUX_MSGTYPE_KEEPALIVE)
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_ERRNUM, e) < 0) {
+    if (!msg || (msg->proto.type != FLUX_MSGTYPE_RESPONSE
+              && msg->proto.type != FLUX_MSGTYPE_KEEPALIVE)) {
         errno = EINVAL;
         return -1;
     }
+    msg->proto.aux1 = e;
     return 0;
 }
 
 int flux_msg_get_errnum (const flux_msg_t *msg, int *e)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-    uint32_t xe;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_RESPONSE && type != FLUX_MSGTYPE_KEEPALIVE)
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_ERRNUM, &xe) < 0) {
+    if (!msg || (msg->proto.type != FLUX_MSGTYPE_RESPONSE
+              && msg->proto.type != FLUX_MSGTYPE_KEEPALIVE)) {
         errno = EPROTO;
         return -1;
     }
-    *e = xe;
+    *e = msg->proto.aux1;
     return 0;
 }
 
 int flux_msg_set_seq (flux_msg_t *msg, uint32_t seq)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_EVENT
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_SEQUENCE, seq) < 0) {
+    if (!msg || msg->proto.type != FLUX_MSGTYPE_EVENT) {
         errno = EINVAL;
         return -1;
     }
+    msg->proto.aux1 = seq;
     return 0;
 }
 
 int flux_msg_get_seq (const flux_msg_t *msg, uint32_t *seq)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_EVENT
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_SEQUENCE, seq) < 0) {
+    if (!msg || msg->proto.type != FLUX_MSGTYPE_EVENT) {
         errno = EPROTO;
         return -1;
     }
+    *seq = msg->proto.aux1;
     return 0;
 }
 
 int flux_msg_set_matchtag (flux_msg_t *msg, uint32_t t)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_REQUEST && type != FLUX_MSGTYPE_RESPONSE)
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_MATCHTAG, t) < 0) {
+    if (!msg || (msg->proto.type != FLUX_MSGTYPE_REQUEST
+              && msg->proto.type != FLUX_MSGTYPE_RESPONSE)) {
         errno = EINVAL;
         return -1;
     }
+    msg->proto.aux2 = t;
     return 0;
 }
 
 int flux_msg_get_matchtag (const flux_msg_t *msg, uint32_t *t)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || (type != FLUX_MSGTYPE_REQUEST && type != FLUX_MSGTYPE_RESPONSE)
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_MATCHTAG, t) < 0) {
+    if (!msg || (msg->proto.type != FLUX_MSGTYPE_REQUEST
+              && msg->proto.type != FLUX_MSGTYPE_RESPONSE)) {
         errno = EPROTO;
         return -1;
     }
+    *t = msg->proto.aux2;
     return 0;
 }
 
 int flux_msg_set_status (flux_msg_t *msg, int s)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_KEEPALIVE
-            || proto_set_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_STATUS, s) < 0) {
+    if (!msg || msg->proto.type != FLUX_MSGTYPE_KEEPALIVE) {
         errno = EINVAL;
         return -1;
     }
+    msg->proto.aux2 = s;
     return 0;
 }
 
 int flux_msg_get_status (const flux_msg_t *msg, int *s)
 {
-    zframe_t *zf = zmsg_last (msg->zmsg);
-    int type;
-    uint32_t u;
-
-    if (!zf || proto_get_type (zframe_data (zf), zframe_size (zf), &type) < 0
-            || type != FLUX_MSGTYPE_KEEPALIVE
-            || proto_get_u32 (zframe_data (zf), zframe_size (zf),
-                              PROTO_IND_STATUS, &u) < 0) {
+    if (!msg || msg->proto.type != FLUX_MSGTYPE_KEEPALIVE) {
         errno = EPROTO;
         return -1;
     }
-    *s = u;
+    *s = msg->proto.aux2;
     return 0;
 }
 
@@ -826,102 +974,78 @@ bool flux_msg_cmp (const flux_msg_t *msg, struct flux_match match)
     return true;
 }
 
-int flux_msg_enable_route (flux_msg_t *msg)
+/* Return 0 if message has a route stack, else -1 with errno = EPROTO.
+ */
+static int msg_has_routes (const flux_msg_t *msg)
 {
-    uint8_t flags;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg) {
+        errno = EINVAL;
         return -1;
-    if ((flags & FLUX_MSGFLAG_ROUTE))
-        return 0;
-    if (zmsg_pushmem (msg->zmsg, NULL, 0) < 0) {
-        errno = ENOMEM;
+    }
+    if (!(msg->proto.flags & FLUX_MSGFLAG_ROUTE)) {
+        errno = EPROTO;
         return -1;
     }
-    flags |= FLUX_MSGFLAG_ROUTE;
-    return flux_msg_set_flags (msg, flags);
+    return 0;
 }
 
-int flux_msg_clear_route (flux_msg_t *msg)
+int flux_msg_enable_route (flux_msg_t *msg)
 {
-    uint8_t flags;
-    zframe_t *zf;
-    int size;
+    if (!msg) {
+        errno = EINVAL;
+        return -1;
+    }
+    msg->proto.flags |= FLUX_MSGFLAG_ROUTE;
+    return 0;
+}
 
-    if (flux_msg_get_flags (msg, &flags) < 0)
+int flux_msg_clear_route (flux_msg_t *msg)
+{
+    if (!msg) {
+        errno = EINVAL;
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE))
-        return 0;
-    while ((zf = zmsg_pop (msg->zmsg))) {
-        size = zframe_size (zf);
-        zframe_destroy (&zf);
-        if (size == 0)
-            break;
     }
-    flags &= ~(uint8_t)FLUX_MSGFLAG_ROUTE;
-    return flux_msg_set_flags (msg, flags);
+    msg_routes_clear (msg);
+    msg->proto.flags &= ~(uint8_t)FLUX_MSGFLAG_ROUTE;
+    return 0;
 }
 
 int flux_msg_push_route (flux_msg_t *msg, const char *id)
 {
-    uint8_t flags;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
-        errno = EPROTO;
+    if (msg_has_routes (msg) < 0)
         return -1;
-    }
-    if (zmsg_pushstr (msg->zmsg, id) < 0) {
-        errno = ENOMEM;
+    if (!id) {
+        errno = EINVAL;
         return -1;
     }
-    return 0;
+    return msg_route_push (msg, id, strlen (id));
 }
 
 int flux_msg_pop_route (flux_msg_t *msg, char **id)
 {
-    uint8_t flags;
-    zframe_t *zf;
+    char *s = NULL;
 
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (msg_has_routes (msg) < 0)
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE) || !(zf = zmsg_first (msg->zmsg))) {
-        errno = EPROTO;
-        return -1;
-    }
-    if (zframe_size (zf) > 0 && (zf = zmsg_pop (msg->zmsg))) {
-        if (id) {
-            char *s = zframe_strdup (zf);
-            if (!s) {
-                zframe_destroy (&zf);
-                errno = ENOMEM;
-                return -1;
-            }
-            *id = s;
-        }
-        zframe_destroy (&zf);
-    } else {
-        if (id)
-            *id = NULL;
-    }
+    if (msg->routes_len > 0)
+        s = msg->routes[--msg->routes_len];
+    if (id)
+        *id = s;
+    else
+        free (s);
     return 0;
 }
 
-/* replaces flux_msg_nexthop */
-int flux_msg_get_route_last (const flux_msg_t *msg, char **id)
+/* Copy route 'index' (0 = closest to delimiter) to 'id', or set 'id' to
+ * NULL if there are no routes.
+ */
+static int msg_route_dup (const flux_msg_t *msg, int index, char **id)
 {
-    uint8_t flags;
-    zframe_t *zf;
     char *s = NULL;
 
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (msg_has_routes (msg) < 0)
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE) || !(zf = zmsg_first (msg->zmsg))) {
-        errno = EPROTO;
-        return -1;
-    }
-    if (zframe_size (zf) > 0 && !(s = zframe_strdup (zf))) {
+    if (msg->routes_len > 0 && !(s = strdup (msg->routes[index]))) {
         errno = ENOMEM;
         return -1;
     }
@@ -929,108 +1053,43 @@ int flux_msg_get_route_last (const flux_msg_t *msg, char **id)
     return 0;
 }
 
+/* replaces flux_msg_nexthop */
+int flux_msg_get_route_last (const flux_msg_t *msg, char **id)
+{
+    return msg_route_dup (msg, msg ? msg->routes_len - 1 : 0, id);
+}
+
 /* replaces flux_msg_sender */
 int flux_msg_get_route_first (const flux_msg_t *msg, char **id)
 {
-    uint8_t flags;
-    zframe_t *zf, *zf_next;
-    char *s = NULL;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
-        errno = EPROTO;
-        return -1;
-    }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        zf_next = zmsg_next (msg->zmsg);
-        if (zf_next && zframe_size (zf_next) == 0)
-            break;
-        zf = zf_next;
-    }
-    if (!zf) {
-        errno = EPROTO;
-        return -1;
-    }
-    if (zframe_size (zf) > 0 && !(s = zframe_strdup (zf))) {
-        errno = ENOMEM;
-        return -1;
-    }
-    *id = s;
-    return 0;
+    return msg_route_dup (msg, 0, id);
 }
 
 int flux_msg_get_route_count (const flux_msg_t *msg)
 {
-    uint8_t flags;
-    zframe_t *zf;
-    int count = 0;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (msg_has_routes (msg) < 0)
         return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
-        errno = EPROTO;
-        return -1;
-    }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        zf = zmsg_next (msg->zmsg);
-        count++;
-    }
-    return count;
+    return msg->routes_len;
 }
 
 /* Get sum of size in bytes of route frames
  */
 static int flux_msg_get_route_size (const flux_msg_t *msg)
 {
-    uint8_t flags;
-    zframe_t *zf;
     int size = 0;
+    int i;
 
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        return -1;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
-        errno = EPROTO;
+    if (msg_has_routes (msg) < 0)
         return -1;
-    }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        size += zframe_size (zf);
-        zf = zmsg_next (msg->zmsg);
-    }
+    for (i = 0; i < msg->routes_len; i++)
+        size += strlen (msg->routes[i]);
     return size;
 }
 
-static zframe_t *flux_msg_get_route_nth (const flux_msg_t *msg, int n)
-{
-    uint8_t flags;
-    zframe_t *zf;
-    int count = 0;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        return NULL;
-    if (!(flags & FLUX_MSGFLAG_ROUTE)) {
-        errno = EPROTO;
-        return NULL;
-    }
-    zf = zmsg_first (msg->zmsg);
-    while (zf && zframe_size (zf) > 0) {
-        if (count == n)
-            return zf;
-        zf = zmsg_next (msg->zmsg);
-        count++;
-    }
-    errno = ENOENT;
-    return NULL;
-}
-
 char *flux_msg_get_route_string (const flux_msg_t *msg)
 {
     int hops, len;
     int n;
-    zframe_t *zf;
     char *buf, *cp;
 
     if (msg == NULL) {
@@ -1043,95 +1102,61 @@ char *flux_msg_get_route_string (const flux_msg_t *msg)
     }
     if (!(cp = buf = malloc (len + hops + 1)))
         return NULL;
-    for (n = hops - 1; n >= 0; n--) {
+    for (n = 0; n < hops; n++) {
         if (cp > buf)
             *cp++ = '!';
-        if (!(zf = flux_msg_get_route_nth (msg, n))) {
-            ERRNO_SAFE_WRAP (free, buf);
-            return NULL;
-        }
-        int cpylen = zframe_size (zf);
+        int cpylen = strlen (msg->routes[n]);
         if (cpylen == 36) /* abbreviate long UUID */
             cpylen = 8;
         assert (cp - buf + cpylen < len + hops);
-        memcpy (cp, zframe_data (zf), cpylen);
+        memcpy (cp, msg->routes[n], cpylen);
         cp += cpylen;
     }
     *cp = '\0';
     return buf;
 }
 
-static bool payload_overlap (const void *b, zframe_t *zf)
+static bool payload_overlap (const void *b, struct payload *p)
 {
-    return ((char *)b >= (char *)zframe_data (zf)
-         && (char *)b <  (char *)zframe_data (zf) + zframe_size (zf));
+    return ((char *)b >= (char *)p->data
+         && (char *)b <  (char *)p->data + p->size);
 }
 
 int flux_msg_set_payload (flux_msg_t *msg, const void *buf, int size)
 {
-    zframe_t *zf;
-    uint8_t flags;
-    int rc = -1;
+    struct payload *p;
 
     if (!msg) {
         errno = EINVAL;
-        goto done;
+        return -1;
     }
     json_decref (msg->json);            /* invalidate cached json object */
     msg->json = NULL;
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        goto done;
-    if (!(flags & FLUX_MSGFLAG_PAYLOAD) && (buf == NULL || size == 0)) {
-        rc = 0;
-        goto done;
-    }
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);      /* skip route frame */
-        if (zf)
-            zf = zmsg_next (msg->zmsg);      /* skip route delim */
-    }
-    if ((flags & FLUX_MSGFLAG_TOPIC)) {
-        if (zf)
-            zf = zmsg_next (msg->zmsg);      /* skip topic frame */
-    }
-    if (!zf) {                          /* must at least have proto frame */
-        errno = EPROTO;
-        goto done;
-    }
-    /* Case #1: replace existing payload.
+    /* Add or replace payload.
      */
-    if ((flags & FLUX_MSGFLAG_PAYLOAD) && (buf != NULL && size > 0)) {
-        if (zframe_data (zf) != buf || zframe_size (zf) != size) {
-            if (payload_overlap (buf, zf)) {
+    if (buf != NULL && size > 0) {
+        if (msg->payload) {
+            if (msg->payload->data == buf && msg->payload->size == size)
+                return 0;
+            if (payload_overlap (buf, msg->payload)) {
                 errno = EINVAL;
-                goto done;
+                return -1;
             }
-            zframe_reset (zf, buf, size);
-        }
-    /* Case #2: add payload.
-     */
-    } else if (!(flags & FLUX_MSGFLAG_PAYLOAD) && (buf != NULL && size > 0)) {
-        zmsg_remove (msg->zmsg, zf);
-        if (zmsg_addmem (msg->zmsg, buf, size) < 0
-                                        || zmsg_append (msg->zmsg, &zf) < 0) {
-            errno = ENOMEM;
-            goto done;
         }
-        flags |= FLUX_MSGFLAG_PAYLOAD;
-    /* Case #3: remove payload.
+        if (!(p = payload_create (buf, size)))
+            return -1;
+        payload_decref (msg->payload);
+        msg->payload = p;
+        msg->proto.flags |= FLUX_MSGFLAG_PAYLOAD;
+    }
+    /* Remove payload (if any).
      */
-    } else if ((flags & FLUX_MSGFLAG_PAYLOAD) && (buf == NULL || size == 0)) {
-        zmsg_remove (msg->zmsg, zf);
-        zframe_destroy (&zf);
-        flags &= ~(uint8_t)(FLUX_MSGFLAG_PAYLOAD);
+    else {
+        payload_decref (msg->payload);
+        msg->payload = NULL;
+        msg->proto.flags &= ~(uint8_t)(FLUX_MSGFLAG_PAYLOAD);
     }
-    if (flux_msg_set_flags (msg, flags) < 0)
-        goto done;
-    rc = 0;
-done:
-    return rc;
+    return 0;
 }
 
 static inline void msg_lasterr_reset (flux_msg_t *msg)
@@ -1208,34 +1233,18 @@ int flux_msg_pack (flux_msg_t *msg, const char *fmt, ...)
 
 int flux_msg_get_payload (const flux_msg_t *msg, const void **buf, int *size)
 {
-    zframe_t *zf;
-    uint8_t flags;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        return -1;
-    if (!(flags & FLUX_MSGFLAG_PAYLOAD)) {
-        errno = EPROTO;
+    if (!msg) {
+        errno = EINVAL;
         return -1;
     }
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
-    }
-    if ((flags & FLUX_MSGFLAG_TOPIC)) {
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
-    }
-    if (!zf) {
+    if (!(msg->proto.flags & FLUX_MSGFLAG_PAYLOAD)) {
         errno = EPROTO;
         return -1;
     }
     if (buf)
-        *buf = zframe_data (zf);
+        *buf = msg->payload->data;
     if (size)
-        *size = zframe_size (zf);
+        *size = msg->payload->size;
     return 0;
 }
 
@@ -1353,139 +1362,63 @@ const char *flux_msg_last_error (const flux_msg_t *msg)
 
 int flux_msg_set_topic (flux_msg_t *msg, const char *topic)
 {
-    zframe_t *zf, *zf2 = NULL;
-    uint8_t flags;
-    int rc = -1;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        goto done;
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {   /* skip over routing frames, if any */
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
-    }
-    if (!zf) {                          /* must at least have proto frame */
-        errno = EPROTO;
-        goto done;
-    }
-    if ((flags & FLUX_MSGFLAG_TOPIC) && topic) {        /* case 1: repl topic */
-        zframe_reset (zf, topic, strlen (topic) + 1);
-    } else if (!(flags & FLUX_MSGFLAG_TOPIC) && topic) {/* case 2: add topic */
-        zmsg_remove (msg->zmsg, zf);
-        if ((flags & FLUX_MSGFLAG_PAYLOAD) && (zf2 = zmsg_next (msg->zmsg)))
-            zmsg_remove (msg->zmsg, zf2);
-        if (zmsg_addmem (msg->zmsg, topic, strlen (topic) + 1) < 0
-                                    || zmsg_append (msg->zmsg, &zf) < 0
-                                    || (zf2 && zmsg_append (msg->zmsg, &zf2) < 0)) {
-            errno = ENOMEM;
-            goto done;
-        }
-        flags |= FLUX_MSGFLAG_TOPIC;
-        if (flux_msg_set_flags (msg, flags) < 0)
-            goto done;
-    } else if ((flags & FLUX_MSGFLAG_TOPIC) && !topic) { /* case 3: del topic */
-        zmsg_remove (msg->zmsg, zf);
-        zframe_destroy (&zf);
-        flags &= ~(uint8_t)FLUX_MSGFLAG_TOPIC;
-        if (flux_msg_set_flags (msg, flags) < 0)
-            goto done;
-    }
-    rc = 0;
-done:
-    return rc;
-}
-
-static int zf_topic (const flux_msg_t *msg, zframe_t **zfp)
-{
-    uint8_t flags;
-    zframe_t *zf = NULL;
-    int rc = -1;
-
-    if (flux_msg_get_flags (msg, &flags) < 0)
-        goto done;
-    if (!(flags & FLUX_MSGFLAG_TOPIC)) {
-        errno = EPROTO;
-        goto done;
+    if (!msg) {
+        errno = EINVAL;
+        return -1;
     }
-    zf = zmsg_first (msg->zmsg);
-    if ((flags & FLUX_MSGFLAG_ROUTE)) {
-        while (zf && zframe_size (zf) > 0)
-            zf = zmsg_next (msg->zmsg);
-        if (zf)
-            zf = zmsg_next (msg->zmsg);
+    if (topic) {
+        if (msg_topic_set (msg, topic, strlen (topic)) < 0)
+            return -1;
+        msg->proto.flags |= FLUX_MSGFLAG_TOPIC;
     }
-    if (!zf) {
-        errno = EPROTO;
-        goto done;
+    else {
+        msg_topic_clear (msg);
+        msg->proto.flags &= ~(uint8_t)FLUX_MSGFLAG_TOPIC;
     }
-    *zfp = zf;
-    rc = 0;
-done:
-    return rc;
+    return 0;
 }
 
 int flux_msg_get_topic (const flux_msg_t *msg, const char **topic)
 {
-    zframe_t *zf;
-    const char *s;
-    int rc = -1;
-
-    if (zf_topic (msg, &zf) < 0)
-        goto done;
-    s = (const char *)zframe_data (zf);
-    if (s[zframe_size (zf) - 1] != '\0') {
+    if (!msg) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(msg->proto.flags & FLUX_MSGFLAG_TOPIC)) {
         errno = EPROTO;
-        goto done;
+        return -1;
     }
-    *topic = s;
-    rc = 0;
-done:
-    return rc;
+    *topic = msg->topic;
+    return 0;
 }
 
 flux_msg_t *flux_msg_copy (const flux_msg_t *msg, bool payload)
 {
-    flux_msg_t *cpy = NULL;
-    zframe_t *zf;
-    int count;
-    uint8_t flags;
-    bool skip_payload = false;
+    flux_msg_t *cpy;
+    int i;
 
-    /* Set skip_payload = true if caller set 'payload' flag false
-     * AND message contains a payload frame.
-     */
-    if (flux_msg_get_flags (msg, &flags) < 0)
+    if (!msg) {
+        errno = EINVAL;
         return NULL;
-    if (!payload && (flags & FLUX_MSGFLAG_PAYLOAD)) {
-        flags &= ~(FLUX_MSGFLAG_PAYLOAD);
-        skip_payload = true;
     }
     if (!(cpy = flux_msg_create_common ()))
         return NULL;
-    if (!(cpy->zmsg = zmsg_new ()))
-        goto nomem;
-
-    /* Copy frames from 'msg' to 'cpy'.
-     * 'count' indexes frames from 0 to zmsg_size (msg) - 1.
-     * The payload frame (if it exists) will be in the second to last position.
-     */
-    count = 0;
-    zf = zmsg_first (msg->zmsg);
-    while (zf) {
-        if (!skip_payload || count != zmsg_size (msg->zmsg) - 2) {
-            if (zmsg_addmem (cpy->zmsg, zframe_data (zf), zframe_size (zf)) < 0)
-                goto nomem;
-        }
-        zf = zmsg_next (msg->zmsg);
-        count++;
+    cpy->proto = msg->proto;
+    for (i = 0; i < msg->routes_len; i++) {
+        if (msg_route_push (cpy, msg->routes[i], strlen (msg->routes[i])) < 0)
+            goto error;
     }
-    if (flux_msg_set_flags (cpy, flags) < 0)
-        goto error;
+    if (msg->topic) {
+        if (msg_topic_set (cpy, msg->topic, strlen (msg->topic)) < 0)
+            goto error;
+    }
+    /* The payload is immutable, so share it rather than copying.
+     */
+    if (payload && msg->payload)
+        cpy->payload = payload_incref (msg->payload);
+    else
+        cpy->proto.flags &= ~(uint8_t)FLUX_MSGFLAG_PAYLOAD;
     return cpy;
-nomem:
-    errno = ENOMEM;
 error:
     flux_msg_destroy (cpy);
     return NULL;
@@ -1529,16 +1462,16 @@ void flux_msg_fprint (FILE *f, const flux_msg_t *msg)
 {
     int hops;
     int type = 0;
-    zframe_t *proto;
+    uint8_t proto[PROTO_SIZE];
     const char *prefix, *topic = NULL;
+    int i;
 
     fprintf (f, "--------------------------------------\n");
     if (!msg) {
         fprintf (f, "NULL");
         return;
     }
-    if (flux_msg_get_type (msg, &type) < 0
-            || (!(proto = zmsg_last (msg->zmsg)))) {
+    if (flux_msg_get_type (msg, &type) < 0) {
         fprintf (f, "malformed message");
         return;
     }
@@ -1573,54 +1506,102 @@ void flux_msg_fprint (FILE *f, const flux_msg_t *msg)
     }
     /* Proto block
      */
-    zframe_fprint (proto, prefix, f);
+    proto_encode (&msg->proto, proto);
+    fprintf (f, "%s[%03d] ", prefix, PROTO_SIZE);
+    for (i = 0; i < PROTO_SIZE; i++)
+        fprintf (f, "%02X", proto[i]);
+    fprintf (f, "\n");
 }
 
 int flux_msg_sendzsock (void *sock, const flux_msg_t *msg)
 {
-    int rc = -1;
+    uint8_t proto[PROTO_SIZE];
+    struct msg_iovec iov;
+    void *handle;
+    int frames;
+    int i;
 
-    if (!sock || !msg || !zmsg_is (msg->zmsg)) {
+    if (!sock || !msg) {
         errno = EINVAL;
-        goto done;
+        return -1;
     }
+    handle = zsock_resolve (sock);
+    proto_encode (&msg->proto, proto);
+    frames = flux_msg_frames (msg);
+    for (i = 0; i < frames; i++) {
+        int flags = i < frames - 1 ? ZMQ_SNDMORE : 0;
 
-    void *handle = zsock_resolve (sock);
-    int flags = ZFRAME_REUSE | ZFRAME_MORE;
-    zframe_t *zf = zmsg_first (msg->zmsg);
-    size_t count = 0;
-
-    while (zf) {
-        if (++count == zmsg_size (msg->zmsg))
-            flags &= ~ZFRAME_MORE;
-        if (zframe_send (&zf, handle, flags) < 0)
-            goto done;
-        zf = zmsg_next (msg->zmsg);
+        msg_frame_get (msg, proto, i, &iov);
+        if (zmq_send (handle, iov.data, iov.size, flags) < 0)
+            return -1;
     }
-    rc = 0;
-done:
-    return rc;
+    return 0;
 }
 
 flux_msg_t *flux_msg_recvzsock (void *sock)
 {
-    zmsg_t *zmsg;
-    flux_msg_t *msg;
+    zmq_msg_t part_inline[MSG_IOV_INLINE];
+    zmq_msg_t *part = part_inline;
+    struct msg_iovec iov_inline[MSG_IOV_INLINE];
+    struct msg_iovec *iov = iov_inline;
+    int size = MSG_IOV_INLINE;
+    int count = 0;
+    void *handle;
+    flux_msg_t *msg = NULL;
+    int i;
 
-    if (!(zmsg = zmsg_recv (sock)))
-        return NULL;
-    if (!(msg = flux_msg_create_common ())) {
-        zmsg_destroy (&zmsg);
-        errno = ENOMEM;
+    if (!sock) {
+        errno = EINVAL;
         return NULL;
     }
-    msg->zmsg = zmsg;
-    return msg;
-}
+    handle = zsock_resolve (sock);
+    do {
+        if (count == size) {
+            zmq_msg_t *new_part;
+            struct msg_iovec *new_iov;
+
+            /* N.B. zmq_msg_t must not be copied with memcpy/realloc.
+             */
+            if (!(new_part = calloc (size * 2, sizeof (part[0])))
+                || !(new_iov = calloc (size * 2, sizeof (iov[0])))) {
+                ERRNO_SAFE_WRAP (free, new_part);
+                errno = ENOMEM;
+                goto done;
+            }
+            for (i = 0; i < count; i++) {
+                zmq_msg_init (&new_part[i]);
+                zmq_msg_move (&new_part[i], &part[i]);
+                zmq_msg_close (&part[i]);
+            }
+            if (part != part_inline)
+                free (part);
+            if (iov != iov_inline)
+                free (iov);
+            part = new_part;
+            iov = new_iov;
+            size *= 2;
+        }
+        zmq_msg_init (&part[count]);
+        if (zmq_msg_recv (&part[count], handle, 0) < 0) {
+            ERRNO_SAFE_WRAP (zmq_msg_close, &part[count]);
+            goto done;
+        }
+        count++;
+    } while (zmq_msg_more (&part[count - 1]));
 
-int flux_msg_frames (const flux_msg_t *msg)
-{
-    return zmsg_size (msg->zmsg);
+    for (i = 0; i < count; i++) {
+        iov[i].data = zmq_msg_data (&part[i]);
+        iov[i].size = zmq_msg_size (&part[i]);
+    }
+    msg = msg_from_iovec (iov, count);
+done:
+    for (i = 0; i < count; i++)
+        ERRNO_SAFE_WRAP (zmq_msg_close, &part[i]);
+    if (part != part_inline)
+        ERRNO_SAFE_WRAP (free, part);
+    if (iov != iov_inline)
+        ERRNO_SAFE_WRAP (free, iov);
+    return msg;
 }
 
 struct flux_match flux_match_init (int typemask,
@@ -26,15 +26,32 @@
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/iterators.h"
 
+/* Handlers that are not found in the hashes below are indexed by a trie
+ * keyed on the literal prefix of their topic glob, that is, the characters
+ * preceding the first glob metacharacter (or the whole topic if it has
+ * none).  A message need only be compared with handlers found on the path
+ * from the root to the node for its topic, so finding matches costs
+ * O(topic length) rather than O(handlers).
+ */
+struct topic_node {
+    char c;
+    struct topic_node *parent;
+    struct topic_node *child;
+    struct topic_node *sibling;
+    zlist_t *handlers;
+};
+
 struct dispatch {
     flux_t *h;
-    zlist_t *handlers;
-    zlist_t *handlers_new;
+    struct topic_node *topics; // topic prefix => handlers (trie)
+    uint64_t seq;
     zhashx_t *handlers_rpc; // matchtag => response handler
     zhashx_t *handlers_method; // topic => request handler (non-glob only)
     flux_watcher_t *w;
     int running_count;
     int usecount;
+    int dispatch_depth;
+    struct flux_msg_handler *destroyed; // destroyed while dispatching
     zlist_t *unmatched;
 #if HAVE_CALIPER
     cali_id_t prof_msg_type;
@@ -51,7 +68,11 @@ struct flux_msg_handler {
     uint32_t rolemask;
     flux_msg_handler_f fn;
     void *arg;
+    uint64_t seq;
+    struct topic_node *node;
     uint8_t running:1;
+    uint8_t destroyed:1;
+    struct flux_msg_handler *destroyed_next; // link in d->destroyed
 };
 
 static void handle_cb (flux_reactor_t *r, flux_watcher_t *w,
@@ -73,6 +94,129 @@ static bool isa_multmatch (const char *s)
     return false;
 }
 
+static const char *glob_metachars = "*?[\\";
+
+static struct topic_node *topic_node_create (struct topic_node *parent, char c)
+{
+    struct topic_node *n;
+
+    if (!(n = calloc (1, sizeof (*n))))
+        return NULL;
+    n->c = c;
+    if ((n->parent = parent)) {
+        n->sibling = parent->child;
+        parent->child = n;
+    }
+    return n;
+}
+
+static void topic_node_destroy (struct topic_node *n)
+{
+    if (n) {
+        int saved_errno = errno;
+        assert (n->child == NULL);
+        assert (n->handlers == NULL || zlist_size (n->handlers) == 0);
+        zlist_destroy (&n->handlers);
+        free (n);
+        errno = saved_errno;
+    }
+}
+
+/* Add 'mh' to the trie node for the literal prefix of its topic glob,
+ * creating nodes as needed.
+ */
+static int topic_index_add (struct topic_node *root, flux_msg_handler_t *mh)
+{
+    const char *p = mh->match.topic_glob ? mh->match.topic_glob : "";
+    struct topic_node *n = root;
+
+    for (; *p != '\0' && !strchr (glob_metachars, *p); p++) {
+        struct topic_node *child = n->child;
+        while (child && child->c != *p)
+            child = child->sibling;
+        if (!child && !(child = topic_node_create (n, *p)))
+            goto nomem;
+        n = child;
+    }
+    if (!n->handlers && !(n->handlers = zlist_new ()))
+        goto nomem;
+    if (zlist_append (n->handlers, mh) < 0)
+        goto nomem;
+    mh->node = n;
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+/* Remove 'mh' from the trie, then prune nodes that no longer lead
+ * to any handlers.
+ */
+static void topic_index_remove (flux_msg_handler_t *mh)
+{
+    struct topic_node *n = mh->node;
+
+    if (!n)
+        return;
+    zlist_remove (n->handlers, mh);
+    mh->node = NULL;
+    while (n->parent
+           && !n->child
+           && (!n->handlers || zlist_size (n->handlers) == 0)) {
+        struct topic_node *parent = n->parent;
+        struct topic_node **pp = &parent->child;
+        while (*pp != n)
+            pp = &(*pp)->sibling;
+        *pp = n->sibling;
+        topic_node_destroy (n);
+        n = parent;
+    }
+}
+
+/* Append handlers from trie node 'n' to the 'cand' array, growing it
+ * on the heap if necessary.  The initial array is caller-provided.
+ */
+static int candidates_add (struct topic_node *n,
+                           flux_msg_handler_t ***cand,
+                           int *count,
+                           int *size,
+                           flux_msg_handler_t **cand_inline)
+{
+    flux_msg_handler_t *mh;
+
+    if (!n->handlers)
+        return 0;
+    FOREACH_ZLIST (n->handlers, mh) {
+        if (*count == *size) {
+            flux_msg_handler_t **new;
+            if (!(new = malloc (sizeof (new[0]) * *size * 2)))
+                return -1;
+            memcpy (new, *cand, sizeof (new[0]) * *count);
+            if (*cand != cand_inline)
+                free (*cand);
+            *cand = new;
+            *size *= 2;
+        }
+        (*cand)[(*count)++] = mh;
+    }
+    return 0;
+}
+
+/* Sort candidates so that the most recently registered come first.
+ * N.B. candidate lists are short, so insertion sort suffices.
+ */
+static void candidates_sort (flux_msg_handler_t **cand, int count)
+{
+    int i, j;
+
+    for (i = 1; i < count; i++) {
+        flux_msg_handler_t *mh = cand[i];
+        for (j = i; j > 0 && cand[j - 1]->seq < mh->seq; j--)
+            cand[j] = cand[j - 1];
+        cand[j] = mh;
+    }
+}
+
 static void dispatch_requeue (struct dispatch *d)
 {
     if (d->unmatched) {
@@ -93,14 +237,8 @@ static void dispatch_usecount_decr (struct dispatch *d)
             dispatch_requeue (d);
             zlist_destroy (&d->unmatched);
         }
-        if (d->handlers) {
-            assert (zlist_size (d->handlers) == 0);
-            zlist_destroy (&d->handlers);
-        }
-        if (d->handlers_new) {
-            assert (zlist_size (d->handlers_new) == 0);
-            zlist_destroy (&d->handlers_new);
-        }
+        topic_node_destroy (d->topics);
+        assert (d->destroyed == NULL);
         flux_watcher_destroy (d->w);
         zhashx_destroy (&d->handlers_rpc);
         zhashx_destroy (&d->handlers_method);
@@ -130,9 +268,7 @@ static struct dispatch *dispatch_get (flux_t *h)
             return NULL;
         memset (d, 0, sizeof (*d));
         d->usecount = 1;
-        if (!(d->handlers = zlist_new ()))
-            goto nomem;
-        if (!(d->handlers_new = zlist_new ()))
+        if (!(d->topics = topic_node_create (NULL, '\0')))
             goto nomem;
         d->h = h;
         d->w = flux_handle_watcher_create (r, h, FLUX_POLLIN, handle_cb, d);
@@ -234,16 +370,30 @@ static void call_handler (flux_msg_handler_t *mh, const flux_msg_t *msg)
 /* Messages are matched in the following order:
  * 1) RPC responses - lookup in handlers_rpc hash by matchtag.
  * 2) RPC requests - lookup in handlers_method hash by topic string
- * 3) Requests and responses not matched above - sent to first match in
- *    list of handlers, where most recently registered handlers match first.
- * 4) Events - sent to all matches in list of handlers
+ * 3) Requests and responses not matched above - sent to first match among
+ *    handlers found in the topic trie, where most recently registered
+ *    handlers match first.
+ * 4) Events - sent to all matches among handlers found in the topic trie,
+ *    most recently registered first.
+ * Handlers destroyed by a callback are not freed until dispatch is complete,
+ * so the candidate array below remains valid.
  */
 static bool dispatch_message (struct dispatch *d,
                               const flux_msg_t *msg,
                               int type)
 {
     flux_msg_handler_t *mh;
+    flux_msg_handler_t *cand_inline[16];
+    flux_msg_handler_t **cand = cand_inline;
+    int size = sizeof (cand_inline) / sizeof (cand_inline[0]);
+    int count = 0;
     bool match = false;
+    const char *topic = NULL;
+
+    dispatch_usecount_incr (d);
+    d->dispatch_depth++;
+
+    (void)flux_msg_get_topic (msg, &topic);
 
     /* rpc response w/matchtag */
     if (type == FLUX_MSGTYPE_RESPONSE) {
@@ -260,8 +410,7 @@ static bool dispatch_message (struct dispatch *d,
     }
     /* rpc request */
     else if (type == FLUX_MSGTYPE_REQUEST) {
-        const char *topic;
-        if (flux_msg_get_topic (msg, &topic) == 0
+        if (topic
                 && (mh = zhashx_lookup (d->handlers_method, topic))
                 && mh->running) {
             call_handler (mh, msg);
@@ -270,8 +419,25 @@ static bool dispatch_message (struct dispatch *d,
     }
     /* other */
     if (!match) {
-        FOREACH_ZLIST (d->handlers, mh) {
-            if (!mh->running)
+        struct topic_node *n = d->topics;
+        const char *p = topic ? topic : "";
+        int i;
+
+        if (candidates_add (n, &cand, &count, &size, cand_inline) < 0)
+            goto done;
+        for (; *p != '\0'; p++) {
+            n = n->child;
+            while (n && n->c != *p)
+                n = n->sibling;
+            if (!n)
+                break;
+            if (candidates_add (n, &cand, &count, &size, cand_inline) < 0)
+                goto done;
+        }
+        candidates_sort (cand, count);
+        for (i = 0; i < count; i++) {
+            mh = cand[i];
+            if (mh->destroyed || !mh->running)
                 continue;
             if (flux_msg_cmp (msg, mh->match)) {
                 call_handler (mh, msg);
@@ -282,6 +448,16 @@ static bool dispatch_message (struct dispatch *d,
             }
         }
     }
+done:
+    if (cand != cand_inline)
+        free (cand);
+    if (--d->dispatch_depth == 0) {
+        while ((mh = d->destroyed)) {
+            d->destroyed = mh->destroyed_next;
+            free_msg_handler (mh);
+        }
+    }
+    dispatch_usecount_decr (d);
     return match;
 }
 
@@ -350,11 +526,6 @@ static void handle_cb (flux_reactor_t *r,
 
     const char *topic;
     flux_msg_get_topic (msg, &topic);
-    /* Add any new handlers here, making handler creation
-     * safe to call during handlers list traversal below.
-     */
-    if (transfer_items_zlist (d->handlers_new, d->handlers) < 0)
-        goto done;
 
 #if defined(HAVE_CALIPER)
     cali_begin_string (d->prof_msg_type, flux_msg_typestr (type));
@@ -484,22 +655,32 @@ void flux_msg_handler_destroy (flux_msg_handler_t *mh)
 {
     if (mh) {
         int saved_errno = errno;
+        struct dispatch *d;
         assert (mh->magic == HANDLER_MAGIC);
+        d = mh->d;
         if (mh->match.typemask == FLUX_MSGTYPE_RESPONSE
                             && mh->match.matchtag != FLUX_MATCHTAG_NONE) {
-            zhashx_delete (mh->d->handlers_rpc, &mh->match.matchtag);
+            zhashx_delete (d->handlers_rpc, &mh->match.matchtag);
         }
         else if (mh->match.typemask == FLUX_MSGTYPE_REQUEST
                             && !isa_multmatch (mh->match.topic_glob)) {
-            zhashx_delete (mh->d->handlers_method, mh->match.topic_glob);
-        }
-        else {
-            zlist_remove (mh->d->handlers_new, mh);
-            zlist_remove (mh->d->handlers, mh);
+            zhashx_delete (d->handlers_method, mh->match.topic_glob);
         }
+        else
+            topic_index_remove (mh);
         flux_msg_handler_stop (mh);
-        dispatch_usecount_decr (mh->d);
-        free_msg_handler (mh);
+        /* Defer free if called from a handler, see dispatch_message().
+         * The handler is linked into d->destroyed in place, so this
+         * cannot fail and free it while it is still a candidate.
+         */
+        if (d->dispatch_depth > 0) {
+            mh->destroyed = 1;
+            mh->destroyed_next = d->destroyed;
+            d->destroyed = mh;
+        }
+        else
+            free_msg_handler (mh);
+        dispatch_usecount_decr (d);
         errno = saved_errno;
     }
 }
@@ -546,19 +727,15 @@ flux_msg_handler_t *flux_msg_handler_create (flux_t *h,
         zhashx_update (d->handlers_method, mh->match.topic_glob, mh);
     }
     /* Request (glob), response (FLUX_MATCHTAG_NONE), events:
-     * Message handler is pushed to the front of the handlers list,
-     * and matches before older ones for requests and responses.
+     * Message handler is added to the topic trie.  Its sequence number
+     * causes it to match before older ones for requests and responses.
      * (Requests and responses in hashes above match first though).
      * Event messages are broadcast to all matching handlers.
      */
     else {
-        /* N.B. append(handlers_new); later, pop(handlers_new), push(handlers).
-         * Net effect: push(handlers).
-         */
-        if (zlist_append (d->handlers_new, mh) < 0) {
-            errno = ENOMEM;
+        mh->seq = d->seq++;
+        if (topic_index_add (d->topics, mh) < 0)
             goto error;
-        }
     }
     dispatch_usecount_incr (d);
     return mh;
@@ -1209,6 +1209,147 @@ void large_data (void)
     flux_buffer_destroy (fb);
 }
 
+void wraparound (void)
+{
+    flux_buffer_t *fb;
+    int pipefds[2];
+    struct iovec iov[2];
+    const char *ptr;
+    int len;
+    int n;
+
+    ok (pipe (pipefds) == 0,
+        "pipe succeeded");
+
+    /* 8 byte buffer, so data must wrap around the end of the ring */
+    ok ((fb = flux_buffer_create (8)) != NULL,
+        "flux_buffer_create works");
+
+    ok (flux_buffer_write (fb, "abcdef", 6) == 6,
+        "flux_buffer_write works");
+    ok (flux_buffer_drop (fb, 4) == 4,
+        "flux_buffer_drop works");
+    ok (flux_buffer_write (fb, "gh\nij", 5) == 5,
+        "flux_buffer_write wraps around end of buffer");
+    ok (flux_buffer_bytes (fb) == 7,
+        "flux_buffer_bytes returns correct length");
+    ok (flux_buffer_write (fb, "klm", 3) == 1,
+        "flux_buffer_write writes partial data when nearly full");
+    ok (flux_buffer_write (fb, "x", 1) < 0 && errno == ENOSPC,
+        "flux_buffer_write fails with ENOSPC when full");
+
+    ok ((n = flux_buffer_peek_iov (fb, -1, iov)) == 2,
+        "flux_buffer_peek_iov returns two iovecs for wrapped data");
+    ok (n == 2
+        && iov[0].iov_len + iov[1].iov_len == 8
+        && !memcmp (iov[0].iov_base, "efgh", 4)
+        && !memcmp (iov[1].iov_base, "\nijk", 4),
+        "flux_buffer_peek_iov returns expected data");
+
+    ok (flux_buffer_lines (fb) == 1,
+        "flux_buffer_lines counts line across wrap");
+    ok ((ptr = flux_buffer_peek (fb, -1, &len)) != NULL
+        && len == 8,
+        "flux_buffer_peek of wrapped data works");
+    ok (!memcmp (ptr, "efgh\nijk", 9),
+        "flux_buffer_peek returns expected data");
+    ok ((ptr = flux_buffer_read_line (fb, &len)) != NULL
+        && len == 5,
+        "flux_buffer_read_line works");
+    ok (!memcmp (ptr, "efgh\n", 6),
+        "flux_buffer_read_line returns expected data");
+
+    ok (flux_buffer_write_line (fb, "12345") < 0 && errno == ENOSPC,
+        "flux_buffer_write_line fails with ENOSPC if line does not fit");
+    ok (flux_buffer_write_line (fb, "1234") == 5,
+        "flux_buffer_write_line wraps around end of buffer");
+    ok ((ptr = flux_buffer_read (fb, 4, &len)) != NULL
+        && len == 4,
+        "flux_buffer_read works");
+    ok (!memcmp (ptr, "ijk1", 5),
+        "flux_buffer_read returns expected data");
+
+    ok (flux_buffer_read_to_fd (fb, pipefds[1], -1) == 4,
+        "flux_buffer_read_to_fd writes wrapped data");
+    ok (flux_buffer_bytes (fb) == 0,
+        "flux_buffer_bytes returns 0 after flux_buffer_read_to_fd");
+
+    /* empty ring restarts at offset 0, so wrap it again */
+    ok (flux_buffer_write (fb, "......", 6) == 6
+        && flux_buffer_drop (fb, 6) == 6,
+        "flux_buffer_write and flux_buffer_drop work");
+    ok (write (pipefds[1], "5678", 4) == 4,
+        "write to pipe works");
+    ok (flux_buffer_write_from_fd (fb, pipefds[0], 8) == 8,
+        "flux_buffer_write_from_fd reads into both halves of ring");
+    ok ((ptr = flux_buffer_read (fb, -1, &len)) != NULL
+        && len == 8,
+        "flux_buffer_read works");
+    ok (!memcmp (ptr, "234\n5678", 9),
+        "flux_buffer_read returns expected data");
+
+    /* reserve/commit */
+    ok (flux_buffer_write (fb, "ab", 2) == 2
+        && flux_buffer_drop (fb, 1) == 1,
+        "flux_buffer_write and flux_buffer_drop work");
+    ok ((n = flux_buffer_reserve_iov (fb, 6, iov)) == 1
+        && iov[0].iov_len == 6,
+        "flux_buffer_reserve_iov returns free space");
+    memcpy (iov[0].iov_base, "cdefgh", 6);
+    ok (flux_buffer_commit (fb, 6) == 6,
+        "flux_buffer_commit works");
+    ok ((n = flux_buffer_reserve_iov (fb, 7, iov)) == 1
+        && iov[0].iov_len == 1,
+        "flux_buffer_reserve_iov returns wrapped free space");
+    ok (flux_buffer_commit (fb, 2) < 0 && errno == EINVAL,
+        "flux_buffer_commit fails with EINVAL if more than reserved");
+    memcpy (iov[0].iov_base, "i", 1);
+    ok (flux_buffer_commit (fb, 1) == 1,
+        "flux_buffer_commit works");
+    ok (flux_buffer_reserve_iov (fb, 1, iov) < 0 && errno == ENOSPC,
+        "flux_buffer_reserve_iov fails with ENOSPC when full");
+    ok ((ptr = flux_buffer_read (fb, -1, &len)) != NULL
+        && len == 8
+        && !memcmp (ptr, "bcdefghi", 9),
+        "flux_buffer_read returns committed data");
+
+    flux_buffer_destroy (fb);
+    close (pipefds[0]);
+    close (pipefds[1]);
+}
+
+void grow_wrapped (void)
+{
+    flux_buffer_t *fb;
+    char data[6000];
+    const char *ptr;
+    int len;
+    int i;
+
+    for (i = 0; i < sizeof (data); i++)
+        data[i] = 'a' + (i % 26);
+
+    ok ((fb = flux_buffer_create (FLUX_BUFFER_TEST_MAXSIZE)) != NULL,
+        "flux_buffer_create works");
+
+    /* wrap data in the initial allocation, then force it to grow */
+    ok (flux_buffer_write (fb, data, 4000) == 4000
+        && flux_buffer_drop (fb, 3000) == 3000,
+        "flux_buffer_write and flux_buffer_drop work");
+    ok (flux_buffer_write (fb, data + 1000, 2000) == 2000,
+        "flux_buffer_write wraps around end of initial allocation");
+    ok (flux_buffer_write (fb, data + 3000, 3000) == 3000,
+        "flux_buffer_write grows wrapped buffer");
+    ok ((ptr = flux_buffer_read (fb, -1, &len)) != NULL
+        && len == 6000,
+        "flux_buffer_read works");
+    ok (!memcmp (ptr, data + 3000, 1000)
+        && !memcmp (ptr + 1000, data + 1000, 5000),
+        "flux_buffer_read returns data in order after growth");
+
+    flux_buffer_destroy (fb);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -1221,6 +1362,8 @@ int main (int argc, char *argv[])
     full_buffer ();
     readonly_buffer ();
     large_data ();
+    wraparound ();
+    grow_wrapped ();
 
     done_testing();
 
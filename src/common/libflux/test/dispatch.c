@@ -462,6 +462,92 @@ void test_cloned_dispatch (flux_t *orig)
     diag ("destroyed reactor, closed clone");
 }
 
+int order[16];
+int order_count;
+void order_cb (flux_t *h, flux_msg_handler_t *mh,
+               const flux_msg_t *msg, void *arg)
+{
+    int *id = arg;
+    if (order_count < 16)
+        order[order_count++] = *id;
+}
+
+flux_msg_handler_t *victim;
+void destroy_cb (flux_t *h, flux_msg_handler_t *mh,
+                 const flux_msg_t *msg, void *arg)
+{
+    flux_msg_handler_destroy (victim);
+    victim = NULL;
+}
+
+static int send_event (flux_t *h, const char *topic)
+{
+    flux_msg_t *msg;
+    int rc;
+
+    if (!(msg = flux_event_encode (topic, NULL)))
+        return -1;
+    rc = flux_send (h, msg, 0);
+    flux_msg_destroy (msg);
+    if (rc < 0)
+        return -1;
+    order_count = 0;
+    return flux_reactor_run (flux_get_reactor (h), FLUX_REACTOR_NOWAIT);
+}
+
+/* Verify that events are delivered to all matching exact and glob
+ * handlers, most recently registered first, and that a handler may
+ * destroy another one that matched the same event.
+ */
+void test_event_topics (flux_t *h)
+{
+    const char *globs[] = { NULL, "foo.*", "baz.*", "foo.bar", "f?o.bar" };
+    int ids[] = { 0, 1, 2, 3, 4 };
+    flux_msg_handler_t *mh[5];
+    flux_msg_handler_t *dmh;
+    struct flux_match m = FLUX_MATCH_EVENT;
+    int i;
+
+    for (i = 0; i < 5; i++) {
+        m.topic_glob = (char *)globs[i];
+        if (!(mh[i] = flux_msg_handler_create (h, m, order_cb, &ids[i])))
+            BAIL_OUT ("flux_msg_handler_create failed");
+        flux_msg_handler_start (mh[i]);
+    }
+    ok (send_event (h, "foo.bar") >= 0,
+        "sent foo.bar event and ran reactor");
+    ok (order_count == 4
+        && order[0] == 4 && order[1] == 3 && order[2] == 1 && order[3] == 0,
+        "exact and glob handlers were called, most recent first");
+    ok (send_event (h, "foo") >= 0,
+        "sent foo event and ran reactor");
+    ok (order_count == 1 && order[0] == 0,
+        "only the catch-all handler was called");
+    ok (send_event (h, "baz.x") >= 0,
+        "sent baz.x event and ran reactor");
+    ok (order_count == 2 && order[0] == 2 && order[1] == 0,
+        "glob and catch-all handlers were called");
+
+    m.topic_glob = "foo.bar";
+    ok ((dmh = flux_msg_handler_create (h, m, destroy_cb, NULL)) != NULL,
+        "created handler that destroys another handler");
+    flux_msg_handler_start (dmh);
+    victim = mh[1];
+    mh[1] = NULL;
+    ok (send_event (h, "foo.bar") >= 0,
+        "sent foo.bar event and ran reactor");
+    ok (victim == NULL
+        && order_count == 3
+        && order[0] == 4 && order[1] == 3 && order[2] == 0,
+        "handler destroyed during dispatch was not called");
+
+    flux_msg_handler_destroy (dmh);
+    for (i = 0; i < 5; i++)
+        flux_msg_handler_destroy (mh[i]);
+    ok (send_event (h, "foo.bar") >= 0 && order_count == 0,
+        "no handlers called after all were destroyed");
+}
+
 int main (int argc, char *argv[])
 {
     flux_t *h;
@@ -481,6 +567,7 @@ int main (int argc, char *argv[])
     test_request_catchall (h);
     test_response_catchall (h);
     test_response_with_routes (h);
+    test_event_topics (h);
 
     flux_close (h);
     done_testing();
@@ -678,6 +678,96 @@ void check_encode (void)
     flux_msg_destroy (msg2);
 }
 
+/* Encode/decode a message with more routes than fit inline,
+ * a long topic string, and a payload.
+ */
+void check_encode_full (void)
+{
+    flux_msg_t *msg, *msg2;
+    char topic[256];
+    char id[16];
+    const char *s;
+    const void *buf;
+    char *route;
+    void *enc;
+    size_t size;
+    int len;
+    int i;
+
+    memset (topic, 't', sizeof (topic) - 1);
+    topic[sizeof (topic) - 1] = '\0';
+
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_REQUEST))
+        || flux_msg_enable_route (msg) < 0
+        || flux_msg_set_topic (msg, topic) < 0
+        || flux_msg_set_string (msg, "payload") < 0)
+        BAIL_OUT ("failed to create test message");
+    for (i = 0; i < 20; i++) {
+        snprintf (id, sizeof (id), "%d", i);
+        if (flux_msg_push_route (msg, id) < 0)
+            BAIL_OUT ("flux_msg_push_route failed");
+    }
+    ok (flux_msg_frames (msg) == 24,
+        "message with 20 routes, topic, and payload has 24 frames");
+    size = flux_msg_encode_size (msg);
+    if (!(enc = malloc (size)))
+        BAIL_OUT ("out of memory");
+    ok (flux_msg_encode (msg, enc, size) == 0,
+        "flux_msg_encode works");
+    errno = 0;
+    ok (flux_msg_encode (msg, enc, size - 1) < 0 && errno == EINVAL,
+        "flux_msg_encode fails with EINVAL if buffer is too small");
+    ok ((msg2 = flux_msg_decode (enc, size)) != NULL,
+        "flux_msg_decode works");
+    ok (flux_msg_get_route_count (msg2) == 20,
+        "decoded message has 20 routes");
+    ok (flux_msg_get_route_first (msg2, &route) == 0
+        && route != NULL && !strcmp (route, "0"),
+        "decoded message has expected first route");
+    free (route);
+    ok (flux_msg_get_route_last (msg2, &route) == 0
+        && route != NULL && !strcmp (route, "19"),
+        "decoded message has expected last route");
+    free (route);
+    ok (flux_msg_get_topic (msg2, &s) == 0 && !strcmp (s, topic),
+        "decoded message has expected topic");
+    ok (flux_msg_get_string (msg2, &s) == 0 && !strcmp (s, "payload"),
+        "decoded message has expected payload");
+    flux_msg_destroy (msg2);
+
+    errno = 0;
+    ok (flux_msg_decode (enc, size - 1) == NULL && errno == EINVAL,
+        "flux_msg_decode fails with EINVAL on truncated buffer");
+    errno = 0;
+    ok (flux_msg_decode (enc, 0) == NULL && errno == EPROTO,
+        "flux_msg_decode fails with EPROTO on empty buffer");
+    errno = 0;
+    ok (flux_msg_decode (enc, 3) == NULL && errno == EPROTO,
+        "flux_msg_decode fails with EPROTO on message without PROTO frame");
+    free (enc);
+
+    /* A copy shares the payload, but setting a new payload on the
+     * copy must not affect the original.
+     */
+    ok ((msg2 = flux_msg_copy (msg, true)) != NULL,
+        "flux_msg_copy works");
+    ok (flux_msg_set_string (msg2, "changed") == 0,
+        "flux_msg_set_string on copy works");
+    ok (flux_msg_get_string (msg, &s) == 0 && !strcmp (s, "payload"),
+        "original payload is unchanged");
+    ok (flux_msg_get_payload (msg2, &buf, &len) == 0
+        && len == strlen ("changed") + 1,
+        "copy has new payload");
+    ok (flux_msg_pop_route (msg2, &route) == 0
+        && route != NULL && !strcmp (route, "19")
+        && flux_msg_get_route_count (msg) == 20,
+        "popping a route from copy does not affect original");
+    free (route);
+    flux_msg_destroy (msg2);
+
+    flux_msg_destroy (msg);
+}
+
 void check_sendzsock (void)
 {
     zsock_t *zsock[2] = { NULL, NULL };
@@ -1032,6 +1122,7 @@ int main (int argc, char *argv[])
     check_cmp ();
 
     check_encode ();
+    check_encode_full ();
     check_sendzsock ();
 
     check_params ();
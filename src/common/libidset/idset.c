@@ -288,6 +288,163 @@ bool idset_equal (const struct idset *idset1,
     return true;
 }
 
+/* Return the first id >= 'id' that is a member of both 'a' and 'b',
+ * or IDSET_INVALID_ID if there is none.  The sets take turns finding the
+ * successor of the other's candidate, so a run of ids present in only
+ * one set is skipped by a single vebsucc() call instead of being visited
+ * id by id.
+ */
+static unsigned int next_common (const struct idset *a,
+                                 const struct idset *b,
+                                 unsigned int id)
+{
+    unsigned int x, y;
+
+    x = vebsucc (a->T, id);
+    while (x < a->T.M) {
+        y = vebsucc (b->T, x);
+        if (y == x)
+            return x;
+        if (y >= b->T.M)
+            break;
+        x = vebsucc (a->T, y);
+    }
+    return IDSET_INVALID_ID;
+}
+
+/* Insert all ids of 'src' into 'dst', which must be large enough.
+ */
+static void idset_put_all (struct idset *dst, const struct idset *src)
+{
+    unsigned int id;
+
+    if (dst->count == 0 && dst->T.M == src->T.M) {
+        memcpy (dst->T.D, src->T.D, vebsize (src->T.M));
+        dst->count = src->count;
+        return;
+    }
+    id = vebsucc (src->T, 0);
+    while (id < src->T.M) {
+        idset_put (dst, id);
+        id = vebsucc (src->T, id + 1);
+    }
+}
+
+bool idset_has_intersection (const struct idset *a, const struct idset *b)
+{
+    if (!a || !b || a->count == 0 || b->count == 0)
+        return false;
+    return next_common (a, b, 0) != IDSET_INVALID_ID;
+}
+
+int idset_add (struct idset *a, const struct idset *b)
+{
+    if (!a || !b) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (b->count == 0)
+        return 0;
+    if (idset_grow (a, idset_last (b) + 1) < 0)
+        return -1;
+    idset_put_all (a, b);
+    return 0;
+}
+
+int idset_subtract (struct idset *a, const struct idset *b)
+{
+    unsigned int id;
+
+    if (!a || !b) {
+        errno = EINVAL;
+        return -1;
+    }
+    id = next_common (a, b, 0);
+    while (id != IDSET_INVALID_ID) {
+        vebdel (a->T, id);
+        a->count--;
+        id = next_common (a, b, id + 1);
+    }
+    return 0;
+}
+
+struct idset *idset_intersect (const struct idset *a, const struct idset *b)
+{
+    struct idset *result;
+    unsigned int id;
+
+    if (!a || !b) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(result = idset_create (a->T.M, a->flags)))
+        return NULL;
+    id = next_common (a, b, 0);
+    while (id != IDSET_INVALID_ID) {
+        vebput (result->T, id);
+        result->count++;
+        id = next_common (a, b, id + 1);
+    }
+    return result;
+}
+
+int idset_retain (struct idset *a, const struct idset *b)
+{
+    struct idset *result;
+    Veb T;
+
+    if (!(result = idset_intersect (a, b)))
+        return -1;
+    T = a->T;
+    a->T = result->T;
+    a->count = result->count;
+    result->T = T;
+    idset_destroy (result);
+    return 0;
+}
+
+struct idset *idset_union (const struct idset *a, const struct idset *b)
+{
+    struct idset *result;
+
+    if (!a || !b) {
+        errno = EINVAL;
+        return NULL;
+    }
+    /* Copy whichever idset is larger so that the result need not grow,
+     * then add the ids of the other one.
+     */
+    if (a->T.M >= b->T.M) {
+        if (!(result = idset_copy (a)))
+            return NULL;
+        idset_put_all (result, b);
+    }
+    else {
+        if (!(result = idset_copy (b)))
+            return NULL;
+        result->flags = a->flags;
+        idset_put_all (result, a);
+    }
+    return result;
+}
+
+struct idset *idset_difference (const struct idset *a, const struct idset *b)
+{
+    struct idset *result;
+
+    if (!a || !b) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(result = idset_copy (a)))
+        return NULL;
+    if (idset_subtract (result, b) < 0) {
+        idset_destroy (result);
+        return NULL;
+    }
+    return result;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -100,6 +100,34 @@ size_t idset_count (const struct idset *idset);
  */
 bool idset_equal (const struct idset *set1, const struct idset *set2);
 
+/* Set operations.
+ * idset_union() returns a new idset containing ids in 'a' or 'b'.
+ * idset_intersect() returns a new idset containing ids in both 'a' and 'b'.
+ * idset_difference() returns a new idset containing ids in 'a' but not 'b'.
+ * The result inherits the flags of 'a' and is large enough to hold it.
+ * Returns idset on success, or NULL on failure with errno set.
+ */
+struct idset *idset_union (const struct idset *a, const struct idset *b);
+struct idset *idset_intersect (const struct idset *a, const struct idset *b);
+struct idset *idset_difference (const struct idset *a, const struct idset *b);
+
+/* In-place set operations on 'a'.
+ * idset_add() adds the ids in 'b' to 'a'.  As with idset_set(), this fails
+ * with EINVAL if 'a' is too small and was not created with
+ * IDSET_FLAG_AUTOGROW.
+ * idset_subtract() removes the ids in 'b' from 'a'.
+ * idset_retain() removes the ids not in 'b' from 'a'.
+ * Return 0 on success, -1 on failure with errno set.
+ */
+int idset_add (struct idset *a, const struct idset *b);
+int idset_subtract (struct idset *a, const struct idset *b);
+int idset_retain (struct idset *a, const struct idset *b);
+
+/* Return true if 'a' and 'b' have at least one id in common.
+ * If either idset is invalid, return false.
+ */
+bool idset_has_intersection (const struct idset *a, const struct idset *b);
+
 /* Expand bracketed idset string(s) in 's', calling 'fun()' for each
  * expanded string.  'fun()' should return 0 on success, or -1 on failure
  * with errno set.  A fun() failure causes idset_format_map () to immediately
@@ -744,6 +744,112 @@ void issue_2336 (void)
     }
 }
 
+void test_set_ops (void)
+{
+    struct idset *a, *b, *c, *result;
+    char *s;
+
+    if (!(a = idset_decode ("1-10,100"))
+        || !(b = idset_decode ("5-20"))
+        || !(c = idset_decode ("200-300")))
+        BAIL_OUT ("idset_decode failed");
+
+    ok (idset_has_intersection (a, b) == true,
+        "idset_has_intersection [1-10,100] [5-20] is true");
+    ok (idset_has_intersection (a, c) == false,
+        "idset_has_intersection [1-10,100] [200-300] is false");
+    ok (idset_has_intersection (NULL, b) == false,
+        "idset_has_intersection (NULL, b) is false");
+
+    result = idset_union (a, b);
+    ok (result != NULL
+        && (s = idset_encode (result, IDSET_FLAG_RANGE)) != NULL
+        && !strcmp (s, "1-20,100"),
+        "idset_union [1-10,100] [5-20] = 1-20,100");
+    free (s);
+    idset_destroy (result);
+
+    result = idset_union (b, c);
+    ok (result != NULL
+        && (s = idset_encode (result, IDSET_FLAG_RANGE)) != NULL
+        && !strcmp (s, "5-20,200-300"),
+        "idset_union with larger second set works");
+    free (s);
+    idset_destroy (result);
+
+    result = idset_intersect (a, b);
+    ok (result != NULL
+        && (s = idset_encode (result, IDSET_FLAG_RANGE)) != NULL
+        && !strcmp (s, "5-10"),
+        "idset_intersect [1-10,100] [5-20] = 5-10");
+    free (s);
+    idset_destroy (result);
+
+    result = idset_intersect (a, c);
+    ok (result != NULL && idset_count (result) == 0,
+        "idset_intersect of disjoint sets is empty");
+    idset_destroy (result);
+
+    result = idset_difference (a, b);
+    ok (result != NULL
+        && (s = idset_encode (result, IDSET_FLAG_RANGE)) != NULL
+        && !strcmp (s, "1-4,100"),
+        "idset_difference [1-10,100] [5-20] = 1-4,100");
+    free (s);
+    idset_destroy (result);
+
+    errno = 0;
+    ok (idset_union (NULL, b) == NULL && errno == EINVAL,
+        "idset_union (NULL, b) fails with EINVAL");
+    errno = 0;
+    ok (idset_intersect (a, NULL) == NULL && errno == EINVAL,
+        "idset_intersect (a, NULL) fails with EINVAL");
+    errno = 0;
+    ok (idset_difference (NULL, NULL) == NULL && errno == EINVAL,
+        "idset_difference (NULL, NULL) fails with EINVAL");
+    errno = 0;
+    ok (idset_add (NULL, b) < 0 && errno == EINVAL,
+        "idset_add (NULL, b) fails with EINVAL");
+    errno = 0;
+    ok (idset_subtract (a, NULL) < 0 && errno == EINVAL,
+        "idset_subtract (a, NULL) fails with EINVAL");
+    errno = 0;
+    ok (idset_retain (NULL, b) < 0 && errno == EINVAL,
+        "idset_retain (NULL, b) fails with EINVAL");
+
+    /* In-place variants
+     */
+    if (!(result = idset_create (0, IDSET_FLAG_AUTOGROW)))
+        BAIL_OUT ("idset_create failed");
+    ok (idset_add (result, a) == 0 && idset_equal (result, a),
+        "idset_add to empty autogrow set copies ids");
+    ok (idset_add (result, c) == 0 && idset_count (result) == 112,
+        "idset_add grows the set as needed");
+    ok (idset_subtract (result, b) == 0
+        && (s = idset_encode (result, IDSET_FLAG_RANGE)) != NULL
+        && !strcmp (s, "1-4,100,200-300"),
+        "idset_subtract removes ids");
+    free (s);
+    ok (idset_retain (result, c) == 0 && idset_equal (result, c),
+        "idset_retain keeps only common ids");
+    ok (idset_retain (result, a) == 0 && idset_count (result) == 0,
+        "idset_retain of disjoint set empties it");
+    idset_destroy (result);
+
+    if (!(result = idset_create (16, 0)))
+        BAIL_OUT ("idset_create failed");
+    errno = 0;
+    ok (idset_add (result, c) < 0 && errno == EINVAL,
+        "idset_add fails with EINVAL if set is too small without AUTOGROW");
+    ok (idset_count (result) == 0,
+        "and set is unchanged");
+    idset_destroy (result);
+
+    idset_destroy (a);
+    idset_destroy (b);
+    idset_destroy (c);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -759,6 +865,7 @@ int main (int argc, char *argv[])
     test_range_clear ();
     test_equal ();
     test_copy ();
+    test_set_ops ();
     test_autogrow ();
     test_format_first ();
     test_format_map ();
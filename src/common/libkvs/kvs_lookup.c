@@ -22,6 +22,7 @@
 #include "kvs_lookup.h"
 #include "kvs_util_private.h"
 #include "treeobj.h"
+#include "src/common/libutil/errno_safe.h"
 
 struct lookup_ctx {
     flux_t *h;
@@ -29,10 +30,11 @@ struct lookup_ctx {
     char *atref;
     int flags;
 
+    const flux_msg_t *msg; // response message that results are decoded from
     json_t *treeobj;
     char *treeobj_str; // json_dumps of tree object returned from lookup
-    void *val_data;    // result of base64 decode of val object data
-    int val_len;
+    void *val_data;    // result of base64 decode of val object data,
+    int val_len;       //   or a copy of the raw value
     bool val_valid;
     json_t *val_obj;
     flux_kvsdir_t *dir;
@@ -49,6 +51,7 @@ static void free_ctx (struct lookup_ctx *ctx)
     if (ctx) {
         free (ctx->key);
         free (ctx->atref);
+        flux_msg_decref (ctx->msg);
         json_decref (ctx->treeobj);
         free (ctx->treeobj_str);
         free (ctx->val_data);
@@ -133,10 +136,11 @@ flux_future_t *flux_kvs_lookup (flux_t *h,
     if ((flags & FLUX_KVS_WATCH))
         rpc_flags |= FLUX_RPC_STREAMING;
     if (!(f = flux_rpc_pack (h, topic, FLUX_NODEID_ANY, rpc_flags,
-                             "{s:s s:s s:i}",
+                             "{s:s s:s s:i s:b}",
                              "key", key,
                              "namespace", ns,
-                             "flags", flags))) {
+                             "flags", flags,
+                             "rawval", 1))) {
         free_ctx (ctx);
         return NULL;
     }
@@ -171,10 +175,11 @@ flux_future_t *flux_kvs_lookupat (flux_t *h, int flags, const char *key,
         return NULL;
     }
     if (!(f = flux_rpc_pack (h, "kvs.lookup", FLUX_NODEID_ANY, 0,
-                             "{s:s s:i s:O}",
+                             "{s:s s:i s:O s:b}",
                              "key", key,
                              "flags", flags,
-                             "rootdir", obj))) {
+                             "rootdir", obj,
+                             "rawval", 1))) {
         free_ctx (ctx);
         json_decref (obj);
         return NULL;
@@ -189,20 +194,6 @@ flux_future_t *flux_kvs_lookupat (flux_t *h, int flags, const char *key,
     return f;
 }
 
-static int decode_treeobj (flux_future_t *f, json_t **treeobj)
-{
-    json_t *obj;
-
-    if (flux_rpc_get_unpack (f, "{s:o}", "val", &obj) < 0)
-        return -1;
-    if (treeobj_validate (obj) < 0) {
-        errno = EPROTO;
-        return -1;
-    }
-    *treeobj = obj;
-    return 0;
-}
-
 static struct lookup_ctx *get_lookup_ctx (flux_future_t *f)
 {
     struct lookup_ctx *ctx;
@@ -214,39 +205,94 @@ static struct lookup_ctx *get_lookup_ctx (flux_future_t *f)
     return ctx;
 }
 
-/* Parse the lookup response message, extracting the 'val' treeobj.
- * If decoded results were previously cached and the response has
- * changed (e.g. future has been reset and another response has arrived),
- * invalidate the cached results.
+static void invalidate_results (struct lookup_ctx *ctx)
+{
+    flux_msg_decref (ctx->msg);
+    ctx->msg = NULL;
+    json_decref (ctx->treeobj);
+    ctx->treeobj = NULL;
+    if (ctx->treeobj_str) {
+        free (ctx->treeobj_str);
+        ctx->treeobj_str = NULL;
+    }
+    if (ctx->val_valid) {
+        free (ctx->val_data);
+        ctx->val_data = NULL;
+        ctx->val_valid = false;
+    }
+    if (ctx->val_obj) {
+        json_decref (ctx->val_obj);
+        ctx->val_obj = NULL;
+    }
+    if (ctx->dir) {
+        flux_kvsdir_destroy (ctx->dir);
+        ctx->dir = NULL;
+    }
+}
+
+/* Parse the lookup response message, extracting the 'val' treeobj, or
+ * if the value was sent as raw bytes, a copy of them.  If decoded results
+ * were previously cached and the response has changed (e.g. future has
+ * been reset and another response has arrived), invalidate the cached
+ * results.
  */
 static int parse_response (flux_future_t *f, struct lookup_ctx *ctx)
 {
-    json_t *treeobj2;
+    const flux_msg_t *msg;
+    const void *payload;
+    int size;
+    json_t *o;
+    json_t *treeobj;
+    const void *data;
+    int len;
 
-    if (decode_treeobj (f, &treeobj2) < 0)
+    if (flux_future_get (f, (const void **)&msg) < 0)
         return -1;
-    if (!ctx->treeobj || !json_equal (ctx->treeobj, treeobj2)) {
-        json_decref (ctx->treeobj);
-        ctx->treeobj = json_incref (treeobj2);
-        if (ctx->treeobj_str) {
-            free (ctx->treeobj_str);
-            ctx->treeobj_str = NULL;
-        }
-        if (ctx->val_valid) {
-            free (ctx->val_data);
-            ctx->val_data = NULL;
-            ctx->val_valid = false;
-        }
-        if (ctx->val_obj) {
-            json_decref (ctx->val_obj);
-            ctx->val_obj = NULL;
-        }
-        if (ctx->dir) {
-            flux_kvsdir_destroy (ctx->dir);
-            ctx->dir = NULL;
+    if (msg == ctx->msg)
+        return 0;
+    if (flux_rpc_get_raw (f, &payload, &size) < 0)
+        return -1;
+    if (kvs_rawval_decode (payload, size, &o, &data, &len) < 0)
+        return -1;
+    invalidate_results (ctx);
+    if (data) {
+        if (!(ctx->val_data = malloc (len + 1)))
+            goto error;
+        memcpy (ctx->val_data, data, len);
+        ((char *)ctx->val_data)[len] = '\0';
+        ctx->val_len = len;
+        ctx->val_valid = true;
+        // N.B. val_data includes xtra 0 byte term not reflected in val_len
+    }
+    else {
+        if (json_unpack (o, "{s:o}", "val", &treeobj) < 0
+            || treeobj_validate (treeobj) < 0) {
+            errno = EPROTO;
+            goto error;
         }
+        ctx->treeobj = json_incref (treeobj);
     }
+    ctx->msg = flux_msg_incref (msg);
+    json_decref (o);
     return 0;
+error:
+    invalidate_results (ctx);
+    ERRNO_SAFE_WRAP (json_decref, o);
+    return -1;
+}
+
+/* A raw value has no treeobj until one is needed.
+ */
+static json_t *get_treeobj (struct lookup_ctx *ctx)
+{
+    if (!ctx->treeobj) {
+        if (!ctx->val_valid) {
+            errno = EPROTO;
+            return NULL;
+        }
+        ctx->treeobj = treeobj_create_val (ctx->val_data, ctx->val_len);
+    }
+    return ctx->treeobj;
 }
 
 int flux_kvs_lookup_get (flux_future_t *f, const char **value)
@@ -278,7 +324,10 @@ int flux_kvs_lookup_get_treeobj (flux_future_t *f, const char **treeobj)
     if (parse_response (f, ctx) < 0)
         return -1;
     if (!ctx->treeobj_str) {
-        if (!(ctx->treeobj_str = treeobj_encode (ctx->treeobj)))
+        json_t *treeobj;
+
+        if (!(treeobj = get_treeobj (ctx))
+            || !(ctx->treeobj_str = treeobj_encode (treeobj)))
             return -1;
     }
     if (treeobj)
@@ -347,8 +396,11 @@ int flux_kvs_lookup_get_dir (flux_future_t *f, const flux_kvsdir_t **dirp)
     if (parse_response (f, ctx) < 0)
         return -1;
     if (!ctx->dir) {
-        if (!(ctx->dir = kvsdir_create_fromobj (ctx->h, ctx->atref,
-                                                ctx->key, ctx->treeobj)))
+        json_t *treeobj;
+
+        if (!(treeobj = get_treeobj (ctx))
+            || !(ctx->dir = kvsdir_create_fromobj (ctx->h, ctx->atref,
+                                                   ctx->key, treeobj)))
             return -1;
     }
     if (dirp)
@@ -367,7 +419,7 @@ int flux_kvs_lookup_get_symlink (flux_future_t *f,
         return -1;
     if (parse_response (f, ctx) < 0)
         return -1;
-    if (!treeobj_is_symlink (ctx->treeobj)) {
+    if (!ctx->treeobj || !treeobj_is_symlink (ctx->treeobj)) {
         errno = EINVAL;
         return -1;
     }
@@ -16,8 +16,11 @@
 #include <stdbool.h>
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
+#include <jansson.h>
 
 #include "kvs.h"
+#include "kvs_util_private.h"
 
 char *kvs_util_normalize_key (const char *key, bool *want_directory)
 {
@@ -68,6 +71,96 @@ const char *kvs_get_namespace (void)
     return KVS_PRIMARY_NAMESPACE;
 }
 
+void *kvs_rawval_encode (json_t *o, const void *data, int len, int *size)
+{
+    json_t *n;
+    char *s = NULL;
+    char *payload;
+    size_t slen;
+
+    if (!o || !json_is_object (o) || len < 0 || (len > 0 && !data)
+        || !size) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(n = json_integer (len))
+        || json_object_set_new (o, "rawval", n) < 0) {
+        json_decref (n);
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (!(s = json_dumps (o, JSON_COMPACT))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    slen = strlen (s) + 1;
+    if (slen + len > INT_MAX) {
+        free (s);
+        errno = EOVERFLOW;
+        return NULL;
+    }
+    if (!(payload = malloc (slen + len))) {
+        free (s);
+        errno = ENOMEM;
+        return NULL;
+    }
+    memcpy (payload, s, slen);
+    if (len > 0)
+        memcpy (payload + slen, data, len);
+    free (s);
+    *size = slen + len;
+    return payload;
+}
+
+int kvs_rawval_decode (const void *payload,
+                       int size,
+                       json_t **op,
+                       const void **data,
+                       int *len)
+{
+    json_t *o;
+    json_t *rawval;
+    size_t slen;
+    int rawlen;
+
+    if (!payload || size <= 0 || !op) {
+        errno = EPROTO;
+        return -1;
+    }
+    /* JSON text never contains a NUL, so the first one terminates it.
+     */
+    slen = strnlen (payload, size);
+    if (slen == (size_t)size
+        || !(o = json_loadb (payload, slen, 0, NULL))) {
+        errno = EPROTO;
+        return -1;
+    }
+    rawlen = size - slen - 1;
+    if ((rawval = json_object_get (o, "rawval"))) {
+        if (!json_is_integer (rawval)
+            || json_integer_value (rawval) != rawlen)
+            goto error;
+        if (data)
+            *data = (const char *)payload + slen + 1;
+        if (len)
+            *len = rawlen;
+    }
+    else {
+        if (rawlen != 0)
+            goto error;
+        if (data)
+            *data = NULL;
+        if (len)
+            *len = 0;
+    }
+    *op = o;
+    return 0;
+error:
+    json_decref (o);
+    errno = EPROTO;
+    return -1;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
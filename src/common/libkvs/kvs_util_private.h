@@ -11,6 +11,9 @@
 #ifndef _FLUX_KVS_UTIL_H
 #define _FLUX_KVS_UTIL_H
 
+#include <stdbool.h>
+#include <jansson.h>
+
 /* Normalize a KVS key
  * Returns new key string (caller must free), or NULL with errno set.
  * On success, 'want_directory' is set to true if key had a trailing
@@ -22,6 +25,30 @@ char *kvs_util_normalize_key (const char *key, bool *want_directory);
  * if not set, return default */
 const char *kvs_get_namespace (void);
 
+/* A lookup response may carry its value as raw bytes rather than as a
+ * base64-encoded RFC 11 val object, if the requestor set "rawval":true
+ * in the request.  The payload is the compact JSON encoding of the
+ * response object, which includes "rawval":N, followed by a NUL and
+ * then the N raw bytes.  Clients that do not ask for it never see it.
+ *
+ * kvs_rawval_encode() sets "rawval" in 'o' and returns the encoded
+ * payload (caller must free), with its size in 'size'.
+ * Returns NULL on error with errno set.
+ */
+void *kvs_rawval_encode (json_t *o, const void *data, int len, int *size);
+
+/* Decode a lookup response payload in either form.  'op' is set to the
+ * response object (caller must json_decref).  If the payload carries a
+ * raw value, 'data' and 'len' are set to its location within 'payload',
+ * otherwise 'data' is set to NULL.  Returns -1 with errno = EPROTO if
+ * the payload is malformed.
+ */
+int kvs_rawval_decode (const void *payload,
+                       int size,
+                       json_t **op,
+                       const void **data,
+                       int *len);
+
 #endif  /* !_FLUX_KVS_UTIL_H */
 
 /*
@@ -14,6 +14,7 @@
 #include <stdbool.h>
 #include <string.h>
 #include <errno.h>
+#include <jansson.h>
 
 #include "src/common/libtap/tap.h"
 #include "src/common/libkvs/kvs_util_private.h"
@@ -64,12 +65,86 @@ void kvs_util_normalize_key_path_tests (void)
     free (s);
 }
 
+void kvs_rawval_tests (void)
+{
+    const char bin[] = { 'a', '\0', 'b', '\xff', '\0' };
+    json_t *o;
+    json_t *o2;
+    void *payload;
+    int size;
+    const void *data;
+    int len;
+    int rootseq;
+    const char *json = "{\"rootseq\":42}";
+
+    if (!(o = json_pack ("{s:i}", "rootseq", 42)))
+        BAIL_OUT ("json_pack failed");
+
+    payload = kvs_rawval_encode (o, bin, sizeof (bin), &size);
+    ok (payload != NULL && size > sizeof (bin),
+        "kvs_rawval_encode works");
+    ok (json_integer_value (json_object_get (o, "rawval")) == sizeof (bin),
+        "kvs_rawval_encode set rawval in the response object");
+
+    data = NULL;
+    len = -1;
+    ok (kvs_rawval_decode (payload, size, &o2, &data, &len) == 0,
+        "kvs_rawval_decode works");
+    ok (data != NULL && len == sizeof (bin)
+        && memcmp (data, bin, sizeof (bin)) == 0,
+        "kvs_rawval_decode returned the raw value");
+    ok (json_unpack (o2, "{s:i}", "rootseq", &rootseq) == 0
+        && rootseq == 42,
+        "kvs_rawval_decode returned the response object");
+    json_decref (o2);
+
+    errno = 0;
+    ok (kvs_rawval_decode (payload, size - 1, &o2, &data, &len) < 0
+        && errno == EPROTO,
+        "kvs_rawval_decode fails with EPROTO on truncated raw value");
+    free (payload);
+
+    payload = kvs_rawval_encode (o, NULL, 0, &size);
+    ok (payload != NULL,
+        "kvs_rawval_encode works with empty value");
+    ok (kvs_rawval_decode (payload, size, &o2, &data, &len) == 0
+        && data != NULL && len == 0,
+        "kvs_rawval_decode returned empty raw value");
+    json_decref (o2);
+    free (payload);
+
+    ok (kvs_rawval_decode (json, strlen (json) + 1, &o2, &data, &len) == 0
+        && data == NULL && len == 0,
+        "kvs_rawval_decode handles response without raw value");
+    json_decref (o2);
+
+    errno = 0;
+    ok (kvs_rawval_decode (json, strlen (json), &o2, &data, &len) < 0
+        && errno == EPROTO,
+        "kvs_rawval_decode fails with EPROTO on unterminated JSON");
+    errno = 0;
+    ok (kvs_rawval_decode ("{}\0x", 4, &o2, &data, &len) < 0
+        && errno == EPROTO,
+        "kvs_rawval_decode fails with EPROTO on unexpected trailing data");
+    errno = 0;
+    ok (kvs_rawval_decode ("{\0", 3, &o2, &data, &len) < 0
+        && errno == EPROTO,
+        "kvs_rawval_decode fails with EPROTO on bad JSON");
+    errno = 0;
+    ok (kvs_rawval_encode (NULL, bin, sizeof (bin), &size) == NULL
+        && errno == EINVAL,
+        "kvs_rawval_encode fails with EINVAL on NULL object");
+
+    json_decref (o);
+}
+
 int main (int argc, char *argv[])
 {
 
     plan (NO_PLAN);
 
     kvs_util_normalize_key_path_tests ();
+    kvs_rawval_tests ();
 
     done_testing ();
     return (0);
@@ -801,6 +801,131 @@ void test_corner_cases (void)
     json_decref (symlink);
 }
 
+void test_hdir (void)
+{
+    json_t *hdir, *hdir2, *dir, *dirref, *val, *o;
+    const json_t *shard;
+    char name[64];
+    int i, index;
+
+    ok (treeobj_create_hdir (-1) == NULL && errno == EINVAL,
+        "treeobj_create_hdir level=-1 fails with EINVAL");
+    ok (treeobj_create_hdir (TREEOBJ_HDIR_MAXLEVEL + 1) == NULL
+        && errno == EINVAL,
+        "treeobj_create_hdir level=MAXLEVEL+1 fails with EINVAL");
+
+    hdir = treeobj_create_hdir (0);
+    ok (hdir != NULL,
+        "treeobj_create_hdir works");
+    diag_json (hdir);
+    ok (treeobj_is_hdir (hdir),
+        "treeobj_is_hdir returns true");
+    ok (!treeobj_is_dir (hdir),
+        "treeobj_is_dir returns false");
+    ok (treeobj_validate (hdir) == 0,
+        "treeobj_validate works on empty hdir");
+    ok (treeobj_hdir_get_level (hdir) == 0,
+        "treeobj_hdir_get_level returns 0");
+    ok (treeobj_get_count (hdir) == 0,
+        "treeobj_get_count returns 0");
+
+    index = treeobj_hdir_index (hdir, "foo");
+    ok (index >= 0 && index < TREEOBJ_HDIR_FANOUT,
+        "treeobj_hdir_index returns index in range");
+    ok (treeobj_hdir_index (hdir, NULL) < 0 && errno == EINVAL,
+        "treeobj_hdir_index name=NULL fails with EINVAL");
+    ok (treeobj_hdir_peek_shard (hdir, index) == NULL && errno == ENOENT,
+        "treeobj_hdir_peek_shard on empty shard fails with ENOENT");
+    ok (treeobj_hdir_peek_shard (hdir, TREEOBJ_HDIR_FANOUT) == NULL
+        && errno == EINVAL,
+        "treeobj_hdir_peek_shard index=FANOUT fails with EINVAL");
+
+    /* insert/get/delete are routed to the shard
+     */
+    val = treeobj_create_val ("a", 1);
+    ok (treeobj_insert_entry (hdir, "foo", val) == 0,
+        "treeobj_insert_entry works on hdir");
+    ok ((shard = treeobj_hdir_peek_shard (hdir, index)) != NULL
+        && treeobj_is_dir (shard),
+        "shard was created as a dir");
+    ok (treeobj_peek_entry (shard, "foo") != NULL,
+        "entry was inserted in shard");
+    ok ((o = treeobj_get_entry (hdir, "foo")) != NULL
+        && json_equal (o, val),
+        "treeobj_get_entry works on hdir");
+    ok (treeobj_peek_entry (hdir, "foo") != NULL,
+        "treeobj_peek_entry works on hdir");
+    ok (treeobj_get_count (hdir) == 1,
+        "treeobj_get_count returns 1");
+    ok (treeobj_validate (hdir) == 0,
+        "treeobj_validate works");
+    ok (treeobj_delete_entry (hdir, "foo") == 0,
+        "treeobj_delete_entry works on hdir");
+    ok (treeobj_get_entry (hdir, "foo") == NULL && errno == ENOENT,
+        "treeobj_get_entry fails with ENOENT after delete");
+    ok (treeobj_get_count (hdir) == 0,
+        "treeobj_get_count returns 0");
+
+    /* set shard
+     */
+    ok (treeobj_hdir_set_shard (hdir, index, val) < 0 && errno == EINVAL,
+        "treeobj_hdir_set_shard fails with EINVAL on val shard");
+    hdir2 = treeobj_create_hdir (0);
+    ok (treeobj_hdir_set_shard (hdir, index, hdir2) < 0 && errno == EINVAL,
+        "treeobj_hdir_set_shard fails with EINVAL on wrong level hdir");
+    json_decref (hdir2);
+    hdir2 = treeobj_create_hdir (1);
+    ok (treeobj_hdir_set_shard (hdir, index, hdir2) == 0,
+        "treeobj_hdir_set_shard works with next level hdir");
+    json_decref (hdir2);
+    ok (treeobj_insert_entry (hdir, "foo", val) == 0
+        && treeobj_get_entry (hdir, "foo") != NULL,
+        "treeobj_insert_entry works through two levels");
+    ok (treeobj_validate (hdir) == 0,
+        "treeobj_validate works on two level hdir");
+    ok (treeobj_get_count (hdir) == 1,
+        "treeobj_get_count returns 1");
+
+    dirref = treeobj_create_dirref (blobrefs[0]);
+    ok (treeobj_hdir_set_shard (hdir, index, dirref) == 0,
+        "treeobj_hdir_set_shard works with dirref");
+    json_decref (dirref);
+    ok (treeobj_get_entry (hdir, "foo") == NULL && errno == ENODATA,
+        "treeobj_get_entry fails with ENODATA on dirref shard");
+    ok (treeobj_insert_entry (hdir, "foo", val) < 0 && errno == ENODATA,
+        "treeobj_insert_entry fails with ENODATA on dirref shard");
+    ok (treeobj_get_count (hdir) < 0 && errno == ENODATA,
+        "treeobj_get_count fails with ENODATA on dirref shard");
+    ok (treeobj_hdir_set_shard (hdir, index, NULL) == 0
+        && treeobj_hdir_peek_shard (hdir, index) == NULL && errno == ENOENT,
+        "treeobj_hdir_set_shard shard=NULL empties the slot");
+    json_decref (val);
+    json_decref (hdir);
+
+    /* convert a large dir
+     */
+    if (!(dir = create_large_dir ()))
+        BAIL_OUT ("could not create %d-entry dir", large_dir_entries);
+    ok (treeobj_hdir_create_from_dir (NULL, 0) == NULL && errno == EINVAL,
+        "treeobj_hdir_create_from_dir dir=NULL fails with EINVAL");
+    hdir = treeobj_hdir_create_from_dir (dir, 0);
+    ok (hdir != NULL,
+        "treeobj_hdir_create_from_dir works");
+    ok (treeobj_validate (hdir) == 0,
+        "treeobj_validate works");
+    ok (treeobj_get_count (hdir) == large_dir_entries,
+        "treeobj_get_count returns %d", large_dir_entries);
+    for (i = 0; i < large_dir_entries; i++) {
+        snprintf (name, sizeof (name), "entry-%.10d", i);
+        if (!treeobj_peek_entry (hdir, name))
+            break;
+    }
+    ok (i == large_dir_entries,
+        "all entries can be found in hdir");
+    json_decref (hdir);
+    json_decref (dir);
+}
+
 int main(int argc, char** argv)
 {
     plan (NO_PLAN);
@@ -814,6 +939,7 @@ int main(int argc, char** argv)
     test_deep_copy ();
     test_symlink ();
     test_corner_cases ();
+    test_hdir ();
 
     test_codec ();
 
@@ -24,6 +24,10 @@
 
 static const int treeobj_version = 1;
 
+static int treeobj_hdir_peek (const json_t *obj,
+                              int *levelp,
+                              const json_t **shardsp);
+
 static int treeobj_unpack (json_t *obj, const char **typep, json_t **datap)
 {
     json_t *data;
@@ -101,6 +105,27 @@ int treeobj_validate (const json_t *obj)
                 goto inval;
         }
     }
+    else if (!strcmp (type, "hdir")) {
+        const json_t *shards;
+        int level;
+        size_t i;
+        if (treeobj_hdir_peek (obj, &level, &shards) < 0)
+            goto inval;
+        json_array_foreach (shards, i, o) {
+            if (json_is_null (o))
+                continue;
+            if (treeobj_validate (o) < 0)
+                goto inval;
+            if (treeobj_is_hdir (o)) {
+                int sublevel;
+                if (treeobj_hdir_peek (o, &sublevel, NULL) < 0
+                    || sublevel != level + 1)
+                    goto inval;
+            }
+            else if (!treeobj_is_dir (o) && !treeobj_is_dirref (o))
+                goto inval;
+        }
+    }
     else if (!strcmp (type, "symlink")) {
         json_t *o;
         if (!json_is_object (data))
@@ -166,6 +191,170 @@ bool treeobj_is_dirref (const json_t *obj)
     return type && !strcmp (type, "dirref");
 }
 
+bool treeobj_is_hdir (const json_t *obj)
+{
+    const char *type = treeobj_get_type (obj);
+    return type && !strcmp (type, "hdir");
+}
+
+/* Unpack hdir data, checking that it is well formed.
+ */
+static int treeobj_hdir_peek (const json_t *obj,
+                              int *levelp,
+                              const json_t **shardsp)
+{
+    const char *type;
+    const json_t *data;
+    json_t *shards;
+    int level;
+
+    if (treeobj_peek (obj, &type, &data) < 0
+        || strcmp (type, "hdir") != 0
+        || json_unpack ((json_t *)data, "{s:i s:o !}",
+                                        "level", &level,
+                                        "shards", &shards) < 0
+        || level < 0
+        || level > TREEOBJ_HDIR_MAXLEVEL
+        || !json_is_array (shards)
+        || json_array_size (shards) != TREEOBJ_HDIR_FANOUT) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (levelp)
+        *levelp = level;
+    if (shardsp)
+        *shardsp = shards;
+    return 0;
+}
+
+/* 32-bit FNV-1a.  This is part of the hdir format and must not change.
+ */
+static uint32_t hdir_hash (const char *name)
+{
+    uint32_t hash = 2166136261u;
+
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int hdir_index (int level, const char *name)
+{
+    return (hdir_hash (name) >> (level * TREEOBJ_HDIR_BITS))
+           & (TREEOBJ_HDIR_FANOUT - 1);
+}
+
+int treeobj_hdir_get_level (const json_t *obj)
+{
+    int level;
+
+    if (treeobj_hdir_peek (obj, &level, NULL) < 0)
+        return -1;
+    return level;
+}
+
+int treeobj_hdir_index (const json_t *obj, const char *name)
+{
+    int level;
+
+    if (!name || treeobj_hdir_peek (obj, &level, NULL) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return hdir_index (level, name);
+}
+
+const json_t *treeobj_hdir_peek_shard (const json_t *obj, int index)
+{
+    const json_t *shards;
+    const json_t *shard;
+
+    if (index < 0
+        || index >= TREEOBJ_HDIR_FANOUT
+        || treeobj_hdir_peek (obj, NULL, &shards) < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    shard = json_array_get (shards, index);
+    if (!shard || json_is_null (shard)) {
+        errno = ENOENT;
+        return NULL;
+    }
+    return shard;
+}
+
+json_t *treeobj_hdir_get_shard (json_t *obj, int index)
+{
+    return (json_t *)treeobj_hdir_peek_shard (obj, index);
+}
+
+int treeobj_hdir_set_shard (json_t *obj, int index, json_t *shard)
+{
+    const json_t *shards;
+    int level;
+
+    if (index < 0
+        || index >= TREEOBJ_HDIR_FANOUT
+        || treeobj_hdir_peek (obj, &level, &shards) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (shard) {
+        if (treeobj_is_hdir (shard)) {
+            if (treeobj_hdir_get_level (shard) != level + 1) {
+                errno = EINVAL;
+                return -1;
+            }
+        }
+        else if (!treeobj_is_dir (shard) && !treeobj_is_dirref (shard)) {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    if (json_array_set ((json_t *)shards,
+                        index,
+                        shard ? shard : json_null ()) < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+/* Descend from hdir 'obj' through in-memory shards to the dir that
+ * holds 'name'.  If the shard is empty and 'create' is true, an empty dir
+ * shard is added, otherwise fail with ENOENT.  If the path to the shard
+ * crosses a dirref, fail with ENODATA - the caller must load it.
+ */
+static json_t *hdir_lookup_shard (json_t *obj, const char *name, bool create)
+{
+    while (treeobj_is_hdir (obj)) {
+        int index = treeobj_hdir_index (obj, name);
+        json_t *shard;
+
+        if (index < 0)
+            return NULL;
+        if (!(shard = treeobj_hdir_get_shard (obj, index))) {
+            if (errno != ENOENT || !create)
+                return NULL;
+            if (!(shard = treeobj_create_dir ()))
+                return NULL;
+            if (treeobj_hdir_set_shard (obj, index, shard) < 0) {
+                json_decref (shard);
+                return NULL;
+            }
+            json_decref (shard);
+        }
+        else if (treeobj_is_dirref (shard)) {
+            errno = ENODATA;
+            return NULL;
+        }
+        obj = shard;
+    }
+    return obj;
+}
+
 json_t *treeobj_get_data (json_t *obj)
 {
     json_t *data;
@@ -264,6 +453,27 @@ int treeobj_get_count (const json_t *obj)
     else if (!strcmp (type, "dir")) {
         count = json_object_size (data);
     }
+    else if (!strcmp (type, "hdir")) {
+        const json_t *shards;
+        const json_t *o;
+        size_t i;
+
+        if (treeobj_hdir_peek (obj, NULL, &shards) < 0)
+            return -1;
+        count = 0;
+        json_array_foreach (shards, i, o) {
+            int n;
+            if (json_is_null (o))
+                continue;
+            if (treeobj_is_dirref (o)) {
+                errno = ENODATA;
+                return -1;
+            }
+            if ((n = treeobj_get_count (o)) < 0)
+                return -1;
+            count += n;
+        }
+    }
     else if (!strcmp (type, "symlink") || !strcmp (type, "val")) {
         count = 1;
     } else {
@@ -279,6 +489,10 @@ json_t *treeobj_get_entry (json_t *obj, const char *name)
     const char *type;
     json_t *data, *obj2;
 
+    if (name && treeobj_is_hdir (obj)) {
+        if (!(obj = hdir_lookup_shard (obj, name, false)))
+            return NULL;
+    }
     if (treeobj_unpack (obj, &type, &data) < 0
             || strcmp (type, "dir") != 0) {
         errno = EINVAL;
@@ -296,6 +510,10 @@ int treeobj_delete_entry (json_t *obj, const char *name)
     const char *type;
     json_t *data;
 
+    if (name && treeobj_is_hdir (obj)) {
+        if (!(obj = hdir_lookup_shard (obj, name, false)))
+            return -1;
+    }
     if (treeobj_unpack (obj, &type, &data) < 0
             || strcmp (type, "dir") != 0) {
         errno = EINVAL;
@@ -313,6 +531,10 @@ int treeobj_insert_entry (json_t *obj, const char *name, json_t *obj2)
     const char *type;
     json_t *data;
 
+    if (name && obj2 && treeobj_is_hdir (obj)) {
+        if (!(obj = hdir_lookup_shard (obj, name, true)))
+            return -1;
+    }
     if (!name || !obj2 || treeobj_unpack (obj, &type, &data) < 0
             || strcmp (type, "dir") != 0
             || treeobj_validate (obj2) < 0) {
@@ -335,6 +557,10 @@ int treeobj_insert_entry_novalidate (json_t *obj,
     const char *type;
     json_t *data;
 
+    if (name && obj2 && treeobj_is_hdir (obj)) {
+        if (!(obj = hdir_lookup_shard (obj, name, true)))
+            return -1;
+    }
     if (!name || !obj2 || treeobj_unpack (obj, &type, &data) < 0
             || strcmp (type, "dir") != 0
             || treeobj_peek (obj2, NULL, NULL) < 0) {
@@ -353,6 +579,12 @@ const json_t *treeobj_peek_entry (const json_t *obj, const char *name)
     const char *type;
     const json_t *data, *obj2;
 
+    /* N.B. it is safe to cast away const here since 'create' is false.
+     */
+    if (name && treeobj_is_hdir (obj)) {
+        if (!(obj = hdir_lookup_shard ((json_t *)obj, name, false)))
+            return NULL;
+    }
     if (treeobj_peek (obj, &type, &data) < 0
             || strcmp (type, "dir") != 0) {
         errno = EINVAL;
@@ -470,6 +702,67 @@ json_t *treeobj_create_dir (void)
     return obj;
 }
 
+json_t *treeobj_create_hdir (int level)
+{
+    json_t *shards;
+    json_t *obj;
+    int i;
+
+    if (level < 0 || level > TREEOBJ_HDIR_MAXLEVEL) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(shards = json_array ()))
+        goto nomem;
+    for (i = 0; i < TREEOBJ_HDIR_FANOUT; i++) {
+        if (json_array_append (shards, json_null ()) < 0) {
+            json_decref (shards);
+            goto nomem;
+        }
+    }
+    /* obj takes reference to "shards" */
+    if (!(obj = json_pack ("{s:i s:s s:{s:i s:o}}",
+                           "ver", treeobj_version,
+                           "type", "hdir",
+                           "data",
+                             "level", level,
+                             "shards", shards))) {
+        json_decref (shards);
+        goto nomem;
+    }
+    return obj;
+nomem:
+    errno = ENOMEM;
+    return NULL;
+}
+
+json_t *treeobj_hdir_create_from_dir (const json_t *dir, int level)
+{
+    const char *type;
+    const json_t *data;
+    const char *name;
+    json_t *o;
+    json_t *hdir;
+
+    if (treeobj_peek (dir, &type, &data) < 0 || strcmp (type, "dir") != 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(hdir = treeobj_create_hdir (level)))
+        return NULL;
+    /* N.B. entries are shared with 'dir', not copied.
+     */
+    json_object_foreach ((json_t *)data, name, o) {
+        if (treeobj_insert_entry_novalidate (hdir, name, o) < 0) {
+            int saved_errno = errno;
+            json_decref (hdir);
+            errno = saved_errno;
+            return NULL;
+        }
+    }
+    return hdir;
+}
+
 json_t *treeobj_create_symlink (const char *ns, const char *target)
 {
     json_t *data, *obj;
@@ -13,6 +13,7 @@
 
 #include <jansson.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* See RFC 11 */
 
@@ -28,6 +29,7 @@ json_t *treeobj_create_val (const void *data, int len);
 json_t *treeobj_create_valref (const char *blobref);
 json_t *treeobj_create_dir (void);
 json_t *treeobj_create_dirref (const char *blobref);
+json_t *treeobj_create_hdir (int level);
 
 /* Validate treeobj, recursively.
  * Return 0 if valid, -1 with errno = EINVAL if invalid.
@@ -45,6 +47,7 @@ bool treeobj_is_val (const json_t *obj);
 bool treeobj_is_valref (const json_t *obj);
 bool treeobj_is_dir (const json_t *obj);
 bool treeobj_is_dirref (const json_t *obj);
+bool treeobj_is_hdir (const json_t *obj);
 
 /* get type-specific value.
  * For dirref/valref, this is an array of blobrefs.
@@ -72,8 +75,10 @@ int treeobj_decode_val (const json_t *obj, void **data, int *len);
 /* get type-specific count.
  * For dirref/valref, this is the number of blobrefs.
  * For directory, this is number of entries
+ * For hdir, this is the number of entries, if all shards are in memory.
  * For symlink or val, this is 1.
- * Return count on success, -1 on error with errno = EINVAL.
+ * Return count on success, -1 on error with errno = EINVAL,
+ * or ENODATA if an hdir shard is a dirref.
  */
 int treeobj_get_count (const json_t *obj);
 
@@ -81,6 +86,8 @@ int treeobj_get_count (const json_t *obj);
  * Get returns JSON object (owned by 'obj', do not destory), NULL on error.
  * insert takes a reference on 'obj2' (caller retains ownership).
  * insert/delete return 0 on success, -1 on error with errno set.
+ * 'obj' may be an hdir, in which case the operation is applied to the
+ * shard holding 'name'.  If that shard is a dirref, fail with ENODATA.
  */
 json_t *treeobj_get_entry (json_t *obj, const char *name);
 int treeobj_insert_entry (json_t *obj, const char *name, json_t *obj2);
@@ -101,6 +108,41 @@ int treeobj_insert_entry_novalidate (json_t *obj,
  */
 const json_t *treeobj_peek_entry (const json_t *obj, const char *name);
 
+/* Sharded directory (hdir)
+ * An hdir is a directory whose entries are spread over TREEOBJ_HDIR_FANOUT
+ * shards according to a hash of the entry name.  Each shard is empty, a
+ * dir, a dirref, or an hdir of the next level, which uses the next
+ * TREEOBJ_HDIR_BITS bits of the hash.  Only the shards along the path to
+ * a modified entry need to be rewritten when the directory changes.
+ */
+#define TREEOBJ_HDIR_BITS       6
+#define TREEOBJ_HDIR_FANOUT     (1 << TREEOBJ_HDIR_BITS)
+#define TREEOBJ_HDIR_MAXLEVEL   4
+
+/* Get the level of an hdir (0 for the top), or -1 with errno = EINVAL.
+ */
+int treeobj_hdir_get_level (const json_t *obj);
+
+/* Get the index of the shard of 'obj' that holds 'name'.
+ * Return index on success, -1 on error with errno = EINVAL.
+ */
+int treeobj_hdir_index (const json_t *obj, const char *name);
+
+/* get/peek/set shard 'index' of hdir.
+ * Get/peek return shard (owned by 'obj'), or NULL with errno = ENOENT
+ * if the shard is empty, or EINVAL on error.
+ * set takes a reference on 'shard' (caller retains ownership).  'shard'
+ * may be NULL to empty the slot.  Return 0 on success, -1 on error.
+ */
+json_t *treeobj_hdir_get_shard (json_t *obj, int index);
+const json_t *treeobj_hdir_peek_shard (const json_t *obj, int index);
+int treeobj_hdir_set_shard (json_t *obj, int index, json_t *shard);
+
+/* Create an hdir of 'level' holding the entries of dir object 'dir'.
+ * Entries are shared with 'dir', not copied.
+ */
+json_t *treeobj_hdir_create_from_dir (const json_t *dir, int level);
+
 /* Shallow copy a treeobj
  * Note that this is not a shallow copy on the json object, but is a
  * shallow copy on the data within a tree object.  For example, for a
@@ -23,11 +23,12 @@
 #include "src/common/libpmi/pmi.h"
 #include "src/common/libpmi/pmi_strerror.h"
 
-#define OPTIONS "nN:l:"
+#define OPTIONS "nN:l:c:"
 static const struct option longopts[] = {
     {"n-squared",    no_argument,        0, 'n'},
     {"key-count",    required_argument,  0, 'N'},
     {"library",      required_argument,  0, 'l'},
+    {"cycles",       required_argument,  0, 'c'},
     {0, 0, 0, 0},
 };
 
@@ -40,6 +41,7 @@ int main(int argc, char *argv[])
     bool nsquared = false;
     int ch;
     int i, j, keycount = 1;
+    int c, cycles = 1;
     char *library = NULL;
 
     while ((ch = getopt_long (argc, argv, OPTIONS, longopts, NULL)) != -1) {
@@ -53,6 +55,9 @@ int main(int argc, char *argv[])
             case 'l':   /* --library */
                 library = optarg;
                 break;
+            case 'c':   /* --cycles N */
+                cycles = strtoul (optarg, NULL, 10);
+                break;
         }
     }
 
@@ -99,60 +104,64 @@ int main(int argc, char *argv[])
     if (e != PMI_SUCCESS)
         log_msg_exit ("%d: PMI_KVS_Get_my_name: %s", rank, pmi_strerror (e));
 
-    /* Put phase
-     * (keycount * PUT) + COMMIT + BARRIER
+    /* Repeat put / barrier / get for each cycle, using new keys each time.
      */
-    monotime (&t);
-    for (i = 0; i < keycount; i++) {
-        snprintf (key, key_len, "kvstest-%d-%d", rank, i);
-        snprintf (val, val_len, "sandwich.%d.%d", rank, i);
-        e = PMI_KVS_Put (kvsname, key, val);
+    for (c = 0; c < cycles; c++) {
+        /* Put phase
+         * (keycount * PUT) + COMMIT + BARRIER
+         */
+        monotime (&t);
+        for (i = 0; i < keycount; i++) {
+            snprintf (key, key_len, "kvstest-%d-%d-%d", c, rank, i);
+            snprintf (val, val_len, "sandwich.%d.%d.%d", c, rank, i);
+            e = PMI_KVS_Put (kvsname, key, val);
+            if (e != PMI_SUCCESS)
+                log_msg_exit ("%d: PMI_KVS_Put: %s", rank, pmi_strerror (e));
+        }
+        e = PMI_KVS_Commit (kvsname);
         if (e != PMI_SUCCESS)
-            log_msg_exit ("%d: PMI_KVS_Put: %s", rank, pmi_strerror (e));
-    }
-    e = PMI_KVS_Commit (kvsname);
-    if (e != PMI_SUCCESS)
-        log_msg_exit ("%d: PMI_KVS_Commit: %s", rank, pmi_strerror (e));
-    e = PMI_Barrier ();
-    if (e != PMI_SUCCESS)
-        log_msg_exit ("%d: PMI_Barrier: %s", rank, pmi_strerror (e));
-    if (rank == 0)
-        printf ("%d: put phase: %.3f msec\n", rank, monotime_since (t));
+            log_msg_exit ("%d: PMI_KVS_Commit: %s", rank, pmi_strerror (e));
+        e = PMI_Barrier ();
+        if (e != PMI_SUCCESS)
+            log_msg_exit ("%d: PMI_Barrier: %s", rank, pmi_strerror (e));
+        if (rank == 0)
+            printf ("%d: put phase: %.3f msec\n", rank, monotime_since (t));
 
-    /* Get phase
-     * no options:    (keycount * GET) + BARRIER
-     * --n-squared:   (keycount * GET * size) + BARRIER
-     */
-    monotime (&t);
-    for (i = 0; i < keycount; i++) {
-        if (nsquared) {
-            for (j = 0; j < size; j++) {
-                snprintf (key, key_len, "kvstest-%d-%d", j, i);
+        /* Get phase
+         * no options:    (keycount * GET) + BARRIER
+         * --n-squared:   (keycount * GET * size) + BARRIER
+         */
+        monotime (&t);
+        for (i = 0; i < keycount; i++) {
+            if (nsquared) {
+                for (j = 0; j < size; j++) {
+                    snprintf (key, key_len, "kvstest-%d-%d-%d", c, j, i);
+                    e = PMI_KVS_Get (kvsname, key, val, val_len);
+                    if (e != PMI_SUCCESS)
+                        log_msg_exit ("%d: PMI_KVS_Get: %s", rank, pmi_strerror (e));
+                    snprintf (val2, val_len, "sandwich.%d.%d.%d", c, j, i);
+                    if (strcmp (val, val2) != 0)
+                        log_msg_exit ("%d: PMI_KVS_Get: exp %s got %s\n",
+                                 rank, val2, val);
+                }
+            } else {
+                snprintf (key, key_len, "kvstest-%d-%d-%d", c,
+                          rank > 0 ? rank - 1 : size - 1, i);
                 e = PMI_KVS_Get (kvsname, key, val, val_len);
                 if (e != PMI_SUCCESS)
-                    log_msg_exit ("%d: PMI_KVS_Get: %s", rank, pmi_strerror (e));
-                snprintf (val2, val_len, "sandwich.%d.%d", j, i);
+                    log_msg_exit ("%d: PMI_IVS_Get: %s", rank, pmi_strerror (e));
+                snprintf (val2, val_len, "sandwich.%d.%d.%d", c,
+                          rank > 0 ? rank - 1 : size - 1, i);
                 if (strcmp (val, val2) != 0)
-                    log_msg_exit ("%d: PMI_KVS_Get: exp %s got %s\n",
-                             rank, val2, val);
+                    log_msg_exit ("%d: PMI_KVS_Get: exp %s got %s\n", rank, val2, val);
             }
-        } else {
-            snprintf (key, key_len, "kvstest-%d-%d",
-                      rank > 0 ? rank - 1 : size - 1, i);
-            e = PMI_KVS_Get (kvsname, key, val, val_len);
-            if (e != PMI_SUCCESS)
-                log_msg_exit ("%d: PMI_IVS_Get: %s", rank, pmi_strerror (e));
-            snprintf (val2, val_len, "sandwich.%d.%d",
-                      rank > 0 ? rank - 1 : size - 1, i);
-            if (strcmp (val, val2) != 0)
-                log_msg_exit ("%d: PMI_KVS_Get: exp %s got %s\n", rank, val2, val);
         }
+        e = PMI_Barrier ();
+        if (e != PMI_SUCCESS)
+            log_msg_exit ("%d: PMI_Barrier: %s", rank, pmi_strerror (e));
+        if (rank == 0)
+            printf ("%d: get phase: %.3f msec\n", rank, monotime_since (t));
     }
-    e = PMI_Barrier ();
-    if (e != PMI_SUCCESS)
-        log_msg_exit ("%d: PMI_Barrier: %s", rank, pmi_strerror (e));
-    if (rank == 0)
-        printf ("%d: get phase: %.3f msec\n", rank, monotime_since (t));
 
     e = PMI_Finalize ();
     if (e != PMI_SUCCESS)
@@ -0,0 +1,379 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <jansson.h>
+#include <flux/idset.h>
+
+#include "src/common/libutil/errno_safe.h"
+
+#include "rlite.h"
+
+struct rlite_entry {
+    struct idset *ranks;
+    struct idset *cores;
+};
+
+/* A run of contiguous ranks belonging to one entry.
+ */
+struct rlite_range {
+    unsigned int lo;
+    unsigned int hi;
+    int entry;
+};
+
+struct rlite {
+    double starttime;
+    double expiration;
+    struct idset *ranks;
+    size_t ncores;
+
+    struct rlite_entry *entries;
+    int nentries;
+
+    struct rlite_range *ranges; // sorted by 'lo'
+    int nranges;
+    int ranges_size;
+};
+
+void rlite_destroy (struct rlite *rl)
+{
+    if (rl) {
+        int saved_errno = errno;
+        int i;
+        for (i = 0; i < rl->nentries; i++) {
+            idset_destroy (rl->entries[i].ranks);
+            idset_destroy (rl->entries[i].cores);
+        }
+        free (rl->entries);
+        free (rl->ranges);
+        idset_destroy (rl->ranks);
+        free (rl);
+        errno = saved_errno;
+    }
+}
+
+static void set_error (json_error_t *errp, const char *msg)
+{
+    if (errp)
+        snprintf (errp->text, sizeof (errp->text), "%s", msg);
+}
+
+static int range_cmp (const void *a, const void *b)
+{
+    const struct rlite_range *x = a;
+    const struct rlite_range *y = b;
+
+    return x->lo < y->lo ? -1 : x->lo > y->lo ? 1 : 0;
+}
+
+/* Append the contiguous runs of 'ranks' to rl->ranges.
+ */
+static int rlite_add_ranges (struct rlite *rl,
+                             const struct idset *ranks,
+                             int entry)
+{
+    unsigned int id = idset_first (ranks);
+
+    while (id != IDSET_INVALID_ID) {
+        struct rlite_range *r;
+        unsigned int next;
+
+        if (rl->nranges == rl->ranges_size) {
+            int size = rl->ranges_size ? rl->ranges_size * 2 : 4;
+            if (!(r = realloc (rl->ranges, size * sizeof (*r))))
+                return -1;
+            rl->ranges = r;
+            rl->ranges_size = size;
+        }
+        r = &rl->ranges[rl->nranges++];
+        r->lo = r->hi = id;
+        r->entry = entry;
+        while ((next = idset_next (ranks, r->hi)) == r->hi + 1)
+            r->hi = next;
+        id = next;
+    }
+    return 0;
+}
+
+/* Decode R_lite entry 'o' and append it to rl->entries.
+ * Set '*overlap' to true if it shares ranks with a previous entry,
+ * or fail if RLITE_FLAG_STRICT is set in 'flags'.
+ */
+static int rlite_add_entry (struct rlite *rl,
+                            json_t *o,
+                            int flags,
+                            bool *overlap,
+                            json_error_t *errp)
+{
+    struct rlite_entry *e;
+    const char *ranks = NULL;
+    const char *cores = NULL;
+
+    e = &rl->entries[rl->nentries];
+    if (json_unpack_ex (o, NULL, 0,
+                        "{s:s s?{s?s}}",
+                        "rank", &ranks,
+                        "children",
+                          "core", &cores) < 0) {
+        set_error (errp, "R_lite: failed to read target rank list");
+        goto inval;
+    }
+    if (!(e->ranks = idset_decode (ranks))) {
+        set_error (errp, "R_lite: failed to read target rank list");
+        goto inval;
+    }
+    if (idset_has_intersection (rl->ranks, e->ranks)) {
+        if ((flags & RLITE_FLAG_STRICT)) {
+            set_error (errp, "R_lite: failed to read target rank list");
+            goto inval;
+        }
+        *overlap = true;
+    }
+    if (idset_add (rl->ranks, e->ranks) < 0) {
+        set_error (errp, "R_lite: failed to read target rank list");
+        goto inval;
+    }
+    if (!(e->cores = cores ? idset_decode (cores) : idset_create (0, 0))) {
+        set_error (errp, "R_lite: failed to read core list");
+        goto inval;
+    }
+    rl->nentries++;
+    return 0;
+inval:
+    /* rl->nentries was not incremented, so clean up here */
+    idset_destroy (e->ranks);
+    idset_destroy (e->cores);
+    e->ranks = e->cores = NULL;
+    errno = EINVAL;
+    return -1;
+}
+
+/* Return the union of the cores of all entries of 'rl' holding 'rank'.
+ */
+static struct idset *rlite_union_cores (struct rlite *rl, unsigned int rank)
+{
+    struct idset *cores;
+    int i;
+
+    if (!(cores = idset_create (0, IDSET_FLAG_AUTOGROW)))
+        return NULL;
+    for (i = 0; i < rl->nentries; i++) {
+        if (idset_test (rl->entries[i].ranks, rank)
+            && idset_add (cores, rl->entries[i].cores) < 0) {
+            idset_destroy (cores);
+            return NULL;
+        }
+    }
+    return cores;
+}
+
+/* R_lite entries that share ranks are merged: each rank is assigned the
+ * union of the cores of all entries that list it.  Rebuild rl->entries
+ * so that each rank appears in exactly one entry, extending an entry
+ * while consecutive ranks have the same cores.  This is O(ranks * entries)
+ * but is only needed for R that lists a rank more than once.
+ */
+static int rlite_merge_entries (struct rlite *rl)
+{
+    struct rlite_entry *entries;
+    int nentries = 0;
+    unsigned int rank;
+    int i;
+
+    if (!(entries = calloc (idset_count (rl->ranks), sizeof (entries[0]))))
+        return -1;
+    rank = idset_first (rl->ranks);
+    while (rank != IDSET_INVALID_ID) {
+        struct rlite_entry *e = nentries > 0 ? &entries[nentries - 1] : NULL;
+        struct idset *cores;
+
+        if (!(cores = rlite_union_cores (rl, rank)))
+            goto error;
+        if (e && idset_equal (e->cores, cores))
+            idset_destroy (cores);
+        else {
+            e = &entries[nentries++];
+            e->cores = cores;
+            if (!(e->ranks = idset_create (0, IDSET_FLAG_AUTOGROW)))
+                goto error;
+        }
+        if (idset_set (e->ranks, rank) < 0)
+            goto error;
+        rank = idset_next (rl->ranks, rank);
+    }
+    for (i = 0; i < rl->nentries; i++) {
+        idset_destroy (rl->entries[i].ranks);
+        idset_destroy (rl->entries[i].cores);
+    }
+    free (rl->entries);
+    rl->entries = entries;
+    rl->nentries = nentries;
+    return 0;
+error:
+    for (i = 0; i < nentries; i++) {
+        idset_destroy (entries[i].ranks);
+        idset_destroy (entries[i].cores);
+    }
+    ERRNO_SAFE_WRAP (free, entries);
+    return -1;
+}
+
+struct rlite *rlite_create (const char *R, int flags, json_error_t *errp)
+{
+    struct rlite *rl;
+    json_t *o = NULL;
+    json_t *R_lite;
+    json_t *entry;
+    int version;
+    size_t index;
+    bool overlap = false;
+    int i;
+
+    if (!(rl = calloc (1, sizeof (*rl)))) {
+        set_error (errp, "out of memory");
+        return NULL;
+    }
+    if (!(o = json_loads (R, 0, errp)))
+        goto inval;
+    if (json_unpack_ex (o, errp, 0,
+                        "{s:i s:{s:o s?F s?F}}",
+                        "version", &version,
+                        "execution",
+                          "R_lite", &R_lite,
+                          "starttime", &rl->starttime,
+                          "expiration", &rl->expiration) < 0)
+        goto inval;
+    if (version != 1) {
+        if (errp)
+            snprintf (errp->text, sizeof (errp->text),
+                      "invalid version: %d", version);
+        goto inval;
+    }
+    if (!(rl->ranks = idset_create (0, IDSET_FLAG_AUTOGROW))) {
+        set_error (errp, "out of memory");
+        goto error;
+    }
+    if (json_is_array (R_lite) && json_array_size (R_lite) > 0) {
+        if (!(rl->entries = calloc (json_array_size (R_lite),
+                                    sizeof (rl->entries[0])))) {
+            set_error (errp, "out of memory");
+            goto error;
+        }
+        json_array_foreach (R_lite, index, entry) {
+            if (rlite_add_entry (rl, entry, flags, &overlap, errp) < 0)
+                goto error;
+        }
+    }
+    if (overlap && rlite_merge_entries (rl) < 0) {
+        set_error (errp, "out of memory");
+        goto error;
+    }
+    for (i = 0; i < rl->nentries; i++) {
+        struct rlite_entry *e = &rl->entries[i];
+
+        if (rlite_add_ranges (rl, e->ranks, i) < 0) {
+            set_error (errp, "out of memory");
+            goto error;
+        }
+        rl->ncores += idset_count (e->ranks) * idset_count (e->cores);
+    }
+    qsort (rl->ranges, rl->nranges, sizeof (rl->ranges[0]), range_cmp);
+    json_decref (o);
+    return rl;
+inval:
+    errno = EINVAL;
+error:
+    ERRNO_SAFE_WRAP (json_decref, o);
+    rlite_destroy (rl);
+    return NULL;
+}
+
+const struct idset *rlite_ranks (const struct rlite *rl)
+{
+    return rl ? rl->ranks : NULL;
+}
+
+size_t rlite_nnodes (const struct rlite *rl)
+{
+    return rl ? idset_count (rl->ranks) : 0;
+}
+
+size_t rlite_ncores (const struct rlite *rl)
+{
+    return rl ? rl->ncores : 0;
+}
+
+const struct idset *rlite_cores (const struct rlite *rl, unsigned int rank)
+{
+    int lo = 0;
+    int hi;
+
+    if (!rl) {
+        errno = EINVAL;
+        return NULL;
+    }
+    hi = rl->nranges - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        const struct rlite_range *r = &rl->ranges[mid];
+
+        if (rank < r->lo)
+            hi = mid - 1;
+        else if (rank > r->hi)
+            lo = mid + 1;
+        else
+            return rl->entries[r->entry].cores;
+    }
+    errno = ENOENT;
+    return NULL;
+}
+
+double rlite_starttime (const struct rlite *rl)
+{
+    return rl ? rl->starttime : 0.;
+}
+
+double rlite_expiration (const struct rlite *rl)
+{
+    return rl ? rl->expiration : 0.;
+}
+
+int rlite_entry_count (const struct rlite *rl)
+{
+    return rl ? rl->nentries : 0;
+}
+
+const struct idset *rlite_entry_ranks (const struct rlite *rl, int index)
+{
+    if (!rl || index < 0 || index >= rl->nentries) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return rl->entries[index].ranks;
+}
+
+const struct idset *rlite_entry_cores (const struct rlite *rl, int index)
+{
+    if (!rl || index < 0 || index >= rl->nentries) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return rl->entries[index].cores;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
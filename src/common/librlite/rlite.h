@@ -0,0 +1,70 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* rlite - compact, read-only representation of R (version 1)
+ *
+ * R is decoded once into the rank and core idsets of each R_lite entry,
+ * then the JSON is discarded.  Entries are indexed by sorted ranges of
+ * contiguous ranks, so finding the cores assigned on a rank is a binary
+ * search over ranges: constant time for the usual case of an allocation
+ * with one contiguous rank range.
+ */
+
+#ifndef _RLITE_H
+#define _RLITE_H
+
+#include <jansson.h>
+#include <flux/idset.h>
+
+struct rlite;
+
+enum {
+    RLITE_FLAG_STRICT = 1,  /* reject R_lite entries that share ranks */
+};
+
+/* Decode R.  R_lite entries that share ranks are merged, each rank being
+ * assigned the union of their cores, unless RLITE_FLAG_STRICT is set,
+ * in which case they are an error.  On failure, return NULL, and if
+ * 'errp' is non-NULL, set errp->text to a description of the error.
+ */
+struct rlite *rlite_create (const char *R, int flags, json_error_t *errp);
+
+void rlite_destroy (struct rlite *rl);
+
+/* Return the set of all ranks in 'rl'.
+ */
+const struct idset *rlite_ranks (const struct rlite *rl);
+
+/* Return the number of ranks and the total number of cores in 'rl'.
+ */
+size_t rlite_nnodes (const struct rlite *rl);
+size_t rlite_ncores (const struct rlite *rl);
+
+/* Return the cores assigned on 'rank', or NULL with errno == ENOENT
+ * if 'rank' is not in 'rl'.
+ */
+const struct idset *rlite_cores (const struct rlite *rl, unsigned int rank);
+
+/* Return execution.starttime and execution.expiration (0. if unset).
+ */
+double rlite_starttime (const struct rlite *rl);
+double rlite_expiration (const struct rlite *rl);
+
+/* Access R_lite entries, each a set of ranks with identical cores.
+ */
+int rlite_entry_count (const struct rlite *rl);
+const struct idset *rlite_entry_ranks (const struct rlite *rl, int index);
+const struct idset *rlite_entry_cores (const struct rlite *rl, int index);
+
+#endif /* !_RLITE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,210 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/librlite/rlite.h"
+
+#define R_LITE(entries) \
+    "{\"version\":1,\"execution\":{\"starttime\":10,\"expiration\":20," \
+    "\"R_lite\":[" entries "]}}"
+
+static char *cores_string (const struct rlite *rl, unsigned int rank)
+{
+    const struct idset *ids = rlite_cores (rl, rank);
+    return ids ? idset_encode (ids, IDSET_FLAG_RANGE) : NULL;
+}
+
+void test_basic (void)
+{
+    const char *R = R_LITE ("{\"rank\":\"0-2,8\",\"children\":{\"core\":\"0-3\"}},"
+                            "{\"rank\":\"4-5\",\"children\":{\"core\":\"1\"}}");
+    json_error_t error;
+    struct rlite *rl;
+    char *s;
+
+    rl = rlite_create (R, 0, &error);
+    ok (rl != NULL,
+        "rlite_create works");
+    if (!rl)
+        BAIL_OUT ("rlite_create failed: %s", error.text);
+    s = idset_encode (rlite_ranks (rl), IDSET_FLAG_RANGE);
+    is (s, "0-2,4-5,8",
+        "rlite_ranks returns all ranks");
+    free (s);
+    ok (rlite_nnodes (rl) == 6,
+        "rlite_nnodes returns 6");
+    ok (rlite_ncores (rl) == 4 * 4 + 2 * 1,
+        "rlite_ncores returns 18");
+    ok (rlite_starttime (rl) == 10. && rlite_expiration (rl) == 20.,
+        "rlite_starttime and rlite_expiration work");
+
+    s = cores_string (rl, 0);
+    is (s, "0-3",
+        "rlite_cores rank 0 returns 0-3");
+    free (s);
+    s = cores_string (rl, 5);
+    is (s, "1",
+        "rlite_cores rank 5 returns 1");
+    free (s);
+    s = cores_string (rl, 8);
+    is (s, "0-3",
+        "rlite_cores rank 8 returns 0-3");
+    free (s);
+    errno = 0;
+    ok (rlite_cores (rl, 3) == NULL && errno == ENOENT,
+        "rlite_cores rank 3 fails with ENOENT");
+    errno = 0;
+    ok (rlite_cores (rl, 9) == NULL && errno == ENOENT,
+        "rlite_cores rank 9 fails with ENOENT");
+
+    ok (rlite_entry_count (rl) == 2,
+        "rlite_entry_count returns 2");
+    s = idset_encode (rlite_entry_ranks (rl, 1), IDSET_FLAG_RANGE);
+    is (s, "4-5",
+        "rlite_entry_ranks 1 returns 4-5");
+    free (s);
+    errno = 0;
+    ok (rlite_entry_cores (rl, 2) == NULL && errno == EINVAL,
+        "rlite_entry_cores with bad index fails with EINVAL");
+
+    rlite_destroy (rl);
+}
+
+void test_empty (void)
+{
+    struct rlite *rl;
+
+    rl = rlite_create (R_LITE (""), 0, NULL);
+    ok (rl != NULL
+        && rlite_nnodes (rl) == 0
+        && rlite_ncores (rl) == 0
+        && rlite_entry_count (rl) == 0,
+        "rlite_create works with empty R_lite");
+    errno = 0;
+    ok (rlite_cores (rl, 0) == NULL && errno == ENOENT,
+        "rlite_cores fails with ENOENT");
+    rlite_destroy (rl);
+}
+
+/* Entries sharing ranks are merged, as rlist_from_R() did.
+ */
+void test_overlap (void)
+{
+    const char *R = R_LITE ("{\"rank\":\"0-3\",\"children\":{\"core\":\"0\"}},"
+                            "{\"rank\":\"2-4\",\"children\":{\"core\":\"1\"}},"
+                            "{\"rank\":\"3\",\"children\":{\"core\":\"0\"}}");
+    json_error_t error;
+    struct rlite *rl;
+    char *s;
+
+    rl = rlite_create (R, 0, &error);
+    ok (rl != NULL,
+        "rlite_create works with overlapping ranks");
+    if (!rl)
+        BAIL_OUT ("rlite_create failed: %s", error.text);
+    s = idset_encode (rlite_ranks (rl), IDSET_FLAG_RANGE);
+    is (s, "0-4",
+        "rlite_ranks returns union of ranks");
+    free (s);
+    ok (rlite_nnodes (rl) == 5,
+        "rlite_nnodes returns 5");
+    ok (rlite_ncores (rl) == 2 * 1 + 2 * 2 + 1,
+        "rlite_ncores counts each core once");
+    s = cores_string (rl, 1);
+    is (s, "0",
+        "rlite_cores rank 1 returns 0");
+    free (s);
+    s = cores_string (rl, 3);
+    is (s, "0-1",
+        "rlite_cores rank 3 returns merged cores 0-1");
+    free (s);
+    s = cores_string (rl, 4);
+    is (s, "1",
+        "rlite_cores rank 4 returns 1");
+    free (s);
+    ok (rlite_entry_count (rl) == 3,
+        "rlite_entry_count returns 3 after merge");
+    s = idset_encode (rlite_entry_ranks (rl, 1), IDSET_FLAG_RANGE);
+    is (s, "2-3",
+        "rlite_entry_ranks 1 returns 2-3");
+    free (s);
+
+    rlite_destroy (rl);
+
+    errno = 0;
+    ok (rlite_create (R, RLITE_FLAG_STRICT, &error) == NULL
+        && errno == EINVAL,
+        "rlite_create RLITE_FLAG_STRICT fails with overlapping ranks");
+    is (error.text, "R_lite: failed to read target rank list",
+        "and error text is set");
+}
+
+struct errtest {
+    const char *descr;
+    const char *R;
+    const char *error;
+};
+
+struct errtest errtests[] = {
+    { "missing R_lite",
+      "{\"version\":1,\"execution\":{}}",
+      "Object item not found: R_lite",
+    },
+    { "bad version",
+      "{\"version\":2,\"execution\":{\"R_lite\":[]}}",
+      "invalid version: 2",
+    },
+    { "bad rank idset",
+      R_LITE ("{\"rank\":\"-2\",\"children\":{\"core\":\"0\"}}"),
+      "R_lite: failed to read target rank list",
+    },
+    { "bad core idset",
+      R_LITE ("{\"rank\":\"0\",\"children\":{\"core\":\"x\"}}"),
+      "R_lite: failed to read core list",
+    },
+    { NULL, NULL, NULL },
+};
+
+void test_errors (void)
+{
+    struct errtest *t;
+
+    for (t = &errtests[0]; t->descr != NULL; t++) {
+        json_error_t error;
+
+        errno = 0;
+        ok (rlite_create (t->R, 0, &error) == NULL && errno == EINVAL,
+            "rlite_create %s fails with EINVAL", t->descr);
+        is (error.text, t->error,
+            "and error is \"%s\"", t->error);
+    }
+    ok (rlite_create ("{", 0, NULL) == NULL,
+        "rlite_create fails on invalid JSON");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_empty ();
+    test_overlap ();
+    test_errors ();
+
+    done_testing ();
+}
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
@@ -39,6 +39,17 @@
  *   is assembled, then it is freed.  The static buffer is sized somewhat
  *   arbitrarily at 4K.
  *
+ * - when recvfd() is given an iobuf, it reads as much as the buffer will
+ *   hold rather than one message at a time, so a burst of small messages
+ *   costs one read(2) rather than two per message.  Bytes belonging to
+ *   the next message(s) are retained in the iobuf, and recvfd() returns
+ *   them without touching the file descriptor.  Since the descriptor may
+ *   no longer be readable while complete messages are buffered, callers
+ *   driven by poll(2) must check iobuf_recv_ready() before sleeping.
+ *
+ * - sendfd_multi() encodes several messages back to back into the iobuf
+ *   and hands them to the kernel with one write(2).
+ *
  * - sendfd/recvfd do not encrypt messages, therefore this transport
  *   is only appropriate for use on AF_LOCAL sockets or on file descriptors
  *   tunneled through a secure channel.
@@ -49,12 +60,32 @@
 #endif
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <string.h>
 #include <flux/core.h>
 
 #include "sendfd.h"
 
 #define IOBUF_MAGIC 0xffee0012
 
+/* Upper bound on bytes sendfd_multi() coalesces into one write.
+ * A single message larger than this is still sent whole.
+ */
+#define IOBUF_BATCH_MAX (64*1024)
+
+/* Headers of coalesced messages are not necessarily 4-byte aligned.
+ */
+static uint32_t get_uint32 (const uint8_t *p)
+{
+    uint32_t val;
+    memcpy (&val, p, sizeof (val));
+    return val;
+}
+
+static void put_uint32 (uint8_t *p, uint32_t val)
+{
+    memcpy (p, &val, sizeof (val));
+}
+
 void iobuf_init (struct iobuf *iobuf)
 {
     memset (iobuf, 0, sizeof (*iobuf));
@@ -110,11 +141,131 @@ done:
     return rc;
 }
 
+/* Write out whatever remains of a previously encoded batch.
+ */
+static int iobuf_flush (int fd, struct iobuf *io)
+{
+    ssize_t n;
+
+    while (io->done < io->size) {
+        if ((n = write (fd, io->buf + io->done, io->size - io->done)) < 0)
+            return -1;
+        io->done += n;
+    }
+    iobuf_clean (io);
+    return 0;
+}
+
+int sendfd_multi (int fd,
+                  const flux_msg_t *msgs[],
+                  int count,
+                  struct iobuf *iobuf)
+{
+    int n = 0;
+
+    if (fd < 0 || (!msgs && count > 0) || count < 0 || !iobuf) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (iobuf->buf && iobuf_flush (fd, iobuf) < 0)
+        goto error;
+    while (n < count) {
+        size_t total = 0;
+        size_t offset = 0;
+        int i;
+
+        for (i = n; i < count; i++) {
+            size_t size = flux_msg_encode_size (msgs[i]) + 8;
+            if (i > n && total + size > IOBUF_BATCH_MAX)
+                break;
+            total += size;
+        }
+        if (total <= sizeof (iobuf->buf_fixed))
+            iobuf->buf = iobuf->buf_fixed;
+        else if (!(iobuf->buf = malloc (total)))
+            goto error;
+        iobuf->size = total;
+        iobuf->done = 0;
+        for (; n < i; n++) {
+            size_t size = flux_msg_encode_size (msgs[n]);
+            put_uint32 (&iobuf->buf[offset], IOBUF_MAGIC);
+            put_uint32 (&iobuf->buf[offset + 4], htonl (size));
+            if (flux_msg_encode (msgs[n], &iobuf->buf[offset + 8], size) < 0)
+                goto error;
+            offset += size + 8;
+        }
+        /* Messages in the batch now belong to the iobuf.  If the kernel
+         * won't take all of it, report them as sent and leave the rest
+         * for the next call.
+         */
+        if (iobuf_flush (fd, iobuf) < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return n;
+            goto error;
+        }
+    }
+    return n;
+error:
+    if (errno != EAGAIN && errno != EWOULDBLOCK)
+        iobuf_clean (iobuf);
+    return -1;
+}
+
+bool iobuf_send_pending (const struct iobuf *iobuf)
+{
+    return iobuf && iobuf->buf != NULL;
+}
+
+/* Move the unconsumed tail of the receive buffer to the front, making
+ * room for a message of 'need' bytes.  The buffer is grown if needed,
+ * or returned to buf_fixed if a previously grown buffer is no longer
+ * required.
+ */
+static int iobuf_reserve (struct iobuf *io, size_t need)
+{
+    size_t avail = io->done - io->pos;
+    uint8_t *buf = io->buf;
+
+    if (need > sizeof (io->buf_fixed)) {
+        if (need > io->size && !(buf = malloc (need)))
+            return -1;
+    }
+    else
+        buf = io->buf_fixed;
+    memmove (buf, io->buf + io->pos, avail);
+    if (buf != io->buf) {
+        if (io->buf != io->buf_fixed)
+            free (io->buf);
+        io->buf = buf;
+        io->size = buf == io->buf_fixed ? sizeof (io->buf_fixed) : need;
+    }
+    io->pos = 0;
+    io->done = avail;
+    return 0;
+}
+
+bool iobuf_recv_ready (const struct iobuf *iobuf)
+{
+    size_t avail;
+
+    if (!iobuf || !iobuf->buf)
+        return false;
+    avail = iobuf->done - iobuf->pos;
+    if (avail < 8)
+        return false;
+    /* A bad header is "ready" too, so recvfd() gets to report EPROTO.
+     */
+    if (get_uint32 (&iobuf->buf[iobuf->pos]) != IOBUF_MAGIC)
+        return true;
+    return avail >= ntohl (get_uint32 (&iobuf->buf[iobuf->pos + 4])) + 8;
+}
+
 flux_msg_t *recvfd (int fd, struct iobuf *iobuf)
 {
     struct iobuf local;
     struct iobuf *io = iobuf ? iobuf : &local;
     flux_msg_t *msg = NULL;
+    size_t need;
     int rc = -1;
 
     if (fd < 0) {
@@ -127,45 +278,50 @@ flux_msg_t *recvfd (int fd, struct iobuf *iobuf)
         io->buf = io->buf_fixed;
         io->size = sizeof (io->buf_fixed);
     }
-    do {
-        if (io->done < 8) {
-            rc = read (fd, io->buf + io->done, 8 - io->done);
-            if (rc < 0)
-                goto done;
-            if (rc == 0) {
-                errno = ECONNRESET;
+    for (;;) {
+        size_t avail = io->done - io->pos;
+        size_t len;
+
+        need = 8;
+        if (avail >= 8) {
+            if (get_uint32 (&io->buf[io->pos]) != IOBUF_MAGIC) {
+                errno = EPROTO;
                 goto done;
             }
-            io->done += rc;
-            if (io->done == 8) {
-                if (*(uint32_t *)&io->buf[0] != IOBUF_MAGIC) {
-                    errno = EPROTO;
-                    goto done;
-                }
-                io->size = ntohl (*(uint32_t *)&io->buf[4]) + 8;
-                if (io->size > sizeof (io->buf_fixed)) {
-                    if (!(io->buf = malloc (io->size)))
-                        goto done;
-                    memcpy (io->buf, io->buf_fixed, 8);
-                }
-            }
+            need = ntohl (get_uint32 (&io->buf[io->pos + 4])) + 8;
+            if (avail >= need)
+                break;
         }
-        if (io->done >= 8 && io->done < io->size) {
-            rc = read (fd, io->buf + io->done, io->size - io->done);
-            if (rc < 0)
+        if (io->pos + need > io->size) {
+            if (iobuf_reserve (io, need) < 0)
                 goto done;
-            if (rc == 0) {
-                errno = ECONNRESET;
-                goto done;
-            }
-            io->done += rc;
         }
-    } while (io->done < io->size);
-    if (!(msg = flux_msg_decode (io->buf + 8, io->size - 8)))
+        /* Without a caller-provided iobuf, anything read past the end of
+         * this message would be lost, so read exactly one message.
+         */
+        if (iobuf)
+            len = io->size - io->done;
+        else
+            len = io->pos + need - io->done;
+        rc = read (fd, io->buf + io->done, len);
+        if (rc < 0)
+            goto done;
+        if (rc == 0) {
+            errno = ECONNRESET;
+            goto done;
+        }
+        io->done += rc;
+    }
+    if (!(msg = flux_msg_decode (io->buf + io->pos + 8, need - 8)))
         goto done;
+    io->pos += need;
 done:
     if (iobuf) {
-        if (msg != NULL || (errno != EAGAIN && errno != EWOULDBLOCK))
+        if (msg != NULL) {
+            if (io->pos == io->done)
+                iobuf_clean (iobuf);
+        }
+        else if (errno != EAGAIN && errno != EWOULDBLOCK)
             iobuf_clean (iobuf);
     } else {
         if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
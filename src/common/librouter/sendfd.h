@@ -11,12 +11,14 @@
 #ifndef _ROUTER_SENDFD_H
 #define _ROUTER_SENDFD_H
 
+#include <stdbool.h>
 #include <flux/core.h>
 
 struct iobuf {
     uint8_t *buf;
     size_t size;
     size_t done;
+    size_t pos;
     uint8_t buf_fixed[4096];
 };
 
@@ -26,12 +28,35 @@ struct iobuf {
  */
 int sendfd (int fd, const flux_msg_t *msg, struct iobuf *iobuf);
 
+/* Send up to 'count' messages to file descriptor, coalescing them into
+ * as few write(2) calls as possible.  Returns the number of messages
+ * consumed, which the caller may now release, or -1 on failure with
+ * errno set.  Consumed messages may still be partially buffered in iobuf
+ * on EAGAIN/EWOULDBLOCK; see iobuf_send_pending().  Do not mix with
+ * sendfd() on the same iobuf.
+ */
+int sendfd_multi (int fd,
+                  const flux_msg_t *msgs[],
+                  int count,
+                  struct iobuf *iobuf);
+
 /* Receive message from file descriptor.
  * iobuf captures intermediate state to make EAGAIN/EWOULDBLOCK restartable.
+ * If iobuf is non-NULL, data beyond the current message may be read ahead
+ * and retained for subsequent calls.
  * Returns message on success, NULL on failure with errno set.
  */
 flux_msg_t *recvfd (int fd, struct iobuf *iobuf);
 
+/* Return true if recvfd() can return a message (or error) from data
+ * already buffered in iobuf, without reading from the file descriptor.
+ */
+bool iobuf_recv_ready (const struct iobuf *iobuf);
+
+/* Return true if sendfd_multi() has bytes left to write from iobuf.
+ */
+bool iobuf_send_pending (const struct iobuf *iobuf);
+
 /* Initialize iobuf members.
  */
 void iobuf_init (struct iobuf *iobuf);
@@ -122,19 +122,22 @@ void recv_cb (flux_reactor_t *r, flux_watcher_t *w, int revents, void *arg)
         BAIL_OUT ("recv_cb POLLERR");
     if ((revents & FLUX_POLLIN)) {
         flux_msg_t *msg;
-        if (!(msg = recvfd (io->fd, &io->iobuf))) {
-            if (errno == EWOULDBLOCK || errno == EAGAIN) {
-                diag ("recv EWOULDBLOCK");
+        do {
+            if (!(msg = recvfd (io->fd, &io->iobuf))) {
+                if (errno == EWOULDBLOCK || errno == EAGAIN) {
+                    diag ("recv EWOULDBLOCK");
+                    return;
+                }
+                BAIL_OUT ("recvfd error: %s", strerror (errno));
+            }
+            if (zlist_append (io->queue, msg) < 0)
+                BAIL_OUT ("zlist_append failed");
+            if (zlist_size (io->queue) == io->max) {
+                diag ("recv queue full, stopping receiver");
+                flux_watcher_stop (io->w);
                 return;
             }
-            BAIL_OUT ("recvfd error: %s", strerror (errno));
-        }
-        if (zlist_append (io->queue, msg) < 0)
-            BAIL_OUT ("zlist_append failed");
-        if (zlist_size (io->queue) == io->max) {
-            diag ("recv queue full, stopping receiver");
-            flux_watcher_stop (io->w);
-        }
+        } while (iobuf_recv_ready (&io->iobuf));
     }
 }
 
@@ -165,6 +168,43 @@ void send_cb (flux_reactor_t *r, flux_watcher_t *w, int revents, void *arg)
     }
 }
 
+void send_multi_cb (flux_reactor_t *r,
+                    flux_watcher_t *w,
+                    int revents,
+                    void *arg)
+{
+    struct io *io = arg;
+
+    if ((revents & FLUX_POLLERR))
+        BAIL_OUT ("send_multi_cb POLLERR");
+    if ((revents & FLUX_POLLOUT)) {
+        const flux_msg_t *msgs[64];
+        flux_msg_t *msg;
+        int count = 0;
+        int n;
+
+        msg = zlist_first (io->queue);
+        while (msg && count < 64) {
+            msgs[count++] = msg;
+            msg = zlist_next (io->queue);
+        }
+        if ((n = sendfd_multi (io->fd, msgs, count, &io->iobuf)) < 0) {
+            if (errno == EWOULDBLOCK || errno == EAGAIN) {
+                diag ("send EWOULDBLOCK");
+                return;
+            }
+            BAIL_OUT ("sendfd_multi error: %s", strerror (errno));
+        }
+        while (n-- > 0)
+            flux_msg_destroy (zlist_pop (io->queue));
+        if (zlist_size (io->queue) == 0
+            && !iobuf_send_pending (&io->iobuf)) {
+            diag ("send queue empty, stopping sender");
+            flux_watcher_stop (io->w);
+        }
+    }
+}
+
 void io_destroy (struct io *io)
 {
     if (io) {
@@ -212,7 +252,7 @@ error:
  * - receiver enqueues all recived messages
  * Verify that messages are all received intact.
  */
-void test_nonblock (int size, int count)
+void test_nonblock (int size, int count, bool multi)
 {
     int pfd[2];
     struct io *iow;
@@ -231,7 +271,10 @@ void test_nonblock (int size, int count)
         BAIL_OUT ("flux_reactor_create failed");
     if (pipe2 (pfd, O_CLOEXEC) < 0)
         BAIL_OUT ("pipe2 failed");
-    if (!(iow = io_create (r, pfd[1], FLUX_POLLOUT, send_cb)))
+    if (!(iow = io_create (r,
+                           pfd[1],
+                           FLUX_POLLOUT,
+                           multi ? send_multi_cb : send_cb)))
         BAIL_OUT ("io_create failed: %s", flux_strerror (errno));
     if (!(ior = io_create (r, pfd[0], FLUX_POLLIN, recv_cb)))
         BAIL_OUT ("io_create failed: %s", flux_strerror (errno));
@@ -247,10 +290,11 @@ void test_nonblock (int size, int count)
     diag ("messages enqueued, starting reactor", count);
 
     ok (flux_reactor_run (r, 0) == 0,
-        "nonblock %d,%d: reactor ran", count, size);
+        "nonblock%s %d,%d: reactor ran", multi ? " multi" : "", count, size);
 
     ok (zlist_size (ior->queue) == count,
-        "nonblock %d,%d: all messages received",
+        "nonblock%s %d,%d: all messages received",
+        multi ? " multi" : "",
         count,
         size);
 
@@ -280,7 +324,8 @@ next:
     }
 
     ok (errors == 0,
-        "nonblock %d,%d: received messages are intact",
+        "nonblock%s %d,%d: received messages are intact",
+        multi ? " multi" : "",
         count,
         size);
 
@@ -292,9 +337,66 @@ next:
     free (buf);
 }
 
+/* Send several small messages in one write and ensure recvfd() with
+ * an iobuf returns them all, the later ones from its read-ahead buffer.
+ */
+void test_readahead (void)
+{
+    int pfd[2];
+    const flux_msg_t *msgs[3];
+    flux_msg_t *msg;
+    struct iobuf out;
+    struct iobuf in;
+    int i;
+    int errors;
+
+    if (pipe2 (pfd, O_CLOEXEC) < 0)
+        BAIL_OUT ("pipe2 failed");
+    for (i = 0; i < 3; i++) {
+        if (!(msg = flux_request_encode ("foo.bar", NULL)))
+            BAIL_OUT ("flux_request_encode failed");
+        msgs[i] = msg;
+    }
+    iobuf_init (&out);
+    iobuf_init (&in);
+    ok (sendfd_multi (pfd[1], msgs, 3, &out) == 3,
+        "sendfd_multi sent 3 messages");
+    ok (!iobuf_send_pending (&out),
+        "iobuf_send_pending returns false");
+    ok (!iobuf_recv_ready (&in),
+        "iobuf_recv_ready returns false before first recvfd");
+    errors = 0;
+    for (i = 0; i < 3; i++) {
+        const char *topic;
+        if (!(msg = recvfd (pfd[0], &in))
+            || flux_request_decode (msg, &topic, NULL) < 0
+            || strcmp (topic, "foo.bar") != 0)
+            errors++;
+        flux_msg_destroy (msg);
+        if (i < 2 && !iobuf_recv_ready (&in))
+            errors++;
+    }
+    ok (errors == 0,
+        "recvfd returned all 3 messages from read-ahead buffer");
+    ok (!iobuf_recv_ready (&in),
+        "iobuf_recv_ready returns false once buffer is drained");
+    ok (sendfd_multi (pfd[1], msgs, 0, &out) == 0,
+        "sendfd_multi count=0 works");
+
+    iobuf_clean (&in);
+    iobuf_clean (&out);
+    for (i = 0; i < 3; i++)
+        flux_msg_destroy ((flux_msg_t *)msgs[i]);
+    close (pfd[1]);
+    close (pfd[0]);
+}
+
 void test_inval (void)
 {
     flux_msg_t *msg;
+    struct iobuf iobuf;
+
+    iobuf_init (&iobuf);
 
     if (!(msg = flux_msg_create (FLUX_MSGTYPE_REQUEST)))
         BAIL_OUT ("flux_msg_create failed");
@@ -309,6 +411,13 @@ void test_inval (void)
     errno = 0;
     ok (sendfd (0, NULL, NULL) < 0 && errno == EINVAL,
         "senfd msg=NULL fails with EINVAL");
+    errno = 0;
+    ok (sendfd_multi (0, NULL, 1, &iobuf) < 0 && errno == EINVAL,
+        "sendfd_multi msgs=NULL fails with EINVAL");
+    errno = 0;
+    ok (sendfd_multi (0, (const flux_msg_t **)&msg, 1, NULL) < 0
+        && errno == EINVAL,
+        "sendfd_multi iobuf=NULL fails with EINVAL");
 
     flux_msg_destroy (msg);
 }
@@ -320,10 +429,15 @@ int main (int argc, char *argv[])
     test_basic ();
     test_large ();
     test_eof ();
-    test_nonblock (1024, 1024);
-    test_nonblock (4096, 256);
-    test_nonblock (16384, 64);
-    test_nonblock (1048586, 1);
+    test_nonblock (1024, 1024, false);
+    test_nonblock (4096, 256, false);
+    test_nonblock (16384, 64, false);
+    test_nonblock (1048586, 1, false);
+    test_nonblock (16, 16384, true);
+    test_nonblock (1024, 1024, true);
+    test_nonblock (16384, 64, true);
+    test_nonblock (1048586, 2, true);
+    test_readahead ();
     test_inval ();
 
     done_testing();
@@ -16,6 +16,7 @@
 
 #include "src/common/libtap/tap.h"
 #include "src/common/libutil/unlink_recursive.h"
+#include "src/common/libutil/monotime.h"
 #include "src/common/libtestutil/util.h"
 #include "src/common/librouter/usock.h"
 
@@ -282,6 +283,61 @@ static void test_async_stream (flux_t *h, int size, int count)
     flux_msg_destroy (ctx.msg);
 }
 
+/* Stream many small RPC responses through the echo server and report
+ * the round trip rate.  This exercises read-ahead on both ends and
+ * coalescing of the server's output queue.
+ */
+static void test_throughput (flux_t *h, int count)
+{
+    char sockpath[PATH_MAX + 1];
+    int fd;
+    struct cli *cli;
+    struct async_ctx ctx;
+    struct timespec t0;
+    double elapsed;
+    int i;
+    int errors;
+
+    memset (&ctx, 0, sizeof (ctx));
+    ctx.r = flux_get_reactor (h);
+    if (!(ctx.msg = flux_response_encode ("a.b", "{}")))
+        BAIL_OUT ("flux_response_encode failed");
+    ctx.max_recv = count;
+
+    if (snprintf (sockpath,
+                  sizeof (sockpath),
+                  "%s/server",
+                  tmpdir) >= sizeof (sockpath))
+        BAIL_OUT ("buffer overflow");
+    fd = usock_client_connect (sockpath, USOCK_RETRY_DEFAULT);
+    if (fd < 0)
+        BAIL_OUT ("usock_client_connect failed");
+    cli = cli_create (ctx.r, fd, async_recv_cb, &ctx);
+    if (!cli)
+        BAIL_OUT ("cli_create failed");
+
+    monotime (&t0);
+    errors = 0;
+    for (i = 0; i < count; i++) {
+        if (cli_send (cli, ctx.msg) < 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "queued %d small responses", count);
+
+    if (flux_reactor_run (ctx.r, 0) < 0)
+        BAIL_OUT ("flux_reactor_run returned -1: %s", flux_strerror (errno));
+    elapsed = monotime_since (t0) * 1E-3;
+    diag ("echoed %d responses in %.3fs: %.0f msgs/s",
+          count,
+          elapsed,
+          elapsed > 0 ? count / elapsed : 0.);
+
+    cli_destroy (cli);
+    (void)close (fd);
+    flux_msg_destroy (ctx.msg);
+}
+
 int main (int argc, char *argv[])
 {
     flux_t *h;
@@ -304,6 +360,7 @@ int main (int argc, char *argv[])
     test_async_stream (h, 4096, 256);
     test_async_stream (h, 16384, 64);
     test_async_stream (h, 1048576, 1);
+    test_throughput (h, 100000);
 
     diag ("stopping test server");
     if (test_server_stop (h) < 0)
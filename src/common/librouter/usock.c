@@ -57,6 +57,10 @@
 
 #define LISTEN_BACKLOG 5
 
+/* Maximum number of queued messages handed to sendfd_multi() at once.
+ */
+#define USOCK_SEND_BATCH 64
+
 #ifndef UUID_STR_LEN
 #define UUID_STR_LEN 37     // defined in later libuuid headers
 #endif
@@ -209,20 +213,26 @@ static void conn_read_cb (flux_reactor_t *r,
     if ((revents & FLUX_POLLIN)) {
         flux_msg_t *msg;
 
-        if (!(msg = recvfd (conn->in.fd, &conn->in.iobuf))) {
-            if (errno != EWOULDBLOCK && errno != EAGAIN)
-                goto error;
-        }
-        else {
+        /* recvfd() reads ahead, so one read may yield several messages.
+         * Deliver all that are buffered before returning to the reactor,
+         * since the fd won't signal POLLIN again for data already read.
+         */
+        do {
+            if (!(msg = recvfd (conn->in.fd, &conn->in.iobuf))) {
+                if (errno != EWOULDBLOCK && errno != EAGAIN)
+                    goto error;
+                break;
+            }
             /* Update message credentials based on connected creds.
              */
-            if (auth_init_message (msg, &conn->cred) < 0)
+            if (auth_init_message (msg, &conn->cred) < 0) {
+                ERRNO_SAFE_WRAP (flux_msg_destroy, msg);
                 goto error;
-
+            }
             if (conn->recv_cb)
                 conn->recv_cb (conn, msg, conn->recv_arg);
             flux_msg_destroy (msg);
-        }
+        } while (iobuf_recv_ready (&conn->in.iobuf));
     }
     return;
 error:
@@ -251,9 +261,25 @@ static void conn_write_cb (flux_reactor_t *r,
     }
 
     if ((revents & FLUX_POLLOUT)) {
-        const flux_msg_t *msg = zlist_head (conn->outqueue);
-        if (msg) {
-            if (sendfd (conn->out.fd, msg, &conn->out.iobuf) < 0) {
+        const flux_msg_t *msgs[USOCK_SEND_BATCH];
+        int count;
+        int n;
+
+        /* Drain the queue in batches, each coalesced by sendfd_multi()
+         * into a single write, until it is empty or the socket is full.
+         */
+        do {
+            const flux_msg_t *msg = zlist_first (conn->outqueue);
+
+            count = 0;
+            while (msg && count < USOCK_SEND_BATCH) {
+                msgs[count++] = msg;
+                msg = zlist_next (conn->outqueue);
+            }
+            if ((n = sendfd_multi (conn->out.fd,
+                                   msgs,
+                                   count,
+                                   &conn->out.iobuf)) < 0) {
                 if (errno == EPIPE) {
                     /* Remote peer has closed connection.
                      * However, there may still be pending messages sent
@@ -268,13 +294,15 @@ static void conn_write_cb (flux_reactor_t *r,
                 }
                 else if (errno != EWOULDBLOCK && errno != EAGAIN)
                     goto error;
+                break;
             }
-            else {
+            while (n-- > 0)
                 (void) conn_outqueue_drop (conn);
-                if (zlist_size (conn->outqueue) == 0)
-                    flux_watcher_stop (conn->out.w);
-            }
-        }
+        } while (count == USOCK_SEND_BATCH
+                 && !iobuf_send_pending (&conn->out.iobuf));
+        if (zlist_size (conn->outqueue) == 0
+            && !iobuf_send_pending (&conn->out.iobuf))
+            flux_watcher_stop (conn->out.w);
     }
     return;
 error:
@@ -563,7 +591,7 @@ int usock_client_pollevents (struct usock_client *client)
 
     if (poll (&pfd, 1, 0) < 0)
         return FLUX_POLLERR;
-    if ((pfd.revents & POLLIN))
+    if ((pfd.revents & POLLIN) || iobuf_recv_ready (&client->in_iobuf))
         flux_revents |= FLUX_POLLIN;
     if ((pfd.revents & POLLOUT))
         flux_revents |= FLUX_POLLOUT;
@@ -13,9 +13,14 @@
 #endif
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <wait.h>
+#include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <signal.h>
+#include <pthread.h>
 
 #include <czmq.h>
 
@@ -633,6 +638,276 @@ static int local_fork (flux_subprocess_t *p)
     return (0);
 }
 
+/* Everything a vfork(2) child needs, prepared by the parent, so that
+ * the child only makes system calls and does not touch the heap or
+ * any state shared with the parent other than 'errnum'.
+ */
+struct local_spawn {
+    int stdio[3];               // fd to dup2 onto 0, 1, 2, or -1
+    bool stdio_close[3];        // close 0, 1, 2 if there is no fd
+    int *keep;                  // channel fds to keep open across exec
+    int keep_count;
+    const char *cwd;
+    char *path;                 // argv[0] resolved against env PATH
+    int path_errnum;            // errno for exec if path is NULL
+    char **argv;
+    char **env;
+    bool setpgrp;
+
+    volatile int errnum;        // set by child on failure
+    volatile bool exec_failed;
+};
+
+static void spawn_write_err (const char *s)
+{
+    if (write (STDERR_FILENO, s, strlen (s)) < 0)
+        return;
+}
+
+static void closefd_spawn (void *arg, int fd)
+{
+    struct local_spawn *sp = arg;
+    int i;
+
+    if (fd < 3)
+        return;
+    for (i = 0; i < sp->keep_count; i++) {
+        if (sp->keep[i] == fd) {
+            (void) fd_unset_cloexec (fd);
+            return;
+        }
+    }
+    close (fd);
+}
+
+/* Child side of vfork(2).  The child shares memory with the parent
+ * (suspended until exec or _exit), so unlike local_child(), reset any
+ * signal handlers before unblocking signals, and report errors through
+ * 'sp' rather than sync_fds.
+ */
+static void __attribute__((noreturn)) local_spawn_child (struct local_spawn *sp)
+{
+    sigset_t mask;
+    int sig;
+    int i;
+
+    for (sig = 1; sig < _NSIG; sig++) {
+        struct sigaction sa;
+        if (sigaction (sig, NULL, &sa) == 0
+            && sa.sa_handler != SIG_DFL
+            && sa.sa_handler != SIG_IGN) {
+            sa.sa_handler = SIG_DFL;
+            sa.sa_flags = 0;
+            sigemptyset (&sa.sa_mask);
+            (void) sigaction (sig, &sa, NULL);
+        }
+    }
+    sigemptyset (&mask);
+    if (sigprocmask (SIG_SETMASK, &mask, NULL) < 0)
+        goto error;
+
+    for (i = 0; i < 3; i++) {
+        if (sp->stdio[i] >= 0) {
+            if (dup2 (sp->stdio[i], i) < 0)
+                goto error;
+        }
+        else if (sp->stdio_close[i])
+            close (i);
+    }
+
+    if (sp->cwd && chdir (sp->cwd) < 0) {
+        spawn_write_err ("Could not change dir to ");
+        spawn_write_err (sp->cwd);
+        spawn_write_err (". Going to /tmp instead\n");
+        if (chdir ("/tmp") < 0)
+            goto error;
+    }
+
+    if (fdwalk (closefd_spawn, sp) < 0)
+        goto error;
+
+    if (sp->setpgrp && setpgrp () < 0)
+        goto error;
+
+#if CODE_COVERAGE_ENABLED
+    __gcov_flush ();
+#endif
+    if (sp->path)
+        execve (sp->path, sp->argv, sp->env);
+    else
+        errno = sp->path_errnum;
+    sp->exec_failed = true;
+error:
+    sp->errnum = errno;
+    _exit (1);
+}
+
+/* Search for 'name' as execvp(3) would, but in the PATH of the command
+ * environment 'env' rather than of the caller, since the vfork child
+ * cannot safely do that itself.  Relative PATH elements are taken
+ * relative to 'cwd', if set.  On success, set sp->path.  If no executable
+ * is found, leave sp->path NULL and set sp->path_errnum to the errno
+ * that exec should fail with.  Return -1 only if out of memory.
+ */
+static int local_spawn_find_path (struct local_spawn *sp, const char *name)
+{
+    const char *path = "/bin:/usr/bin";
+    const char *dir;
+    int i;
+
+    sp->path_errnum = ENOENT;
+    if (!name || strlen (name) == 0)
+        return 0;
+    if (strchr (name, '/'))
+        return (sp->path = strdup (name)) ? 0 : -1;
+    for (i = 0; sp->env[i] != NULL; i++) {
+        if (!strncmp (sp->env[i], "PATH=", 5)) {
+            path = sp->env[i] + 5;
+            break;
+        }
+    }
+    dir = path;
+    while (dir) {
+        const char *end = strchrnul (dir, ':');
+        int dirlen = end - dir;
+        char *candidate;
+        int rc;
+
+        if (dirlen == 0)
+            rc = asprintf (&candidate, "%s/%s", sp->cwd ? sp->cwd : ".", name);
+        else if (dir[0] != '/' && sp->cwd)
+            rc = asprintf (&candidate, "%s/%.*s/%s",
+                           sp->cwd, dirlen, dir, name);
+        else
+            rc = asprintf (&candidate, "%.*s/%s", dirlen, dir, name);
+        if (rc < 0)
+            return -1;
+        if (access (candidate, X_OK) == 0) {
+            struct stat sb;
+            if (stat (candidate, &sb) == 0 && S_ISREG (sb.st_mode)) {
+                sp->path = candidate;
+                return 0;
+            }
+        }
+        else if (errno == EACCES)
+            sp->path_errnum = EACCES;
+        free (candidate);
+        dir = *end ? end + 1 : NULL;
+    }
+    return 0;
+}
+
+static int local_spawn_prepare (flux_subprocess_t *p, struct local_spawn *sp)
+{
+    const char *stdio_names[] = { "stdin", "stdout", "stderr" };
+    struct subprocess_channel *c;
+    int i;
+
+    memset (sp, 0, sizeof (*sp));
+    for (i = 0; i < 3; i++) {
+        sp->stdio[i] = -1;
+        if (!(p->flags & FLUX_SUBPROCESS_FLAGS_STDIO_FALLTHROUGH)) {
+            if ((c = zhash_lookup (p->channels, stdio_names[i])))
+                sp->stdio[i] = c->child_fd;
+            else if (i > 0)
+                sp->stdio_close[i] = true;
+        }
+    }
+    if (!(sp->keep = calloc (zhash_size (p->channels) + 1, sizeof (int))))
+        return -1;
+    c = zhash_first (p->channels);
+    while (c) {
+        if (c->child_fd != -1)
+            sp->keep[sp->keep_count++] = c->child_fd;
+        c = zhash_next (p->channels);
+    }
+    sp->cwd = flux_cmd_getcwd (p->cmd);
+    sp->setpgrp = (p->flags & FLUX_SUBPROCESS_FLAGS_SETPGRP) ? true : false;
+    if (!(sp->env = flux_cmd_env_expand (p->cmd))
+        || !(sp->argv = flux_cmd_argv_expand (p->cmd))
+        || local_spawn_find_path (sp, sp->argv[0]) < 0) {
+        free (sp->argv);
+        free (sp->env);
+        free (sp->keep);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+static void local_spawn_cleanup (struct local_spawn *sp)
+{
+    int saved_errno = errno;
+    free (sp->keep);
+    free (sp->path);
+    free (sp->argv);
+    free (sp->env);
+    errno = saved_errno;
+}
+
+/* Start the child with vfork(2), which avoids copying the parent's page
+ * tables, and return once it has called exec(2) or failed.  There is no
+ * point between fork and exec at which the parent runs, so this is only
+ * used when no pre_exec or post_fork hook is set.
+ */
+static int local_spawn (flux_subprocess_t *p)
+{
+    struct local_spawn sp;
+    sigset_t all, old;
+    pid_t pid;
+    int status;
+
+    if (local_spawn_prepare (p, &sp) < 0)
+        return -1;
+
+    /* Block signals so no handler of the parent runs in the child
+     * before local_spawn_child() resets them.
+     */
+    sigfillset (&all);
+    pthread_sigmask (SIG_SETMASK, &all, &old);
+    pid = vfork ();
+    if (pid == 0)
+        local_spawn_child (&sp); /* No return */
+    pthread_sigmask (SIG_SETMASK, &old, NULL);
+    if (pid < 0)
+        goto error;
+    p->pid = pid;
+
+    close_child_fds (p);
+    close (p->sync_fds[0]);
+    p->sync_fds[0] = -1;
+
+    if (sp.errnum != 0) {
+        /* As in local_exec(), reap the child so the caller need not.
+         */
+        if (waitpid (p->pid, &status, 0) <= 0)
+            goto error;
+        p->status = status;
+        if (sp.exec_failed)
+            p->exec_failed_errno = sp.errnum;
+        errno = sp.errnum;
+        goto error;
+    }
+    p->pid_set = true;
+
+    /* no-op if reactor is !FLUX_REACTOR_SIGCHLD */
+    if (!(p->child_w = flux_child_watcher_create (p->reactor,
+                                                  p->pid,
+                                                  true,
+                                                  child_watch_cb,
+                                                  p))) {
+        flux_log_error (p->h, "flux_child_watcher_create");
+        goto error;
+    }
+    flux_watcher_start (p->child_w);
+    p->state = FLUX_SUBPROCESS_RUNNING;
+    local_spawn_cleanup (&sp);
+    return 0;
+error:
+    local_spawn_cleanup (&sp);
+    return -1;
+}
+
 /*  Signal child to proceed with exec(2) and read any error from exec
  *   back on sync_fds.  Return < 0 on failure to signal, or > 0 errnum if
  *   an exec error was returned from child.
@@ -712,10 +987,18 @@ int subprocess_local_setup (flux_subprocess_t *p)
         return -1;
     if (local_setup_channels (p) < 0)
         return -1;
-    if (local_fork (p) < 0)
-        return -1;
-    if (local_exec (p) < 0)
-        return -1;
+    if (!p->hooks.pre_exec
+        && !p->hooks.post_fork
+        && !(p->flags & FLUX_SUBPROCESS_FLAGS_FORK_EXEC)) {
+        if (local_spawn (p) < 0)
+            return -1;
+    }
+    else {
+        if (local_fork (p) < 0)
+            return -1;
+        if (local_exec (p) < 0)
+            return -1;
+    }
     if (start_local_watchers (p) < 0)
         return -1;
     return 0;
@@ -66,6 +66,10 @@ enum {
     FLUX_SUBPROCESS_FLAGS_STDIO_FALLTHROUGH = 1,
     /* flux_exec(): call setpgrp() before exec(2) */
     FLUX_SUBPROCESS_FLAGS_SETPGRP = 2,
+    /* flux_exec(): always start the process with fork(2).  By default,
+     * vfork(2) is used when there is no pre_exec or post_fork hook.
+     */
+    FLUX_SUBPROCESS_FLAGS_FORK_EXEC = 4,
 };
 
 /*
@@ -18,6 +18,7 @@
 #include <sys/mman.h>
 
 #include "src/common/libtap/tap.h"
+#include "src/common/libutil/monotime.h"
 #include "src/common/libsubprocess/subprocess.h"
 
 extern char **environ;
@@ -2599,6 +2600,153 @@ void test_post_fork_hook (flux_reactor_t *r)
     flux_cmd_destroy (cmd);
 }
 
+void test_fork_exec_flag (flux_reactor_t *r)
+{
+    char *av[] = { "/bin/true", NULL };
+    char *av_enoent[] = { "/usr/bin/foobarbaz", NULL };
+    flux_cmd_t *cmd;
+    flux_subprocess_t *p = NULL;
+    flux_subprocess_ops_t ops = {
+        .on_completion = completion_cb
+    };
+
+    ok ((cmd = flux_cmd_create (1, av, NULL)) != NULL, "flux_cmd_create");
+    completion_cb_count = 0;
+    p = flux_local_exec (r, FLUX_SUBPROCESS_FLAGS_FORK_EXEC, cmd, &ops, NULL);
+    ok (p != NULL, "flux_local_exec with FORK_EXEC flag");
+    ok (flux_reactor_run (r, 0) == 0, "flux_reactor_run returned zero status");
+    ok (completion_cb_count == 1, "completion callback called 1 time");
+    flux_subprocess_destroy (p);
+    flux_cmd_destroy (cmd);
+
+    ok ((cmd = flux_cmd_create (1, av_enoent, NULL)) != NULL,
+        "flux_cmd_create");
+    p = flux_local_exec (r, FLUX_SUBPROCESS_FLAGS_FORK_EXEC, cmd, NULL, NULL);
+    ok (p == NULL && errno == ENOENT,
+        "flux_local_exec with FORK_EXEC flag failed with ENOENT");
+    flux_cmd_destroy (cmd);
+}
+
+void test_cwd (flux_reactor_t *r)
+{
+    char *av_root[] = { "/bin/sh", "-c", "test $(pwd) = /", NULL };
+    char *av_tmp[] = { "/bin/sh", "-c", "test $(pwd) = /tmp", NULL };
+    flux_cmd_t *cmd;
+    flux_subprocess_t *p = NULL;
+    flux_subprocess_ops_t ops = {
+        .on_completion = completion_cb
+    };
+
+    ok ((cmd = flux_cmd_create (3, av_root, NULL)) != NULL, "flux_cmd_create");
+    ok (flux_cmd_setcwd (cmd, "/") == 0, "flux_cmd_setcwd /");
+    completion_cb_count = 0;
+    p = flux_local_exec (r, 0, cmd, &ops, NULL);
+    ok (p != NULL, "flux_local_exec");
+    ok (flux_reactor_run (r, 0) == 0, "flux_reactor_run returned zero status");
+    ok (completion_cb_count == 1, "command ran in /");
+    flux_subprocess_destroy (p);
+    flux_cmd_destroy (cmd);
+
+    ok ((cmd = flux_cmd_create (3, av_tmp, NULL)) != NULL, "flux_cmd_create");
+    ok (flux_cmd_setcwd (cmd, "/nonexistent-dir") == 0,
+        "flux_cmd_setcwd /nonexistent-dir");
+    completion_cb_count = 0;
+    p = flux_local_exec (r, 0, cmd, &ops, NULL);
+    ok (p != NULL, "flux_local_exec");
+    ok (flux_reactor_run (r, 0) == 0, "flux_reactor_run returned zero status");
+    ok (completion_cb_count == 1, "command with bad cwd ran in /tmp");
+    flux_subprocess_destroy (p);
+    flux_cmd_destroy (cmd);
+}
+
+/* A command without a slash is found in the PATH of the command
+ * environment, not that of the caller.
+ */
+void test_cmd_path (flux_reactor_t *r)
+{
+    char *av[] = { "test_echo", "-O", "hi", NULL };
+    int flags[] = { FLUX_SUBPROCESS_FLAGS_FORK_EXEC, 0 };
+    const char *names[] = { "fork", "vfork" };
+    flux_cmd_t *cmd;
+    flux_subprocess_t *p = NULL;
+    flux_subprocess_ops_t ops = {
+        .on_completion = completion_cb
+    };
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        ok ((cmd = flux_cmd_create (3, av, NULL)) != NULL, "flux_cmd_create");
+        ok (flux_cmd_setenvf (cmd, 1, "PATH", "/nonexistent:%s",
+                              TEST_SUBPROCESS_DIR) == 0,
+            "flux_cmd_setenvf PATH");
+        completion_cb_count = 0;
+        p = flux_local_exec (r, flags[i], cmd, &ops, NULL);
+        ok (p != NULL,
+            "%s: flux_local_exec found command in cmd PATH", names[i]);
+        ok (flux_reactor_run (r, 0) == 0,
+            "flux_reactor_run returned zero status");
+        ok (completion_cb_count == 1, "completion callback called 1 time");
+        flux_subprocess_destroy (p);
+        flux_cmd_destroy (cmd);
+
+        ok ((cmd = flux_cmd_create (3, av, NULL)) != NULL, "flux_cmd_create");
+        ok (flux_cmd_setenvf (cmd, 1, "PATH", "/nonexistent") == 0,
+            "flux_cmd_setenvf PATH");
+        p = flux_local_exec (r, flags[i], cmd, &ops, NULL);
+        ok (p == NULL && errno == ENOENT,
+            "%s: flux_local_exec fails with ENOENT if not in cmd PATH",
+            names[i]);
+        flux_cmd_destroy (cmd);
+    }
+}
+
+int rate_cb_count;
+
+void rate_completion_cb (flux_subprocess_t *p)
+{
+    rate_cb_count++;
+}
+
+/* Not a test as such: report how many processes per second can be
+ * started serially with fork(2) and with vfork(2).
+ */
+void test_spawn_rate (flux_reactor_t *r)
+{
+    char *av[] = { "/bin/true", NULL };
+    int flags[] = { FLUX_SUBPROCESS_FLAGS_FORK_EXEC, 0 };
+    const char *names[] = { "fork", "vfork" };
+    int count = 200;
+    flux_subprocess_ops_t ops = {
+        .on_completion = rate_completion_cb
+    };
+    flux_cmd_t *cmd;
+    struct timespec t;
+    int i, j;
+
+    if (!(cmd = flux_cmd_create (1, av, NULL)))
+        BAIL_OUT ("flux_cmd_create failed");
+    for (i = 0; i < 2; i++) {
+        rate_cb_count = 0;
+        monotime (&t);
+        for (j = 0; j < count; j++) {
+            flux_subprocess_t *p;
+            if (!(p = flux_local_exec (r, flags[i], cmd, &ops, NULL)))
+                break;
+            if (flux_reactor_run (r, 0) < 0) {
+                flux_subprocess_destroy (p);
+                break;
+            }
+            flux_subprocess_destroy (p);
+        }
+        ok (rate_cb_count == count,
+            "%s: started %d processes", names[i], count);
+        diag ("%s: %.1f processes/sec",
+              names[i],
+              count / (monotime_since (t) / 1000.));
+    }
+    flux_cmd_destroy (cmd);
+}
+
 int main (int argc, char *argv[])
 {
     flux_reactor_t *r;
@@ -2704,6 +2852,14 @@ int main (int argc, char *argv[])
     test_pre_exec_hook (r);
     diag ("post_fork_hook");
     test_post_fork_hook (r);
+    diag ("fork_exec_flag");
+    test_fork_exec_flag (r);
+    diag ("cwd");
+    test_cwd (r);
+    diag ("cmd_path");
+    test_cmd_path (r);
+    diag ("spawn_rate");
+    test_spawn_rate (r);
 
     end_fdcount = fdcount ();
 
@@ -0,0 +1,312 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* blake3.c - portable BLAKE3
+ *
+ * This is a straightforward implementation of the BLAKE3 specification,
+ * structured like the reference implementation: input is split into
+ * 1024 byte chunks, each chunk is compressed 64 bytes at a time into a
+ * chaining value, and chaining values are merged into a binary tree
+ * using a stack, so memory use is fixed regardless of input size.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+
+#include "blake3.h"
+
+enum {
+    CHUNK_START = 1 << 0,
+    CHUNK_END = 1 << 1,
+    PARENT = 1 << 2,
+    ROOT = 1 << 3,
+};
+
+static const uint32_t IV[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+    0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+};
+
+static const uint8_t MSG_SCHEDULE[7][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8},
+    {3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1},
+    {10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6},
+    {12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4},
+    {9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7},
+    {11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13},
+};
+
+/* An output is the input to the final compression of a chunk or parent
+ * node, held back until we know whether it is the root.
+ */
+struct output {
+    uint32_t cv[8];
+    uint8_t block[BLAKE3_BLOCK_LEN];
+    uint64_t counter;
+    uint8_t block_len;
+    uint8_t flags;
+};
+
+static inline uint32_t rotr32 (uint32_t w, int c)
+{
+    return (w >> c) | (w << (32 - c));
+}
+
+static inline uint32_t load32 (const uint8_t *p)
+{
+    return ((uint32_t)p[0]) | ((uint32_t)p[1] << 8)
+         | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store32 (uint8_t *p, uint32_t w)
+{
+    p[0] = w;
+    p[1] = w >> 8;
+    p[2] = w >> 16;
+    p[3] = w >> 24;
+}
+
+static inline void g (uint32_t *s, int a, int b, int c, int d,
+                      uint32_t x, uint32_t y)
+{
+    s[a] = s[a] + s[b] + x;
+    s[d] = rotr32 (s[d] ^ s[a], 16);
+    s[c] = s[c] + s[d];
+    s[b] = rotr32 (s[b] ^ s[c], 12);
+    s[a] = s[a] + s[b] + y;
+    s[d] = rotr32 (s[d] ^ s[a], 8);
+    s[c] = s[c] + s[d];
+    s[b] = rotr32 (s[b] ^ s[c], 7);
+}
+
+static void compress (const uint32_t cv[8],
+                      const uint8_t block[BLAKE3_BLOCK_LEN],
+                      uint8_t block_len,
+                      uint64_t counter,
+                      uint8_t flags,
+                      uint32_t out[16])
+{
+    uint32_t m[16];
+    uint32_t s[16];
+    int r, i;
+
+    for (i = 0; i < 16; i++)
+        m[i] = load32 (block + 4 * i);
+    for (i = 0; i < 8; i++)
+        s[i] = cv[i];
+    s[8] = IV[0];
+    s[9] = IV[1];
+    s[10] = IV[2];
+    s[11] = IV[3];
+    s[12] = (uint32_t)counter;
+    s[13] = (uint32_t)(counter >> 32);
+    s[14] = block_len;
+    s[15] = flags;
+
+    for (r = 0; r < 7; r++) {
+        const uint8_t *sched = MSG_SCHEDULE[r];
+
+        g (s, 0, 4, 8, 12, m[sched[0]], m[sched[1]]);
+        g (s, 1, 5, 9, 13, m[sched[2]], m[sched[3]]);
+        g (s, 2, 6, 10, 14, m[sched[4]], m[sched[5]]);
+        g (s, 3, 7, 11, 15, m[sched[6]], m[sched[7]]);
+        g (s, 0, 5, 10, 15, m[sched[8]], m[sched[9]]);
+        g (s, 1, 6, 11, 12, m[sched[10]], m[sched[11]]);
+        g (s, 2, 7, 8, 13, m[sched[12]], m[sched[13]]);
+        g (s, 3, 4, 9, 14, m[sched[14]], m[sched[15]]);
+    }
+    for (i = 0; i < 8; i++) {
+        out[i] = s[i] ^ s[i + 8];
+        out[i + 8] = s[i + 8] ^ cv[i];
+    }
+}
+
+static void output_cv (const struct output *o, uint32_t cv[8])
+{
+    uint32_t out[16];
+
+    compress (o->cv, o->block, o->block_len, o->counter, o->flags, out);
+    memcpy (cv, out, 8 * sizeof (uint32_t));
+}
+
+static void output_root_bytes (const struct output *o,
+                               uint8_t *out,
+                               size_t out_len)
+{
+    uint64_t counter = 0;
+    uint32_t words[16];
+    uint8_t block[BLAKE3_BLOCK_LEN];
+    size_t n;
+    int i;
+
+    while (out_len > 0) {
+        compress (o->cv, o->block, o->block_len, counter++,
+                  o->flags | ROOT, words);
+        for (i = 0; i < 16; i++)
+            store32 (block + 4 * i, words[i]);
+        n = out_len < sizeof (block) ? out_len : sizeof (block);
+        memcpy (out, block, n);
+        out += n;
+        out_len -= n;
+    }
+}
+
+static void parent_output (const uint32_t left[8],
+                           const uint32_t right[8],
+                           struct output *o)
+{
+    int i;
+
+    memcpy (o->cv, IV, sizeof (o->cv));
+    for (i = 0; i < 8; i++) {
+        store32 (o->block + 4 * i, left[i]);
+        store32 (o->block + 32 + 4 * i, right[i]);
+    }
+    o->counter = 0;
+    o->block_len = BLAKE3_BLOCK_LEN;
+    o->flags = PARENT;
+}
+
+static void chunk_init (blake3_chunk_state *cs, uint64_t chunk_counter)
+{
+    memcpy (cs->cv, IV, sizeof (cs->cv));
+    cs->chunk_counter = chunk_counter;
+    memset (cs->buf, 0, sizeof (cs->buf));
+    cs->buf_len = 0;
+    cs->blocks_compressed = 0;
+}
+
+static size_t chunk_len (const blake3_chunk_state *cs)
+{
+    return BLAKE3_BLOCK_LEN * (size_t)cs->blocks_compressed + cs->buf_len;
+}
+
+static uint8_t chunk_start_flag (const blake3_chunk_state *cs)
+{
+    return cs->blocks_compressed == 0 ? CHUNK_START : 0;
+}
+
+/* Add up to one chunk of input.  The last block is buffered, not
+ * compressed, since it must be compressed with CHUNK_END.
+ */
+static void chunk_update (blake3_chunk_state *cs,
+                          const uint8_t *input,
+                          size_t input_len)
+{
+    while (input_len > 0) {
+        size_t n;
+
+        if (cs->buf_len == BLAKE3_BLOCK_LEN) {
+            uint32_t out[16];
+
+            compress (cs->cv, cs->buf, BLAKE3_BLOCK_LEN, cs->chunk_counter,
+                      chunk_start_flag (cs), out);
+            memcpy (cs->cv, out, sizeof (cs->cv));
+            cs->blocks_compressed++;
+            memset (cs->buf, 0, sizeof (cs->buf));
+            cs->buf_len = 0;
+        }
+        n = BLAKE3_BLOCK_LEN - cs->buf_len;
+        if (n > input_len)
+            n = input_len;
+        memcpy (cs->buf + cs->buf_len, input, n);
+        cs->buf_len += n;
+        input += n;
+        input_len -= n;
+    }
+}
+
+static void chunk_output (const blake3_chunk_state *cs, struct output *o)
+{
+    memcpy (o->cv, cs->cv, sizeof (o->cv));
+    memcpy (o->block, cs->buf, sizeof (o->block));
+    o->counter = cs->chunk_counter;
+    o->block_len = cs->buf_len;
+    o->flags = chunk_start_flag (cs) | CHUNK_END;
+}
+
+/* Push the chaining value of a completed chunk, first merging completed
+ * subtrees.  The number of trailing zero bits in the total number of
+ * chunks is the number of subtrees that this chunk completes.
+ */
+static void push_chunk_cv (blake3_hasher *self,
+                           uint32_t cv[8],
+                           uint64_t total_chunks)
+{
+    while ((total_chunks & 1) == 0) {
+        struct output o;
+
+        parent_output (self->cv_stack[--self->cv_stack_len], cv, &o);
+        output_cv (&o, cv);
+        total_chunks >>= 1;
+    }
+    memcpy (self->cv_stack[self->cv_stack_len++], cv, 8 * sizeof (uint32_t));
+}
+
+void blake3_hasher_init (blake3_hasher *self)
+{
+    chunk_init (&self->chunk, 0);
+    self->cv_stack_len = 0;
+}
+
+void blake3_hasher_update (blake3_hasher *self,
+                           const void *input,
+                           size_t input_len)
+{
+    const uint8_t *p = input;
+
+    while (input_len > 0) {
+        size_t n;
+
+        /* Finish the current chunk only once more input has arrived,
+         * since the last chunk must be handled by finalize.
+         */
+        if (chunk_len (&self->chunk) == BLAKE3_CHUNK_LEN) {
+            struct output o;
+            uint32_t cv[8];
+            uint64_t total_chunks = self->chunk.chunk_counter + 1;
+
+            chunk_output (&self->chunk, &o);
+            output_cv (&o, cv);
+            push_chunk_cv (self, cv, total_chunks);
+            chunk_init (&self->chunk, total_chunks);
+        }
+        n = BLAKE3_CHUNK_LEN - chunk_len (&self->chunk);
+        if (n > input_len)
+            n = input_len;
+        chunk_update (&self->chunk, p, n);
+        p += n;
+        input_len -= n;
+    }
+}
+
+void blake3_hasher_finalize (const blake3_hasher *self,
+                             uint8_t *out,
+                             size_t out_len)
+{
+    struct output o;
+    int i;
+
+    chunk_output (&self->chunk, &o);
+    for (i = self->cv_stack_len - 1; i >= 0; i--) {
+        uint32_t cv[8];
+
+        output_cv (&o, cv);
+        parent_output (self->cv_stack[i], cv, &o);
+    }
+    output_root_bytes (&o, out, out_len);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,56 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_BLAKE3_H
+#define _UTIL_BLAKE3_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Portable BLAKE3 hash (default 32 byte output, unkeyed mode only).
+ * See https://github.com/BLAKE3-team/BLAKE3-specs
+ */
+
+#define BLAKE3_OUT_LEN      32
+#define BLAKE3_BLOCK_LEN    64
+#define BLAKE3_CHUNK_LEN    1024
+#define BLAKE3_MAX_DEPTH    54
+
+typedef struct {
+    uint32_t cv[8];
+    uint64_t chunk_counter;
+    uint8_t buf[BLAKE3_BLOCK_LEN];
+    uint8_t buf_len;
+    uint8_t blocks_compressed;
+} blake3_chunk_state;
+
+typedef struct {
+    blake3_chunk_state chunk;
+    uint8_t cv_stack_len;
+    uint32_t cv_stack[BLAKE3_MAX_DEPTH][8];
+} blake3_hasher;
+
+void blake3_hasher_init (blake3_hasher *self);
+void blake3_hasher_update (blake3_hasher *self,
+                           const void *input,
+                           size_t input_len);
+
+/* Write 'out_len' bytes of output to 'out'.  The hasher is not modified,
+ * so more input may be added afterwards.
+ */
+void blake3_hasher_finalize (const blake3_hasher *self,
+                             uint8_t *out,
+                             size_t out_len);
+
+#endif /* !_UTIL_BLAKE3_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
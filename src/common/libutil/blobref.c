@@ -20,6 +20,8 @@
 #include "blobref.h"
 #include "sha1.h"
 #include "sha256.h"
+#include "sha_x86.h"
+#include "blake3.h"
 
 #define SHA1_PREFIX_STRING  "sha1-"
 #define SHA1_PREFIX_LENGTH  5
@@ -29,6 +31,10 @@
 #define SHA256_PREFIX_LENGTH  7
 #define SHA256_STRING_SIZE    (SHA256_BLOCK_SIZE*2 + SHA256_PREFIX_LENGTH + 1)
 
+#define BLAKE3_PREFIX_STRING  "blake3-"
+#define BLAKE3_PREFIX_LENGTH  7
+#define BLAKE3_STRING_SIZE    (BLAKE3_OUT_LEN*2 + BLAKE3_PREFIX_LENGTH + 1)
+
 #if BLOBREF_MAX_STRING_SIZE < SHA1_STRING_SIZE
 #error BLOBREF_MAX_STRING_SIZE is too small
 #endif
@@ -41,9 +47,16 @@
 #if BLOBREF_MAX_DIGEST_SIZE < SHA256_BLOCK_SIZE
 #error BLOBREF_MAX_DIGEST_SIZE is too small
 #endif
+#if BLOBREF_MAX_STRING_SIZE < BLAKE3_STRING_SIZE
+#error BLOBREF_MAX_STRING_SIZE is too small
+#endif
+#if BLOBREF_MAX_DIGEST_SIZE < BLAKE3_OUT_LEN
+#error BLOBREF_MAX_DIGEST_SIZE is too small
+#endif
 
 static void sha1_hash (const void *data, int data_len, void *hash, int hash_len);
 static void sha256_hash (const void *data, int data_len, void *hash, int hash_len);
+static void blake3_hash (const void *data, int data_len, void *hash, int hash_len);
 
 struct blobhash {
     char *name;
@@ -60,14 +73,66 @@ static struct blobhash blobtab[] = {
       .hashlen = SHA256_BLOCK_SIZE,
       .hashfun = sha256_hash,
     },
+    { .name = "blake3",
+      .hashlen = BLAKE3_OUT_LEN,
+      .hashfun = blake3_hash,
+    },
     { NULL, 0, 0 },
 };
 
+/* Hash a complete message with a SHA-1/SHA-256 block function: run the
+ * block function over the whole blocks in place, then over one or two
+ * blocks holding the tail, the 0x80 terminator, and the bit length.
+ */
+static void md_blocks (void (*blocks)(uint32_t *state,
+                                      const uint8_t *data,
+                                      size_t nblocks),
+                       uint32_t *state,
+                       const uint8_t *data,
+                       size_t len)
+{
+    uint8_t tail[128];
+    size_t nblocks = len / 64;
+    size_t rem = len % 64;
+    size_t tail_len = rem < 56 ? 64 : 128;
+    uint64_t bitlen = (uint64_t)len * 8;
+    int i;
+
+    if (nblocks > 0)
+        blocks (state, data, nblocks);
+    memset (tail, 0, sizeof (tail));
+    memcpy (tail, data + nblocks * 64, rem);
+    tail[rem] = 0x80;
+    for (i = 0; i < 8; i++)
+        tail[tail_len - 1 - i] = bitlen >> (8 * i);
+    blocks (state, tail, tail_len / 64);
+}
+
+static void state_to_hash (const uint32_t *state, int nwords, uint8_t *hash)
+{
+    int i;
+
+    for (i = 0; i < nwords; i++) {
+        hash[i*4] = state[i] >> 24;
+        hash[i*4 + 1] = state[i] >> 16;
+        hash[i*4 + 2] = state[i] >> 8;
+        hash[i*4 + 3] = state[i];
+    }
+}
+
 static void sha1_hash (const void *data, int data_len, void *hash, int hash_len)
 {
     SHA1_CTX ctx;
 
     assert (hash_len == SHA1_DIGEST_SIZE);
+    if (sha_x86_supported ()) {
+        uint32_t state[5] = {
+            0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0,
+        };
+        md_blocks (sha1_x86_blocks, state, data, data_len);
+        state_to_hash (state, 5, hash);
+        return;
+    }
     SHA1_Init (&ctx);
     SHA1_Update (&ctx, data, data_len);
     SHA1_Final (&ctx, hash);
@@ -78,11 +143,30 @@ static void sha256_hash (const void *data, int data_len, void *hash, int hash_le
     SHA256_CTX ctx;
 
     assert (hash_len == SHA256_BLOCK_SIZE);
+    if (sha_x86_supported ()) {
+        uint32_t state[8] = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+            0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+        };
+        md_blocks (sha256_x86_blocks, state, data, data_len);
+        state_to_hash (state, 8, hash);
+        return;
+    }
     sha256_init (&ctx);
     sha256_update (&ctx, data, data_len);
     sha256_final (&ctx, hash);
 }
 
+static void blake3_hash (const void *data, int data_len, void *hash, int hash_len)
+{
+    blake3_hasher hasher;
+
+    assert (hash_len == BLAKE3_OUT_LEN);
+    blake3_hasher_init (&hasher);
+    blake3_hasher_update (&hasher, data, data_len);
+    blake3_hasher_finalize (&hasher, hash, hash_len);
+}
+
 /* true if s1 contains "s2-" prefix
  */
 static int prefixmatch (const char *s1, const char *s2)
@@ -0,0 +1,218 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <arpa/inet.h>
+
+#include "blobvec.h"
+
+struct blobvec {
+    uint8_t *buf;           /* encoded buffer */
+    int len;                /* bytes used in 'buf' */
+    int alloc;              /* bytes allocated in 'buf' (0 if not owned) */
+    int *offsets;           /* offset of each record header in 'buf' */
+    int count;
+    int offsets_alloc;
+    int readonly;           /* 'buf' is borrowed from blobvec_decode() */
+};
+
+void blobvec_destroy (blobvec_t *bv)
+{
+    if (bv) {
+        int saved_errno = errno;
+        if (!bv->readonly)
+            free (bv->buf);
+        free (bv->offsets);
+        free (bv);
+        errno = saved_errno;
+    }
+}
+
+blobvec_t *blobvec_create (void)
+{
+    blobvec_t *bv;
+
+    if (!(bv = calloc (1, sizeof (*bv)))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return bv;
+}
+
+static int grow_offsets (blobvec_t *bv)
+{
+    if (bv->count == bv->offsets_alloc) {
+        int n = bv->offsets_alloc ? bv->offsets_alloc * 2 : 16;
+        int *new;
+        if (!(new = realloc (bv->offsets, n * sizeof (new[0])))) {
+            errno = ENOMEM;
+            return -1;
+        }
+        bv->offsets = new;
+        bv->offsets_alloc = n;
+    }
+    return 0;
+}
+
+static int grow_buf (blobvec_t *bv, int need)
+{
+    if (bv->len + need > bv->alloc) {
+        int n = bv->alloc ? bv->alloc : 4096;
+        uint8_t *new;
+        while (n < bv->len + need) {
+            if (n > INT32_MAX / 2) {
+                errno = EOVERFLOW;
+                return -1;
+            }
+            n *= 2;
+        }
+        if (!(new = realloc (bv->buf, n))) {
+            errno = ENOMEM;
+            return -1;
+        }
+        bv->buf = new;
+        bv->alloc = n;
+    }
+    return 0;
+}
+
+static int append_record (blobvec_t *bv, int32_t hdr, const void *data, int len)
+{
+    uint32_t nhdr = htonl ((uint32_t)hdr);
+
+    if (!bv || bv->readonly) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (len > INT32_MAX - (int)sizeof (nhdr)) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    if (grow_offsets (bv) < 0 || grow_buf (bv, sizeof (nhdr) + len) < 0)
+        return -1;
+    bv->offsets[bv->count++] = bv->len;
+    memcpy (bv->buf + bv->len, &nhdr, sizeof (nhdr));
+    bv->len += sizeof (nhdr);
+    if (len > 0) {
+        memcpy (bv->buf + bv->len, data, len);
+        bv->len += len;
+    }
+    return 0;
+}
+
+int blobvec_append (blobvec_t *bv, const void *data, int len)
+{
+    if (len < 0 || (len > 0 && !data)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return append_record (bv, len, data, len);
+}
+
+int blobvec_append_error (blobvec_t *bv, int errnum)
+{
+    if (errnum <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return append_record (bv, -errnum, NULL, 0);
+}
+
+int blobvec_encode (blobvec_t *bv, const void **buf, int *len)
+{
+    if (!bv || !buf || !len) {
+        errno = EINVAL;
+        return -1;
+    }
+    *buf = bv->buf;
+    *len = bv->len;
+    return 0;
+}
+
+blobvec_t *blobvec_decode (const void *buf, int len)
+{
+    blobvec_t *bv;
+    int offset = 0;
+
+    if ((!buf && len > 0) || len < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(bv = blobvec_create ()))
+        return NULL;
+    bv->buf = (uint8_t *)buf;
+    bv->len = len;
+    bv->readonly = 1;
+    while (offset < len) {
+        uint32_t nhdr;
+        int32_t hdr;
+
+        if (len - offset < sizeof (nhdr))
+            goto proto;
+        memcpy (&nhdr, bv->buf + offset, sizeof (nhdr));
+        hdr = (int32_t)ntohl (nhdr);
+        if (hdr > len - offset - (int)sizeof (nhdr) || hdr == INT32_MIN)
+            goto proto;
+        if (grow_offsets (bv) < 0)
+            goto error;
+        bv->offsets[bv->count++] = offset;
+        offset += sizeof (nhdr);
+        if (hdr > 0)
+            offset += hdr;
+    }
+    return bv;
+proto:
+    errno = EPROTO;
+error:
+    blobvec_destroy (bv);
+    return NULL;
+}
+
+int blobvec_count (blobvec_t *bv)
+{
+    return bv ? bv->count : 0;
+}
+
+int blobvec_size (blobvec_t *bv)
+{
+    return bv ? bv->len : 0;
+}
+
+int blobvec_get (blobvec_t *bv, int index, const void **data, int *len)
+{
+    uint32_t nhdr;
+    int32_t hdr;
+
+    if (!bv || index < 0 || index >= bv->count) {
+        errno = EINVAL;
+        return -1;
+    }
+    memcpy (&nhdr, bv->buf + bv->offsets[index], sizeof (nhdr));
+    hdr = (int32_t)ntohl (nhdr);
+    if (hdr < 0) {
+        errno = -hdr;
+        return -1;
+    }
+    if (data)
+        *data = hdr > 0 ? bv->buf + bv->offsets[index] + sizeof (nhdr) : NULL;
+    if (len)
+        *len = hdr;
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
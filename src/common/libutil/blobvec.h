@@ -0,0 +1,68 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* blobvec - encode/decode a vector of blobs in a single buffer
+ *
+ * Each record consists of a 4 byte signed length in network byte order,
+ * followed by that many bytes of data.  A negative length encodes an
+ * error number (-errnum) for that slot, and is followed by no data.
+ *
+ * This is the payload format of the content.load-batch and
+ * content.store-batch requests and responses.
+ */
+
+#ifndef _UTIL_BLOBVEC_H
+#define _UTIL_BLOBVEC_H
+
+typedef struct blobvec blobvec_t;
+
+/* Create an empty blobvec for encoding.
+ */
+blobvec_t *blobvec_create (void);
+void blobvec_destroy (blobvec_t *bv);
+
+/* Append a copy of 'data' of length 'len' as the next record.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int blobvec_append (blobvec_t *bv, const void *data, int len);
+
+/* Append an error record.  'errnum' must be > 0.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int blobvec_append_error (blobvec_t *bv, int errnum);
+
+/* Access the encoded buffer.  Storage belongs to 'bv'.
+ */
+int blobvec_encode (blobvec_t *bv, const void **buf, int *len);
+
+/* Decode 'buf' into a read-only blobvec.  'buf' is not copied, and must
+ * remain valid for the lifetime of the returned blobvec.
+ * Returns blobvec on success, NULL on failure with errno set
+ * (EPROTO if 'buf' is malformed).
+ */
+blobvec_t *blobvec_decode (const void *buf, int len);
+
+/* Return the number of records, or the total size of the encoded buffer.
+ */
+int blobvec_count (blobvec_t *bv);
+int blobvec_size (blobvec_t *bv);
+
+/* Get record 'index'.  If the record is an error record, return -1 with
+ * errno set to its error number.  Storage for 'data' belongs to 'bv'
+ * (or the buffer it was decoded from).
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int blobvec_get (blobvec_t *bv, int index, const void **data, int *len);
+
+#endif /* !_UTIL_BLOBVEC_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,335 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* histogram.c - log-linear histogram
+ *
+ * Bucket index for value v, with SUB_COUNT = 2^PRECISION buckets of
+ * width 1 for the smallest values, and HALF_COUNT buckets for each
+ * power of two above that:
+ *
+ *   v < SUB_COUNT:  index = v
+ *   otherwise:      shift = msb(v) - (PRECISION - 1)
+ *                   index = SUB_COUNT + (shift - 1) * HALF_COUNT
+ *                         + (v >> shift) - HALF_COUNT
+ *
+ * i.e. the top PRECISION bits of v select the bucket within its
+ * power of two, as in HdrHistogram.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <jansson.h>
+
+#include "histogram.h"
+
+#define PRECISION   7
+#define SUB_COUNT   (1 << PRECISION)
+#define HALF_COUNT  (SUB_COUNT / 2)
+
+struct histogram {
+    uint64_t *counts;
+    int size;           // number of allocated buckets
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+};
+
+static int bucket_index (uint64_t value)
+{
+    int msb, shift;
+
+    if (value < SUB_COUNT)
+        return value;
+    msb = 63 - __builtin_clzll (value);
+    shift = msb - (PRECISION - 1);
+    return SUB_COUNT + (shift - 1) * HALF_COUNT + (value >> shift) - HALF_COUNT;
+}
+
+static uint64_t bucket_low (int index)
+{
+    int shift;
+
+    if (index < SUB_COUNT)
+        return index;
+    shift = (index - SUB_COUNT) / HALF_COUNT + 1;
+    return (uint64_t)((index - SUB_COUNT) % HALF_COUNT + HALF_COUNT) << shift;
+}
+
+static uint64_t bucket_high (int index)
+{
+    int shift;
+
+    if (index < SUB_COUNT)
+        return index;
+    shift = (index - SUB_COUNT) / HALF_COUNT + 1;
+    return bucket_low (index) + (((uint64_t)1 << shift) - 1);
+}
+
+/* Ensure there is a bucket for 'index'.
+ * Grow by at least one power of two at a time to limit reallocs.
+ */
+static int histogram_grow (struct histogram *h, int index)
+{
+    uint64_t *counts;
+    int size;
+
+    if (index < h->size)
+        return 0;
+    size = index + 1 + HALF_COUNT;
+    if (size < SUB_COUNT)
+        size = SUB_COUNT;
+    if (!(counts = realloc (h->counts, size * sizeof (counts[0])))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    memset (counts + h->size, 0, (size - h->size) * sizeof (counts[0]));
+    h->counts = counts;
+    h->size = size;
+    return 0;
+}
+
+void histogram_reset (struct histogram *h)
+{
+    if (h) {
+        if (h->counts)
+            memset (h->counts, 0, h->size * sizeof (h->counts[0]));
+        h->count = 0;
+        h->min = 0;
+        h->max = 0;
+        h->sum = 0;
+    }
+}
+
+void histogram_destroy (struct histogram *h)
+{
+    if (h) {
+        int saved_errno = errno;
+        free (h->counts);
+        free (h);
+        errno = saved_errno;
+    }
+}
+
+struct histogram *histogram_create (void)
+{
+    struct histogram *h;
+
+    if (!(h = calloc (1, sizeof (*h)))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return h;
+}
+
+/* Add 'n' occurrences of 'value'.
+ */
+static int histogram_add_n (struct histogram *h, uint64_t value, uint64_t n)
+{
+    int index = bucket_index (value);
+
+    if (histogram_grow (h, index) < 0)
+        return -1;
+    h->counts[index] += n;
+    if (h->count == 0 || value < h->min)
+        h->min = value;
+    if (h->count == 0 || value > h->max)
+        h->max = value;
+    h->count += n;
+    h->sum += (double)value * n;
+    return 0;
+}
+
+int histogram_add (struct histogram *h, uint64_t value)
+{
+    if (!h) {
+        errno = EINVAL;
+        return -1;
+    }
+    return histogram_add_n (h, value, 1);
+}
+
+int histogram_merge (struct histogram *dst, const struct histogram *src)
+{
+    int i;
+
+    if (!dst || !src) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (src->count == 0)
+        return 0;
+    if (histogram_grow (dst, src->size - 1) < 0)
+        return -1;
+    for (i = 0; i < src->size; i++)
+        dst->counts[i] += src->counts[i];
+    if (dst->count == 0 || src->min < dst->min)
+        dst->min = src->min;
+    if (dst->count == 0 || src->max > dst->max)
+        dst->max = src->max;
+    dst->count += src->count;
+    dst->sum += src->sum;
+    return 0;
+}
+
+uint64_t histogram_count (const struct histogram *h)
+{
+    return h ? h->count : 0;
+}
+
+uint64_t histogram_min (const struct histogram *h)
+{
+    return h ? h->min : 0;
+}
+
+uint64_t histogram_max (const struct histogram *h)
+{
+    return h ? h->max : 0;
+}
+
+double histogram_mean (const struct histogram *h)
+{
+    if (!h || h->count == 0)
+        return 0;
+    return h->sum / h->count;
+}
+
+uint64_t histogram_percentile (const struct histogram *h, double pct)
+{
+    double target;
+    uint64_t rank;
+    uint64_t total = 0;
+    uint64_t value;
+    int i;
+
+    if (!h || h->count == 0)
+        return 0;
+    if (pct < 0)
+        pct = 0;
+    if (pct > 100)
+        pct = 100;
+    target = pct / 100. * h->count;
+    rank = target;
+    if (rank < target)
+        rank++;
+    if (rank == 0)
+        rank = 1;
+    for (i = 0; i < h->size; i++) {
+        total += h->counts[i];
+        if (total >= rank)
+            break;
+    }
+    value = bucket_high (i);
+    if (value > h->max)
+        value = h->max;
+    if (value < h->min)
+        value = h->min;
+    return value;
+}
+
+json_t *histogram_encode (const struct histogram *h)
+{
+    json_t *buckets;
+    json_t *o;
+    int i;
+
+    if (!h) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(buckets = json_array ()))
+        goto nomem;
+    for (i = 0; i < h->size; i++) {
+        json_t *entry;
+
+        if (h->counts[i] == 0)
+            continue;
+        if (!(entry = json_pack ("[I I I]",
+                                 (json_int_t)bucket_low (i),
+                                 (json_int_t)bucket_high (i),
+                                 (json_int_t)h->counts[i]))
+            || json_array_append_new (buckets, entry) < 0)
+            goto nomem;
+    }
+    if (!(o = json_pack ("{s:I s:I s:I s:f s:I s:I s:I s:I s:O}",
+                         "count", (json_int_t)h->count,
+                         "min", (json_int_t)h->min,
+                         "max", (json_int_t)h->max,
+                         "mean", histogram_mean (h),
+                         "p50", (json_int_t)histogram_percentile (h, 50),
+                         "p90", (json_int_t)histogram_percentile (h, 90),
+                         "p99", (json_int_t)histogram_percentile (h, 99),
+                         "p99.9", (json_int_t)histogram_percentile (h, 99.9),
+                         "buckets", buckets)))
+        goto nomem;
+    json_decref (buckets);
+    return o;
+nomem:
+    json_decref (buckets);
+    errno = ENOMEM;
+    return NULL;
+}
+
+struct histogram *histogram_decode (json_t *o)
+{
+    struct histogram *h;
+    json_int_t count, min, max;
+    double mean;
+    json_t *buckets;
+    json_t *entry;
+    size_t index;
+
+    if (!o || json_unpack (o, "{s:I s:I s:I s:F s:o}",
+                           "count", &count,
+                           "min", &min,
+                           "max", &max,
+                           "mean", &mean,
+                           "buckets", &buckets) < 0
+           || !json_is_array (buckets)
+           || count < 0 || min < 0 || max < min) {
+        errno = EPROTO;
+        return NULL;
+    }
+    if (!(h = histogram_create ()))
+        return NULL;
+    json_array_foreach (buckets, index, entry) {
+        json_int_t lo, hi, n;
+
+        if (json_unpack (entry, "[I I I]", &lo, &hi, &n) < 0
+            || lo < 0 || hi < lo || n < 0
+            || bucket_index (lo) != bucket_index (hi)) {
+            errno = EPROTO;
+            goto error;
+        }
+        if (histogram_add_n (h, lo, n) < 0)
+            goto error;
+    }
+    if (h->count != count) {
+        errno = EPROTO;
+        goto error;
+    }
+    /* Restore exact values, which bucket boundaries only approximate.
+     */
+    h->min = min;
+    h->max = max;
+    h->sum = mean * count;
+    return h;
+error:
+    histogram_destroy (h);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,71 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_HISTOGRAM_H
+#define _UTIL_HISTOGRAM_H
+
+/* histogram - log-linear histogram of non-negative integer values
+ *
+ * Values below 128 are counted exactly.  Above that, each power of two
+ * is split into 64 equal buckets, so a value reported by the histogram
+ * is within 1/64 (about 1.6%) of the true value, at any magnitude.
+ * The bucket array grows to the largest value added, so a histogram of
+ * latencies in microseconds up to one second needs about 8K of memory.
+ *
+ * Typically used for latencies in microseconds, e.g.
+ *   histogram_add (h, monotime_since (t0) * 1000);
+ */
+
+#include <stdint.h>
+#include <jansson.h>
+
+struct histogram *histogram_create (void);
+void histogram_destroy (struct histogram *h);
+
+/* Clear all values.
+ */
+void histogram_reset (struct histogram *h);
+
+/* Add a value.  Returns 0 on success, -1 on failure with errno set.
+ */
+int histogram_add (struct histogram *h, uint64_t value);
+
+/* Add all the values in 'src' to 'dst'.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int histogram_merge (struct histogram *dst, const struct histogram *src);
+
+uint64_t histogram_count (const struct histogram *h);
+uint64_t histogram_min (const struct histogram *h);
+uint64_t histogram_max (const struct histogram *h);
+double histogram_mean (const struct histogram *h);
+
+/* Return the value at percentile 'pct' (0 to 100), that is, the
+ * smallest value such that 'pct' percent of values are less than
+ * or equal to it, rounded up to the top of its bucket.  Returns 0 if
+ * the histogram is empty.
+ */
+uint64_t histogram_percentile (const struct histogram *h, double pct);
+
+/* Encode/decode a histogram as JSON:
+ *   {"count":I "min":I "max":I "mean":f
+ *    "p50":I "p90":I "p99":I "p99.9":I
+ *    "buckets":[[lo,hi,count],...]}
+ * where "buckets" lists non-empty buckets in increasing order, and
+ * the percentile keys are informational (ignored by decode).
+ */
+json_t *histogram_encode (const struct histogram *h);
+struct histogram *histogram_decode (json_t *o);
+
+#endif /* !_UTIL_HISTOGRAM_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,234 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* sha_x86.c - SHA-1 and SHA-256 block functions using the x86 SHA
+ * extensions (SHA-NI), with runtime CPU detection.
+ *
+ * The message schedule and round structure follow Intel's "New
+ * Instructions Supporting the Secure Hash Algorithm on Intel
+ * Architecture Processors" (2013), written here as loops over groups
+ * of four rounds.  The loops must be unrolled so that register
+ * allocation of the message words and round function selectors work
+ * out, otherwise performance is no better than the portable code.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <assert.h>
+
+#include "sha_x86.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define HAVE_SHA_X86 1
+#endif
+
+#if HAVE_SHA_X86
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define SHA_X86_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+
+#if defined(__clang__)
+#define SHA_X86_UNROLL _Pragma ("unroll")
+#elif __GNUC__ >= 8
+#define SHA_X86_UNROLL _Pragma ("GCC unroll 20")
+#else
+#define SHA_X86_UNROLL
+#endif
+
+static const uint32_t k256[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static bool detect_sha_x86 (void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid_max (0, NULL) < 7)
+        return false;
+    __cpuid (1, eax, ebx, ecx, edx);
+    if (!(ecx & (1 << 9)) || !(ecx & (1 << 19)))    /* SSSE3, SSE4.1 */
+        return false;
+    __cpuid_count (7, 0, eax, ebx, ecx, edx);
+    if (!(ebx & (1 << 29)))                         /* SHA */
+        return false;
+    return true;
+}
+
+bool sha_x86_supported (void)
+{
+    /* N.B. the race here is benign, as all threads compute the same value.
+     */
+    static int supported = -1;
+
+    if (supported < 0)
+        supported = detect_sha_x86 () ? 1 : 0;
+    return supported == 1;
+}
+
+SHA_X86_TARGET
+void sha1_x86_blocks (uint32_t state[5], const uint8_t *data, size_t nblocks)
+{
+    const __m128i mask = _mm_set_epi64x (0x0001020304050607ULL,
+                                         0x08090a0b0c0d0e0fULL);
+    __m128i abcd, abcd_save, e_save;
+    __m128i e[2];
+    __m128i msg[4];
+    int i;
+
+    abcd = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *)state), 0x1B);
+    e[0] = _mm_set_epi32 (state[4], 0, 0, 0);
+
+    while (nblocks-- > 0) {
+        abcd_save = abcd;
+        e_save = e[0];
+
+        SHA_X86_UNROLL
+        for (i = 0; i < 20; i++) {
+            if (i < 4) {
+                msg[i] = _mm_loadu_si128 ((const __m128i *)(data + 16 * i));
+                msg[i] = _mm_shuffle_epi8 (msg[i], mask);
+            }
+            if (i == 0)
+                e[0] = _mm_add_epi32 (e[0], msg[0]);
+            else
+                e[i % 2] = _mm_sha1nexte_epu32 (e[i % 2], msg[i % 4]);
+            e[(i + 1) % 2] = abcd;
+            if (i >= 3 && i <= 18)
+                msg[(i + 1) % 4] = _mm_sha1msg2_epu32 (msg[(i + 1) % 4],
+                                                       msg[i % 4]);
+            /* The function selector must be an immediate.
+             */
+            switch (i / 5) {
+                case 0:
+                    abcd = _mm_sha1rnds4_epu32 (abcd, e[i % 2], 0);
+                    break;
+                case 1:
+                    abcd = _mm_sha1rnds4_epu32 (abcd, e[i % 2], 1);
+                    break;
+                case 2:
+                    abcd = _mm_sha1rnds4_epu32 (abcd, e[i % 2], 2);
+                    break;
+                default:
+                    abcd = _mm_sha1rnds4_epu32 (abcd, e[i % 2], 3);
+                    break;
+            }
+            if (i >= 1 && i <= 16)
+                msg[(i + 3) % 4] = _mm_sha1msg1_epu32 (msg[(i + 3) % 4],
+                                                       msg[i % 4]);
+            if (i >= 2 && i <= 17)
+                msg[(i + 2) % 4] = _mm_xor_si128 (msg[(i + 2) % 4],
+                                                  msg[i % 4]);
+        }
+        e[0] = _mm_sha1nexte_epu32 (e[0], e_save);
+        abcd = _mm_add_epi32 (abcd, abcd_save);
+        data += 64;
+    }
+
+    abcd = _mm_shuffle_epi32 (abcd, 0x1B);
+    _mm_storeu_si128 ((__m128i *)state, abcd);
+    state[4] = _mm_extract_epi32 (e[0], 3);
+}
+
+SHA_X86_TARGET
+void sha256_x86_blocks (uint32_t state[8], const uint8_t *data, size_t nblocks)
+{
+    const __m128i mask = _mm_set_epi64x (0x0c0d0e0f08090a0bULL,
+                                         0x0405060700010203ULL);
+    __m128i state0, state1, abef_save, cdgh_save, tmp, m;
+    __m128i msg[4];
+    int i;
+
+    /* Rearrange state words into the ABEF/CDGH order used by sha256rnds2.
+     */
+    tmp = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *)&state[0]),
+                             0xB1);                         /* CDAB */
+    state1 = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *)&state[4]),
+                                0x1B);                      /* EFGH */
+    state0 = _mm_alignr_epi8 (tmp, state1, 8);              /* ABEF */
+    state1 = _mm_blend_epi16 (state1, tmp, 0xF0);           /* CDGH */
+
+    while (nblocks-- > 0) {
+        abef_save = state0;
+        cdgh_save = state1;
+
+        SHA_X86_UNROLL
+        for (i = 0; i < 16; i++) {
+            if (i < 4) {
+                msg[i] = _mm_loadu_si128 ((const __m128i *)(data + 16 * i));
+                msg[i] = _mm_shuffle_epi8 (msg[i], mask);
+            }
+            m = _mm_add_epi32 (msg[i % 4],
+                               _mm_loadu_si128 ((const __m128i *)&k256[4 * i]));
+            state1 = _mm_sha256rnds2_epu32 (state1, state0, m);
+            if (i >= 3 && i <= 14) {
+                tmp = _mm_alignr_epi8 (msg[i % 4], msg[(i + 3) % 4], 4);
+                msg[(i + 1) % 4] = _mm_add_epi32 (msg[(i + 1) % 4], tmp);
+                msg[(i + 1) % 4] = _mm_sha256msg2_epu32 (msg[(i + 1) % 4],
+                                                         msg[i % 4]);
+            }
+            m = _mm_shuffle_epi32 (m, 0x0E);
+            state0 = _mm_sha256rnds2_epu32 (state0, state1, m);
+            if (i >= 1 && i <= 12)
+                msg[(i + 3) % 4] = _mm_sha256msg1_epu32 (msg[(i + 3) % 4],
+                                                         msg[i % 4]);
+        }
+        state0 = _mm_add_epi32 (state0, abef_save);
+        state1 = _mm_add_epi32 (state1, cdgh_save);
+        data += 64;
+    }
+
+    tmp = _mm_shuffle_epi32 (state0, 0x1B);                 /* FEBA */
+    state1 = _mm_shuffle_epi32 (state1, 0xB1);              /* DCHG */
+    state0 = _mm_blend_epi16 (tmp, state1, 0xF0);           /* DCBA */
+    state1 = _mm_alignr_epi8 (state1, tmp, 8);              /* HGFE */
+    _mm_storeu_si128 ((__m128i *)&state[0], state0);
+    _mm_storeu_si128 ((__m128i *)&state[4], state1);
+}
+
+#else /* !HAVE_SHA_X86 */
+
+bool sha_x86_supported (void)
+{
+    return false;
+}
+
+void sha1_x86_blocks (uint32_t state[5], const uint8_t *data, size_t nblocks)
+{
+    abort ();
+}
+
+void sha256_x86_blocks (uint32_t state[8], const uint8_t *data, size_t nblocks)
+{
+    abort ();
+}
+
+#endif /* !HAVE_SHA_X86 */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
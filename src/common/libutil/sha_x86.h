@@ -0,0 +1,38 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_SHA_X86_H
+#define _UTIL_SHA_X86_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* SHA-1 and SHA-256 block functions using the x86 SHA extensions.
+ *
+ * sha_x86_supported() returns true if the running CPU has the SHA
+ * extensions (and the SSSE3/SSE4.1 instructions used alongside them).
+ * The block functions must not be called unless it returns true.
+ * They are always compiled, since the instructions are enabled per
+ * function, so no special compiler flags are needed.
+ *
+ * The block functions update 'state' with 'nblocks' 64-byte blocks of
+ * 'data'.  Padding and finalization are up to the caller.
+ */
+bool sha_x86_supported (void);
+
+void sha1_x86_blocks (uint32_t state[5], const uint8_t *data, size_t nblocks);
+void sha256_x86_blocks (uint32_t state[8], const uint8_t *data, size_t nblocks);
+
+#endif /* !_UTIL_SHA_X86_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,126 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <string.h>
+#include <stdio.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/blake3.h"
+
+/* Test vectors from the BLAKE3 reference test_vectors.json.
+ * Input is a repeating sequence of bytes 0..250 of the given length.
+ * Lengths are chosen to cover partial blocks, exact chunks, and
+ * several levels of the chunk tree.
+ */
+static struct {
+    size_t len;
+    const char *hash;
+} vectors[] = {
+    { 0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262" },
+    { 1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213" },
+    { 1024, "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7" },
+    { 1025, "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444" },
+    { 2048, "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a" },
+};
+
+static void tohex (const uint8_t *hash, size_t len, char *s)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+        sprintf (s + i * 2, "%02x", hash[i]);
+}
+
+static void hash_input (const uint8_t *input,
+                        size_t len,
+                        size_t step,
+                        uint8_t hash[BLAKE3_OUT_LEN])
+{
+    blake3_hasher hasher;
+    size_t n;
+
+    blake3_hasher_init (&hasher);
+    while (len > 0) {
+        n = len < step ? len : step;
+        blake3_hasher_update (&hasher, input, n);
+        input += n;
+        len -= n;
+    }
+    blake3_hasher_finalize (&hasher, hash, BLAKE3_OUT_LEN);
+}
+
+void test_vectors (void)
+{
+    uint8_t input[4096];
+    uint8_t hash[BLAKE3_OUT_LEN];
+    char s[BLAKE3_OUT_LEN * 2 + 1];
+    int i;
+
+    for (i = 0; i < sizeof (input); i++)
+        input[i] = i % 251;
+
+    for (i = 0; i < sizeof (vectors) / sizeof (vectors[0]); i++) {
+        hash_input (input, vectors[i].len, vectors[i].len + 1, hash);
+        tohex (hash, sizeof (hash), s);
+        ok (!strcmp (s, vectors[i].hash),
+            "blake3 of %zu bytes is correct", vectors[i].len);
+
+        hash_input (input, vectors[i].len, 7, hash);
+        tohex (hash, sizeof (hash), s);
+        ok (!strcmp (s, vectors[i].hash),
+            "blake3 of %zu bytes added in small pieces is correct",
+            vectors[i].len);
+    }
+
+    hash_input ((uint8_t *)"abc", 3, 3, hash);
+    tohex (hash, sizeof (hash), s);
+    ok (!strcmp (s, "6437b3ac38465133ffb63b75273a8db5"
+                    "48c558465d79db03fd359c6cd5bd9d85"),
+        "blake3 of \"abc\" is correct");
+}
+
+void test_finalize (void)
+{
+    blake3_hasher hasher;
+    uint8_t hash[BLAKE3_OUT_LEN];
+    uint8_t hash2[BLAKE3_OUT_LEN];
+    uint8_t xof[BLAKE3_OUT_LEN * 4];
+
+    blake3_hasher_init (&hasher);
+    blake3_hasher_update (&hasher, "foo", 3);
+    blake3_hasher_finalize (&hasher, hash, sizeof (hash));
+    blake3_hasher_finalize (&hasher, hash2, sizeof (hash2));
+    ok (!memcmp (hash, hash2, sizeof (hash)),
+        "blake3_hasher_finalize can be called twice");
+
+    blake3_hasher_finalize (&hasher, xof, sizeof (xof));
+    ok (!memcmp (hash, xof, sizeof (hash)),
+        "extended output begins with default length output");
+
+    blake3_hasher_update (&hasher, "bar", 3);
+    blake3_hasher_finalize (&hasher, hash2, sizeof (hash2));
+    ok (memcmp (hash, hash2, sizeof (hash)) != 0,
+        "more input can be added after blake3_hasher_finalize");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_vectors ();
+    test_finalize ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
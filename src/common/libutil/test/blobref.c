@@ -14,6 +14,7 @@
 #include "src/common/libutil/blobref.h"
 #include "src/common/libutil/sha1.h"
 #include "src/common/libutil/sha256.h"
+#include "src/common/libutil/blake3.h"
 
 const char *badref[] = {
     "nerf-4d4ed591f7d26abd8145650f334d283bdb661765", // unknown hash
@@ -26,6 +27,7 @@ const char *badref[] = {
 const char *goodref[] = {
     "sha1-4d4ed591f7d26abd8145650f334d283bdb661765",
     "sha256-a99c07ce93703c7390589c5b007bd9a97a8b6de29e9a920d474d4f028ce2d42c",
+    "blake3-af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262",
     NULL,
 };
 
@@ -131,6 +133,25 @@ int main(int argc, char** argv)
     ok (strcmp (ref, ref2) == 0,
         "and blobrefs match");
 
+    /* blake3 */
+    ok (blobref_hash ("blake3", NULL, 0, ref, sizeof (ref)) == 0,
+        "blobref_hash blake3 handles zero length data");
+    diag ("%s", ref);
+    ok (strcmp (ref, goodref[2]) == 0,
+        "blobref_hash blake3 of zero length data is correct");
+    ok (blobref_hash ("blake3", data, sizeof (data), ref, sizeof (ref)) == 0,
+        "blobref_hash blake3 works");
+    diag ("%s", ref);
+
+    ok (blobref_strtohash (ref, digest, sizeof (digest)) == BLAKE3_OUT_LEN,
+        "blobref_strtohash returns expected size hash");
+    ok (blobref_hashtostr ("blake3", digest, BLAKE3_OUT_LEN, ref2,
+                           sizeof (ref2)) == 0,
+        "blobref_hashtostr back again works");
+    diag ("%s", ref2);
+    ok (strcmp (ref, ref2) == 0,
+        "and blobrefs match");
+
     /* blobref_validate */
     const char **pp;
     pp = &goodref[0];
@@ -152,6 +173,8 @@ int main(int argc, char** argv)
         "blobref_validate_hashtype sha1 is valid");
     ok (blobref_validate_hashtype ("sha256") == 0,
         "blobref_validate_hashtype sha256 is valid");
+    ok (blobref_validate_hashtype ("blake3") == 0,
+        "blobref_validate_hashtype blake3 is valid");
     ok (blobref_validate_hashtype ("nerf") == -1,
         "blobref_validate_hashtype nerf is invalid");
     ok (blobref_validate_hashtype (NULL) == -1,
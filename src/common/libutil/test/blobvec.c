@@ -0,0 +1,146 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/blobvec.h"
+
+void test_basic (void)
+{
+    blobvec_t *bv, *bv2;
+    const void *buf;
+    int len;
+    const void *data;
+    int dlen;
+
+    bv = blobvec_create ();
+    ok (bv != NULL,
+        "blobvec_create works");
+    ok (blobvec_count (bv) == 0 && blobvec_size (bv) == 0,
+        "empty blobvec has count=0 size=0");
+    ok (blobvec_append (bv, "hello", 6) == 0,
+        "blobvec_append hello works");
+    ok (blobvec_append (bv, NULL, 0) == 0,
+        "blobvec_append of empty blob works");
+    ok (blobvec_append_error (bv, ENOENT) == 0,
+        "blobvec_append_error ENOENT works");
+    ok (blobvec_append (bv, "world", 5) == 0,
+        "blobvec_append world works");
+    ok (blobvec_count (bv) == 4,
+        "blobvec_count returns 4");
+    ok (blobvec_encode (bv, &buf, &len) == 0 && len == 4*4 + 6 + 5,
+        "blobvec_encode returns expected size");
+
+    bv2 = blobvec_decode (buf, len);
+    ok (bv2 != NULL,
+        "blobvec_decode works");
+    ok (blobvec_count (bv2) == 4,
+        "decoded blobvec has 4 records");
+    ok (blobvec_get (bv2, 0, &data, &dlen) == 0
+        && dlen == 6 && !strcmp (data, "hello"),
+        "record 0 is hello");
+    ok (blobvec_get (bv2, 1, &data, &dlen) == 0
+        && dlen == 0 && data == NULL,
+        "record 1 is empty");
+    errno = 0;
+    ok (blobvec_get (bv2, 2, &data, &dlen) < 0 && errno == ENOENT,
+        "record 2 fails with ENOENT");
+    ok (blobvec_get (bv2, 3, &data, &dlen) == 0
+        && dlen == 5 && !memcmp (data, "world", 5),
+        "record 3 is world");
+    errno = 0;
+    ok (blobvec_get (bv2, 4, &data, &dlen) < 0 && errno == EINVAL,
+        "record 4 fails with EINVAL");
+    errno = 0;
+    ok (blobvec_append (bv2, "x", 1) < 0 && errno == EINVAL,
+        "blobvec_append on decoded blobvec fails with EINVAL");
+
+    blobvec_destroy (bv2);
+    blobvec_destroy (bv);
+}
+
+void test_large (void)
+{
+    blobvec_t *bv, *bv2;
+    const void *buf;
+    int len;
+    int i;
+    int errors = 0;
+
+    if (!(bv = blobvec_create ()))
+        BAIL_OUT ("blobvec_create failed");
+    for (i = 0; i < 10000; i++) {
+        if (blobvec_append (bv, &i, sizeof (i)) < 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "appended 10000 records");
+    ok (blobvec_encode (bv, &buf, &len) == 0
+        && (bv2 = blobvec_decode (buf, len)) != NULL,
+        "encode/decode works");
+    ok (blobvec_count (bv2) == 10000,
+        "decoded blobvec has 10000 records");
+    for (i = 0; i < 10000; i++) {
+        const void *data;
+        int dlen;
+        if (blobvec_get (bv2, i, &data, &dlen) < 0
+            || dlen != sizeof (i)
+            || memcmp (data, &i, sizeof (i)) != 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "all records decoded correctly");
+    blobvec_destroy (bv2);
+    blobvec_destroy (bv);
+}
+
+void test_proto (void)
+{
+    uint8_t bad1[] = { 0, 0, 0 };
+    uint8_t bad2[] = { 0, 0, 0, 5, 'a', 'b' };
+    uint8_t bad3[] = { 0x80, 0, 0, 0 };
+    blobvec_t *bv;
+
+    errno = 0;
+    ok (blobvec_decode (bad1, sizeof (bad1)) == NULL && errno == EPROTO,
+        "blobvec_decode of truncated header fails with EPROTO");
+    errno = 0;
+    ok (blobvec_decode (bad2, sizeof (bad2)) == NULL && errno == EPROTO,
+        "blobvec_decode of truncated data fails with EPROTO");
+    errno = 0;
+    ok (blobvec_decode (bad3, sizeof (bad3)) == NULL && errno == EPROTO,
+        "blobvec_decode of INT32_MIN length fails with EPROTO");
+    bv = blobvec_decode (NULL, 0);
+    ok (bv != NULL && blobvec_count (bv) == 0,
+        "blobvec_decode of empty buffer works");
+    blobvec_destroy (bv);
+    errno = 0;
+    ok (blobvec_append_error (NULL, ENOENT) < 0 && errno == EINVAL,
+        "blobvec_append_error bv=NULL fails with EINVAL");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_large ();
+    test_proto ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
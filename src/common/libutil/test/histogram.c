@@ -0,0 +1,283 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <stdint.h>
+#include <jansson.h>
+
+#include "src/common/libtap/tap.h"
+#include "histogram.h"
+
+static void test_empty (void)
+{
+    struct histogram *h;
+
+    ok ((h = histogram_create ()) != NULL,
+        "histogram_create works");
+    ok (histogram_count (h) == 0
+        && histogram_min (h) == 0
+        && histogram_max (h) == 0
+        && histogram_mean (h) == 0,
+        "empty histogram has zero count, min, max, mean");
+    ok (histogram_percentile (h, 50) == 0,
+        "histogram_percentile of empty histogram returns 0");
+    histogram_destroy (h);
+}
+
+static void test_exact (void)
+{
+    struct histogram *h;
+    int i;
+    int errors = 0;
+
+    if (!(h = histogram_create ()))
+        BAIL_OUT ("histogram_create failed");
+    for (i = 1; i <= 100; i++) {
+        if (histogram_add (h, i) < 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "histogram_add 1..100 works");
+    ok (histogram_count (h) == 100,
+        "histogram_count returns 100");
+    ok (histogram_min (h) == 1 && histogram_max (h) == 100,
+        "histogram_min/max return 1 and 100");
+    ok (histogram_mean (h) == 50.5,
+        "histogram_mean returns 50.5");
+    ok (histogram_percentile (h, 50) == 50,
+        "p50 is exact for small values");
+    ok (histogram_percentile (h, 99) == 99,
+        "p99 is exact for small values");
+    ok (histogram_percentile (h, 100) == 100,
+        "p100 is the maximum");
+    ok (histogram_percentile (h, 0) == 1,
+        "p0 is the minimum");
+
+    histogram_reset (h);
+    ok (histogram_count (h) == 0 && histogram_percentile (h, 50) == 0,
+        "histogram_reset clears histogram");
+
+    histogram_destroy (h);
+}
+
+static void test_precision (void)
+{
+    struct histogram *h;
+    uint64_t values[] = { 128, 255, 256, 1000, 12345, 999999,
+                          1ULL << 40, (1ULL << 50) + 12345, 0 };
+    int i;
+
+    for (i = 0; values[i] != 0; i++) {
+        uint64_t v;
+
+        if (!(h = histogram_create ()))
+            BAIL_OUT ("histogram_create failed");
+        if (histogram_add (h, 1) < 0 || histogram_add (h, values[i]) < 0)
+            BAIL_OUT ("histogram_add failed");
+        v = histogram_percentile (h, 50);
+        ok (v == 1,
+            "p50 of 1,%ju is 1", (uintmax_t)values[i]);
+        v = histogram_percentile (h, 100);
+        ok (v == values[i],
+            "p100 of 1,%ju is clamped to max", (uintmax_t)values[i]);
+        histogram_destroy (h);
+
+        /* Check the bucket containing values[i] is within 1/64 of it,
+         * by adding a value just above the bucket start.
+         */
+        if (!(h = histogram_create ()))
+            BAIL_OUT ("histogram_create failed");
+        if (histogram_add (h, values[i]) < 0
+            || histogram_add (h, values[i] * 2) < 0)
+            BAIL_OUT ("histogram_add failed");
+        v = histogram_percentile (h, 50);
+        ok (v >= values[i] && v - values[i] <= values[i] / 64,
+            "p50 of %ju,%ju is %ju (within 1/64)",
+            (uintmax_t)values[i],
+            (uintmax_t)values[i] * 2,
+            (uintmax_t)v);
+        histogram_destroy (h);
+    }
+}
+
+static void test_percentile (void)
+{
+    struct histogram *h;
+    int i;
+
+    if (!(h = histogram_create ()))
+        BAIL_OUT ("histogram_create failed");
+    /* 990 fast, 9 slow, 1 very slow */
+    for (i = 0; i < 990; i++)
+        histogram_add (h, 100);
+    for (i = 0; i < 9; i++)
+        histogram_add (h, 10000);
+    histogram_add (h, 1000000);
+
+    ok (histogram_percentile (h, 50) == 100,
+        "p50 is 100");
+    ok (histogram_percentile (h, 99) == 100,
+        "p99 is 100");
+    ok (histogram_percentile (h, 99.5) >= 10000
+        && histogram_percentile (h, 99.5) <= 10000 + 10000 / 64,
+        "p99.5 is ~10000");
+    ok (histogram_percentile (h, 99.95) == 1000000,
+        "p99.95 is 1000000");
+    histogram_destroy (h);
+}
+
+static void test_merge (void)
+{
+    struct histogram *a;
+    struct histogram *b;
+    struct histogram *empty;
+
+    if (!(a = histogram_create ())
+        || !(b = histogram_create ())
+        || !(empty = histogram_create ()))
+        BAIL_OUT ("histogram_create failed");
+    histogram_add (a, 5);
+    histogram_add (a, 10);
+    histogram_add (b, 1);
+    histogram_add (b, 100000);
+
+    ok (histogram_merge (a, empty) == 0
+        && histogram_count (a) == 2
+        && histogram_min (a) == 5,
+        "histogram_merge of empty histogram is a no-op");
+    ok (histogram_merge (a, b) == 0,
+        "histogram_merge works");
+    ok (histogram_count (a) == 4
+        && histogram_min (a) == 1
+        && histogram_max (a) == 100000,
+        "merged histogram has expected count, min, max");
+    ok (histogram_mean (a) == (5 + 10 + 1 + 100000) / 4.,
+        "merged histogram has expected mean");
+    ok (histogram_percentile (a, 50) == 5
+        && histogram_percentile (a, 75) == 10,
+        "merged histogram has expected percentiles");
+    ok (histogram_merge (empty, a) == 0
+        && histogram_count (empty) == 4
+        && histogram_min (empty) == 1,
+        "histogram_merge into empty histogram works");
+
+    histogram_destroy (a);
+    histogram_destroy (b);
+    histogram_destroy (empty);
+}
+
+static void test_codec (void)
+{
+    struct histogram *h;
+    struct histogram *h2;
+    json_t *o;
+    json_t *buckets;
+    json_int_t p99;
+
+    if (!(h = histogram_create ()))
+        BAIL_OUT ("histogram_create failed");
+    histogram_add (h, 3);
+    histogram_add (h, 3);
+    histogram_add (h, 5004);
+
+    ok ((o = histogram_encode (h)) != NULL,
+        "histogram_encode works");
+    ok (json_unpack (o, "{s:I s:o}", "p99", &p99, "buckets", &buckets) == 0
+        && p99 == 5004
+        && json_array_size (buckets) == 2,
+        "encoded histogram has p99 and two buckets");
+    ok ((h2 = histogram_decode (o)) != NULL,
+        "histogram_decode works");
+    ok (histogram_count (h2) == 3
+        && histogram_min (h2) == 3
+        && histogram_max (h2) == 5004
+        && histogram_percentile (h2, 50) == 3
+        && histogram_mean (h2) == histogram_mean (h),
+        "decoded histogram matches original");
+    json_decref (o);
+    histogram_destroy (h2);
+    histogram_destroy (h);
+
+    o = json_pack ("{s:I s:I s:I s:f s:[[III]]}",
+                   "count", (json_int_t)2,
+                   "min", (json_int_t)1,
+                   "max", (json_int_t)1,
+                   "mean", 1.,
+                   "buckets",
+                   (json_int_t)1, (json_int_t)1, (json_int_t)1);
+    errno = 0;
+    ok (histogram_decode (o) == NULL && errno == EPROTO,
+        "histogram_decode fails with EPROTO on count mismatch");
+    json_decref (o);
+
+    o = json_pack ("{s:I s:I s:I s:f s:[[III]]}",
+                   "count", (json_int_t)1,
+                   "min", (json_int_t)200,
+                   "max", (json_int_t)200,
+                   "mean", 200.,
+                   "buckets",
+                   (json_int_t)200, (json_int_t)300, (json_int_t)1);
+    errno = 0;
+    ok (histogram_decode (o) == NULL && errno == EPROTO,
+        "histogram_decode fails with EPROTO on bad bucket bounds");
+    json_decref (o);
+
+    errno = 0;
+    ok (histogram_decode (NULL) == NULL && errno == EPROTO,
+        "histogram_decode o=NULL fails with EPROTO");
+}
+
+static void test_inval (void)
+{
+    struct histogram *h;
+
+    if (!(h = histogram_create ()))
+        BAIL_OUT ("histogram_create failed");
+    errno = 0;
+    ok (histogram_add (NULL, 1) < 0 && errno == EINVAL,
+        "histogram_add h=NULL fails with EINVAL");
+    errno = 0;
+    ok (histogram_merge (NULL, h) < 0 && errno == EINVAL,
+        "histogram_merge dst=NULL fails with EINVAL");
+    errno = 0;
+    ok (histogram_merge (h, NULL) < 0 && errno == EINVAL,
+        "histogram_merge src=NULL fails with EINVAL");
+    errno = 0;
+    ok (histogram_encode (NULL) == NULL && errno == EINVAL,
+        "histogram_encode h=NULL fails with EINVAL");
+    lives_ok ({histogram_destroy (NULL);},
+        "histogram_destroy h=NULL doesn't crash");
+    lives_ok ({histogram_reset (NULL);},
+        "histogram_reset h=NULL doesn't crash");
+    histogram_destroy (h);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_empty ();
+    test_exact ();
+    test_precision ();
+    test_percentile ();
+    test_merge ();
+    test_codec ();
+    test_inval ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,74 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <string.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/sha1.h"
+#include "src/common/libutil/sha256.h"
+#include "src/common/libutil/sha_x86.h"
+#include "src/common/libutil/blobref.h"
+
+/* Compare blobref_hash(), which uses the SHA extensions when available,
+ * with the portable implementations for lengths that cover every tail
+ * size and the one vs. two padding block cases.
+ */
+void test_compare (const char *hashtype, int digest_size)
+{
+    uint8_t data[4096 + 64];
+    uint8_t d1[BLOBREF_MAX_DIGEST_SIZE];
+    uint8_t d2[BLOBREF_MAX_DIGEST_SIZE];
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    int len, errors = 0;
+
+    for (len = 0; len < sizeof (data); len++)
+        data[len] = len * 7 + 3;
+
+    for (len = 0; len < sizeof (data); len++) {
+        if (digest_size == SHA1_DIGEST_SIZE) {
+            SHA1_CTX ctx;
+            SHA1_Init (&ctx);
+            SHA1_Update (&ctx, data, len);
+            SHA1_Final (&ctx, d1);
+        }
+        else {
+            SHA256_CTX ctx;
+            sha256_init (&ctx);
+            sha256_update (&ctx, data, len);
+            sha256_final (&ctx, d1);
+        }
+        if (blobref_hash (hashtype, data, len, ref, sizeof (ref)) < 0
+            || blobref_strtohash (ref, d2, sizeof (d2)) != digest_size
+            || memcmp (d1, d2, digest_size) != 0) {
+            diag ("%s: mismatch at length %d", hashtype, len);
+            errors++;
+        }
+    }
+    ok (errors == 0,
+        "%s blobref_hash matches portable implementation", hashtype);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    diag ("SHA extensions are %savailable",
+          sha_x86_supported () ? "" : "not ");
+
+    test_compare ("sha1", SHA1_DIGEST_SIZE);
+    test_compare ("sha256", SHA256_BLOCK_SIZE);
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -13,6 +13,7 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <limits.h>
 #include <sqlite3.h>
 #include <czmq.h>
 #include <lz4.h>
@@ -26,6 +27,7 @@
 
 const size_t lzo_buf_chunksize = 1024*1024;
 const size_t compression_threshold = 256; /* compress blobs >= this size */
+const int default_batch_size = 256; /* max stores per transaction */
 
 const char *sql_create_table = "CREATE TABLE if not exists objects("
                                "  hash CHAR(20) PRIMARY KEY,"
@@ -46,8 +48,17 @@ const char *sql_checkpt_get = "SELECT value FROM checkpt"
 const char *sql_checkpt_put = "REPLACE INTO checkpt (key,value) "
                               "  values (?1, ?2)";
 
+/* A store that was executed in the open transaction.  The response is
+ * deferred until the transaction commits.
+ */
+struct store_pending {
+    const flux_msg_t *msg;
+    char blobref[BLOBREF_MAX_STRING_SIZE];
+};
+
 struct content_sqlite {
     flux_msg_handler_t **handlers;
+    flux_watcher_t *commit_w;
     char *dbfile;
     sqlite3 *db;
     sqlite3_stmt *load_stmt;
@@ -58,6 +69,16 @@ struct content_sqlite {
     const char *hashfun;
     size_t lzo_bufsize;
     void *lzo_buf;
+    const char *journal_mode;
+    const char *synchronous;
+    const char *cache_size;
+    struct store_pending *batch;
+    int batch_size;
+    int batch_count;
+    bool txn_open;
+    int txn_count;          // transactions committed
+    int txn_stores;         // stores in committed transactions
+    int txn_stores_max;     // most stores in one committed transaction
 };
 
 static void log_sqlite_error (struct content_sqlite *ctx, const char *fmt, ...)
@@ -273,6 +294,91 @@ error:
     return -1;
 }
 
+/* Open a transaction for stores if one is not already open.  It is
+ * committed by commit_prep_cb() once no more requests are ready, or
+ * sooner if the batch fills up.
+ */
+static int content_sqlite_begin (struct content_sqlite *ctx)
+{
+    if (!ctx->txn_open) {
+        if (sqlite3_exec (ctx->db, "BEGIN", NULL, NULL, NULL) != SQLITE_OK) {
+            log_sqlite_error (ctx, "store: begin transaction");
+            set_errno_from_sqlite_error (ctx);
+            return -1;
+        }
+        ctx->txn_open = true;
+        flux_watcher_start (ctx->commit_w);
+    }
+    return 0;
+}
+
+/* Commit the open transaction, if any, then respond to the stores it
+ * contains.  If the commit fails, each store receives an error response.
+ * Returns 0 on success, -1 on error with errno set.
+ */
+static int content_sqlite_commit (struct content_sqlite *ctx)
+{
+    int errnum = 0;
+    int i;
+
+    if (!ctx->txn_open)
+        return 0;
+    if (sqlite3_exec (ctx->db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "store: commit transaction");
+        set_errno_from_sqlite_error (ctx);
+        errnum = errno;
+        (void)sqlite3_exec (ctx->db, "ROLLBACK", NULL, NULL, NULL);
+    }
+    else {
+        ctx->txn_count++;
+        ctx->txn_stores += ctx->batch_count;
+        if (ctx->txn_stores_max < ctx->batch_count)
+            ctx->txn_stores_max = ctx->batch_count;
+    }
+    ctx->txn_open = false;
+    flux_watcher_stop (ctx->commit_w);
+
+    for (i = 0; i < ctx->batch_count; i++) {
+        struct store_pending *sp = &ctx->batch[i];
+
+        if (errnum == 0) {
+            if (flux_respond_raw (ctx->h,
+                                  sp->msg,
+                                  sp->blobref,
+                                  strlen (sp->blobref) + 1) < 0)
+                flux_log_error (ctx->h, "store: flux_respond_raw");
+        }
+        else {
+            if (flux_respond_error (ctx->h, sp->msg, errnum, NULL) < 0)
+                flux_log_error (ctx->h, "store: flux_respond_error");
+        }
+        flux_msg_decref (sp->msg);
+    }
+    ctx->batch_count = 0;
+    if (errnum != 0) {
+        errno = errnum;
+        return -1;
+    }
+    return 0;
+}
+
+/* The handle dispatches one message per reactor loop iteration, so
+ * don't commit while more requests are ready, as the reactor is not
+ * about to block.  Those requests may add stores to the transaction.
+ */
+static void commit_prep_cb (flux_reactor_t *r,
+                            flux_watcher_t *w,
+                            int revents,
+                            void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    int events = flux_pollevents (ctx->h);
+
+    if (events >= 0 && (events & FLUX_POLLIN))
+        return;
+    (void)content_sqlite_commit (ctx);
+}
+
 static void load_cb (flux_t *h,
                      flux_msg_handler_t *mh,
                      const flux_msg_t *msg,
@@ -321,6 +427,23 @@ void store_cb (flux_t *h,
         flux_log_error (h, "store: request decode failed");
         goto error;
     }
+    if (ctx->batch_size > 1) {
+        struct store_pending *sp;
+
+        if (content_sqlite_begin (ctx) < 0)
+            goto error;
+        sp = &ctx->batch[ctx->batch_count];
+        if (content_sqlite_store (ctx,
+                                  data,
+                                  size,
+                                  sp->blobref,
+                                  sizeof (sp->blobref)) < 0)
+            goto error;
+        sp->msg = flux_msg_incref (msg);
+        if (++ctx->batch_count == ctx->batch_size)
+            (void)content_sqlite_commit (ctx);
+        return;
+    }
     if (content_sqlite_store (ctx, data, size, blobref, sizeof (blobref)) < 0)
         goto error;
     if (flux_respond_raw (h, msg, blobref, strlen (blobref) + 1) < 0)
@@ -389,6 +512,10 @@ void checkpoint_put_cb (flux_t *h,
         errno = EINVAL;
         goto error;
     }
+    /* Ensure blobs referenced by the checkpoint are committed first.
+     */
+    if (content_sqlite_commit (ctx) < 0)
+        goto error;
     if (sqlite3_bind_text (ctx->checkpt_put_stmt,
                            1,
                            (char *)key,
@@ -451,6 +578,23 @@ static void content_sqlite_closedb (struct content_sqlite *ctx)
     }
 }
 
+static int set_pragma (struct content_sqlite *ctx,
+                       const char *name,
+                       const char *value)
+{
+    char s[64];
+
+    if (snprintf (s, sizeof (s), "PRAGMA %s=%s", name, value) >= sizeof (s)) {
+        flux_log (ctx->h, LOG_ERR, "sqlite '%s' pragma is too long", name);
+        return -1;
+    }
+    if (sqlite3_exec (ctx->db, s, NULL, NULL, NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "setting sqlite '%s' pragma", name);
+        return -1;
+    }
+    return 0;
+}
+
 /* Open the database file ctx->dbfile and set up the database.
  */
 static int content_sqlite_opendb (struct content_sqlite *ctx)
@@ -461,21 +605,12 @@ static int content_sqlite_opendb (struct content_sqlite *ctx)
         log_sqlite_error (ctx, "opening %s", ctx->dbfile);
         goto error;
     }
-    if (sqlite3_exec (ctx->db,
-                      "PRAGMA journal_mode=OFF",
-                      NULL,
-                      NULL,
-                      NULL) != SQLITE_OK) {
-        log_sqlite_error (ctx, "setting sqlite 'journal_mode' pragma");
-        goto error;
-    }
-    if (sqlite3_exec (ctx->db,
-                      "PRAGMA synchronous=OFF",
-                      NULL,
-                      NULL,
-                      NULL) != SQLITE_OK) {
-        log_sqlite_error (ctx, "setting sqlite 'synchronous' pragma");
+    if (set_pragma (ctx, "journal_mode", ctx->journal_mode) < 0
+        || set_pragma (ctx, "synchronous", ctx->synchronous) < 0)
         goto error;
+    if (ctx->cache_size) {
+        if (set_pragma (ctx, "cache_size", ctx->cache_size) < 0)
+            goto error;
     }
     if (sqlite3_exec (ctx->db,
                       "PRAGMA locking_mode=EXCLUSIVE",
@@ -544,6 +679,8 @@ static void content_sqlite_destroy (struct content_sqlite *ctx)
     if (ctx) {
         int saved_errno = errno;
         flux_msg_handler_delvec (ctx->handlers);
+        flux_watcher_destroy (ctx->commit_w);
+        free (ctx->batch);
         free (ctx->dbfile);
         free (ctx->lzo_buf);
         free (ctx);
@@ -551,7 +688,25 @@ static void content_sqlite_destroy (struct content_sqlite *ctx)
     }
 }
 
+static void stats_get_cb (flux_t *h,
+                          flux_msg_handler_t *mh,
+                          const flux_msg_t *msg,
+                          void *arg)
+{
+    struct content_sqlite *ctx = arg;
+
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:i s:i s:i s:i}",
+                           "batch", ctx->batch_size,
+                           "txn_count", ctx->txn_count,
+                           "txn_stores", ctx->txn_stores,
+                           "txn_stores_max", ctx->txn_stores_max) < 0)
+        flux_log_error (h, "stats: flux_respond_pack");
+}
+
 static const struct flux_msg_handler_spec htab[] = {
+    { FLUX_MSGTYPE_REQUEST, "content-sqlite.stats.get", stats_get_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.load",    load_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.store",   store_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.get", checkpoint_get_cb, 0 },
@@ -559,7 +714,75 @@ static const struct flux_msg_handler_spec htab[] = {
     FLUX_MSGHANDLER_TABLE_END,
 };
 
-static struct content_sqlite *content_sqlite_create (flux_t *h)
+static bool valid_keyword (const char *s, const char *keywords[])
+{
+    int i;
+
+    for (i = 0; keywords[i] != NULL; i++) {
+        if (!strcasecmp (s, keywords[i]))
+            return true;
+    }
+    return false;
+}
+
+static bool valid_integer (const char *s, long min)
+{
+    char *endptr;
+    long l;
+
+    errno = 0;
+    l = strtol (s, &endptr, 10);
+    if (errno != 0 || *s == '\0' || *endptr != '\0' || l < min || l > INT_MAX)
+        return false;
+    return true;
+}
+
+/* Module arguments:
+ * - journal_mode=MODE, synchronous=MODE, cache_size=N set sqlite pragmas
+ * - batch=N sets the max number of stores per transaction (1=no batching)
+ */
+static int parse_args (struct content_sqlite *ctx, int argc, char **argv)
+{
+    const char *journal_modes[] = { "delete", "truncate", "persist",
+                                    "memory", "wal", "off", NULL };
+    const char *synchronous_modes[] = { "off", "normal", "full",
+                                        "extra", NULL };
+    int i;
+
+    for (i = 0; i < argc; i++) {
+        if (!strncmp (argv[i], "journal_mode=", 13)) {
+            ctx->journal_mode = argv[i] + 13;
+            if (!valid_keyword (ctx->journal_mode, journal_modes))
+                goto inval;
+        }
+        else if (!strncmp (argv[i], "synchronous=", 12)) {
+            ctx->synchronous = argv[i] + 12;
+            if (!valid_keyword (ctx->synchronous, synchronous_modes))
+                goto inval;
+        }
+        else if (!strncmp (argv[i], "cache_size=", 11)) {
+            ctx->cache_size = argv[i] + 11;
+            if (!valid_integer (ctx->cache_size, INT_MIN))
+                goto inval;
+        }
+        else if (!strncmp (argv[i], "batch=", 6)) {
+            if (!valid_integer (argv[i] + 6, 1))
+                goto inval;
+            ctx->batch_size = strtol (argv[i] + 6, NULL, 10);
+        }
+        else
+            goto inval;
+    }
+    return 0;
+inval:
+    errno = EINVAL;
+    flux_log_error (ctx->h, "%s", argv[i]);
+    return -1;
+}
+
+static struct content_sqlite *content_sqlite_create (flux_t *h,
+                                                     int argc,
+                                                     char **argv)
 {
     struct content_sqlite *ctx;
     const char *backing_path;
@@ -570,6 +793,17 @@ static struct content_sqlite *content_sqlite_create (flux_t *h)
         goto error;
     ctx->lzo_bufsize = lzo_buf_chunksize;
     ctx->h = h;
+    ctx->journal_mode = "OFF";
+    ctx->synchronous = "OFF";
+    ctx->batch_size = default_batch_size;
+    if (parse_args (ctx, argc, argv) < 0)
+        goto error;
+    if (!(ctx->batch = calloc (ctx->batch_size, sizeof (ctx->batch[0]))))
+        goto error;
+    if (!(ctx->commit_w = flux_prepare_watcher_create (flux_get_reactor (h),
+                                                       commit_prep_cb,
+                                                       ctx)))
+        goto error;
 
     /* Some tunables:
      * - the hash function, e.g. sha1, sha256
@@ -617,7 +851,7 @@ int mod_main (flux_t *h, int argc, char **argv)
 {
     struct content_sqlite *ctx;
 
-    if (!(ctx = content_sqlite_create (h))) {
+    if (!(ctx = content_sqlite_create (h, argc, argv))) {
         flux_log_error (h, "content_sqlite_create failed");
         return -1;
     }
@@ -633,9 +867,15 @@ int mod_main (flux_t *h, int argc, char **argv)
         flux_log_error (h, "flux_reactor_run");
         goto done;
     }
+    if (content_sqlite_commit (ctx) < 0)
+        goto done;
     if (content_unregister_backing_store (h) < 0)
         goto done;
 done:
+    /* On error paths, stores may remain in the open transaction.
+     * Commit them so that each receives a response.
+     */
+    (void)content_sqlite_commit (ctx);
     content_sqlite_closedb (ctx);
     content_sqlite_destroy (ctx);
     return 0;
@@ -12,15 +12,13 @@
 # include "config.h"
 #endif
 
-#include <sys/wait.h>
-#define EXIT_CODE(x) __W_EXITCODE(x,0)
-
 #include <flux/core.h>
 #include <flux/idset.h>
 #include <czmq.h>
 
 #include "src/common/libutil/aux.h"
 #include "bulk-exec.h"
+#include "fanout.h"
 
 struct exec_cmd {
     struct idset *ranks;
@@ -41,6 +39,7 @@ struct bulk_exec {
     int exit_status;         /* Largest wait status of all complete procs */
 
     unsigned int active:1;
+    unsigned int fanout:1;   /* Launch commands with a TBON fanout */
 
     flux_watcher_t *prep;
     flux_watcher_t *check;
@@ -53,6 +52,8 @@ struct bulk_exec {
 
     zlist_t *commands;
     zlist_t *processes;
+    zlist_t *fanouts;
+    int fanout_ranks;        /* Number of ranks launched via fanout */
 
     struct bulk_exec_ops *handlers;
     void *arg;
@@ -65,7 +66,7 @@ int bulk_exec_rc (struct bulk_exec *exec)
 
 int bulk_exec_current (struct bulk_exec *exec)
 {
-    return zlist_size (exec->processes);
+    return zlist_size (exec->processes) + exec->fanout_ranks;
 }
 
 int bulk_exec_total (struct bulk_exec *exec)
@@ -77,6 +78,10 @@ int bulk_exec_write (struct bulk_exec *exec, const char *stream,
                      const char *buf, size_t len)
 {
     flux_subprocess_t *p = zlist_first (exec->processes);
+    if (zlist_size (exec->fanouts) > 0) {
+        errno = ENOTSUP;
+        return -1;
+    }
     while (p) {
         if (flux_subprocess_write (p, stream, buf, len) < len)
             return -1;
@@ -88,6 +93,10 @@ int bulk_exec_write (struct bulk_exec *exec, const char *stream,
 int bulk_exec_close (struct bulk_exec *exec, const char *stream)
 {
     flux_subprocess_t *p = zlist_first (exec->processes);
+    if (zlist_size (exec->fanouts) > 0) {
+        errno = ENOTSUP;
+        return -1;
+    }
     while (p) {
         if (flux_subprocess_close (p, stream) < 0)
             return -1;
@@ -115,7 +124,7 @@ static void exit_batch_cb (flux_reactor_t *r, flux_watcher_t *w,
     exec_exit_notify (exec);
 }
 
-/*  Append completed subprocess 'p' to the current batch for exit
+/*  Append completed 'rank' to the current batch for exit
  *   notification. If this is the first exited process in the batch,
  *   then start a timer which will fire and call the function to
  *   notify bulk_exec user of the batch of subprocess exits.
@@ -123,9 +132,8 @@ static void exit_batch_cb (flux_reactor_t *r, flux_watcher_t *w,
  *  This appraoch avoids unecessarily calling into user's callback
  *   multiple times when all tasks exit within 0.01s.
  */
-static void exit_batch_append (struct bulk_exec *exec, flux_subprocess_t *p)
+static void exit_batch_append (struct bulk_exec *exec, int rank)
 {
-    int rank = flux_subprocess_rank (p);
     if (idset_set (exec->exit_batch, rank) < 0) {
         flux_log_error (exec->h, "exit_batch_append:idset_set");
         return;
@@ -145,10 +153,10 @@ static void exit_batch_append (struct bulk_exec *exec, flux_subprocess_t *p)
     }
 }
 
-static void exec_add_completed (struct bulk_exec *exec, flux_subprocess_t *p)
+static void exec_add_completed (struct bulk_exec *exec, int rank)
 {
     /* Append this process to the current batch for notification */
-    exit_batch_append (exec, p);
+    exit_batch_append (exec, rank);
 
     if (++exec->complete == exec->total) {
         exec_exit_notify (exec);
@@ -165,7 +173,7 @@ static void exec_complete_cb (flux_subprocess_t *p)
     if (status > exec->exit_status)
         exec->exit_status = status;
 
-    exec_add_completed (exec, p);
+    exec_add_completed (exec, flux_subprocess_rank (p));
 }
 
 static void exec_state_cb (flux_subprocess_t *p, flux_subprocess_state_t state)
@@ -180,22 +188,16 @@ static void exec_state_cb (flux_subprocess_t *p, flux_subprocess_state_t state)
     else if (state == FLUX_SUBPROCESS_FAILED
             || state == FLUX_SUBPROCESS_EXEC_FAILED) {
         int errnum = flux_subprocess_fail_errno (p);
-        int code = EXIT_CODE(1);
-
-        if (errnum == EPERM || errnum == EACCES)
-            code = EXIT_CODE(126);
-        else if (errnum == ENOENT)
-            code = EXIT_CODE(127);
-        else if (errnum == EHOSTUNREACH)
-            code = EXIT_CODE(68);
+        int code = fanout_fail_status (errnum);
+        int rank = flux_subprocess_rank (p);
 
         if (code > exec->exit_status)
             exec->exit_status = code;
 
         if (exec->handlers->on_error)
-            (*exec->handlers->on_error) (exec, p, exec->arg);
+            (*exec->handlers->on_error) (exec, rank, errnum, exec->arg);
 
-        exec_add_completed (exec, p);
+        exec_add_completed (exec, rank);
     }
 }
 
@@ -212,7 +214,8 @@ static void exec_output_cb (flux_subprocess_t *p, const char *stream)
     if (len) {
         int rank = flux_subprocess_rank (p);
         if (exec->handlers->on_output)
-            (*exec->handlers->on_output) (exec, p, stream, s, len, exec->arg);
+            (*exec->handlers->on_output) (exec, rank, stream, s, len,
+                                          exec->arg);
         else
             flux_log (exec->h, LOG_INFO, "rank %d: %s: %s", rank, stream, s);
     }
@@ -302,6 +305,95 @@ static int exec_start_cmd (struct bulk_exec *exec,
     return count;
 }
 
+/*  Fanout callbacks.  Start and exit notifications arrive already
+ *   aggregated by subtree.
+ */
+static void fanout_start_cb (struct fanout *fo,
+                             const struct idset *ranks,
+                             void *arg)
+{
+    struct bulk_exec *exec = arg;
+    exec->started += idset_count (ranks);
+    if (exec->started == exec->total) {
+        if (exec->handlers->on_start)
+            (*exec->handlers->on_start) (exec, exec->arg);
+    }
+}
+
+static void fanout_exit_cb (struct fanout *fo,
+                            const struct idset *ranks,
+                            int status,
+                            void *arg)
+{
+    struct bulk_exec *exec = arg;
+    unsigned int rank;
+
+    if (status > exec->exit_status)
+        exec->exit_status = status;
+    rank = idset_first (ranks);
+    while (rank != IDSET_INVALID_ID) {
+        exec_add_completed (exec, rank);
+        rank = idset_next (ranks, rank);
+    }
+}
+
+static void fanout_output_cb (struct fanout *fo,
+                              int rank,
+                              const char *stream,
+                              const char *data,
+                              int len,
+                              void *arg)
+{
+    struct bulk_exec *exec = arg;
+    if (exec->handlers->on_output)
+        (*exec->handlers->on_output) (exec, rank, stream, data, len,
+                                      exec->arg);
+    else
+        flux_log (exec->h, LOG_INFO, "rank %d: %s: %s", rank, stream, data);
+}
+
+static void fanout_error_cb (struct fanout *fo,
+                             int rank,
+                             int errnum,
+                             void *arg)
+{
+    struct bulk_exec *exec = arg;
+    if (exec->handlers->on_error)
+        (*exec->handlers->on_error) (exec, rank, errnum, exec->arg);
+}
+
+static const struct fanout_ops fanout_ops = {
+    .on_start =     fanout_start_cb,
+    .on_exit =      fanout_exit_cb,
+    .on_output =    fanout_output_cb,
+    .on_error =     fanout_error_cb,
+    .on_complete =  NULL,
+};
+
+static int exec_start_fanout (struct bulk_exec *exec, struct exec_cmd *cmd)
+{
+    struct fanout *fo;
+
+    if (!(fo = fanout_create (exec->h,
+                              cmd->ranks,
+                              cmd->cmd,
+                              cmd->flags,
+                              &fanout_ops,
+                              exec)))
+        return -1;
+    if (zlist_append (exec->fanouts, fo) < 0) {
+        fanout_destroy (fo);
+        errno = ENOMEM;
+        return -1;
+    }
+    zlist_freefn (exec->fanouts, fo, (zlist_free_fn *) fanout_destroy, true);
+    exec->fanout_ranks += idset_count (cmd->ranks);
+    if (fanout_start (fo) < 0)
+        return -1;
+    idset_range_clear (cmd->ranks, 0, INT_MAX);
+    return 0;
+}
+
 void bulk_exec_stop (struct bulk_exec *exec)
 {
     flux_watcher_stop (exec->prep);
@@ -312,7 +404,14 @@ static int exec_start_cmds (struct bulk_exec *exec, int max)
 {
     while (zlist_size (exec->commands) && (max != 0)) {
         struct exec_cmd *cmd = zlist_first (exec->commands);
-        int rc = exec_start_cmd (exec, cmd, max);
+        int rc;
+        if (exec->fanout) {
+            /*  One request per command regardless of the number of ranks */
+            if ((rc = exec_start_fanout (exec, cmd)) == 0)
+                rc = 1;
+        }
+        else
+            rc = exec_start_cmd (exec, cmd, max);
         if (rc < 0) {
             flux_log_error (exec->h, "exec_start_cmd failed");
             return -1;
@@ -350,7 +449,7 @@ static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
     if (exec_start_cmds (exec, exec->max_start_per_loop) < 0) {
         bulk_exec_stop (exec);
         if (exec->handlers->on_error)
-            (*exec->handlers->on_error) (exec, NULL, exec->arg);
+            (*exec->handlers->on_error) (exec, -1, errno, exec->arg);
     }
 }
 
@@ -358,6 +457,7 @@ void bulk_exec_destroy (struct bulk_exec *exec)
 {
     if (exec) {
         zlist_destroy (&exec->processes);
+        zlist_destroy (&exec->fanouts);
         zlist_destroy (&exec->commands);
         idset_destroy (exec->exit_batch);
         flux_watcher_destroy (exec->prep);
@@ -383,6 +483,7 @@ struct bulk_exec * bulk_exec_create (struct bulk_exec_ops *ops, void *arg)
     exec->handlers = ops;
     exec->arg = arg;
     exec->processes = zlist_new ();
+    exec->fanouts = zlist_new ();
     exec->commands = zlist_new ();
     exec->exit_batch = idset_create (0, IDSET_FLAG_AUTOGROW);
     exec->max_start_per_loop = 1;
@@ -400,6 +501,16 @@ int bulk_exec_set_max_per_loop (struct bulk_exec *exec, int max)
     return 0;
 }
 
+int bulk_exec_set_fanout (struct bulk_exec *exec, bool enable)
+{
+    if (exec->active) {
+        errno = EINVAL;
+        return -1;
+    }
+    exec->fanout = enable ? 1 : 0;
+    return 0;
+}
+
 int bulk_exec_push_cmd (struct bulk_exec *exec,
                        const struct idset *ranks,
                        flux_cmd_t *cmd,
@@ -469,7 +580,9 @@ int bulk_exec_cancel (struct bulk_exec *exec)
 flux_future_t *bulk_exec_kill (struct bulk_exec *exec, int signum)
 {
     flux_subprocess_t *p = zlist_first (exec->processes);
+    struct fanout *fo;
     flux_future_t *cf = NULL;
+    int i = 0;
 
     if (!(cf = flux_future_wait_all_create ()))
         return NULL;
@@ -498,6 +611,23 @@ flux_future_t *bulk_exec_kill (struct bulk_exec *exec, int signum)
         p = zlist_next (exec->processes);
     }
 
+    fo = zlist_first (exec->fanouts);
+    while (fo) {
+        flux_future_t *f;
+        char s[64];
+        if ((f = fanout_kill (fo, signum))) {
+            (void) snprintf (s, sizeof (s)-1, "fanout%d", i);
+            if (flux_future_push (cf, s, f) < 0) {
+                fprintf (stderr, "flux_future_push: %s\n", strerror (errno));
+                flux_future_destroy (f);
+            }
+        }
+        else if (errno != ENOENT)
+            flux_log_error (exec->h, "fanout_kill");
+        fo = zlist_next (exec->fanouts);
+        i++;
+    }
+
     /*  If no child futures were pushed into the wait_all future `cf`,
      *   then no signals were sent and we should immediately return ENOENT.
      */
@@ -511,13 +641,12 @@ flux_future_t *bulk_exec_kill (struct bulk_exec *exec, int signum)
 }
 
 static void imp_kill_output (struct bulk_exec *kill,
-                             flux_subprocess_t *p,
+                             int rank,
                              const char *stream,
                              const char *data,
                              int len,
                              void *arg)
 {
-    int rank = flux_subprocess_rank (p);
     flux_log (kill->h, LOG_INFO,
               "rank%d: flux-imp kill: %s: %s",
               rank,
@@ -535,12 +664,12 @@ static void imp_kill_complete (struct bulk_exec *kill, void *arg)
 }
 
 static void imp_kill_error (struct bulk_exec *kill,
-                            flux_subprocess_t *p,
+                            int rank,
+                            int errnum,
                             void *arg)
 {
-    flux_log_error (kill->h,
-                    "imp kill: rank=%d: failed",
-                    flux_subprocess_rank (p));
+    errno = errnum;
+    flux_log_error (kill->h, "imp kill: rank=%d: failed", rank);
 }
 
 
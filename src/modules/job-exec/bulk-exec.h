@@ -23,14 +23,16 @@ typedef void (*exec_exit_f) (struct bulk_exec *, void *arg,
                              const struct idset *ranks);
 
 typedef void (*exec_io_f)   (struct bulk_exec *,
-                             flux_subprocess_t *,
+                             int rank,
                              const char *stream,
 			     const char *data,
 			     int data_len,
                              void *arg);
 
+/*  rank is -1 if the failure is not specific to one rank */
 typedef void (*exec_error_f) (struct bulk_exec *,
-                              flux_subprocess_t *,
+                              int rank,
+                              int errnum,
                               void *arg);
 
 struct bulk_exec_ops {
@@ -55,6 +57,14 @@ int bulk_exec_aux_set (struct bulk_exec *exec,
  */
 int bulk_exec_set_max_per_loop (struct bulk_exec *exec, int max);
 
+/*  Launch each pushed command with a single request that fans out along
+ *   the TBON (see fanout.h), instead of one flux_rexec(3) per rank.
+ *   Must be set before bulk_exec_start().  Processes launched this way
+ *   do not support bulk_exec_write(), bulk_exec_close(), or
+ *   bulk_exec_imp_kill().
+ */
+int bulk_exec_set_fanout (struct bulk_exec *exec, bool enable);
+
 void bulk_exec_destroy (struct bulk_exec *exec);
 
 int bulk_exec_push_cmd (struct bulk_exec *exec,
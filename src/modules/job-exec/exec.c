@@ -14,6 +14,11 @@
  *
  * Launch configured job shell, one per rank.
  *
+ * Jobs spanning at least exec.fanout-threshold ranks (default 256, 0 to
+ * disable) are launched with a single request that fans out along the
+ * TBON, unless they are multiuser jobs, which require the IMP to be
+ * signaled and fed input from here.
+ *
  * TEST CONFIGURATION
  *
  * Test and other configuration may be presented in the jobspec
@@ -40,6 +45,7 @@ extern char **environ;
 static const char *default_cwd = "/tmp";
 static const char *default_job_shell = NULL;
 static const char *flux_imp_path = NULL;
+static int fanout_threshold = 256;
 
 /* Configuration for "bulk" execution implementation. Used only for testing
  *  for now.
@@ -137,7 +143,7 @@ static void complete_cb (struct bulk_exec *exec, void *arg)
                             bulk_exec_rc (exec));
 }
 
-static void output_cb (struct bulk_exec *exec, flux_subprocess_t *p,
+static void output_cb (struct bulk_exec *exec, int rank,
                        const char *stream,
                        const char *data,
                        int data_len,
@@ -146,17 +152,19 @@ static void output_cb (struct bulk_exec *exec, flux_subprocess_t *p,
     struct jobinfo *job = arg;
     flux_log (job->h, LOG_INFO, "%ju: %d: %s: %s",
                       (uintmax_t) job->id,
-                      flux_subprocess_rank (p),
+                      rank,
                       stream, data);
 }
 
-static void error_cb (struct bulk_exec *exec, flux_subprocess_t *p, void *arg)
+static void error_cb (struct bulk_exec *exec, int rank, int errnum, void *arg)
 {
     struct jobinfo *job = arg;
-    const char *arg0 = flux_cmd_arg (flux_subprocess_get_cmd (p), 0);
-    jobinfo_fatal_error (job, flux_subprocess_fail_errno (p),
-                              "cmd=%s: rank=%d failed",
-                              arg0, flux_subprocess_rank (p));
+    const char *arg0 = job->multiuser ? flux_imp_path : job_shell_path (job);
+    if (rank < 0)
+        jobinfo_fatal_error (job, errnum, "cmd=%s: launch failed", arg0);
+    else
+        jobinfo_fatal_error (job, errnum, "cmd=%s: rank=%d failed",
+                             arg0, rank);
 }
 
 static struct bulk_exec_ops exec_ops = {
@@ -223,6 +231,13 @@ static int exec_init (struct jobinfo *job)
         flux_log_error (job->h, "exec_init: flux_cmd_setcwd");
         goto err;
     }
+    if (!job->multiuser
+        && fanout_threshold > 0
+        && (int) idset_count (ranks) >= fanout_threshold
+        && bulk_exec_set_fanout (exec, true) < 0) {
+        flux_log_error (job->h, "exec_init: bulk_exec_set_fanout");
+        goto err;
+    }
     if (bulk_exec_push_cmd (exec, ranks, cmd, 0) < 0) {
         flux_log_error (job->h, "exec_init: bulk_exec_push_cmd");
         goto err;
@@ -373,12 +388,26 @@ static int exec_config (flux_t *h, int argc, char **argv)
         return -1;
     }
 
+    /*  Check configuration for exec.fanout-threshold */
+    if (flux_conf_unpack (flux_get_conf (h),
+                          &err,
+                          "{s?:{s?i}}",
+                          "exec",
+                            "fanout-threshold", &fanout_threshold) < 0) {
+        flux_log (h, LOG_ERR,
+                  "error reading config value exec.fanout-threshold: %s",
+                  err.errbuf);
+        return -1;
+    }
+
     /* Finally, override values on cmdline */
     for (int i = 0; i < argc; i++) {
         if (strncmp (argv[i], "job-shell=", 10) == 0)
             default_job_shell = argv[i]+10;
         else if (strncmp (argv[i], "imp=", 4) == 0)
             flux_imp_path = argv[i]+4;
+        else if (strncmp (argv[i], "fanout-threshold=", 17) == 0)
+            fanout_threshold = strtol (argv[i]+17, NULL, 10);
     }
     flux_log (h, LOG_DEBUG, "using default shell path %s", default_job_shell);
     if (flux_imp_path)
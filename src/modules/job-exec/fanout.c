@@ -0,0 +1,935 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* Hierarchical remote execution along the TBON
+ *
+ * PROTOCOL
+ *
+ * The parent sends one streaming "job-exec.fanout" request to each TBON
+ * child with targets in its subtree:
+ *
+ *   {"ranks":s, "cmd":s, "flags":i}
+ *
+ * where "ranks" is an idset and "cmd" is flux_cmd_tojson() output.
+ * The child responds with a stream of
+ *
+ *   {"type":"start", "ranks":s}
+ *   {"type":"exit", "ranks":s, "status":i}
+ *   {"type":"output", "rank":i, "stream":s, "data":s}
+ *   {"type":"error", "rank":i, "errnum":i}
+ *
+ * terminated by ENODATA once all ranks have exited.  The "start" response
+ * is sent once per subtree, and "exit" responses are batched for 0.01s,
+ * so the parent sees a handful of messages per child regardless of the
+ * size of the subtree.
+ *
+ * "job-exec.fanout-kill" {"matchtag":i, "signum":i} signals the subtree
+ * started by the sender's fanout request with the given matchtag, and
+ * responds once the subtree has been signaled.
+ */
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <sys/wait.h>
+#define EXIT_CODE(x) __W_EXITCODE(x,0)
+
+#include <flux/core.h>
+#include <flux/idset.h>
+#include <czmq.h>
+#include <jansson.h>
+
+#include "src/common/libsubprocess/command.h"
+#include "src/common/libutil/kary.h"
+#include "src/common/libutil/errno_safe.h"
+#include "fanout.h"
+
+struct fanout_child {
+    struct fanout *fo;
+    uint32_t rank;              /* TBON child rank */
+    struct idset *ranks;        /* target ranks in the child's subtree */
+    flux_future_t *f;
+    unsigned int responded:1;
+    unsigned int done:1;
+};
+
+struct fanout {
+    flux_t *h;
+    struct idset *ranks;
+    flux_cmd_t *cmd;
+    int flags;
+
+    struct idset *local;        /* ranks launched directly from here */
+    zlist_t *children;          /* list of struct fanout_child */
+    zlist_t *processes;
+
+    struct idset *started;
+    int failed;                 /* ranks that failed before starting */
+    unsigned int start_notified:1;
+    unsigned int complete:1;
+
+    struct idset *pending;      /* ranks which have not yet exited */
+    struct idset *exit_batch;
+    int exit_batch_status;
+    flux_watcher_t *exit_batch_timer;
+    unsigned int exit_batch_armed:1;
+
+    flux_subprocess_ops_t sp_ops;
+    const struct fanout_ops *ops;
+    void *arg;
+};
+
+int fanout_fail_status (int errnum)
+{
+    if (errnum == EPERM || errnum == EACCES)
+        return EXIT_CODE(126);
+    else if (errnum == ENOENT)
+        return EXIT_CODE(127);
+    else if (errnum == EHOSTUNREACH)
+        return EXIT_CODE(68);
+    return EXIT_CODE(1);
+}
+
+const struct idset *fanout_ranks (struct fanout *fo)
+{
+    return fo->ranks;
+}
+
+static void fanout_check_start (struct fanout *fo)
+{
+    if (fo->start_notified
+        || idset_count (fo->started) + fo->failed < idset_count (fo->ranks))
+        return;
+    fo->start_notified = 1;
+    if (idset_count (fo->started) > 0 && fo->ops->on_start)
+        (*fo->ops->on_start) (fo, fo->started, fo->arg);
+}
+
+static void fanout_started (struct fanout *fo, unsigned int rank)
+{
+    if (!idset_test (fo->ranks, rank) || idset_test (fo->started, rank))
+        return;
+    if (idset_set (fo->started, rank) < 0)
+        flux_log_error (fo->h, "fanout_started: idset_set");
+}
+
+static void exit_batch_arm (struct fanout *fo, double after)
+{
+    flux_watcher_stop (fo->exit_batch_timer);
+    flux_timer_watcher_reset (fo->exit_batch_timer, after, 0.);
+    flux_watcher_start (fo->exit_batch_timer);
+    fo->exit_batch_armed = 1;
+}
+
+/*  Append 'rank' to the current batch for exit notification.  The batch
+ *   is flushed 0.01s after its first entry, or on the next reactor loop
+ *   once every rank has exited.
+ */
+static void exit_batch_append (struct fanout *fo, unsigned int rank, int status)
+{
+    if (!idset_test (fo->pending, rank))
+        return;
+    if (idset_clear (fo->pending, rank) < 0
+        || idset_set (fo->exit_batch, rank) < 0) {
+        flux_log_error (fo->h, "exit_batch_append: idset");
+        return;
+    }
+    if (status > fo->exit_batch_status)
+        fo->exit_batch_status = status;
+    if (idset_count (fo->pending) == 0)
+        exit_batch_arm (fo, 0.);
+    else if (!fo->exit_batch_armed)
+        exit_batch_arm (fo, 0.01);
+}
+
+static void exit_batch_cb (flux_reactor_t *r, flux_watcher_t *w,
+                           int revents, void *arg)
+{
+    struct fanout *fo = arg;
+
+    fo->exit_batch_armed = 0;
+    if (idset_count (fo->exit_batch) > 0) {
+        if (fo->ops->on_exit)
+            (*fo->ops->on_exit) (fo,
+                                 fo->exit_batch,
+                                 fo->exit_batch_status,
+                                 fo->arg);
+        idset_range_clear (fo->exit_batch, 0, INT_MAX);
+        fo->exit_batch_status = 0;
+    }
+    if (idset_count (fo->pending) == 0 && !fo->complete) {
+        fo->complete = 1;
+        /*  N.B. fo may be destroyed by on_complete */
+        if (fo->ops->on_complete)
+            (*fo->ops->on_complete) (fo, fo->arg);
+    }
+}
+
+/*  'rank' failed to start or was lost with 'errnum'.
+ */
+static void fanout_fail (struct fanout *fo, unsigned int rank, int errnum)
+{
+    if (!idset_test (fo->pending, rank))
+        return;
+    if (!idset_test (fo->started, rank))
+        fo->failed++;
+    if (fo->ops->on_error)
+        (*fo->ops->on_error) (fo, rank, errnum, fo->arg);
+    exit_batch_append (fo, rank, fanout_fail_status (errnum));
+}
+
+static void fanout_fail_set (struct fanout *fo,
+                             const struct idset *ranks,
+                             int errnum)
+{
+    unsigned int rank = idset_first (ranks);
+    while (rank != IDSET_INVALID_ID) {
+        fanout_fail (fo, rank, errnum);
+        rank = idset_next (ranks, rank);
+    }
+}
+
+/*  Local subprocess callbacks
+ */
+static void fanout_state_cb (flux_subprocess_t *p,
+                             flux_subprocess_state_t state)
+{
+    struct fanout *fo = flux_subprocess_aux_get (p, "job-exec::fanout");
+    int rank = flux_subprocess_rank (p);
+
+    if (state == FLUX_SUBPROCESS_RUNNING) {
+        fanout_started (fo, rank);
+        fanout_check_start (fo);
+    }
+    else if (state == FLUX_SUBPROCESS_FAILED
+            || state == FLUX_SUBPROCESS_EXEC_FAILED) {
+        fanout_fail (fo, rank, flux_subprocess_fail_errno (p));
+        fanout_check_start (fo);
+    }
+}
+
+static void fanout_complete_cb (flux_subprocess_t *p)
+{
+    struct fanout *fo = flux_subprocess_aux_get (p, "job-exec::fanout");
+    exit_batch_append (fo,
+                       flux_subprocess_rank (p),
+                       flux_subprocess_status (p));
+}
+
+static void fanout_output_cb (flux_subprocess_t *p, const char *stream)
+{
+    struct fanout *fo = flux_subprocess_aux_get (p, "job-exec::fanout");
+    const char *s;
+    int len;
+
+    if (!(s = flux_subprocess_getline (p, stream, &len))) {
+        flux_log_error (fo->h, "flux_subprocess_getline");
+        return;
+    }
+    if (len && fo->ops->on_output)
+        (*fo->ops->on_output) (fo,
+                               flux_subprocess_rank (p),
+                               stream,
+                               s,
+                               len,
+                               fo->arg);
+}
+
+static int fanout_launch (struct fanout *fo, unsigned int rank)
+{
+    flux_subprocess_t *p;
+
+    if (!(p = flux_rexec (fo->h, rank, fo->flags, fo->cmd, &fo->sp_ops)))
+        return -1;
+    if (flux_subprocess_aux_set (p, "job-exec::fanout", fo, NULL) < 0
+        || zlist_append (fo->processes, p) < 0) {
+        ERRNO_SAFE_WRAP (flux_subprocess_unref, p);
+        return -1;
+    }
+    zlist_freefn (fo->processes,
+                  p,
+                  (zlist_free_fn *) flux_subprocess_unref,
+                  true);
+    return 0;
+}
+
+static void fanout_launch_set (struct fanout *fo, const struct idset *ranks)
+{
+    unsigned int rank = idset_first (ranks);
+    while (rank != IDSET_INVALID_ID) {
+        if (fanout_launch (fo, rank) < 0) {
+            flux_log_error (fo->h, "fanout: rexec rank %u", rank);
+            fanout_fail (fo, rank, errno);
+        }
+        rank = idset_next (ranks, rank);
+    }
+}
+
+/*  Child subtree callbacks
+ */
+static void child_finish (struct fanout_child *c, int errnum)
+{
+    struct fanout *fo = c->fo;
+
+    c->done = 1;
+    if (errnum == ENOSYS && !c->responded) {
+        /*  No fanout service on this child.  Launch its subtree directly.
+         */
+        flux_log (fo->h, LOG_DEBUG,
+                  "fanout: rank %u: no fanout service, using rexec",
+                  c->rank);
+        fanout_launch_set (fo, c->ranks);
+    }
+    else
+        fanout_fail_set (fo, c->ranks, errnum);
+    fanout_check_start (fo);
+}
+
+static void child_continuation (flux_future_t *f, void *arg)
+{
+    struct fanout_child *c = arg;
+    struct fanout *fo = c->fo;
+    const char *type;
+    const char *ranks = NULL;
+    const char *stream = NULL;
+    const char *data = NULL;
+    int rank = -1;
+    int status = 0;
+    int errnum = 0;
+    struct idset *ids = NULL;
+
+    if (flux_rpc_get_unpack (f, "{s:s s?s s?i s?i s?i s?s s?s}",
+                             "type", &type,
+                             "ranks", &ranks,
+                             "rank", &rank,
+                             "status", &status,
+                             "errnum", &errnum,
+                             "stream", &stream,
+                             "data", &data) < 0) {
+        errnum = errno;
+        if (errnum != ENODATA)
+            flux_log_error (fo->h, "fanout: rank %u", c->rank);
+        /*  Ranks still pending when the stream ends were lost.
+         */
+        child_finish (c, errnum == ENODATA ? EPROTO : errnum);
+        return;
+    }
+    c->responded = 1;
+    if (ranks && !(ids = idset_decode (ranks))) {
+        flux_log_error (fo->h, "fanout: rank %u: idset_decode", c->rank);
+        goto out;
+    }
+    if (!strcmp (type, "start") && ids) {
+        unsigned int id = idset_first (ids);
+        while (id != IDSET_INVALID_ID) {
+            if (idset_test (c->ranks, id))
+                fanout_started (fo, id);
+            id = idset_next (ids, id);
+        }
+        fanout_check_start (fo);
+    }
+    else if (!strcmp (type, "exit") && ids) {
+        unsigned int id = idset_first (ids);
+        while (id != IDSET_INVALID_ID) {
+            if (idset_test (c->ranks, id))
+                exit_batch_append (fo, id, status);
+            id = idset_next (ids, id);
+        }
+    }
+    else if (!strcmp (type, "output") && stream && data) {
+        if (fo->ops->on_output)
+            (*fo->ops->on_output) (fo,
+                                   rank,
+                                   stream,
+                                   data,
+                                   strlen (data),
+                                   fo->arg);
+    }
+    else if (!strcmp (type, "error") && rank >= 0) {
+        if (idset_test (c->ranks, rank)) {
+            fanout_fail (fo, rank, errnum);
+            fanout_check_start (fo);
+        }
+    }
+    else
+        flux_log (fo->h, LOG_ERR,
+                  "fanout: rank %u: malformed %s response",
+                  c->rank, type);
+out:
+    idset_destroy (ids);
+    flux_future_reset (f);
+}
+
+static int child_start (struct fanout_child *c, const char *cmd)
+{
+    struct fanout *fo = c->fo;
+    char *ranks;
+
+    if (!(ranks = idset_encode (c->ranks, IDSET_FLAG_RANGE)))
+        return -1;
+    if (!(c->f = flux_rpc_pack (fo->h,
+                                "job-exec.fanout",
+                                c->rank,
+                                FLUX_RPC_STREAMING,
+                                "{s:s s:s s:i}",
+                                "ranks", ranks,
+                                "cmd", cmd,
+                                "flags", fo->flags))
+        || flux_future_then (c->f, -1., child_continuation, c) < 0) {
+        ERRNO_SAFE_WRAP (free, ranks);
+        return -1;
+    }
+    free (ranks);
+    return 0;
+}
+
+static void child_destroy (void *arg)
+{
+    struct fanout_child *c = arg;
+    if (c) {
+        int saved_errno = errno;
+        flux_future_destroy (c->f);
+        idset_destroy (c->ranks);
+        free (c);
+        errno = saved_errno;
+    }
+}
+
+static struct fanout_child *child_get (struct fanout *fo, uint32_t rank)
+{
+    struct fanout_child *c = zlist_first (fo->children);
+
+    while (c) {
+        if (c->rank == rank)
+            return c;
+        c = zlist_next (fo->children);
+    }
+    if (!(c = calloc (1, sizeof (*c))))
+        return NULL;
+    c->fo = fo;
+    c->rank = rank;
+    if (!(c->ranks = idset_create (0, IDSET_FLAG_AUTOGROW))
+        || zlist_append (fo->children, c) < 0) {
+        child_destroy (c);
+        errno = ENOMEM;
+        return NULL;
+    }
+    zlist_freefn (fo->children, c, child_destroy, true);
+    return c;
+}
+
+/*  Split fo->ranks into those launched from here and those handed to
+ *   the TBON child whose subtree contains them.
+ */
+static int fanout_partition (struct fanout *fo)
+{
+    const char *s;
+    uint32_t size;
+    uint32_t self;
+    int k;
+    unsigned int rank;
+
+    if (!(s = flux_attr_get (fo->h, "tbon.arity"))
+        || flux_get_size (fo->h, &size) < 0
+        || flux_get_rank (fo->h, &self) < 0)
+        return -1;
+    if ((k = strtol (s, NULL, 10)) < 1) {
+        errno = EINVAL;
+        return -1;
+    }
+    rank = idset_first (fo->ranks);
+    while (rank != IDSET_INVALID_ID) {
+        uint32_t child = kary_child_route (k, size, self, rank);
+        if (child == KARY_NONE) {
+            if (idset_set (fo->local, rank) < 0)
+                return -1;
+        }
+        else {
+            struct fanout_child *c;
+            if (!(c = child_get (fo, child))
+                || idset_set (c->ranks, rank) < 0)
+                return -1;
+        }
+        rank = idset_next (fo->ranks, rank);
+    }
+    return 0;
+}
+
+int fanout_start (struct fanout *fo)
+{
+    struct fanout_child *c;
+    char *cmd = NULL;
+
+    if (zlist_size (fo->children) > 0) {
+        if (!(cmd = flux_cmd_tojson (fo->cmd)))
+            return -1;
+        c = zlist_first (fo->children);
+        while (c) {
+            if (child_start (c, cmd) < 0) {
+                flux_log_error (fo->h, "fanout: rank %u", c->rank);
+                child_finish (c, errno);
+            }
+            c = zlist_next (fo->children);
+        }
+        free (cmd);
+    }
+    fanout_launch_set (fo, fo->local);
+    fanout_check_start (fo);
+    if (idset_count (fo->pending) == 0 && !fo->exit_batch_armed)
+        exit_batch_arm (fo, 0.);
+    return 0;
+}
+
+static int kill_push (flux_future_t *cf, const char *name, flux_future_t *f)
+{
+    if (flux_future_push (cf, name, f) < 0) {
+        flux_future_destroy (f);
+        return -1;
+    }
+    return 0;
+}
+
+flux_future_t *fanout_kill (struct fanout *fo, int signum)
+{
+    flux_subprocess_t *p;
+    struct fanout_child *c;
+    flux_future_t *cf;
+    flux_future_t *f;
+    char name[64];
+
+    if (!(cf = flux_future_wait_all_create ()))
+        return NULL;
+    flux_future_set_flux (cf, fo->h);
+
+    p = zlist_first (fo->processes);
+    while (p) {
+        if (flux_subprocess_state (p) == FLUX_SUBPROCESS_RUNNING
+            || flux_subprocess_state (p) == FLUX_SUBPROCESS_INIT) {
+            if (!(f = flux_subprocess_kill (p, signum))) {
+                int err = errno;
+                if (!(f = flux_future_create (NULL, NULL)))
+                    goto error;
+                flux_future_fulfill_error (f, err, flux_strerror (err));
+            }
+            (void) snprintf (name, sizeof (name), "%d",
+                             flux_subprocess_rank (p));
+            if (kill_push (cf, name, f) < 0)
+                goto error;
+        }
+        p = zlist_next (fo->processes);
+    }
+    c = zlist_first (fo->children);
+    while (c) {
+        if (!c->done) {
+            if (!(f = flux_rpc_pack (fo->h,
+                                     "job-exec.fanout-kill",
+                                     c->rank,
+                                     0,
+                                     "{s:i s:i}",
+                                     "matchtag", flux_rpc_get_matchtag (c->f),
+                                     "signum", signum)))
+                goto error;
+            (void) snprintf (name, sizeof (name), "child-%u", c->rank);
+            if (kill_push (cf, name, f) < 0)
+                goto error;
+        }
+        c = zlist_next (fo->children);
+    }
+    if (!flux_future_first_child (cf)) {
+        flux_future_destroy (cf);
+        errno = ENOENT;
+        return NULL;
+    }
+    return cf;
+error:
+    ERRNO_SAFE_WRAP (flux_future_destroy, cf);
+    return NULL;
+}
+
+void fanout_destroy (struct fanout *fo)
+{
+    if (fo) {
+        int saved_errno = errno;
+        zlist_destroy (&fo->children);
+        zlist_destroy (&fo->processes);
+        flux_watcher_destroy (fo->exit_batch_timer);
+        idset_destroy (fo->ranks);
+        idset_destroy (fo->local);
+        idset_destroy (fo->started);
+        idset_destroy (fo->pending);
+        idset_destroy (fo->exit_batch);
+        flux_cmd_destroy (fo->cmd);
+        free (fo);
+        errno = saved_errno;
+    }
+}
+
+struct fanout *fanout_create (flux_t *h,
+                              const struct idset *ranks,
+                              const flux_cmd_t *cmd,
+                              int flags,
+                              const struct fanout_ops *ops,
+                              void *arg)
+{
+    flux_subprocess_ops_t sp_ops = {
+        .on_completion =   fanout_complete_cb,
+        .on_state_change = fanout_state_cb,
+        .on_stdout =       fanout_output_cb,
+        .on_stderr =       fanout_output_cb,
+    };
+    struct fanout *fo;
+
+    if (!h || !ranks || !cmd || !ops) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(fo = calloc (1, sizeof (*fo))))
+        return NULL;
+    fo->h = h;
+    fo->flags = flags;
+    fo->sp_ops = sp_ops;
+    fo->ops = ops;
+    fo->arg = arg;
+    if (!(fo->ranks = idset_copy (ranks))
+        || !(fo->pending = idset_copy (ranks))
+        || !(fo->cmd = flux_cmd_copy (cmd))
+        || !(fo->local = idset_create (0, IDSET_FLAG_AUTOGROW))
+        || !(fo->started = idset_create (0, IDSET_FLAG_AUTOGROW))
+        || !(fo->exit_batch = idset_create (0, IDSET_FLAG_AUTOGROW))
+        || !(fo->children = zlist_new ())
+        || !(fo->processes = zlist_new ())
+        || !(fo->exit_batch_timer =
+                flux_timer_watcher_create (flux_get_reactor (h),
+                                           0.01, 0.,
+                                           exit_batch_cb,
+                                           fo)))
+        goto error;
+    if (fanout_partition (fo) < 0)
+        goto error;
+    return fo;
+error:
+    fanout_destroy (fo);
+    return NULL;
+}
+
+/*  Service
+ */
+struct fanout_service {
+    flux_t *h;
+    flux_msg_handler_t **handlers;
+    zlist_t *requests;          /* list of struct fanout_request */
+};
+
+struct fanout_request {
+    struct fanout_service *svc;
+    const flux_msg_t *msg;
+    struct fanout *fo;
+};
+
+static void fanout_request_destroy (void *arg)
+{
+    struct fanout_request *req = arg;
+    if (req) {
+        int saved_errno = errno;
+        fanout_destroy (req->fo);
+        flux_msg_decref (req->msg);
+        free (req);
+        errno = saved_errno;
+    }
+}
+
+static void respond_start (struct fanout *fo,
+                           const struct idset *ranks,
+                           void *arg)
+{
+    struct fanout_request *req = arg;
+    char *s;
+
+    if (!(s = idset_encode (ranks, IDSET_FLAG_RANGE))
+        || flux_respond_pack (req->svc->h, req->msg,
+                              "{s:s s:s}",
+                              "type", "start",
+                              "ranks", s) < 0)
+        flux_log_error (req->svc->h, "fanout: error responding to start");
+    free (s);
+}
+
+static void respond_exit (struct fanout *fo,
+                          const struct idset *ranks,
+                          int status,
+                          void *arg)
+{
+    struct fanout_request *req = arg;
+    char *s;
+
+    if (!(s = idset_encode (ranks, IDSET_FLAG_RANGE))
+        || flux_respond_pack (req->svc->h, req->msg,
+                              "{s:s s:s s:i}",
+                              "type", "exit",
+                              "ranks", s,
+                              "status", status) < 0)
+        flux_log_error (req->svc->h, "fanout: error responding to exit");
+    free (s);
+}
+
+static void respond_output (struct fanout *fo,
+                            int rank,
+                            const char *stream,
+                            const char *data,
+                            int len,
+                            void *arg)
+{
+    struct fanout_request *req = arg;
+
+    if (flux_respond_pack (req->svc->h, req->msg,
+                           "{s:s s:i s:s s:s#}",
+                           "type", "output",
+                           "rank", rank,
+                           "stream", stream,
+                           "data", data, len) < 0)
+        flux_log_error (req->svc->h, "fanout: error responding to output");
+}
+
+static void respond_error (struct fanout *fo, int rank, int errnum, void *arg)
+{
+    struct fanout_request *req = arg;
+
+    if (flux_respond_pack (req->svc->h, req->msg,
+                           "{s:s s:i s:i}",
+                           "type", "error",
+                           "rank", rank,
+                           "errnum", errnum) < 0)
+        flux_log_error (req->svc->h, "fanout: error responding to error");
+}
+
+static void respond_complete (struct fanout *fo, void *arg)
+{
+    struct fanout_request *req = arg;
+    struct fanout_service *svc = req->svc;
+
+    if (flux_respond_error (svc->h, req->msg, ENODATA, NULL) < 0)
+        flux_log_error (svc->h, "fanout: error responding to complete");
+    zlist_remove (svc->requests, req);
+}
+
+static const struct fanout_ops service_ops = {
+    .on_start = respond_start,
+    .on_exit = respond_exit,
+    .on_output = respond_output,
+    .on_error = respond_error,
+    .on_complete = respond_complete,
+};
+
+static void fanout_cb (flux_t *h, flux_msg_handler_t *mh,
+                       const flux_msg_t *msg, void *arg)
+{
+    struct fanout_service *svc = arg;
+    struct fanout_request *req = NULL;
+    const char *ranks;
+    const char *cmd_str;
+    int flags;
+    struct idset *ids = NULL;
+    flux_cmd_t *cmd = NULL;
+    json_error_t error;
+
+    if (flux_request_unpack (msg, NULL, "{s:s s:s s:i}",
+                             "ranks", &ranks,
+                             "cmd", &cmd_str,
+                             "flags", &flags) < 0)
+        goto error;
+    if (!flux_msg_is_streaming (msg)) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(ids = idset_decode (ranks)))
+        goto error;
+    if (!(cmd = flux_cmd_fromjson (cmd_str, &error))) {
+        flux_log (h, LOG_ERR, "fanout: flux_cmd_fromjson: %s", error.text);
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(req = calloc (1, sizeof (*req))))
+        goto error;
+    req->svc = svc;
+    req->msg = flux_msg_incref (msg);
+    if (!(req->fo = fanout_create (h, ids, cmd, flags, &service_ops, req)))
+        goto error;
+    if (zlist_append (svc->requests, req) < 0) {
+        errno = ENOMEM;
+        goto error;
+    }
+    zlist_freefn (svc->requests, req, fanout_request_destroy, true);
+    if (fanout_start (req->fo) < 0) {
+        flux_log_error (h, "fanout_start");
+        fanout_fail_set (req->fo, ids, errno);
+    }
+    idset_destroy (ids);
+    flux_cmd_destroy (cmd);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    fanout_request_destroy (req);
+    idset_destroy (ids);
+    flux_cmd_destroy (cmd);
+}
+
+static bool fanout_request_match (struct fanout_request *req,
+                                  const char *sender,
+                                  uint32_t matchtag)
+{
+    char *s = NULL;
+    uint32_t t;
+    bool match = (flux_msg_get_matchtag (req->msg, &t) == 0
+                  && (matchtag == FLUX_MATCHTAG_NONE || t == matchtag)
+                  && flux_msg_get_route_first (req->msg, &s) == 0
+                  && s != NULL
+                  && !strcmp (sender, s));
+    free (s);
+    return match;
+}
+
+static struct fanout_request *fanout_request_find (struct fanout_service *svc,
+                                                   const char *sender,
+                                                   uint32_t matchtag)
+{
+    struct fanout_request *req = zlist_first (svc->requests);
+
+    while (req) {
+        if (fanout_request_match (req, sender, matchtag))
+            return req;
+        req = zlist_next (svc->requests);
+    }
+    return NULL;
+}
+
+static void kill_continuation (flux_future_t *f, void *arg)
+{
+    flux_t *h = flux_future_get_flux (f);
+    const flux_msg_t *msg = flux_future_aux_get (f, "job-exec::msg");
+
+    if (flux_future_get (f, NULL) < 0) {
+        if (flux_respond_error (h, msg, errno, NULL) < 0)
+            flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    }
+    else if (flux_respond (h, msg, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+    flux_future_destroy (f);
+}
+
+static void fanout_kill_cb (flux_t *h, flux_msg_handler_t *mh,
+                            const flux_msg_t *msg, void *arg)
+{
+    struct fanout_service *svc = arg;
+    struct fanout_request *req;
+    char *sender = NULL;
+    int matchtag;
+    int signum;
+    flux_future_t *f = NULL;
+
+    if (flux_request_unpack (msg, NULL, "{s:i s:i}",
+                             "matchtag", &matchtag,
+                             "signum", &signum) < 0
+        || flux_msg_get_route_first (msg, &sender) < 0)
+        goto error;
+    if (!sender
+        || !(req = fanout_request_find (svc, sender, matchtag))) {
+        errno = ENOENT;
+        goto error;
+    }
+    if (!(f = fanout_kill (req->fo, signum)))
+        goto error;
+    if (flux_future_aux_set (f,
+                             "job-exec::msg",
+                             (void *) flux_msg_incref (msg),
+                             (flux_free_f) flux_msg_decref) < 0) {
+        flux_msg_decref (msg);
+        goto error;
+    }
+    if (flux_future_then (f, -1., kill_continuation, NULL) < 0)
+        goto error;
+    free (sender);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    flux_future_destroy (f);
+    free (sender);
+}
+
+static void kill_destroy (flux_future_t *f, void *arg)
+{
+    flux_future_destroy (f);
+}
+
+/*  The parent went away.  Kill its processes.  The fanout is destroyed
+ *   as usual once they exit.
+ */
+static void disconnect_cb (flux_t *h, flux_msg_handler_t *mh,
+                           const flux_msg_t *msg, void *arg)
+{
+    struct fanout_service *svc = arg;
+    struct fanout_request *req;
+    char *sender;
+
+    if (flux_msg_get_route_first (msg, &sender) < 0 || !sender)
+        return;
+    req = zlist_first (svc->requests);
+    while (req) {
+        if (fanout_request_match (req, sender, FLUX_MATCHTAG_NONE)) {
+            flux_future_t *f = fanout_kill (req->fo, SIGKILL);
+            if (f && flux_future_then (f, -1., kill_destroy, NULL) < 0)
+                flux_future_destroy (f);
+        }
+        req = zlist_next (svc->requests);
+    }
+    free (sender);
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    { FLUX_MSGTYPE_REQUEST,  "job-exec.fanout",      fanout_cb,      0 },
+    { FLUX_MSGTYPE_REQUEST,  "job-exec.fanout-kill", fanout_kill_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST,  "job-exec.disconnect",  disconnect_cb,  0 },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+void fanout_service_destroy (struct fanout_service *svc)
+{
+    if (svc) {
+        int saved_errno = errno;
+        flux_msg_handler_delvec (svc->handlers);
+        zlist_destroy (&svc->requests);
+        free (svc);
+        errno = saved_errno;
+    }
+}
+
+struct fanout_service *fanout_service_create (flux_t *h)
+{
+    struct fanout_service *svc;
+
+    if (!(svc = calloc (1, sizeof (*svc))))
+        return NULL;
+    svc->h = h;
+    if (!(svc->requests = zlist_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_msg_handler_addvec (h, htab, svc, &svc->handlers) < 0)
+        goto error;
+    return svc;
+error:
+    fanout_service_destroy (svc);
+    return NULL;
+}
+
+/* vi: ts=4 sw=4 expandtab
+ */
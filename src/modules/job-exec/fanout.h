@@ -0,0 +1,96 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* Hierarchical remote execution along the TBON
+ *
+ * A fanout runs one command on a set of ranks.  Ranks reachable through
+ * a TBON child are handed to the job-exec module on that child in a
+ * single "job-exec.fanout" streaming request, which recursively does the
+ * same, so each broker only talks to its direct children and to the
+ * ranks it launches itself.  Start and exit notifications are batched
+ * at each level on the way back up.
+ *
+ * If a child does not implement the fanout service (ENOSYS), the ranks
+ * in its subtree are launched directly with flux_rexec(3) instead.
+ */
+
+#ifndef HAVE_JOB_EXEC_FANOUT_H
+#define HAVE_JOB_EXEC_FANOUT_H 1
+
+#include <flux/core.h>
+#include <flux/idset.h>
+
+struct fanout;
+
+struct fanout_ops {
+    /* 'ranks' have started (called once, after every rank has started
+     *  or failed)
+     */
+    void (*on_start) (struct fanout *fo,
+                      const struct idset *ranks,
+                      void *arg);
+    /* 'ranks' have exited, 'status' is the largest wait status among them
+     */
+    void (*on_exit) (struct fanout *fo,
+                     const struct idset *ranks,
+                     int status,
+                     void *arg);
+    /* A line of output from 'rank'
+     */
+    void (*on_output) (struct fanout *fo,
+                       int rank,
+                       const char *stream,
+                       const char *data,
+                       int len,
+                       void *arg);
+    /* 'rank' failed to start or was lost.  An exit notification with
+     *  status fanout_fail_status(errnum) follows.
+     */
+    void (*on_error) (struct fanout *fo, int rank, int errnum, void *arg);
+    /* All ranks have exited.  Called from the reactor, after the final
+     *  on_exit, so the fanout may be destroyed here.
+     */
+    void (*on_complete) (struct fanout *fo, void *arg);
+};
+
+struct fanout *fanout_create (flux_t *h,
+                              const struct idset *ranks,
+                              const flux_cmd_t *cmd,
+                              int flags,
+                              const struct fanout_ops *ops,
+                              void *arg);
+
+void fanout_destroy (struct fanout *fo);
+
+int fanout_start (struct fanout *fo);
+
+/* Send 'signum' to all running processes.  The returned future is
+ *  fulfilled once the whole tree has been signaled.  Returns NULL with
+ *  errno == ENOENT if there was nothing to signal.
+ */
+flux_future_t *fanout_kill (struct fanout *fo, int signum);
+
+/* Return the ranks targeted by 'fo'.
+ */
+const struct idset *fanout_ranks (struct fanout *fo);
+
+/* Wait status reported for a process that failed with 'errnum'.
+ */
+int fanout_fail_status (int errnum);
+
+/* Service "job-exec.fanout" requests from the parent broker.
+ */
+struct fanout_service *fanout_service_create (flux_t *h);
+void fanout_service_destroy (struct fanout_service *svc);
+
+#endif /* !HAVE_JOB_EXEC_FANOUT_H */
+
+/* vi: ts=4 sw=4 expandtab
+ */
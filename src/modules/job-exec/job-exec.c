@@ -101,6 +101,7 @@
 #include "src/common/libutil/fsd.h"
 #include "src/common/libutil/errno_safe.h"
 #include "job-exec.h"
+#include "fanout.h"
 
 static double kill_timeout=5.0;
 
@@ -1152,8 +1153,26 @@ int mod_main (flux_t *h, int argc, char **argv)
 {
     int saved_errno = 0;
     int rc = -1;
+    uint32_t rank = 0;
+    struct fanout_service *fanout = NULL;
     struct job_exec_ctx *ctx = job_exec_ctx_create (h);
 
+    /*  The fanout service relays job shell launch on every rank.
+     *   The remainder of the exec service only runs on rank 0.
+     */
+    if (flux_get_rank (h, &rank) < 0) {
+        flux_log_error (h, "flux_get_rank");
+        goto out;
+    }
+    if (!(fanout = fanout_service_create (h))) {
+        flux_log_error (h, "fanout_service_create");
+        goto out;
+    }
+    if (rank > 0) {
+        rc = flux_reactor_run (flux_get_reactor (h), 0);
+        goto out;
+    }
+
     if (job_exec_initialize (h, argc, argv) < 0
         || configure_implementations (h, argc, argv) < 0) {
         flux_log_error (h, "job-exec: module initialization failed");
@@ -1174,8 +1193,9 @@ int mod_main (flux_t *h, int argc, char **argv)
     rc = flux_reactor_run (flux_get_reactor (h), 0);
 out:
     saved_errno = errno;
-    if (flux_event_unsubscribe (h, "job-exception") < 0)
+    if (rank == 0 && flux_event_unsubscribe (h, "job-exception") < 0)
         flux_log_error (h, "flux_event_unsubscribe ('job-exception')");
+    fanout_service_destroy (fanout);
     job_exec_ctx_destroy (ctx);
     errno = saved_errno;
     return rc;
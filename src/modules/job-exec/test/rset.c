@@ -64,6 +64,20 @@ struct resource_set_test {
     "    } " \
     "}"
 
+#define OVERLAP_R \
+    "{ \"version\": 1," \
+    "  \"execution\": { " \
+    "    \"R_lite\": " \
+    "       [ {\"rank\": \"0-1\", " \
+    "          \"children\": { \"core\": \"0\" } " \
+    "         }, " \
+    "         {\"rank\": \"1-2\", " \
+    "          \"children\": { \"core\": \"1\" } " \
+    "         } " \
+    "       ] " \
+    "    } " \
+    "}"
+
 struct resource_set_test tests[] = {
 
     { "no R_lite",
@@ -81,6 +95,11 @@ struct resource_set_test tests[] = {
       NULL, 0., 0.,
       "R_lite: failed to read target rank list",
     },
+    { "overlapping R_lite ranks",
+      OVERLAP_R,
+      NULL, 0., 0.,
+      "R_lite: failed to read target rank list",
+    },
     { "basic R check",
       BASIC_R,
       "0-2", 12345., 12445.,
@@ -21,6 +21,7 @@
 #include "src/common/libutil/fluid.h"
 #include "src/common/libjob/job_hash.h"
 #include "src/common/libidset/idset.h"
+#include "src/common/librlite/rlite.h"
 
 #include "job_state.h"
 #include "idsync.h"
@@ -80,7 +81,6 @@ static void job_destroy (void *data)
         json_decref (job->annotations);
         json_decref (job->jobspec_job);
         json_decref (job->jobspec_cmd);
-        json_decref (job->R);
         free (job->ranks);
         zlist_destroy (&job->next_states);
         free (job);
@@ -122,6 +122,63 @@ static struct job *job_create (struct info_ctx *ctx, flux_jobid_t id)
     return job;
 }
 
+static void user_jobs_destroy (struct user_jobs *uj)
+{
+    if (uj) {
+        joblist_destroy (uj->pending);
+        joblist_destroy (uj->running);
+        joblist_destroy (uj->inactive);
+        free (uj);
+    }
+}
+
+static void user_jobs_destroy_wrapper (void **data)
+{
+    struct user_jobs **uj = (struct user_jobs **)data;
+    user_jobs_destroy (*uj);
+}
+
+static struct user_jobs *user_jobs_create (uint32_t userid)
+{
+    struct user_jobs *uj;
+
+    if (!(uj = calloc (1, sizeof (*uj))))
+        return NULL;
+    uj->userid = userid;
+    if (!(uj->pending = joblist_create (offsetof (struct job,
+                                                  user_list_node),
+                                        job_priority_cmp))
+        || !(uj->running = joblist_create (offsetof (struct job,
+                                                     user_list_node),
+                                           job_running_cmp))
+        || !(uj->inactive = joblist_create (offsetof (struct job,
+                                                      user_list_node),
+                                            job_inactive_cmp))) {
+        user_jobs_destroy (uj);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return uj;
+}
+
+/* N.B. zhashx_hash_fn signature
+ */
+static size_t userid_hasher (const void *key)
+{
+    const uint32_t *userid = key;
+    return *userid;
+}
+
+/* N.B. zhashx_comparator_fn signature
+ */
+static int userid_cmp (const void *key1, const void *key2)
+{
+    const uint32_t *userid1 = key1;
+    const uint32_t *userid2 = key2;
+
+    return NUMCMP (*userid1, *userid2);
+}
+
 struct job_state_ctx *job_state_create (flux_t *h)
 {
     struct job_state_ctx *jsctx = NULL;
@@ -142,21 +199,32 @@ struct job_state_ctx *job_state_create (flux_t *h)
         goto error;
     zhashx_set_destructor (jsctx->index, job_destroy_wrapper);
 
-    if (!(jsctx->pending = zlistx_new ()))
+    if (!(jsctx->pending = joblist_create (offsetof (struct job, list_node),
+                                           job_priority_cmp)))
         goto error;
-    zlistx_set_comparator (jsctx->pending, job_priority_cmp);
 
-    if (!(jsctx->running = zlistx_new ()))
+    if (!(jsctx->running = joblist_create (offsetof (struct job, list_node),
+                                           job_running_cmp)))
         goto error;
-    zlistx_set_comparator (jsctx->running, job_running_cmp);
 
-    if (!(jsctx->inactive = zlistx_new ()))
+    if (!(jsctx->inactive = joblist_create (offsetof (struct job, list_node),
+                                            job_inactive_cmp)))
         goto error;
-    zlistx_set_comparator (jsctx->inactive, job_inactive_cmp);
 
     if (!(jsctx->processing = zlistx_new ()))
         goto error;
 
+    /* User index keys point to user_jobs->userid, so no key
+     * duplication or destruction is required.
+     */
+    if (!(jsctx->users = zhashx_new ()))
+        goto error;
+    zhashx_set_key_hasher (jsctx->users, userid_hasher);
+    zhashx_set_key_comparator (jsctx->users, userid_cmp);
+    zhashx_set_key_duplicator (jsctx->users, NULL);
+    zhashx_set_key_destructor (jsctx->users, NULL);
+    zhashx_set_destructor (jsctx->users, user_jobs_destroy_wrapper);
+
     if (!(jsctx->futures = zlistx_new ()))
         goto error;
 
@@ -204,12 +272,11 @@ void job_state_destroy (void *data)
          * destroy the job objects */
         if (jsctx->processing)
             zlistx_destroy (&jsctx->processing);
-        if (jsctx->inactive)
-            zlistx_destroy (&jsctx->inactive);
-        if (jsctx->running)
-            zlistx_destroy (&jsctx->running);
-        if (jsctx->pending)
-            zlistx_destroy (&jsctx->pending);
+        joblist_destroy (jsctx->inactive);
+        joblist_destroy (jsctx->running);
+        joblist_destroy (jsctx->pending);
+        if (jsctx->users)
+            zhashx_destroy (&jsctx->users);
         if (jsctx->index)
             zhashx_destroy (&jsctx->index);
         if (jsctx->transitions)
@@ -219,7 +286,7 @@ void job_state_destroy (void *data)
     }
 }
 
-/* zlistx_insert() and zlistx_reorder() take a 'low_value' parameter
+/* joblist_insert() takes a 'low_value' parameter
  * which indicates which end of the list to search from.
  * false=search begins at tail (lowest priority, youngest)
  * true=search begins at head (highest priority, oldest)
@@ -283,62 +350,128 @@ static void update_job_state (struct info_ctx *ctx,
         (*increment)++;
 }
 
+/* Return the list holding jobs in 'state', or NULL for FLUX_JOB_NEW,
+ * as those jobs are on the processing list.
+ */
+static struct joblist *get_list (struct job_state_ctx *jsctx,
+                                 flux_job_state_t state)
+{
+    if (state == FLUX_JOB_NEW)
+        return NULL;
+    else if (state == FLUX_JOB_DEPEND
+             || state == FLUX_JOB_SCHED)
+        return jsctx->pending;
+    else if (state == FLUX_JOB_RUN
+             || state == FLUX_JOB_CLEANUP)
+        return jsctx->running;
+    else /* state == FLUX_JOB_INACTIVE */
+        return jsctx->inactive;
+}
+
+static struct joblist *user_jobs_list (struct user_jobs *uj, int state)
+{
+    if (state & FLUX_JOB_PENDING)
+        return uj->pending;
+    else if (state & FLUX_JOB_RUNNING)
+        return uj->running;
+    else /* state == FLUX_JOB_INACTIVE */
+        return uj->inactive;
+}
+
+static struct user_jobs *user_jobs_get (struct job_state_ctx *jsctx,
+                                        uint32_t userid)
+{
+    struct user_jobs *uj;
+
+    if (!(uj = zhashx_lookup (jsctx->users, &userid))) {
+        if (!(uj = user_jobs_create (userid)))
+            return NULL;
+        if (zhashx_insert (jsctx->users, &uj->userid, uj) < 0) {
+            user_jobs_destroy (uj);
+            errno = EEXIST;
+            return NULL;
+        }
+    }
+    return uj;
+}
+
+/* Add job to 'list', which holds jobs in 'newstate'.
+ */
+static void list_insert (struct joblist *list,
+                         struct job *job,
+                         flux_job_state_t newstate)
+{
+    /* Note: comparator is set for running & inactive lists, but
+     * joblist_add_start() does not sort */
+    if (newstate == FLUX_JOB_DEPEND
+        || newstate == FLUX_JOB_SCHED)
+        joblist_insert (list, job, search_direction (job));
+    else /* newstate == RUN, CLEANUP, or INACTIVE */
+        joblist_add_start (list, job);
+}
+
 static void job_insert_list (struct job_state_ctx *jsctx,
                              struct job *job,
                              flux_job_state_t newstate)
 {
-    /* Note: comparator is set for running & inactive lists, but the
-     * sort calls are not called on zlistx_add_start() */
-    if (newstate == FLUX_JOB_DEPEND
-        || newstate == FLUX_JOB_SCHED) {
-        if (!(job->list_handle = zlistx_insert (jsctx->pending,
-                                                job,
-                                                search_direction (job))))
-            flux_log_error (jsctx->h, "%s: zlistx_insert",
-                            __FUNCTION__);
-    }
-    else if (newstate == FLUX_JOB_RUN
-             || newstate == FLUX_JOB_CLEANUP) {
-        if (!(job->list_handle = zlistx_add_start (jsctx->running,
-                                                   job)))
-            flux_log_error (jsctx->h, "%s: zlistx_add_start",
-                            __FUNCTION__);
-    }
-    else { /* newstate == FLUX_JOB_INACTIVE */
-        if (!(job->list_handle = zlistx_add_start (jsctx->inactive,
-                                                   job)))
-            flux_log_error (jsctx->h, "%s: zlistx_add_start",
-                            __FUNCTION__);
+    struct user_jobs *uj;
+
+    list_insert (get_list (jsctx, newstate), job, newstate);
+
+    if (!(uj = user_jobs_get (jsctx, job->userid))) {
+        flux_log_error (jsctx->h, "%s: error updating user index",
+                        __FUNCTION__);
+        return;
     }
+    list_insert (user_jobs_list (uj, newstate), job, newstate);
 }
 
 /* remove job from one list and move it to another based on the
  * newstate */
 static void job_change_list (struct job_state_ctx *jsctx,
                              struct job *job,
-                             zlistx_t *oldlist,
+                             flux_job_state_t oldstate,
                              flux_job_state_t newstate)
 {
-    if (zlistx_detach (oldlist, job->list_handle) < 0)
-        flux_log_error (jsctx->h, "%s: zlistx_detach",
-                        __FUNCTION__);
-    job->list_handle = NULL;
+    if (oldstate == FLUX_JOB_NEW) {
+        if (zlistx_detach (jsctx->processing, job->list_handle) < 0)
+            flux_log_error (jsctx->h, "%s: zlistx_detach",
+                            __FUNCTION__);
+        job->list_handle = NULL;
+    }
+    else
+        joblist_detach (get_list (jsctx, oldstate), job);
+
+    /* jobs on the processing list are not in the user index */
+    if (job->user_list_node.linked) {
+        struct user_jobs *uj = zhashx_lookup (jsctx->users, &job->userid);
+        if (!uj)
+            flux_log (jsctx->h, LOG_ERR, "%s: error updating user index",
+                      __FUNCTION__);
+        else
+            joblist_detach (user_jobs_list (uj, oldstate), job);
+    }
 
     job_insert_list (jsctx, job, newstate);
 }
 
-static zlistx_t *get_list (struct job_state_ctx *jsctx, flux_job_state_t state)
+struct joblist *job_state_list (struct job_state_ctx *jsctx,
+                                uint32_t userid,
+                                flux_job_state_t state)
 {
-    if (state == FLUX_JOB_NEW)
-        return jsctx->processing;
-    else if (state == FLUX_JOB_DEPEND
-             || state == FLUX_JOB_SCHED)
-        return jsctx->pending;
-    else if (state == FLUX_JOB_RUN
-             || state == FLUX_JOB_CLEANUP)
-        return jsctx->running;
-    else /* state == FLUX_JOB_INACTIVE */
-        return jsctx->inactive;
+    struct user_jobs *uj;
+
+    if (userid == FLUX_USERID_UNKNOWN) {
+        if (state & FLUX_JOB_PENDING)
+            return jsctx->pending;
+        else if (state & FLUX_JOB_RUNNING)
+            return jsctx->running;
+        else
+            return jsctx->inactive;
+    }
+    if (!(uj = zhashx_lookup (jsctx->users, &userid)))
+        return NULL;
+    return user_jobs_list (uj, state);
 }
 
 static void update_job_state_and_list (struct info_ctx *ctx,
@@ -346,10 +479,11 @@ static void update_job_state_and_list (struct info_ctx *ctx,
                                        flux_job_state_t newstate,
                                        double timestamp)
 {
-    zlistx_t *oldlist, *newlist;
+    struct joblist *oldlist, *newlist;
     struct job_state_ctx *jsctx = job->ctx->jsctx;
+    flux_job_state_t oldstate = job->state;
 
-    oldlist = get_list (jsctx, job->state);
+    oldlist = get_list (jsctx, oldstate);
     newlist = get_list (jsctx, newstate);
 
     /* must call before job_change_list(), to ensure timestamps are
@@ -358,7 +492,7 @@ static void update_job_state_and_list (struct info_ctx *ctx,
     update_job_state (ctx, job, newstate, timestamp);
 
     if (oldlist != newlist)
-        job_change_list (jsctx, job, oldlist, newstate);
+        job_change_list (jsctx, job, oldstate, newstate);
 }
 
 static void list_id_respond (struct info_ctx *ctx,
@@ -738,111 +872,27 @@ static flux_future_t *state_depend_lookup (struct job_state_ctx *jsctx,
     return NULL;
 }
 
-static int idset_add_set (struct idset *set, struct idset *new)
-{
-    unsigned int i = idset_first (new);
-    while (i != IDSET_INVALID_ID) {
-        if (idset_test (set, i)) {
-            errno = EEXIST;
-            return -1;
-        }
-        if (idset_set (set, i) < 0)
-            return -1;
-        i = idset_next (new, i);
-    }
-    return 0;
-}
-
-static int idset_set_string (struct idset *idset, const char *ids)
-{
-    int rc;
-    struct idset *new = idset_decode (ids);
-    if (!new)
-        return -1;
-    rc = idset_add_set (idset, new);
-    idset_destroy (new);
-    return rc;
-}
-
-static int parse_rlite (struct info_ctx *ctx,
-                        struct job *job,
-                        const json_t *R_lite)
-{
-    struct idset *idset = NULL;
-    size_t index;
-    json_t *value;
-    int saved_errno, rc = -1;
-    int flags = IDSET_FLAG_BRACKETS | IDSET_FLAG_RANGE;
-
-    if (!(idset = idset_create (0, IDSET_FLAG_AUTOGROW)))
-        return -1;
-    json_array_foreach (R_lite, index, value) {
-        const char *ranks = NULL;
-        if ((json_unpack_ex (value, NULL, 0, "{s:s}", "rank", &ranks) < 0)
-            || (idset_set_string (idset, ranks) < 0))
-            goto nonfatal_err;
-    }
-
-    job->nnodes = idset_count (idset);
-    if (!(job->ranks = idset_encode (idset, flags)))
-        goto nonfatal_err;
-
-    /* nonfatal error - invalid rlite, but we'll continue on.  job
-     * listing will get initialized data */
-nonfatal_err:
-    rc = 0;
-    saved_errno = errno;
-    idset_destroy (idset);
-    errno = saved_errno;
-    return rc;
-}
-
 static int R_lookup_parse (struct info_ctx *ctx,
                            struct job *job,
                            const char *s)
 {
     json_error_t error;
-    json_t *R_lite = NULL;
-    int version;
-    int rc = -1;
-
-    if (!(job->R = json_loads (s, 0, &error))) {
-        flux_log (ctx->h, LOG_ERR,
-                  "%s: job %ju invalid R: %s",
-                  __FUNCTION__, (uintmax_t)job->id, error.text);
-        goto nonfatal_error;
-    }
+    struct rlite *rl;
+    int flags = IDSET_FLAG_BRACKETS | IDSET_FLAG_RANGE;
 
-    if (json_unpack_ex (job->R, &error, 0,
-                        "{s:i s:{s?F s:o}}",
-                        "version", &version,
-                        "execution",
-                        "expiration", &job->expiration,
-                        "R_lite", &R_lite) < 0) {
+    /* nonfatal error - invalid R, but we'll continue on.  job
+     * listing will get initialized data */
+    if (!(rl = rlite_create (s, RLITE_FLAG_STRICT, &error))) {
         flux_log (ctx->h, LOG_ERR,
                   "%s: job %ju invalid R: %s",
                   __FUNCTION__, (uintmax_t)job->id, error.text);
-        goto nonfatal_error;
+        return 0;
     }
-    if (version != 1) {
-        flux_log (ctx->h, LOG_ERR,
-                  "%s: job %ju invalid R version: %d",
-                  __FUNCTION__, (uintmax_t)job->id, version);
-        goto nonfatal_error;
-    }
-    if (parse_rlite (ctx, job, R_lite) < 0) {
-        flux_log (ctx->h, LOG_ERR,
-                  "%s: job %ju parse_rlite: %s",
-                  __FUNCTION__, (uintmax_t)job->id, strerror (errno));
-        goto error;
-    }
-
-    /* nonfatal error - invalid rlite, but we'll continue on.  job
-     * listing will get initialized data */
-nonfatal_error:
-    rc = 0;
-error:
-    return rc;
+    job->expiration = rlite_expiration (rl);
+    job->nnodes = rlite_nnodes (rl);
+    job->ranks = idset_encode (rlite_ranks (rl), flags);
+    rlite_destroy (rl);
+    return 0;
 }
 
 static void state_run_lookup_continuation (flux_future_t *f, void *arg)
@@ -1643,6 +1693,7 @@ int job_state_init_from_kvs (struct info_ctx *ctx)
 {
     const char *dirname = "job";
     int dirskip = strlen (dirname);
+    struct user_jobs *uj;
     int count;
 
     count = depthfirst_map (ctx, dirname, dirskip);
@@ -1650,8 +1701,17 @@ int job_state_init_from_kvs (struct info_ctx *ctx)
         return -1;
     flux_log (ctx->h, LOG_DEBUG, "%s: read %d jobs", __FUNCTION__, count);
 
-    zlistx_sort (ctx->jsctx->running);
-    zlistx_sort (ctx->jsctx->inactive);
+    if (joblist_sort (ctx->jsctx->running) < 0
+        || joblist_sort (ctx->jsctx->inactive) < 0)
+        return -1;
+
+    uj = zhashx_first (ctx->jsctx->users);
+    while (uj) {
+        if (joblist_sort (uj->running) < 0
+            || joblist_sort (uj->inactive) < 0)
+            return -1;
+        uj = zhashx_next (ctx->jsctx->users);
+    }
     return 0;
 }
 
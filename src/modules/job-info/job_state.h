@@ -15,6 +15,7 @@
 #include <jansson.h>
 
 #include "info.h"
+#include "joblist.h"
 
 /* To handle the common case of user queries on job state, we will
  * store jobs in three different lists.
@@ -32,17 +33,33 @@
  * There is also an additional list `processing` that stores jobs that
  * cannot yet be stored on one of the lists above.
  *
+ * The pending, running, and inactive lists are intrusive (see
+ * joblist.h), so a listing can resume after any job in O(1).
+ *
+ * The hash `users` is a secondary index keyed by userid.  Each entry
+ * holds that user's jobs on pending, running, and inactive lists
+ * sorted identically to the lists above, so that queries restricted
+ * to a single user need not scan the jobs of every other user.
+ *
  * The list `futures` is used to store in process futures.
  */
 
+struct user_jobs {
+    uint32_t userid;
+    struct joblist *pending;
+    struct joblist *running;
+    struct joblist *inactive;
+};
+
 struct job_state_ctx {
     flux_t *h;
     zhashx_t *index;
-    zlistx_t *pending;
-    zlistx_t *running;
-    zlistx_t *inactive;
+    struct joblist *pending;
+    struct joblist *running;
+    struct joblist *inactive;
     zlistx_t *processing;
     zlistx_t *futures;
+    zhashx_t *users;
 
     /* count current jobs in what states */
     int depend_count;
@@ -83,7 +100,6 @@ struct job {
     /* cache of job information */
     json_t *jobspec_job;
     json_t *jobspec_cmd;
-    json_t *R;
 
     /* Track which states we have seen and have completed transition
      * to.  We do not immediately update to the new state and place
@@ -97,7 +113,9 @@ struct job {
      */
     zlist_t *next_states;
     unsigned int states_mask;
-    void *list_handle;
+    void *list_handle;                  // processing list
+    struct joblist_node list_node;      // pending, running, inactive lists
+    struct joblist_node user_list_node; // lists of the per-user index
 
     /* timestamp of when we enter the state
      *
@@ -135,6 +153,15 @@ void job_state_unpause_cb (flux_t *h, flux_msg_handler_t *mh,
 
 int job_state_init_from_kvs (struct info_ctx *ctx);
 
+/* Return the pending, running, or inactive list holding jobs in
+ * 'state'.  If 'userid' is not FLUX_USERID_UNKNOWN, return the list
+ * from the per-user index instead.  Returns NULL if the user has no
+ * jobs.
+ */
+struct joblist *job_state_list (struct job_state_ctx *jsctx,
+                                uint32_t userid,
+                                flux_job_state_t state);
+
 #endif /* ! _FLUX_JOB_INFO_JOB_STATE_H */
 
 /*
@@ -0,0 +1,212 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* joblist.c - sorted, intrusive doubly linked list */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "joblist.h"
+
+struct joblist {
+    size_t offset;
+    joblist_cmp_f cmp;
+    void *head;
+    void *tail;
+    size_t size;
+};
+
+static struct joblist_node *node (struct joblist *l, void *item)
+{
+    return (struct joblist_node *)((char *)item + l->offset);
+}
+
+struct joblist *joblist_create (size_t node_offset, joblist_cmp_f cmp)
+{
+    struct joblist *l;
+
+    if (!(l = calloc (1, sizeof (*l)))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    l->offset = node_offset;
+    l->cmp = cmp;
+    return l;
+}
+
+/* Items are owned by the caller, so just unlink them.
+ */
+void joblist_destroy (struct joblist *l)
+{
+    if (l) {
+        void *item = l->head;
+        while (item) {
+            struct joblist_node *n = node (l, item);
+            item = n->next;
+            memset (n, 0, sizeof (*n));
+        }
+        free (l);
+    }
+}
+
+/* Link 'item' in before 'next', or at the tail if 'next' is NULL.
+ */
+static void link_before (struct joblist *l, void *item, void *next)
+{
+    struct joblist_node *n = node (l, item);
+
+    n->next = next;
+    if (next) {
+        n->prev = node (l, next)->prev;
+        node (l, next)->prev = item;
+    }
+    else {
+        n->prev = l->tail;
+        l->tail = item;
+    }
+    if (n->prev)
+        node (l, n->prev)->next = item;
+    else
+        l->head = item;
+    n->linked = true;
+    l->size++;
+}
+
+void joblist_insert (struct joblist *l, void *item, bool low_value)
+{
+    void *next;
+
+    if (low_value) {
+        next = l->head;
+        while (next && l->cmp (next, item) < 0)
+            next = node (l, next)->next;
+    }
+    else {
+        void *prev = l->tail;
+        while (prev && l->cmp (prev, item) > 0)
+            prev = node (l, prev)->prev;
+        next = prev ? node (l, prev)->next : l->head;
+    }
+    link_before (l, item, next);
+}
+
+void joblist_add_start (struct joblist *l, void *item)
+{
+    link_before (l, item, l->head);
+}
+
+void joblist_detach (struct joblist *l, void *item)
+{
+    struct joblist_node *n = node (l, item);
+
+    if (!n->linked)
+        return;
+    if (n->prev)
+        node (l, n->prev)->next = n->next;
+    else
+        l->head = n->next;
+    if (n->next)
+        node (l, n->next)->prev = n->prev;
+    else
+        l->tail = n->prev;
+    memset (n, 0, sizeof (*n));
+    l->size--;
+}
+
+bool joblist_linked (struct joblist *l, void *item)
+{
+    return node (l, item)->linked;
+}
+
+/* Merge sorted runs a[lo..mid) and a[mid..hi) into b[lo..hi).
+ * Ties are taken from the first run, so the sort is stable.
+ */
+static void merge (struct joblist *l,
+                   void **a,
+                   void **b,
+                   size_t lo,
+                   size_t mid,
+                   size_t hi)
+{
+    size_t i = lo;
+    size_t j = mid;
+    size_t k;
+
+    for (k = lo; k < hi; k++) {
+        if (i < mid && (j >= hi || l->cmp (a[i], a[j]) <= 0))
+            b[k] = a[i++];
+        else
+            b[k] = a[j++];
+    }
+}
+
+int joblist_sort (struct joblist *l)
+{
+    void **a;
+    void **b;
+    void *item;
+    size_t width;
+    size_t i;
+    size_t n = l->size;
+
+    if (n < 2)
+        return 0;
+    if (!(a = calloc (2 * n, sizeof (*a)))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    b = a + n;
+    i = 0;
+    item = l->head;
+    while (item) {
+        a[i++] = item;
+        item = node (l, item)->next;
+    }
+    for (width = 1; width < n; width *= 2) {
+        void **tmp;
+        for (i = 0; i < n; i += 2 * width) {
+            size_t mid = i + width < n ? i + width : n;
+            size_t hi = i + 2 * width < n ? i + 2 * width : n;
+            merge (l, a, b, i, mid, hi);
+        }
+        tmp = a;
+        a = b;
+        b = tmp;
+    }
+    l->head = l->tail = NULL;
+    l->size = 0;
+    for (i = 0; i < n; i++)
+        link_before (l, a[i], NULL);
+    free (a < b ? a : b);
+    return 0;
+}
+
+void *joblist_first (struct joblist *l)
+{
+    return l->head;
+}
+
+void *joblist_next (struct joblist *l, void *item)
+{
+    return node (l, item)->next;
+}
+
+size_t joblist_size (struct joblist *l)
+{
+    return l->size;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,73 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_JOB_INFO_JOBLIST_H
+#define _FLUX_JOB_INFO_JOBLIST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* joblist - sorted, intrusive doubly linked list
+ *
+ * Items embed a struct joblist_node for each list they may be on, and
+ * the list is created with the offset of that node within the item.
+ * Unlike zlistx, iteration is stateless and can resume from any item
+ * on the list in O(1), e.g.
+ *   item = joblist_next (list, after);
+ *
+ * Insert and sort behave as zlistx_insert() and zlistx_sort() with
+ * the same comparator.
+ */
+
+struct joblist_node {
+    void *prev;
+    void *next;
+    bool linked;
+};
+
+/* N.B. same signature as zlistx_comparator_fn */
+typedef int (*joblist_cmp_f) (const void *item1, const void *item2);
+
+struct joblist *joblist_create (size_t node_offset, joblist_cmp_f cmp);
+void joblist_destroy (struct joblist *l);
+
+/* Insert 'item' in sorted order.  If 'low_value' is true, the search
+ * starts at the head of the list, otherwise at the tail.
+ */
+void joblist_insert (struct joblist *l, void *item, bool low_value);
+
+void joblist_add_start (struct joblist *l, void *item);
+
+/* Remove 'item' from the list.  No-op if 'item' is not on a list.
+ */
+void joblist_detach (struct joblist *l, void *item);
+
+/* Return true if 'item' is on the list 'l' uses the node of.
+ */
+bool joblist_linked (struct joblist *l, void *item);
+
+/* Sort the list with its comparator (stable).
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int joblist_sort (struct joblist *l);
+
+void *joblist_first (struct joblist *l);
+
+/* Return the item following 'item' or NULL if it is the last item.
+ */
+void *joblist_next (struct joblist *l, void *item);
+
+size_t joblist_size (struct joblist *l);
+
+#endif /* ! _FLUX_JOB_INFO_JOBLIST_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
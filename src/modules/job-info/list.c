@@ -45,24 +45,39 @@ bool job_filter (struct job *job, uint32_t userid, int states, int results)
 }
 
 /* Put jobs from list onto jobs array, breaking if max_entries has
- * been reached. Returns 1 if jobs array is full, 0 if continue, -1
- * one error with errno set:
+ * been reached.  If 'after' is non-NULL, skip jobs up to and including
+ * 'after'.  Inactive jobs with 't_inactive' not newer than 'since' end
+ * the walk, as the inactive list is sorted by completion time.
+ * Returns 1 if jobs array is full, 0 if continue, -1 one error with
+ * errno set:
  *
  * ENOMEM - out of memory
  */
 int get_jobs_from_list (json_t *jobs,
                         job_info_error_t *errp,
-                        zlistx_t *list,
+                        struct joblist *list,
                         int max_entries,
                         json_t *attrs,
                         uint32_t userid,
                         int states,
-                        int results)
+                        int results,
+                        struct job *after,
+                        double since)
 {
     struct job *job;
 
-    job = zlistx_first (list);
+    if (after) {
+        if (!joblist_linked (list, after))
+            return 0;
+        job = joblist_next (list, after);
+    }
+    else
+        job = joblist_first (list);
     while (job) {
+        if (since > 0.
+            && job->state == FLUX_JOB_INACTIVE
+            && job->t_inactive <= since)
+            break;
         if (job_filter (job, userid, states, results)) {
             json_t *o;
             if (!(o = job_to_json (job, attrs, errp)))
@@ -75,15 +90,18 @@ int get_jobs_from_list (json_t *jobs,
             if (json_array_size (jobs) == max_entries)
                 return 1;
         }
-        job = zlistx_next (list);
+        job = joblist_next (list, job);
     }
 
     return 0;
 }
 
 /* Create a JSON array of 'job' objects.  'max_entries' determines the
- * max number of jobs to return, 0=unlimited.  Returns JSON object
- * which the caller must free.  On error, return NULL with errno set:
+ * max number of jobs to return, 0=unlimited.  If 'after' is non-NULL,
+ * listing resumes with the job following 'after' in the sort order
+ * below.  Only inactive jobs with 't_inactive' newer than 'since' are
+ * returned.  Returns JSON object which the caller must free.  On
+ * error, return NULL with errno set:
  *
  * EPROTO - malformed or empty attrs array, max_entries out of range
  * ENOMEM - out of memory
@@ -94,58 +112,55 @@ json_t *get_jobs (struct info_ctx *ctx,
                   json_t *attrs,
                   uint32_t userid,
                   int states,
-                  int results)
+                  int results,
+                  struct job *after,
+                  double since)
 {
+    int lists[] = { FLUX_JOB_PENDING, FLUX_JOB_RUNNING, FLUX_JOB_INACTIVE };
     json_t *jobs = NULL;
     int saved_errno;
     int ret = 0;
+    int i;
 
     if (!(jobs = json_array ()))
         goto error_nomem;
 
     /* We return jobs in the following order, pending, running,
-     * inactive */
-
-    if (states & FLUX_JOB_PENDING) {
+     * inactive.  When resuming after a job, lists preceding the one
+     * holding that job are skipped.
+     */
+
+    for (i = 0; i < 3 && !ret; i++) {
+        struct job *cursor = NULL;
+        uint32_t list_userid = userid;
+        struct joblist *list;
+
+        if (after) {
+            if (!(after->state & lists[i]))
+                continue;
+            cursor = after;
+            after = NULL;
+            /* cursor job is only on the per-user list of its owner */
+            if (cursor->userid != userid)
+                list_userid = FLUX_USERID_UNKNOWN;
+        }
+        if (!(states & lists[i]))
+            continue;
+        if (!(list = job_state_list (ctx->jsctx, list_userid, lists[i])))
+            continue;
         if ((ret = get_jobs_from_list (jobs,
                                        errp,
-                                       ctx->jsctx->pending,
+                                       list,
                                        max_entries,
                                        attrs,
                                        userid,
                                        states,
-                                       results)) < 0)
+                                       results,
+                                       cursor,
+                                       since)) < 0)
             goto error;
     }
 
-    if (states & FLUX_JOB_RUNNING) {
-        if (!ret) {
-            if ((ret = get_jobs_from_list (jobs,
-                                           errp,
-                                           ctx->jsctx->running,
-                                           max_entries,
-                                           attrs,
-                                           userid,
-                                           states,
-                                           results)) < 0)
-                goto error;
-        }
-    }
-
-    if (states & FLUX_JOB_INACTIVE) {
-        if (!ret) {
-            if ((ret = get_jobs_from_list (jobs,
-                                           errp,
-                                           ctx->jsctx->inactive,
-                                           max_entries,
-                                           attrs,
-                                           userid,
-                                           states,
-                                           results)) < 0)
-                goto error;
-        }
-    }
-
     return jobs;
 
 error_nomem:
@@ -168,13 +183,18 @@ void list_cb (flux_t *h, flux_msg_handler_t *mh,
     uint32_t userid;
     int states;
     int results;
+    flux_jobid_t after_id = FLUX_JOBID_ANY;
+    struct job *after = NULL;
+    double since = 0.;
 
-    if (flux_request_unpack (msg, NULL, "{s:i s:o s:i s:i s:i}",
+    if (flux_request_unpack (msg, NULL, "{s:i s:o s:i s:i s:i s?:I s?:F}",
                              "max_entries", &max_entries,
                              "attrs", &attrs,
                              "userid", &userid,
                              "states", &states,
-                             "results", &results) < 0) {
+                             "results", &results,
+                             "after_id", &after_id,
+                             "since", &since) < 0) {
         seterror (&err, "invalid payload: %s", flux_msg_last_error (msg));
         errno = EPROTO;
         goto error;
@@ -184,11 +204,24 @@ void list_cb (flux_t *h, flux_msg_handler_t *mh,
         errno = EPROTO;
         goto error;
     }
+    if (since < 0.) {
+        seterror (&err, "invalid payload: since < 0.0 not allowed");
+        errno = EPROTO;
+        goto error;
+    }
     if (!json_is_array (attrs)) {
         seterror (&err, "invalid payload: attrs must be an array");
         errno = EPROTO;
         goto error;
     }
+    if (after_id != FLUX_JOBID_ANY) {
+        if (!(after = zhashx_lookup (ctx->jsctx->index, &after_id))
+            || after->state == FLUX_JOB_NEW) {
+            seterror (&err, "after_id: job not found");
+            errno = ENOENT;
+            goto error;
+        }
+    }
     /* If user sets no states, assume they want all information */
     if (!states)
         states = (FLUX_JOB_PENDING
@@ -203,7 +236,7 @@ void list_cb (flux_t *h, flux_msg_handler_t *mh,
                    | FLUX_JOB_RESULT_TIMEOUT);
 
     if (!(jobs = get_jobs (ctx, &err, max_entries,
-                           attrs, userid, states, results)))
+                           attrs, userid, states, results, after, since)))
         goto error;
 
     if (flux_respond_pack (h, msg, "{s:O}", "jobs", jobs) < 0) {
@@ -242,7 +275,7 @@ json_t *get_inactive_jobs (struct info_ctx *ctx,
     if (!(jobs = json_array ()))
         goto error_nomem;
 
-    job = zlistx_first (ctx->jsctx->inactive);
+    job = joblist_first (ctx->jsctx->inactive);
     while (job && (job->t_inactive > since)) {
         json_t *o;
         if (!name || strcmp (job->name, name) == 0) {
@@ -256,7 +289,7 @@ json_t *get_inactive_jobs (struct info_ctx *ctx,
             if (json_array_size (jobs) == max_entries)
                 goto out;
         }
-        job = zlistx_next (ctx->jsctx->inactive);
+        job = joblist_next (ctx->jsctx->inactive, job);
     }
 
 out:
@@ -0,0 +1,243 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "src/common/libtap/tap.h"
+#include "joblist.h"
+
+struct item {
+    int key;
+    char name;
+    struct joblist_node node;
+};
+
+static int cmp_key (const void *item1, const void *item2)
+{
+    const struct item *a = item1;
+    const struct item *b = item2;
+
+    return a->key < b->key ? -1 : a->key > b->key ? 1 : 0;
+}
+
+/* Return list contents as a string of item names, e.g. "abc".
+ */
+static const char *names (struct joblist *l)
+{
+    static char buf[64];
+    struct item *item;
+    int i = 0;
+
+    item = joblist_first (l);
+    while (item && i < sizeof (buf) - 1) {
+        buf[i++] = item->name;
+        item = joblist_next (l, item);
+    }
+    buf[i] = '\0';
+    return buf;
+}
+
+static struct joblist *create (void)
+{
+    struct joblist *l;
+
+    if (!(l = joblist_create (offsetof (struct item, node), cmp_key)))
+        BAIL_OUT ("joblist_create failed");
+    return l;
+}
+
+static void test_empty (void)
+{
+    struct joblist *l = create ();
+    struct item a = { .key = 1, .name = 'a' };
+
+    ok (joblist_size (l) == 0,
+        "empty list has size 0");
+    ok (joblist_first (l) == NULL,
+        "joblist_first on empty list returns NULL");
+    ok (joblist_sort (l) == 0,
+        "joblist_sort on empty list works");
+    ok (joblist_linked (l, &a) == false,
+        "joblist_linked is false for item not on list");
+    joblist_detach (l, &a);
+    ok (joblist_size (l) == 0,
+        "joblist_detach of item not on list is a no-op");
+
+    joblist_add_start (l, &a);
+    ok (joblist_size (l) == 1
+        && joblist_first (l) == &a
+        && joblist_next (l, &a) == NULL,
+        "single item list has one item with no next");
+    ok (joblist_sort (l) == 0 && joblist_first (l) == &a,
+        "joblist_sort on single item list works");
+    joblist_detach (l, &a);
+    ok (joblist_size (l) == 0
+        && joblist_first (l) == NULL
+        && joblist_linked (l, &a) == false,
+        "detaching the only item leaves the list empty");
+
+    joblist_insert (l, &a, false);
+    ok (joblist_first (l) == &a,
+        "item can be inserted again after list was emptied");
+    joblist_destroy (l);
+    ok (a.node.linked == false,
+        "joblist_destroy unlinks items still on the list");
+
+    joblist_destroy (NULL);
+    ok (true, "joblist_destroy (NULL) works");
+}
+
+static void test_insert (void)
+{
+    struct joblist *l = create ();
+    struct item a = { .key = 1, .name = 'a' };
+    struct item b = { .key = 2, .name = 'b' };
+    struct item c = { .key = 3, .name = 'c' };
+    struct item d = { .key = 4, .name = 'd' };
+    struct item e = { .key = 5, .name = 'e' };
+
+    joblist_insert (l, &c, true);
+    joblist_insert (l, &a, true);
+    joblist_insert (l, &e, false);
+    joblist_insert (l, &b, true);
+    joblist_insert (l, &d, false);
+    is (names (l), "abcde",
+        "joblist_insert from head and tail keeps list sorted");
+    ok (joblist_size (l) == 5,
+        "joblist_size is 5");
+    ok (joblist_linked (l, &c) == true,
+        "joblist_linked is true for item on list");
+    ok (joblist_next (l, &c) == &d,
+        "joblist_next resumes from a given item");
+
+    joblist_detach (l, &a);
+    is (names (l), "bcde",
+        "detach head works");
+    joblist_detach (l, &e);
+    is (names (l), "bcd",
+        "detach tail works");
+    joblist_detach (l, &c);
+    is (names (l), "bd",
+        "detach middle works");
+    ok (joblist_size (l) == 2 && joblist_linked (l, &c) == false,
+        "detached items are unlinked and size is updated");
+
+    joblist_insert (l, &e, false);
+    joblist_insert (l, &a, true);
+    joblist_insert (l, &c, false);
+    is (names (l), "abcde",
+        "insert at head, tail and middle after detach works");
+
+    joblist_detach (l, &a);
+    joblist_add_start (l, &a);
+    is (names (l), "abcde",
+        "joblist_add_start puts item at the head");
+
+    joblist_destroy (l);
+}
+
+static void test_detach_iter (void)
+{
+    struct joblist *l = create ();
+    struct item items[6];
+    struct item *item;
+    int i;
+
+    for (i = 0; i < 6; i++) {
+        memset (&items[i], 0, sizeof (items[i]));
+        items[i].key = i;
+        items[i].name = 'a' + i;
+        joblist_insert (l, &items[i], false);
+    }
+    is (names (l), "abcdef",
+        "list of 6 items created");
+
+    /* Detach even keys while iterating, fetching next before detach.
+     */
+    item = joblist_first (l);
+    while (item) {
+        struct item *next = joblist_next (l, item);
+        if (item->key % 2 == 0)
+            joblist_detach (l, item);
+        item = next;
+    }
+    is (names (l), "bdf",
+        "detaching items during iteration works");
+    ok (joblist_size (l) == 3,
+        "joblist_size is 3");
+
+    item = joblist_first (l);
+    while (item) {
+        struct item *next = joblist_next (l, item);
+        joblist_detach (l, item);
+        item = next;
+    }
+    ok (joblist_size (l) == 0 && joblist_first (l) == NULL,
+        "detaching every item during iteration empties the list");
+
+    joblist_destroy (l);
+}
+
+static void test_ties (void)
+{
+    struct joblist *l = create ();
+    struct item a = { .key = 1, .name = 'a' };
+    struct item b = { .key = 2, .name = 'b' };
+    struct item c = { .key = 2, .name = 'c' };
+    struct item d = { .key = 2, .name = 'd' };
+    struct item e = { .key = 3, .name = 'e' };
+
+    joblist_insert (l, &a, false);
+    joblist_insert (l, &e, false);
+    joblist_insert (l, &c, false);
+    joblist_insert (l, &d, false);
+    is (names (l), "acde",
+        "insert from tail puts item after equal items");
+    joblist_insert (l, &b, true);
+    is (names (l), "abcde",
+        "insert from head puts item before equal items");
+
+    /* Reverse the keys of a and e, then sort.
+     * Equal items b, c, d must keep their relative order.
+     */
+    a.key = 3;
+    e.key = 1;
+    ok (joblist_sort (l) == 0,
+        "joblist_sort works");
+    is (names (l), "ebcda",
+        "joblist_sort is stable");
+    ok (joblist_size (l) == 5,
+        "joblist_size is unchanged by sort");
+
+    joblist_detach (l, &a);
+    joblist_insert (l, &a, false);
+    is (names (l), "ebcda",
+        "tail is correct after sort");
+
+    joblist_destroy (l);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_empty ();
+    test_insert ();
+    test_detach_iter ();
+    test_ties ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,297 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* builtin - in-process jobspec validation
+ *
+ * This mirrors validate_jobspec() in the Python bindings (flux.job.Jobspec
+ * and JobspecV1), including its error messages, so that the common case
+ * does not require a round trip to a validator worker.
+ *
+ * Where Python semantics differ from a plain reading of the JSON, for
+ * example bool is an int in Python, and a string is a sequence, the
+ * jobspec is deferred to a worker rather than guessing.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <jansson.h>
+
+#include "builtin.h"
+
+#define DEFER 1
+
+struct builtin {
+    char *errbuf;
+    int errbufsz;
+};
+
+static int invalid (struct builtin *b, const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start (ap, fmt);
+    (void)vsnprintf (b->errbuf, b->errbufsz, fmt, ap);
+    va_end (ap);
+    return -1;
+}
+
+/* Check that 'o' contains each of the NULL-terminated 'keys', unless
+ * 'optional' is true, and that it contains no others.
+ */
+static int validate_keys (struct builtin *b,
+                          json_t *o,
+                          const char **keys,
+                          bool optional)
+{
+    const char *key;
+    json_t *val;
+    int i;
+
+    if (!optional) {
+        for (i = 0; keys[i] != NULL; i++) {
+            if (!json_object_get (o, keys[i]))
+                return invalid (b, "Missing key (%s)", keys[i]);
+        }
+    }
+    json_object_foreach (o, key, val) {
+        for (i = 0; keys[i] != NULL; i++) {
+            if (!strcmp (key, keys[i]))
+                break;
+        }
+        if (keys[i] == NULL)
+            return invalid (b, "Extraneous key (%s)", key);
+    }
+    return 0;
+}
+
+static int validate_range (struct builtin *b, json_t *count)
+{
+    const char *keys[] = { "min", "max", "operator", "operand", NULL };
+    const char *intkeys[] = { "min", "max", "operand", NULL };
+    json_t *val;
+    const char *op;
+    int rc;
+    int i;
+
+    if (!json_object_get (count, "min"))
+        return invalid (b, "min must be in range");
+    if (json_object_size (count) > 1) {
+        if ((rc = validate_keys (b, count, keys, false)) != 0)
+            return rc;
+    }
+    for (i = 0; intkeys[i] != NULL; i++) {
+        if (!(val = json_object_get (count, intkeys[i])))
+            continue;
+        if (json_is_boolean (val))
+            return DEFER;
+        if (!json_is_integer (val))
+            return invalid (b, "%s must be an int", intkeys[i]);
+        if (json_integer_value (val) < 1)
+            return invalid (b, "%s must be > 0", intkeys[i]);
+    }
+    if ((val = json_object_get (count, "operator"))) {
+        if (!(op = json_string_value (val))
+            || (strcmp (op, "+") && strcmp (op, "*") && strcmp (op, "^")))
+            return invalid (b, "operator must be one of ['+', '*', '^']");
+    }
+    return 0;
+}
+
+/* Validate 'res', then its children (depth-first, pre-order).
+ */
+static int validate_resource (struct builtin *b, json_t *res)
+{
+    const char *strkeys[] = { "id", "unit", "label", NULL };
+    json_t *val;
+    json_t *with;
+    size_t index;
+    int rc;
+    int i;
+
+    if (!json_is_object (res))
+        return invalid (b, "resource must be a mapping");
+
+    if (!(val = json_object_get (res, "type")))
+        return invalid (b, "type is a required key for resources");
+    if (!json_is_string (val))
+        return invalid (b, "type must be a string");
+
+    if (!(val = json_object_get (res, "count")))
+        return invalid (b, "count is a required key for resources");
+    if (json_is_object (val)) {
+        if ((rc = validate_range (b, val)) != 0)
+            return rc;
+    }
+    else if (json_is_boolean (val))
+        return DEFER;
+    else if (!json_is_integer (val))
+        return invalid (b, "count must be an int or mapping");
+    else if (json_integer_value (val) < 1)
+        return invalid (b, "count must be > 0");
+
+    for (i = 0; strkeys[i] != NULL; i++) {
+        if ((val = json_object_get (res, strkeys[i])) && !json_is_string (val))
+            return invalid (b, "%s must be a string", strkeys[i]);
+    }
+
+    if ((val = json_object_get (res, "exclusive"))) {
+        if (json_is_number (val))
+            return DEFER;
+        if (!json_is_boolean (val))
+            return invalid (b, "exclusive must be a boolean");
+    }
+
+    if (!strcmp (json_string_value (json_object_get (res, "type")), "slot")
+        && !json_object_get (res, "label"))
+        return invalid (b, "slots must have labels");
+
+    if ((with = json_object_get (res, "with"))) {
+        if (!json_is_array (with))
+            return DEFER;
+        json_array_foreach (with, index, val) {
+            if ((rc = validate_resource (b, val)) != 0)
+                return rc;
+        }
+    }
+    return 0;
+}
+
+static int validate_command (struct builtin *b, json_t *command)
+{
+    json_t *val;
+    size_t index;
+    size_t len;
+
+    if (json_is_string (command))
+        len = json_string_length (command);
+    else if (json_is_object (command))
+        len = json_object_size (command);
+    else if (json_is_array (command))
+        len = json_array_size (command);
+    else
+        return DEFER;
+    if (len == 0)
+        return invalid (b, "command array cannot have length of zero");
+    if (!json_is_array (command))
+        return invalid (b, "command must be a list of strings");
+    json_array_foreach (command, index, val) {
+        if (!json_is_string (val))
+            return invalid (b, "command must be a list of strings");
+    }
+    return 0;
+}
+
+static int validate_task (struct builtin *b, json_t *task)
+{
+    const char *keys[] = { "command", "slot", "count", NULL };
+    json_t *val;
+    int i;
+
+    if (!json_is_object (task))
+        return invalid (b, "task must be a mapping");
+    for (i = 0; keys[i] != NULL; i++) {
+        if (!json_object_get (task, keys[i]))
+            return invalid (b, "Missing key (%s)", keys[i]);
+    }
+    if (!json_is_object (json_object_get (task, "count")))
+        return invalid (b, "count must be a mapping");
+    if (!json_is_string (json_object_get (task, "slot")))
+        return invalid (b, "slot must be a string");
+    if ((val = json_object_get (task, "attributes")) && !json_is_object (val))
+        return invalid (b, "count must be a mapping");
+    return validate_command (b, json_object_get (task, "command"));
+}
+
+static int validate_v1 (struct builtin *b, json_t *attributes)
+{
+    json_t *system;
+    json_t *duration;
+
+    if (!(system = json_object_get (attributes, "system")))
+        return invalid (b, "attributes.system is a required key");
+    if (!json_is_object (system))
+        return invalid (b, "attributes.system must be a mapping");
+    if (!(duration = json_object_get (system, "duration")))
+        return invalid (b, "attributes.system.duration is a required key");
+    if (!json_is_number (duration) && !json_is_boolean (duration))
+        return invalid (b, "attributes.system.duration must be a number");
+    return 0;
+}
+
+int builtin_validate (json_t *o,
+                      int require_version,
+                      char *errbuf,
+                      int errbufsz)
+{
+    const char *top_keys[] = { "resources", "tasks", "version",
+                               "attributes", NULL };
+    const char *attr_keys[] = { "system", "user", NULL };
+    struct builtin b = { .errbuf = errbuf, .errbufsz = errbufsz };
+    json_t *resources;
+    json_t *tasks;
+    json_t *version;
+    json_t *attributes;
+    json_t *val;
+    size_t index;
+    bool v1;
+    int rc;
+
+    if (!json_is_object (o))
+        return DEFER;
+    if ((rc = validate_keys (&b, o, top_keys, false)) != 0)
+        return rc;
+    resources = json_object_get (o, "resources");
+    tasks = json_object_get (o, "tasks");
+    version = json_object_get (o, "version");
+    attributes = json_object_get (o, "attributes");
+
+    if (json_is_boolean (version)
+        || json_is_string (resources)
+        || json_is_string (tasks))
+        return DEFER;
+    v1 = require_version == 1
+         || (json_is_number (version) && json_number_value (version) == 1);
+    if (v1 && !(json_is_number (version) && json_number_value (version) == 1))
+        return invalid (&b, "version must be 1");
+
+    if (!json_is_array (resources))
+        return invalid (&b, "resources must be a sequence");
+    if (!json_is_array (tasks))
+        return invalid (&b, "tasks must be a sequence");
+    if (!json_is_integer (version))
+        return invalid (&b, "version must be an integer");
+    if (!json_is_object (attributes))
+        return invalid (&b, "attributes must be a mapping");
+    if (json_integer_value (version) < 1)
+        return invalid (&b, "version must be >= 1");
+
+    json_array_foreach (resources, index, val) {
+        if ((rc = validate_resource (&b, val)) != 0)
+            return rc;
+    }
+    json_array_foreach (tasks, index, val) {
+        if ((rc = validate_task (&b, val)) != 0)
+            return rc;
+    }
+    if ((rc = validate_keys (&b, attributes, attr_keys, true)) != 0)
+        return rc;
+    if (v1)
+        return validate_v1 (&b, attributes);
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,33 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _JOB_INGEST_BUILTIN_H
+#define _JOB_INGEST_BUILTIN_H
+
+#include <jansson.h>
+
+/* Validate jobspec 'o' in process, applying the same checks as the
+ * validate-jobspec.py worker.  If 'require_version' is 1, validate as
+ * version 1 jobspec regardless of the version field (0 = not required).
+ *
+ * Return 0 if 'o' is valid, -1 with a message in 'errbuf' if it is not,
+ * or 1 if 'o' contains a construct the builtin validator does not handle
+ * identically, and must be sent to a worker instead.
+ */
+int builtin_validate (json_t *o,
+                      int require_version,
+                      char *errbuf,
+                      int errbufsz);
+
+#endif /* !_JOB_INGEST_BUILTIN_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
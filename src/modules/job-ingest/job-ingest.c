@@ -674,8 +674,34 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
+static void stats_cb (flux_t *h,
+                      flux_msg_handler_t *mh,
+                      const flux_msg_t *msg,
+                      void *arg)
+{
+    struct job_ingest_ctx *ctx = arg;
+    json_t *o = NULL;
+
+    if (!ctx->validate) {
+        errno = EAGAIN;
+        goto error;
+    }
+    if (!(o = validate_get_stats (ctx->validate))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_respond_pack (h, msg, "{s:O}", "validate", o) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    json_decref (o);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.getinfo", getinfo_cb, 0},
+    { FLUX_MSGTYPE_REQUEST,  "job-ingest.stats.get", stats_cb, 0},
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.submit", submit_cb, FLUX_ROLE_USER },
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.shutdown", shutdown_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END,
@@ -692,9 +718,13 @@ int validate_initialize (flux_t *h,
                          struct validate **validate)
 {
     const char *usage_message = "Usage: flux module load [OPTIONS] job-ingest "
-                                " [validator-args=ARGS] [validator=PATH]";
+                                " [validator-args=ARGS] [validator=PATH]"
+                                " [validator-workers=N]"
+                                " [builtin-validator=yes|no]";
     const char *valpath;
     const char *valargs;
+    int workers = 0;
+    bool builtin = true;
     struct validate *v;
     int i;
 
@@ -711,6 +741,20 @@ int validate_initialize (flux_t *h,
                 return -1;
             }
         }
+        else if (!strncmp (argv[i], "validator-workers=", 18)) {
+            char *endptr;
+            errno = 0;
+            workers = strtol (argv[i] + 18, &endptr, 10);
+            if (errno != 0 || *endptr != '\0' || workers < 1) {
+                flux_log (h, LOG_ERR, "invalid option %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+        }
+        else if (!strcmp (argv[i], "builtin-validator=yes"))
+            builtin = true;
+        else if (!strcmp (argv[i], "builtin-validator=no"))
+            builtin = false;
         else {
             flux_log (h, LOG_ERR, "invalid option %s", argv[i]);
             flux_log (h, LOG_ERR, "%s", usage_message);
@@ -718,7 +762,7 @@ int validate_initialize (flux_t *h,
             return -1;
         }
     }
-    if (!(v = validate_create (h, valpath, valargs))) {
+    if (!(v = validate_create (h, valpath, valargs, workers, builtin))) {
         flux_log_error (h, "validate_create");
         return -1;
     }
@@ -0,0 +1,161 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <string.h>
+#include <jansson.h>
+
+#include "src/common/libtap/tap.h"
+
+#include "src/modules/job-ingest/builtin.h"
+
+#define RES "[{\"type\":\"slot\",\"count\":1,\"label\":\"foo\"," \
+            "\"with\":[{\"type\":\"core\",\"count\":1}]}]"
+#define TASKS "[{\"command\":[\"app\"],\"slot\":\"foo\"," \
+              "\"count\":{\"per_slot\":1}}]"
+#define ATTR "{\"system\":{\"duration\":0}}"
+
+struct testcase {
+    const char *desc;
+    const char *jobspec;
+    int require_version;
+    int rc;
+    const char *errstr;
+};
+
+static struct testcase tests[] = {
+    { "valid v1 jobspec",
+      "{\"version\":1,\"resources\":" RES ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTR "}",
+      0, 0, NULL },
+    { "valid v2 jobspec without duration",
+      "{\"version\":2,\"resources\":" RES ",\"tasks\":" TASKS
+      ",\"attributes\":{}}",
+      0, 0, NULL },
+    { "v2 jobspec with version 1 required",
+      "{\"version\":2,\"resources\":" RES ",\"tasks\":" TASKS
+      ",\"attributes\":{}}",
+      1, -1, "version must be 1" },
+    { "valid v1 jobspec with range count",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"label\":\"foo\","
+      "\"count\":{\"min\":1,\"max\":4,\"operator\":\"+\",\"operand\":1}}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTR "}",
+      0, 0, NULL },
+    { "missing attributes",
+      "{\"version\":1,\"resources\":" RES ",\"tasks\":" TASKS "}",
+      0, -1, "Missing key (attributes)" },
+    { "extra top level key",
+      "{\"version\":1,\"resources\":" RES ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTR ",\"foo\":1}",
+      0, -1, "Extraneous key (foo)" },
+    { "null attributes",
+      "{\"version\":1,\"resources\":" RES ",\"tasks\":" TASKS
+      ",\"attributes\":null}",
+      0, -1, "attributes must be a mapping" },
+    { "v1 without duration",
+      "{\"version\":1,\"resources\":" RES ",\"tasks\":" TASKS
+      ",\"attributes\":{\"system\":{}}}",
+      0, -1, "attributes.system.duration is a required key" },
+    { "bad attributes entry",
+      "{\"version\":1,\"resources\":" RES ",\"tasks\":" TASKS
+      ",\"attributes\":{\"system\":{\"duration\":1},\"foo\":1}}",
+      0, -1, "Extraneous key (foo)" },
+    { "version not scalar",
+      "{\"version\":{\"foo\":1},\"resources\":" RES ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTR "}",
+      0, -1, "version must be an integer" },
+    { "resources not sequence",
+      "{\"version\":1,\"resources\":{\"type\":\"slot\",\"count\":1},"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTR "}",
+      0, -1, "resources must be a sequence" },
+    { "unlabeled slot",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTR "}",
+      0, -1, "slots must have labels" },
+    { "child resource count zero",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"foo\",\"with\":[{\"type\":\"core\",\"count\":0}]}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTR "}",
+      0, -1, "count must be > 0" },
+    { "range count missing operand",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"label\":\"foo\","
+      "\"count\":{\"min\":1,\"max\":4,\"operator\":\"+\"}}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTR "}",
+      0, -1, "Missing key (operand)" },
+    { "exclusive not boolean",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"foo\",\"exclusive\":\"blah\"}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTR "}",
+      0, -1, "exclusive must be a boolean" },
+    { "task command not array",
+      "{\"version\":1,\"resources\":" RES ",\"tasks\":[{\"command\":\"app\","
+      "\"slot\":\"foo\",\"count\":{\"per_slot\":1}}],"
+      "\"attributes\":" ATTR "}",
+      0, -1, "command must be a list of strings" },
+    { "task command zero length",
+      "{\"version\":1,\"resources\":" RES ",\"tasks\":[{\"command\":[],"
+      "\"slot\":\"foo\",\"count\":{\"per_slot\":1}}],"
+      "\"attributes\":" ATTR "}",
+      0, -1, "command array cannot have length of zero" },
+    { "task missing slot",
+      "{\"version\":1,\"resources\":" RES ",\"tasks\":[{\"command\":[\"a\"],"
+      "\"count\":{\"per_slot\":1}}],\"attributes\":" ATTR "}",
+      0, -1, "Missing key (slot)" },
+    { "resource errors are reported before task errors",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1}],"
+      "\"tasks\":[1],\"attributes\":" ATTR "}",
+      0, -1, "slots must have labels" },
+    { "boolean version is deferred",
+      "{\"version\":true,\"resources\":" RES ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTR "}",
+      0, 1, NULL },
+    { "string resources is deferred",
+      "{\"version\":1,\"resources\":\"\",\"tasks\":" TASKS
+      ",\"attributes\":" ATTR "}",
+      0, 1, NULL },
+    { "numeric exclusive is deferred",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"foo\",\"exclusive\":1}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTR "}",
+      0, 1, NULL },
+    { "non-object jobspec is deferred",
+      "[1,2,3]",
+      0, 1, NULL },
+    { NULL, NULL, 0, 0, NULL },
+};
+
+int main (int argc, char *argv[])
+{
+    struct testcase *t;
+
+    plan (NO_PLAN);
+
+    for (t = &tests[0]; t->desc != NULL; t++) {
+        char errbuf[256] = "";
+        json_t *o;
+        int rc;
+
+        if (!(o = json_loads (t->jobspec, 0, NULL)))
+            BAIL_OUT ("could not decode test jobspec: %s", t->desc);
+        rc = builtin_validate (o, t->require_version, errbuf, sizeof (errbuf));
+        ok (rc == t->rc,
+            "builtin_validate %s returns %d", t->desc, t->rc);
+        if (t->errstr) {
+            is (errbuf, t->errstr,
+                "and error is \"%s\"", t->errstr);
+        }
+        json_decref (o);
+    }
+
+    done_testing ();
+}
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
@@ -10,9 +10,19 @@
 
 /* validate - asynchronous jobspec validation interface
  *
- * Spawn worker(s) to validate jobspec.  Up to 'DEFAULT_WORKER_COUNT'
- * workers may be active at one time.  They are started lazily, on demand,
- * and stop after a period of inactivity (see "tunables" below).
+ * If the validator is the default validate-jobspec.py, jobspec is first
+ * checked in process by builtin_validate(), and only sent to a worker if
+ * it contains something the builtin validator does not handle.
+ *
+ * Otherwise, spawn worker(s) to validate jobspec.  Up to 'worker_count'
+ * workers (default DEFAULT_WORKER_COUNT) may be active at one time.  They
+ * are started lazily, on demand, and stop after a period of inactivity
+ * (see "tunables" below).
+ *
+ * Each worker is given at most 'worker_queue_max' requests at a time.
+ * Beyond that, requests wait in a shared backlog, and are handed to
+ * whichever worker finishes a request first, so a slow worker does not
+ * accumulate work that an idle one could be doing.
  *
  * The validator executable and its command line, including the
  * location of jobspec.jsonschema, are currently hardwired.
@@ -36,20 +46,27 @@
 #include <jansson.h>
 #include <flux/core.h>
 
+#include "src/common/libutil/errno_safe.h"
+
 #include "validate.h"
 #include "worker.h"
+#include "builtin.h"
 
 /* Tunables:
  */
 
-/* The maximum number of concurrent workers.
+/* The default maximum number of concurrent workers.
  */
-#define MAX_WORKER_COUNT 4
+#define DEFAULT_WORKER_COUNT 4
 
 /* Start a new worker if backlog reaches this level for all active workers.
  */
 const int worker_queue_threshold = 32;
 
+/* Hold requests in the shared backlog once all workers reach this level.
+ */
+const int worker_queue_max = 64;
+
 /* Workers exit once they have been inactive for this many seconds.
  */
 const double worker_inactivity_timeout = 5.0;
@@ -58,9 +75,72 @@ const double worker_inactivity_timeout = 5.0;
 
 struct validate {
     flux_t *h;
-    struct worker *worker[MAX_WORKER_COUNT];
+    int worker_count;
+    struct worker **worker;
+    zlist_t *backlog;       // requests waiting for a worker
+    bool builtin;           // use builtin_validate() first
+    int require_version;    // passed to builtin_validate()
+    int builtin_count;      // requests handled in process
+    int worker_request_count; // requests sent to a worker
+};
+
+struct validate_request {
+    struct validate *v;
+    char *s;                // jobspec, encoded without whitespace
+    flux_future_t *f;       // returned by validate_jobspec(), not owned
+    bool backlogged;        // request is on v->backlog
 };
 
+static const char *validate_request_auxkey = "flux::validate_request";
+static const char *validate_future_auxkey = "flux::validate_future";
+
+/* The future returned by validate_jobspec() is being destroyed, possibly
+ * before the request completes.  Forget it, and if the request has not
+ * been handed to a worker yet, drop it from the backlog.
+ */
+static void validate_request_orphan (struct validate_request *req)
+{
+    req->f = NULL;
+    if (req->backlogged) {
+        zlist_remove (req->v->backlog, req);
+        req->backlogged = false;
+        free (req->s);
+        free (req);
+    }
+}
+
+static void validate_request_destroy (struct validate_request *req)
+{
+    if (req) {
+        int saved_errno = errno;
+        if (req->f) {
+            flux_future_t *f = req->f;
+            /* N.B. this calls validate_request_orphan(), which only
+             * clears req->f since req->backlogged is false.
+             */
+            req->backlogged = false;
+            (void)flux_future_aux_set (f, validate_future_auxkey, NULL, NULL);
+        }
+        free (req->s);
+        free (req);
+        errno = saved_errno;
+    }
+}
+
+static struct validate_request *validate_request_create (struct validate *v,
+                                                         char *s,
+                                                         flux_future_t *f)
+{
+    struct validate_request *req;
+
+    if (!(req = calloc (1, sizeof (*req))))
+        return NULL;
+    req->v = v;
+    req->s = s;
+    req->f = f;
+    return req;
+}
+
 static void validate_killall (struct validate *v)
 {
     flux_future_t *cf = flux_future_wait_all_create ();
@@ -71,7 +151,7 @@ static void validate_killall (struct validate *v)
         return;
     }
     flux_future_set_flux (cf, v->h);
-    for (i = 0; i < MAX_WORKER_COUNT; i++) {
+    for (i = 0; i < v->worker_count; i++) {
         if ((f = worker_kill (v->worker[i], SIGKILL)))
             flux_future_push (cf, NULL, f);
     }
@@ -92,7 +172,7 @@ int validate_stop_notify (struct validate *v, process_exit_f cb, void *arg)
     int count;
 
     count = 0;
-    for (i = 0; i < MAX_WORKER_COUNT; i++)
+    for (i = 0; i < v->worker_count; i++)
         count += worker_stop_notify (v->worker[i], cb, arg);
     return count;
 }
@@ -102,9 +182,18 @@ void validate_destroy (struct validate *v)
     if (v) {
         int saved_errno = errno;
         int i;
-        validate_killall (v);
-        for (i = 0; i < MAX_WORKER_COUNT; i++)
-            worker_destroy (v->worker[i]);
+        if (v->worker) {
+            validate_killall (v);
+            for (i = 0; i < v->worker_count; i++)
+                worker_destroy (v->worker[i]);
+            free (v->worker);
+        }
+        if (v->backlog) {
+            struct validate_request *req;
+            while ((req = zlist_pop (v->backlog)))
+                validate_request_destroy (req);
+            zlist_destroy (&v->backlog);
+        }
         free (v);
         errno = saved_errno;
     }
@@ -119,27 +208,64 @@ static bool str_ends_with (const char *str, const char *suffix)
         (!strncmp ((str + str_len) - suffix_len, suffix, suffix_len));
 }
 
+/* The builtin validator can stand in for validate-jobspec.py, provided
+ * it was given no arguments other than --require-version 1.
+ */
+static bool builtin_applies (const char *validate_path,
+                             int argc,
+                             char **argv,
+                             int *require_version)
+{
+    const char *name = strrchr (validate_path, '/');
+    int i;
+
+    name = name ? name + 1 : validate_path;
+    if (strcmp (name, "validate-jobspec.py") != 0)
+        return false;
+    *require_version = 0;
+    for (i = 0; i < argc; i++) {
+        if (!strcmp (argv[i], "--require-version=1"))
+            *require_version = 1;
+        else if (!strcmp (argv[i], "--require-version") && i + 1 < argc
+                 && !strcmp (argv[++i], "1"))
+            *require_version = 1;
+        else
+            return false;
+    }
+    return true;
+}
+
 struct validate *validate_create (flux_t *h,
                                   const char *validate_path,
-                                  const char *validator_args)
+                                  const char *validator_args,
+                                  int worker_count,
+                                  bool builtin)
 {
     struct validate *v;
-    char *argv[5];
+    char **argv = NULL;
     int argc = 0;
     int i;
     char *validator_argz = NULL;
     char *validator_arg = NULL;
     size_t validator_argz_len = 0;
+    int first;
 
+    if (worker_count == 0)
+        worker_count = DEFAULT_WORKER_COUNT;
+    if (worker_count < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
     if (!(v = calloc (1, sizeof (*v))))
         return NULL;
     v->h = h;
+    v->worker_count = worker_count;
+    if (!(v->worker = calloc (worker_count, sizeof (v->worker[0])))
+        || !(v->backlog = zlist_new ()))
+        goto nomem;
 
     assert (validate_path != NULL);
 
-    if (str_ends_with (validate_path, ".py"))
-        argv[argc++] = PYTHON_INTERPRETER;
-    argv[argc++] = (char *)validate_path;
     if (validator_args != NULL) {
         // Parse the comma-separated argument list passed in when loading the
         // job-ingest module.  For example:
@@ -148,44 +274,59 @@ struct validate *validate_create (flux_t *h,
                              ',',
                              &validator_argz,
                              &validator_argz_len) != 0) {
-            goto error;
+            goto nomem;
         }
+    }
+    if (!(argv = calloc (argz_count (validator_argz, validator_argz_len) + 3,
+                         sizeof (argv[0]))))
+        goto nomem;
+    if (str_ends_with (validate_path, ".py"))
+        argv[argc++] = PYTHON_INTERPRETER;
+    argv[argc++] = (char *)validate_path;
+    first = argc;
+    validator_arg = argz_next (validator_argz, validator_argz_len, NULL);
+    while (validator_arg != NULL) {
+        argv[argc++] = validator_arg;
         validator_arg = argz_next (validator_argz,
                                    validator_argz_len,
-                                   NULL);
-        while (validator_arg != NULL) {
-            argv[argc++] = validator_arg;
-            validator_arg = argz_next (validator_argz,
-                                       validator_argz_len,
-                                       validator_arg);
-        }
+                                   validator_arg);
     }
     argv[argc] = NULL;
 
-    for (i = 0; i < MAX_WORKER_COUNT; i++) {
+    if (builtin)
+        v->builtin = builtin_applies (validate_path,
+                                      argc - first,
+                                      argv + first,
+                                      &v->require_version);
+    for (i = 0; i < v->worker_count; i++) {
         if (!(v->worker[i] = worker_create (h, worker_inactivity_timeout,
                                             validate_path,
                                             argc, argv)))
             goto error;
     }
+    free (argv);
     free (validator_argz);
     return v;
+nomem:
+    errno = ENOMEM;
 error:
-    free (validator_argz);
+    ERRNO_SAFE_WRAP (free, argv);
+    ERRNO_SAFE_WRAP (free, validator_argz);
     validate_destroy (v);
     return NULL;
 }
 
 /* Select worker with least backlog.  If none is running, or the best
  * has a backlog at or beyond threshold, activate a new one, if possible.
+ * Return NULL if all workers have reached 'worker_queue_max'.
  */
-struct worker *select_best_worker (struct validate *v)
+static struct worker *select_best_worker (struct validate *v)
 {
     struct worker *best = NULL;
     struct worker *idle = NULL;
     int i;
 
-    for (i = 0; i < MAX_WORKER_COUNT; i++) {
+    for (i = 0; i < v->worker_count; i++) {
         if (worker_is_running (v->worker[i])) {
             if (!best || (worker_queue_depth (v->worker[i])
                         < worker_queue_depth (best)))
@@ -196,50 +337,188 @@ struct worker *select_best_worker (struct validate *v)
     }
     if (idle && (!best || worker_queue_depth (best) >= worker_queue_threshold))
         best = idle;
+    if (best && worker_queue_depth (best) >= worker_queue_max)
+        best = NULL;
 
     return best;
 }
 
-flux_future_t *validate_jobspec (struct validate *v, const char *buf, int len)
+static int validate_dispatch (struct validate *v,
+                              struct worker *w,
+                              struct validate_request *req);
+
+/* Hand backlogged requests to workers that have room for them.
+ */
+static void validate_dispatch_backlog (struct validate *v)
+{
+    struct validate_request *req;
+    struct worker *w;
+
+    while ((req = zlist_first (v->backlog)) && (w = select_best_worker (v))) {
+        zlist_remove (v->backlog, req);
+        req->backlogged = false;
+        if (validate_dispatch (v, w, req) < 0) {
+            flux_future_fulfill_error (req->f, errno, NULL);
+            validate_request_destroy (req);
+        }
+    }
+}
+
+/* Worker has finished a request.  Pass its result on to the future
+ * returned by validate_jobspec(), unless it has been destroyed, then
+ * refill workers from the backlog.  Destroying the worker's future
+ * destroys 'req'.
+ */
+static void worker_continuation (flux_future_t *wf, void *arg)
+{
+    struct validate_request *req = arg;
+    struct validate *v = req->v;
+
+    if (req->f) {
+        if (flux_future_get (wf, NULL) < 0)
+            flux_future_fulfill_error (req->f,
+                                       errno,
+                                       flux_future_has_error (wf)
+                                       ? flux_future_error_string (wf) : NULL);
+        else
+            flux_future_fulfill (req->f, NULL, NULL);
+    }
+    flux_future_destroy (wf);
+    validate_dispatch_backlog (v);
+}
+
+/* Send 'req' to worker 'w'.  On success, 'req' is owned by the worker's
+ * future.
+ */
+static int validate_dispatch (struct validate *v,
+                              struct worker *w,
+                              struct validate_request *req)
+{
+    flux_future_t *wf;
+
+    if (!(wf = worker_request (w, req->s)))
+        return -1;
+    if (flux_future_then (wf, -1., worker_continuation, req) < 0
+        || flux_future_aux_set (wf,
+                                validate_request_auxkey,
+                                req,
+                                (flux_free_f)validate_request_destroy) < 0) {
+        flux_future_destroy (wf);
+        return -1;
+    }
+    v->worker_request_count++;
+    return 0;
+}
+
+static flux_future_t *fulfilled_future (struct validate *v,
+                                        int errnum,
+                                        const char *errstr)
 {
     flux_future_t *f;
+
+    if (!(f = flux_future_create (NULL, NULL)))
+        return NULL;
+    flux_future_set_flux (f, v->h);
+    if (errnum)
+        flux_future_fulfill_error (f, errnum, errstr);
+    else
+        flux_future_fulfill (f, NULL, NULL);
+    return f;
+}
+
+flux_future_t *validate_jobspec (struct validate *v, const char *buf, int len)
+{
+    flux_future_t *f = NULL;
     json_t *o;
     json_error_t error;
-    char *s;
-    int saved_errno;
+    char *s = NULL;
+    struct validate_request *req;
     struct worker *w;
 
     /* Make sure jobspec decodes as JSON (no YAML allowed here).
      * Capture any JSON parsing errors by returning them in a future.
-     * Then re-encode in compact form to eliminate any white space (esp \n).
      */
     if (!(o = json_loadb (buf, len, 0, &error))) {
         char errbuf[256];
-        if (!(f = flux_future_create (NULL, NULL)))
-            return NULL;
-        flux_future_set_flux (f, v->h);
         (void)snprintf (errbuf, sizeof (errbuf),
                        "jobspec: invalid JSON: %s", error.text);
-        flux_future_fulfill_error (f, EINVAL, errbuf);
-        return f;
+        return fulfilled_future (v, EINVAL, errbuf);
+    }
+    if (v->builtin) {
+        char errbuf[256];
+        int rc;
+
+        if ((rc = builtin_validate (o,
+                                    v->require_version,
+                                    errbuf,
+                                    sizeof (errbuf))) <= 0) {
+            v->builtin_count++;
+            json_decref (o);
+            /* N.B. validate-jobspec.py rejects with errnum 1 (EPERM),
+             * so use the same errno regardless of which path rejected it.
+             */
+            return fulfilled_future (v, rc < 0 ? EPERM : 0, errbuf);
+        }
     }
+    /* Re-encode in compact form to eliminate any white space (esp \n).
+     */
     if (!(s = json_dumps (o, JSON_COMPACT)))
+        goto nomem;
+    if (!(f = flux_future_create (NULL, NULL)))
+        goto error;
+    flux_future_set_flux (f, v->h);
+    if (!(req = validate_request_create (v, s, f)))
         goto error;
-    w = select_best_worker (v);
-    assert (w != NULL);
-    if (!(f = worker_request (w, s)))
+    s = NULL; // owned by 'req' now
+    if (flux_future_aux_set (f,
+                             validate_future_auxkey,
+                             req,
+                             (flux_free_f)validate_request_orphan) < 0) {
+        req->f = NULL;
+        validate_request_destroy (req);
         goto error;
-    free (s);
+    }
+    if (zlist_size (v->backlog) == 0 && (w = select_best_worker (v))) {
+        if (validate_dispatch (v, w, req) < 0) {
+            validate_request_destroy (req);
+            goto error;
+        }
+    }
+    else if (zlist_append (v->backlog, req) < 0) {
+        validate_request_destroy (req);
+        goto nomem;
+    }
+    else
+        req->backlogged = true;
     json_decref (o);
     return f;
+nomem:
+    errno = ENOMEM;
 error:
-    saved_errno = errno;
-    free (s);
-    json_decref (o);
-    errno = saved_errno;
+    ERRNO_SAFE_WRAP (free, s);
+    ERRNO_SAFE_WRAP (json_decref, o);
+    flux_future_destroy (f);
     return NULL;
 }
 
+json_t *validate_get_stats (struct validate *v)
+{
+    int running = 0;
+    int i;
+
+    for (i = 0; i < v->worker_count; i++) {
+        if (worker_is_running (v->worker[i]))
+            running++;
+    }
+    return json_pack ("{s:b s:i s:i s:i s:i s:i}",
+                      "builtin", v->builtin,
+                      "builtin_count", v->builtin_count,
+                      "worker_count", v->worker_request_count,
+                      "backlog", (int)zlist_size (v->backlog),
+                      "workers", v->worker_count,
+                      "workers_running", running);
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
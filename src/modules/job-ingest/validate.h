@@ -11,6 +11,8 @@
 #ifndef _JOB_INGEST_VALIDATE_H
 #define _JOB_INGEST_VALIDATE_H
 
+#include <stdbool.h>
+#include <jansson.h>
 #include <flux/core.h>
 
 #include "types.h"
@@ -28,12 +30,22 @@ flux_future_t *validate_jobspec (struct validate *v, const char *buf, int len);
  */
 int validate_stop_notify (struct validate *v, process_exit_f cb, void *arg);
 
+/* Create validation interface with up to 'worker_count' workers running
+ * 'validate_path' (0 = default count).  If 'builtin' is true, and the
+ * validator is validate-jobspec.py, validate in process when possible.
+ */
 struct validate *validate_create (flux_t *h,
                                   const char *validate_path,
-                                  const char *validator_args);
+                                  const char *validator_args,
+                                  int worker_count,
+                                  bool builtin);
 
 void validate_destroy (struct validate *v);
 
+/* Return counts of requests handled in process and by workers.
+ */
+json_t *validate_get_stats (struct validate *v);
+
 #endif /* !_JOB_INGEST_VALIDATE_H */
 
 /*
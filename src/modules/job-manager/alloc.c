@@ -26,6 +26,8 @@
 #include <flux/schedutil.h>
 #include <assert.h>
 
+#include "src/common/libutil/monotime.h"
+
 #include "job.h"
 #include "alloc.h"
 #include "event.h"
@@ -222,6 +224,7 @@ static void alloc_response_cb (flux_t *h, flux_msg_handler_t *mh,
             errno = EEXIST;
             goto teardown;
         }
+        monotime (&job->t_alloc);
         if (annotations_update (h, job, annotations) < 0)
             flux_log_error (h, "annotations_update: id=%ju", (uintmax_t)id);
         if (annotations) {
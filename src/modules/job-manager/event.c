@@ -27,6 +27,14 @@
  * event_job_update(), event_job_action(), and committing the event to
  * the job eventlog, in a delayed batch.
  *
+ * In adaptive batch mode, the batch window grows (up to batch_timeout_max)
+ * while commits back up, and shrinks back to batch_timeout when the
+ * pipeline drains.  At most max_commits_inflight commits are outstanding;
+ * once the limit is reached, the open batch keeps accumulating updates
+ * until a commit completes.  Since state transitions and annotations are
+ * published once per batch, this also reduces the number of job-state
+ * events published under load.
+ *
  * Notes:
  * - A KVS commit failure is handled as fatal to the job-manager
  * - event_job_action() is idempotent
@@ -48,8 +56,12 @@
 #include "event.h"
 
 #include "src/common/libeventlog/eventlog.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/tstat.h"
 
 const double batch_timeout = 0.01;
+const double batch_timeout_max = 0.16;
+const int max_commits_inflight = 2;
 
 struct event {
     struct job_manager *ctx;
@@ -57,6 +69,14 @@ struct event {
     flux_watcher_t *timer;
     zlist_t *pending;
     zlist_t *pub_futures;
+    bool adaptive;
+    double timeout;         // current batch window
+    double timeout_peak;    // largest batch window so far
+    bool commit_deferred;   // batch window expired with commits maxed out
+    int commits;
+    int deferrals;
+    tstat_t size_stats;     // eventlog updates per batch
+    tstat_t latency_stats;  // batch open to commit complete, in msec
 };
 
 struct event_batch {
@@ -66,10 +86,13 @@ struct event_batch {
     json_t *state_trans;
     json_t *annotations;
     zlist_t *responses; // responses deferred until batch complete
+    struct timespec t_start;
+    int count;          // number of eventlog updates in txn
 };
 
 struct event_batch *event_batch_create (struct event *event);
 void event_batch_destroy (struct event_batch *batch);
+void event_batch_commit (struct event *event);
 
 /* Batch commit has completed.
  * If there was a commit error, log it and stop the reactor.
@@ -85,8 +108,16 @@ void commit_continuation (flux_future_t *f, void *arg)
         flux_log_error (ctx->h, "%s: eventlog update failed", __FUNCTION__);
         flux_reactor_stop_error (flux_get_reactor (ctx->h));
     }
+    tstat_push (&event->latency_stats, monotime_since (batch->t_start));
     zlist_remove (event->pending, batch);
     event_batch_destroy (batch);
+
+    /* A batch held back by the in-flight limit may go now.
+     */
+    if (event->commit_deferred) {
+        event->commit_deferred = false;
+        event_batch_commit (event);
+    }
 }
 
 /* job-state event publish has completed.
@@ -116,6 +147,8 @@ void event_batch_commit (struct event *event)
     if (batch) {
         event->batch = NULL;
         if (batch->txn) {
+            event->commits++;
+            tstat_push (&event->size_stats, batch->count);
             if (!(batch->f = flux_kvs_commit (ctx->h, NULL, 0, batch->txn)))
                 goto error;
             if (flux_future_then (batch->f, -1., commit_continuation, batch) < 0)
@@ -136,10 +169,42 @@ error: // unlikely (e.g. ENOMEM)
     event_batch_destroy (batch);
 }
 
+/* Adjust the batch window based on how far behind the commit pipeline is
+ * when a batch window closes: double it while commits are outstanding,
+ * and halve it once they have all completed.
+ */
+static void event_batch_adapt (struct event *event)
+{
+    if (zlist_size (event->pending) > 0) {
+        event->timeout *= 2;
+        if (event->timeout > batch_timeout_max)
+            event->timeout = batch_timeout_max;
+        if (event->timeout > event->timeout_peak)
+            event->timeout_peak = event->timeout;
+    }
+    else {
+        event->timeout /= 2;
+        if (event->timeout < batch_timeout)
+            event->timeout = batch_timeout;
+    }
+}
+
 void timer_cb (flux_reactor_t *r, flux_watcher_t *w, int revents, void *arg)
 {
     struct job_manager *ctx = arg;
-    event_batch_commit (ctx->event);
+    struct event *event = ctx->event;
+
+    if (event->adaptive) {
+        event_batch_adapt (event);
+        if (event->batch
+            && event->batch->txn
+            && zlist_size (event->pending) >= max_commits_inflight) {
+            event->commit_deferred = true;
+            event->deferrals++;
+            return;
+        }
+    }
+    event_batch_commit (event);
 }
 
 void event_publish (struct event *event, const char *topic,
@@ -223,6 +288,7 @@ struct event_batch *event_batch_create (struct event *event)
     if (!(batch = calloc (1, sizeof (*batch))))
         return NULL;
     batch->event = event;
+    monotime (&batch->t_start);
     return batch;
 }
 
@@ -234,7 +300,7 @@ int event_batch_start (struct event *event)
     if (!event->batch) {
         if (!(event->batch = event_batch_create (event)))
             return -1;
-        flux_timer_watcher_reset (event->timer, batch_timeout, 0.);
+        flux_timer_watcher_reset (event->timer, event->timeout, 0.);
         flux_watcher_start (event->timer);
     }
     return 0;
@@ -263,6 +329,7 @@ static int event_batch_commit_event (struct event *event,
         return -1;
     }
     free (entrystr);
+    event->batch->count++;
     return 0;
 }
 
@@ -596,6 +663,54 @@ error:
     return -1;
 }
 
+void event_set_adaptive (struct event *event, bool enable)
+{
+    event->adaptive = enable;
+    event->timeout = batch_timeout;
+    event->timeout_peak = batch_timeout;
+}
+
+static json_t *tstat_encode (tstat_t *ts)
+{
+    return json_pack ("{s:i s:f s:f s:f s:f}",
+                      "count", tstat_count (ts),
+                      "min", tstat_min (ts),
+                      "mean", tstat_mean (ts),
+                      "stddev", tstat_stddev (ts),
+                      "max", tstat_max (ts));
+}
+
+json_t *event_get_stats (struct event *event)
+{
+    json_t *size;
+    json_t *latency = NULL;
+    json_t *o;
+
+    if (!(size = tstat_encode (&event->size_stats))
+        || !(latency = tstat_encode (&event->latency_stats)))
+        goto nomem;
+    if (!(o = json_pack ("{s:s s:f s:f s:i s:i s:i s:i s:O s:O}",
+                         "mode", event->adaptive ? "adaptive" : "fixed",
+                         "timeout", event->timeout,
+                         "timeout-peak", event->timeout_peak,
+                         "commits", event->commits,
+                         "inflight", (int)zlist_size (event->pending),
+                         "max-inflight", event->adaptive
+                                         ? max_commits_inflight : -1,
+                         "deferrals", event->deferrals,
+                         "size", size,
+                         "latency", latency)))
+        goto nomem;
+    json_decref (size);
+    json_decref (latency);
+    return o;
+nomem:
+    json_decref (size);
+    json_decref (latency);
+    errno = ENOMEM;
+    return NULL;
+}
+
 /* Finalizes in-flight batch KVS commits and event pubs (synchronously).
  */
 void event_ctx_destroy (struct event *event)
@@ -632,6 +747,8 @@ struct event *event_ctx_create (struct job_manager *ctx)
     if (!(event = calloc (1, sizeof (*event))))
         return NULL;
     event->ctx = ctx;
+    event->timeout = batch_timeout;
+    event->timeout_peak = batch_timeout;
     if (!(event->timer = flux_timer_watcher_create (flux_get_reactor (ctx->h),
                                                     0.,
                                                     0.,
@@ -55,6 +55,15 @@ int event_job_post_pack (struct event *event,
                          const char *context_fmt,
                          ...);
 
+/* Enable/disable adaptive batch sizing (disabled by default).
+ */
+void event_set_adaptive (struct event *event, bool enable);
+
+/* Get batch statistics for job-manager.stats.get.
+ * Returns a new JSON object on success, or NULL on failure with errno set.
+ */
+json_t *event_get_stats (struct event *event);
+
 void event_ctx_destroy (struct event *event);
 struct event *event_ctx_create (struct job_manager *ctx);
 
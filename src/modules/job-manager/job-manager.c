@@ -52,6 +52,70 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
+static void stats_handle_request (flux_t *h,
+                                  flux_msg_handler_t *mh,
+                                  const flux_msg_t *msg,
+                                  void *arg)
+{
+    struct job_manager *ctx = arg;
+    json_t *batch = NULL;
+    json_t *latency = NULL;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    if (!(batch = event_get_stats (ctx->event))
+        || !(latency = start_get_stats (ctx->start)))
+        goto error;
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:i s:i s:O s:O}",
+                           "active_jobs", (int)zhashx_size (ctx->active_jobs),
+                           "running_jobs", ctx->running_jobs,
+                           "batch", batch,
+                           "latency", latency) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    json_decref (batch);
+    json_decref (latency);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    json_decref (batch);
+    json_decref (latency);
+}
+
+/* Read [job-manager] batch-adaptive from config, allow override on cmdline.
+ */
+static int job_manager_config (struct job_manager *ctx, int argc, char **argv)
+{
+    flux_conf_error_t err;
+    int adaptive = 0;
+
+    if (flux_conf_unpack (flux_get_conf (ctx->h),
+                          &err,
+                          "{s?:{s?b}}",
+                          "job-manager",
+                            "batch-adaptive", &adaptive) < 0) {
+        flux_log (ctx->h, LOG_ERR,
+                  "error reading config value job-manager.batch-adaptive: %s",
+                  err.errbuf);
+        return -1;
+    }
+    for (int i = 0; i < argc; i++) {
+        if (!strcmp (argv[i], "batch-adaptive"))
+            adaptive = 1;
+        else if (!strcmp (argv[i], "batch-fixed"))
+            adaptive = 0;
+        else {
+            flux_log (ctx->h, LOG_ERR, "unknown option: %s", argv[i]);
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    event_set_adaptive (ctx->event, adaptive);
+    return 0;
+}
+
 static const struct flux_msg_handler_spec htab[] = {
     {
         FLUX_MSGTYPE_REQUEST,
@@ -71,6 +135,12 @@ static const struct flux_msg_handler_spec htab[] = {
         getinfo_handle_request,
         FLUX_ROLE_USER
     },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "job-manager.stats.get",
+        stats_handle_request,
+        0
+    },
     FLUX_MSGHANDLER_TABLE_END,
 };
 
@@ -93,6 +163,8 @@ int mod_main (flux_t *h, int argc, char **argv)
         flux_log_error (h, "error creating event batcher");
         goto done;
     }
+    if (job_manager_config (&ctx, argc, argv) < 0)
+        goto done;
     if (!(ctx.submit = submit_ctx_create (&ctx))) {
         flux_log_error (h, "error creating submit interface");
         goto done;
@@ -133,10 +205,16 @@ int mod_main (flux_t *h, int argc, char **argv)
         flux_log_error (h, "restart_from_kvs");
         goto done;
     }
+    if (!(ctx.checkpoint = checkpoint_ctx_create (&ctx))) {
+        flux_log_error (h, "error creating checkpoint interface");
+        goto done;
+    }
     if (flux_reactor_run (r, 0) < 0) {
         flux_log_error (h, "flux_reactor_run");
         goto done;
     }
+    checkpoint_ctx_destroy (ctx.checkpoint);
+    ctx.checkpoint = NULL;
     if (checkpoint_to_kvs (&ctx) < 0) {
         flux_log_error (h, "checkpoint_to_kvs");
         goto done;
@@ -144,6 +222,7 @@ int mod_main (flux_t *h, int argc, char **argv)
     rc = 0;
 done:
     flux_msg_handler_delvec (ctx.handlers);
+    checkpoint_ctx_destroy (ctx.checkpoint);
     annotate_ctx_destroy (ctx.annotate);
     kill_ctx_destroy (ctx.kill);
     raise_ctx_destroy (ctx.raise);
@@ -12,6 +12,7 @@
 #define _FLUX_JOB_MANAGER_JOB_H
 
 #include <stdint.h>
+#include <time.h>
 #include <czmq.h>
 #include <jansson.h>
 #include "src/common/libjob/job.h"
@@ -34,6 +35,8 @@ struct job {
 
     json_t *annotations;
 
+    struct timespec t_alloc; // monotonic time resources were allocated
+
     void *handle;           // zlistx_t handle
     int refcount;           // private to job.c
 };
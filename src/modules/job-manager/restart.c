@@ -8,7 +8,20 @@
  * SPDX-License-Identifier: LGPL-3.0
 \************************************************************/
 
-/* restart - reload active jobs from the KVS */
+/* restart - reload active jobs from the KVS
+ *
+ * The ids of active jobs and unreaped zombies are saved in a compact
+ * binary snapshot, periodically and on shutdown.  On restart, the jobs in
+ * the snapshot are reloaded by id, then only the part of the job.
+ * directory that may hold jobs submitted after the snapshot is walked,
+ * so restart time is proportional to the number of active jobs rather
+ * than the size of the job history.  Without a snapshot, the whole
+ * directory is walked.
+ *
+ * Snapshot format (network byte order):
+ *   uint32 magic, uint32 version, uint64 max_jobid, uint32 count,
+ *   uint64 id[count]
+ */
 
 #if HAVE_CONFIG_H
 #include "config.h"
@@ -16,9 +29,11 @@
 #include <stdlib.h>
 #include <argz.h>
 #include <envz.h>
+#include <arpa/inet.h>
 #include <flux/core.h>
 
 #include "src/common/libutil/fluid.h"
+#include "src/common/libutil/errno_safe.h"
 
 #include "job.h"
 #include "restart.h"
@@ -31,6 +46,116 @@
 typedef int (*restart_map_f)(struct job *job, void *arg);
 
 const char *checkpoint_key = "checkpoint.job-manager";
+const char *checkpoint_jobs_key = "checkpoint.job-manager-jobs";
+
+static const uint32_t checkpoint_jobs_magic = 0x464a4d43; // "FJMC"
+static const uint32_t checkpoint_jobs_version = 1;
+static const double checkpoint_period = 60.;
+
+/* Jobs submitted slightly before the snapshot may not yet have reached
+ * the job manager when it was taken, so walk jobs with FLUID timestamps
+ * up to this many milliseconds older than the snapshot's max_jobid.
+ */
+static const uint64_t checkpoint_slack_ms = 300000;
+
+struct checkpoint {
+    struct job_manager *ctx;
+    flux_watcher_t *timer;
+    flux_future_t *f;           // periodic commit in progress
+};
+
+struct restart_walk {
+    struct job_manager *ctx;
+    flux_jobid_t min_id;        // skip subtrees holding only smaller ids
+    const flux_jobid_t *skip;   // sorted ids already loaded
+    int skip_count;
+};
+
+static void put_uint32 (uint8_t *p, uint32_t val)
+{
+    uint32_t x = htonl (val);
+    memcpy (p, &x, sizeof (x));
+}
+
+static uint32_t get_uint32 (const uint8_t *p)
+{
+    uint32_t x;
+    memcpy (&x, p, sizeof (x));
+    return ntohl (x);
+}
+
+static void put_uint64 (uint8_t *p, uint64_t val)
+{
+    put_uint32 (p, val >> 32);
+    put_uint32 (p + 4, val & 0xffffffff);
+}
+
+static uint64_t get_uint64 (const uint8_t *p)
+{
+    return ((uint64_t)get_uint32 (p) << 32) | get_uint32 (p + 4);
+}
+
+void *restart_jobs_encode (flux_jobid_t max_jobid,
+                           const flux_jobid_t *ids,
+                           int count,
+                           int *sizep)
+{
+    int size = 20 + 8 * count;
+    uint8_t *buf;
+
+    if (count < 0 || (count > 0 && !ids) || !sizep) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(buf = malloc (size)))
+        return NULL;
+    put_uint32 (buf, checkpoint_jobs_magic);
+    put_uint32 (buf + 4, checkpoint_jobs_version);
+    put_uint64 (buf + 8, max_jobid);
+    put_uint32 (buf + 16, count);
+    for (int i = 0; i < count; i++)
+        put_uint64 (buf + 20 + 8 * i, ids[i]);
+    *sizep = size;
+    return buf;
+}
+
+int restart_jobs_decode (const void *data,
+                         int size,
+                         flux_jobid_t *max_jobid,
+                         flux_jobid_t **idsp,
+                         int *countp)
+{
+    const uint8_t *buf = data;
+    flux_jobid_t *ids = NULL;
+    uint32_t count;
+
+    if (!data || size < 20 || !max_jobid || !idsp || !countp)
+        goto inval;
+    if (get_uint32 (buf) != checkpoint_jobs_magic
+        || get_uint32 (buf + 4) != checkpoint_jobs_version)
+        goto inval;
+    count = get_uint32 (buf + 16);
+    if (count > (size - 20) / 8 || size != 20 + 8 * count)
+        goto inval;
+    if (count > 0 && !(ids = calloc (count, sizeof (ids[0]))))
+        return -1;
+    for (int i = 0; i < count; i++)
+        ids[i] = get_uint64 (buf + 20 + 8 * i);
+    *max_jobid = get_uint64 (buf + 8);
+    *idsp = ids;
+    *countp = count;
+    return 0;
+inval:
+    errno = EINVAL;
+    return -1;
+}
+
+static int jobid_cmp (const void *a, const void *b)
+{
+    flux_jobid_t x = *(const flux_jobid_t *)a;
+    flux_jobid_t y = *(const flux_jobid_t *)b;
+    return x == y ? 0 : x < y ? -1 : 1;
+}
 
 int restart_count_char (const char *s, char c)
 {
@@ -42,22 +167,15 @@ int restart_count_char (const char *s, char c)
     return count;
 }
 
-static int depthfirst_map_one (flux_t *h, const char *key, int dirskip,
-                               restart_map_f cb, void *arg)
+static int restart_load_one (flux_t *h, flux_jobid_t id,
+                             restart_map_f cb, void *arg)
 {
-    flux_jobid_t id;
     flux_future_t *f;
     const char *eventlog;
     struct job *job = NULL;
     char path[64];
     int rc = -1;
 
-    if (strlen (key) <= dirskip) {
-        errno = EINVAL;
-        return -1;
-    }
-    if (fluid_decode (key + dirskip + 1, &id, FLUID_STRING_DOTHEX) < 0)
-        return -1;
     if (flux_job_kvs_key (path, sizeof (path), id, "eventlog") < 0) {
         errno = EINVAL;
         return -1;
@@ -77,8 +195,58 @@ done:
     return rc;
 }
 
+static int depthfirst_map_one (flux_t *h, const char *key, int dirskip,
+                               struct restart_walk *walk,
+                               restart_map_f cb, void *arg)
+{
+    flux_jobid_t id;
+
+    if (strlen (key) <= dirskip) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (fluid_decode (key + dirskip + 1, &id, FLUID_STRING_DOTHEX) < 0)
+        return -1;
+    if (id < walk->min_id
+        || (walk->skip_count > 0 && bsearch (&id,
+                                             walk->skip,
+                                             walk->skip_count,
+                                             sizeof (walk->skip[0]),
+                                             jobid_cmp)))
+        return 0;
+    return restart_load_one (h, id, cb, arg);
+}
+
+/* Return true if the job directory at 'path_level' (0-3) with 16-bit
+ * dothex component 'name' under 'prefix' can only hold ids < min_id.
+ */
+static bool depthfirst_prune (struct restart_walk *walk,
+                              uint64_t prefix,
+                              int path_level,
+                              const char *name,
+                              uint64_t *nprefix)
+{
+    int shift = 16 * (3 - path_level);
+    uint64_t max;
+    char *endptr;
+    unsigned long c;
+
+    errno = 0;
+    c = strtoul (name, &endptr, 16);
+    if (errno != 0 || *endptr != '\0' || c > 0xffff) {
+        *nprefix = prefix;
+        return false; // not a job directory, let fluid_decode sort it out
+    }
+    *nprefix = (prefix << 16) | c;
+    max = shift == 0 ? *nprefix
+                     : (*nprefix << shift) | ((UINT64_C(1) << shift) - 1);
+    return max < walk->min_id;
+}
+
 static int depthfirst_map (flux_t *h, const char *key,
-                           int dirskip, restart_map_f cb, void *arg)
+                           int dirskip, struct restart_walk *walk,
+                           uint64_t prefix,
+                           restart_map_f cb, void *arg)
 {
     flux_future_t *f;
     const flux_kvsdir_t *dir;
@@ -100,15 +268,20 @@ static int depthfirst_map (flux_t *h, const char *key,
         goto done;
     while ((name = flux_kvsitr_next (itr))) {
         char *nkey;
+        uint64_t nprefix = 0;
         int n;
         if (!flux_kvsdir_isdir (dir, name))
             continue;
+        if (walk->min_id > 0
+            && path_level <= 3
+            && depthfirst_prune (walk, prefix, path_level, name, &nprefix))
+            continue;
         if (!(nkey = flux_kvsdir_key_at (dir, name)))
             goto done_destroyitr;
         if (path_level == 3) // orig 'key' = .A.B.C, thus 'nkey' is complete
-            n = depthfirst_map_one (h, nkey, dirskip, cb, arg);
+            n = depthfirst_map_one (h, nkey, dirskip, walk, cb, arg);
         else
-            n = depthfirst_map (h, nkey, dirskip, cb, arg);
+            n = depthfirst_map (h, nkey, dirskip, walk, nprefix, cb, arg);
         if (n < 0) {
             int saved_errno = errno;
             free (nkey);
@@ -145,21 +318,72 @@ static int restart_map_cb (struct job *job, void *arg)
     return 0;
 }
 
-static int checkpoint_save (struct job_manager *ctx)
+/* Build the binary snapshot of active and zombie job ids.
+ */
+static void *checkpoint_jobs_encode (struct job_manager *ctx, int *sizep)
+{
+    flux_jobid_t *ids;
+    struct job *job;
+    int size = zhashx_size (ctx->active_jobs);
+    int count = 0;
+    void *buf;
+
+    job = wait_zombie_first (ctx->wait);
+    while (job) {
+        size++;
+        job = wait_zombie_next (ctx->wait);
+    }
+    if (!(ids = calloc (size + 1, sizeof (ids[0]))))
+        return NULL;
+    job = zhashx_first (ctx->active_jobs);
+    while (job) {
+        ids[count++] = job->id;
+        job = zhashx_next (ctx->active_jobs);
+    }
+    job = wait_zombie_first (ctx->wait);
+    while (job) {
+        ids[count++] = job->id;
+        job = wait_zombie_next (ctx->wait);
+    }
+    buf = restart_jobs_encode (ctx->max_jobid, ids, count, sizep);
+    ERRNO_SAFE_WRAP (free, ids);
+    return buf;
+}
+
+static flux_kvs_txn_t *checkpoint_txn_create (struct job_manager *ctx)
 {
-    flux_future_t *f = NULL;
     flux_kvs_txn_t *txn;
-    int rc = -1;
+    void *buf = NULL;
+    int size;
 
     if (!(txn = flux_kvs_txn_create ()))
-        return -1;
+        return NULL;
     if (flux_kvs_txn_pack (txn,
                            0,
                            checkpoint_key,
                            "{s:I}",
                            "max_jobid",
                            ctx->max_jobid) < 0)
-        goto done;
+        goto error;
+    if (!(buf = checkpoint_jobs_encode (ctx, &size))
+        || flux_kvs_txn_put_raw (txn, 0, checkpoint_jobs_key, buf, size) < 0)
+        goto error;
+    free (buf);
+    return txn;
+error:
+    ERRNO_SAFE_WRAP (free, buf);
+    flux_kvs_txn_destroy (txn);
+    return NULL;
+}
+
+static int checkpoint_save (struct job_manager *ctx)
+{
+    flux_future_t *f = NULL;
+    flux_kvs_txn_t *txn;
+    int rc = -1;
+
+    if (!(txn = checkpoint_txn_create (ctx)))
+        return -1;
     if (!(f = flux_kvs_commit (ctx->h, NULL, 0, txn)))
         goto done;
     if (flux_future_get (f, NULL) < 0)
@@ -188,6 +412,79 @@ static int checkpoint_restore (struct job_manager *ctx)
     return 0;
 }
 
+/* Fetch the job id snapshot.  On success, the caller must free '*idsp'.
+ */
+static int checkpoint_jobs_restore (struct job_manager *ctx,
+                                    flux_jobid_t *max_jobid,
+                                    flux_jobid_t **idsp,
+                                    int *countp)
+{
+    flux_future_t *f;
+    const void *data;
+    int size;
+    int rc = -1;
+
+    if (!(f = flux_kvs_lookup (ctx->h, NULL, 0, checkpoint_jobs_key)))
+        return -1;
+    if (flux_kvs_lookup_get_raw (f, &data, &size) < 0)
+        goto done;
+    if (restart_jobs_decode (data, size, max_jobid, idsp, countp) < 0)
+        goto done;
+    rc = 0;
+done:
+    flux_future_destroy (f);
+    return rc;
+}
+
+/* Reload the jobs in the snapshot, then walk only the part of the job
+ * directory that may contain jobs submitted since.  Returns the number of
+ * jobs loaded, or -1 on error (errno == ENOENT if there is no snapshot).
+ */
+static int restart_from_checkpoint (struct job_manager *ctx,
+                                    const char *dirname,
+                                    int dirskip)
+{
+    flux_jobid_t max_jobid;
+    flux_jobid_t *ids = NULL;
+    int count = 0;
+    int total = 0;
+    struct restart_walk walk = { .ctx = ctx };
+    uint64_t ts;
+    int n;
+
+    if (checkpoint_jobs_restore (ctx, &max_jobid, &ids, &count) < 0)
+        return -1;
+    qsort (ids, count, sizeof (ids[0]), jobid_cmp);
+    for (int i = 0; i < count; i++) {
+        if ((n = restart_load_one (ctx->h, ids[i], restart_map_cb, ctx)) < 0) {
+            if (errno != ENOENT)
+                goto error;
+            flux_log (ctx->h, LOG_DEBUG,
+                      "restart: checkpointed job %ju not found",
+                      (uintmax_t)ids[i]);
+            continue;
+        }
+        total += n;
+    }
+    ts = fluid_get_timestamp (max_jobid);
+    walk.min_id = ts > checkpoint_slack_ms
+                  ? (ts - checkpoint_slack_ms) << 24 : 0;
+    walk.skip = ids;
+    walk.skip_count = count;
+    if ((n = depthfirst_map (ctx->h, dirname, dirskip, &walk, 0,
+                             restart_map_cb, ctx)) < 0)
+        goto error;
+    total += n;
+    flux_log (ctx->h, LOG_INFO,
+              "restart: checkpoint has %d jobs, %d newer jobs found",
+              count, n);
+    free (ids);
+    return total;
+error:
+    ERRNO_SAFE_WRAP (free, ids);
+    return -1;
+}
+
 int restart_from_kvs (struct job_manager *ctx)
 {
     const char *dirname = "job";
@@ -197,9 +494,21 @@ int restart_from_kvs (struct job_manager *ctx)
 
     /* Load any active jobs present in the KVS at startup.
      */
-    count = depthfirst_map (ctx->h, dirname, dirskip, restart_map_cb, ctx);
-    if (count < 0)
-        return -1;
+    if ((count = restart_from_checkpoint (ctx, dirname, dirskip)) < 0) {
+        struct restart_walk walk = { .ctx = ctx };
+
+        if (errno != ENOENT && errno != EINVAL) {
+            flux_log_error (ctx->h, "restart: %s", checkpoint_jobs_key);
+            return -1;
+        }
+        if (errno == EINVAL)
+            flux_log (ctx->h, LOG_ERR, "restart: ignoring invalid %s",
+                      checkpoint_jobs_key);
+        count = depthfirst_map (ctx->h, dirname, dirskip, &walk, 0,
+                                restart_map_cb, ctx);
+        if (count < 0)
+            return -1;
+    }
     flux_log (ctx->h, LOG_INFO, "restart: %d jobs", count);
     /* Initialize the count of "running" jobs
      */
@@ -236,6 +545,73 @@ int checkpoint_to_kvs (struct job_manager *ctx)
     return 0;
 }
 
+static void checkpoint_continuation (flux_future_t *f, void *arg)
+{
+    struct checkpoint *ckpt = arg;
+
+    if (flux_future_get (f, NULL) < 0)
+        flux_log_error (ckpt->ctx->h, "checkpoint");
+    flux_future_destroy (f);
+    ckpt->f = NULL;
+}
+
+/* Save the snapshot without blocking the reactor.  Skip this period if the
+ * previous commit has not completed.
+ */
+static void checkpoint_timer_cb (flux_reactor_t *r,
+                                 flux_watcher_t *w,
+                                 int revents,
+                                 void *arg)
+{
+    struct checkpoint *ckpt = arg;
+    struct job_manager *ctx = ckpt->ctx;
+    flux_kvs_txn_t *txn;
+
+    if (ckpt->f)
+        return;
+    if (!(txn = checkpoint_txn_create (ctx))
+        || !(ckpt->f = flux_kvs_commit (ctx->h, NULL, 0, txn))
+        || flux_future_then (ckpt->f, -1., checkpoint_continuation, ckpt) < 0) {
+        flux_log_error (ctx->h, "checkpoint");
+        flux_future_destroy (ckpt->f);
+        ckpt->f = NULL;
+    }
+    flux_kvs_txn_destroy (txn);
+}
+
+void checkpoint_ctx_destroy (struct checkpoint *ckpt)
+{
+    if (ckpt) {
+        int saved_errno = errno;
+        flux_watcher_destroy (ckpt->timer);
+        if (ckpt->f)
+            (void)flux_future_wait_for (ckpt->f, -1);
+        flux_future_destroy (ckpt->f);
+        free (ckpt);
+        errno = saved_errno;
+    }
+}
+
+struct checkpoint *checkpoint_ctx_create (struct job_manager *ctx)
+{
+    struct checkpoint *ckpt;
+
+    if (!(ckpt = calloc (1, sizeof (*ckpt))))
+        return NULL;
+    ckpt->ctx = ctx;
+    if (!(ckpt->timer = flux_timer_watcher_create (flux_get_reactor (ctx->h),
+                                                   checkpoint_period,
+                                                   checkpoint_period,
+                                                   checkpoint_timer_cb,
+                                                   ckpt)))
+        goto error;
+    flux_watcher_start (ckpt->timer);
+    return ckpt;
+error:
+    checkpoint_ctx_destroy (ckpt);
+    return NULL;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -20,8 +20,26 @@ int restart_from_kvs (struct job_manager *ctx);
 /* exposed for unit testing only */
 int restart_count_char (const char *s, char c);
 
+/* Encode/decode the binary snapshot of active job ids.
+ * Exposed for unit testing only.
+ */
+void *restart_jobs_encode (flux_jobid_t max_jobid,
+                           const flux_jobid_t *ids,
+                           int count,
+                           int *sizep);
+int restart_jobs_decode (const void *data,
+                         int size,
+                         flux_jobid_t *max_jobid,
+                         flux_jobid_t **idsp,
+                         int *countp);
+
 int checkpoint_to_kvs (struct job_manager *ctx);
 
+/* Checkpoint periodically while the job manager is running.
+ */
+struct checkpoint *checkpoint_ctx_create (struct job_manager *ctx);
+void checkpoint_ctx_destroy (struct checkpoint *ckpt);
+
 #endif /* _FLUX_JOB_MANAGER_RESTART_H */
 
 /*
@@ -85,6 +85,9 @@
 #include <flux/core.h>
 #include <assert.h>
 
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/histogram.h"
+
 #include "job.h"
 #include "event.h"
 
@@ -94,6 +97,7 @@ struct start {
     struct job_manager *ctx;
     flux_msg_handler_t **handlers;
     char *topic;
+    struct histogram *alloc_start; // usec, alloc response to start response
 };
 
 static void hello_cb (flux_t *h, flux_msg_handler_t *mh,
@@ -198,6 +202,10 @@ static void start_response_cb (flux_t *h, flux_msg_handler_t *mh,
         goto error;
     }
     if (!strcmp (type, "start")) {
+        if (monotime_isset (job->t_alloc)) {
+            (void)histogram_add (start->alloc_start,
+                                 monotime_since (job->t_alloc) * 1000);
+        }
         if (event_job_post_pack (ctx->event, job, "start", NULL) < 0)
             goto error_post;
     }
@@ -296,6 +304,7 @@ void start_ctx_destroy (struct start *start)
     if (start) {
         int saved_errno = errno;;
         flux_msg_handler_delvec (start->handlers);
+        histogram_destroy (start->alloc_start);
         free (start->topic);
         free (start);
         errno = saved_errno;
@@ -315,6 +324,8 @@ struct start *start_ctx_create (struct job_manager *ctx)
     if (!(start = calloc (1, sizeof (*start))))
         return NULL;
     start->ctx = ctx;
+    if (!(start->alloc_start = histogram_create ()))
+        goto error;
     if (flux_msg_handler_addvec (ctx->h, htab, ctx, &start->handlers) < 0)
         goto error;
     return start;
@@ -323,6 +334,21 @@ error:
     return NULL;
 }
 
+json_t *start_get_stats (struct start *start)
+{
+    json_t *alloc_start;
+    json_t *o;
+
+    if (!(alloc_start = histogram_encode (start->alloc_start)))
+        return NULL;
+    if (!(o = json_pack ("{s:o}", "alloc-start", alloc_start))) {
+        json_decref (alloc_start);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return o;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
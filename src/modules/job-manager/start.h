@@ -12,6 +12,7 @@
 #define _FLUX_JOB_MANAGER_START_H
 
 #include <flux/core.h>
+#include <jansson.h>
 
 #include "job-manager.h"
 
@@ -20,6 +21,12 @@ void start_ctx_destroy (struct start *start);
 
 int start_send_request (struct start *start, struct job *job);
 
+/* Return latency histograms (usec) of the start path as a JSON object:
+ *   "alloc-start": alloc response from scheduler to start response
+ * Returns NULL on failure with errno set.
+ */
+json_t *start_get_stats (struct start *start);
+
 #endif /* ! _FLUX_JOB_MANAGER_START_H */
 
 /*
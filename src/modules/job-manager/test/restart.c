@@ -9,12 +9,59 @@
 \************************************************************/
 
 #include <jansson.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "src/common/libtap/tap.h"
 
 #include "src/modules/job-manager/job.h"
 #include "src/modules/job-manager/restart.h"
 
+void test_jobs_codec (void)
+{
+    flux_jobid_t ids[] = { 1, 42, 0x123456789abcdef0ULL };
+    flux_jobid_t *nids;
+    flux_jobid_t max_jobid;
+    int count;
+    uint8_t *buf;
+    int size;
+
+    buf = restart_jobs_encode (99, ids, 3, &size);
+    ok (buf != NULL && size == 20 + 3 * 8,
+        "restart_jobs_encode works");
+    nids = NULL;
+    ok (restart_jobs_decode (buf, size, &max_jobid, &nids, &count) == 0
+        && max_jobid == 99
+        && count == 3
+        && nids[0] == 1 && nids[1] == 42 && nids[2] == ids[2],
+        "restart_jobs_decode works");
+    free (nids);
+
+    errno = 0;
+    ok (restart_jobs_decode (buf, size - 1, &max_jobid, &nids, &count) < 0
+        && errno == EINVAL,
+        "restart_jobs_decode fails with EINVAL on truncated buffer");
+    buf[0] ^= 0xff;
+    errno = 0;
+    ok (restart_jobs_decode (buf, size, &max_jobid, &nids, &count) < 0
+        && errno == EINVAL,
+        "restart_jobs_decode fails with EINVAL on bad magic");
+    free (buf);
+
+    buf = restart_jobs_encode (0, NULL, 0, &size);
+    ok (buf != NULL && size == 20,
+        "restart_jobs_encode count=0 works");
+    nids = ids;
+    ok (restart_jobs_decode (buf, size, &max_jobid, &nids, &count) == 0
+        && max_jobid == 0 && count == 0 && nids == NULL,
+        "restart_jobs_decode count=0 works");
+    free (buf);
+
+    errno = 0;
+    ok (restart_jobs_encode (0, NULL, 1, &size) == NULL && errno == EINVAL,
+        "restart_jobs_encode ids=NULL count=1 fails with EINVAL");
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -30,6 +77,8 @@ int main (int argc, char *argv[])
     ok (restart_count_char (".a.b.c.", '/') == 0,
         "restart_count_char s=.a.b.c. c=. returns 4");
 
+    test_jobs_codec ();
+
     done_testing ();
 }
 
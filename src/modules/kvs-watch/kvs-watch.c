@@ -20,6 +20,7 @@
 #include "src/common/libkvs/treeobj.h"
 #include "src/common/libkvs/kvs_util_private.h"
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/errno_safe.h"
 
 /* State for one watcher */
 struct watcher {
@@ -32,6 +33,7 @@ struct watcher {
     bool initial_rpc_sent;      // flag is initial watch rpc sent
     bool initial_rpc_received;  // flag is initial watch rpc received
     bool finished;              // flag indicates if watcher is finished
+    bool rawval;                // requestor accepts raw value responses
     int initial_rootseq;        // initial rootseq returned by initial rpc
     char *key;                  // lookup key
     int flags;                  // kvs_lookup flags
@@ -40,6 +42,16 @@ struct watcher {
     struct ns_monitor *nsm;     // back pointer for removal
     json_t *prev;               // previous watch value for KVS_WATCH_FULL/UNIQ
     int append_offset;          // offset for KVS_WATCH_APPEND
+    json_t *append_valref;      // last valref sent for KVS_WATCH_APPEND
+};
+
+/* State for a content load issued on behalf of a KVS_WATCH_APPEND
+ * watcher, attached to the load future as "append-load".
+ */
+struct append_load {
+    int start;                  // index of first blobref loaded
+    int count;                  // total blobrefs in valref
+    json_t *valref;             // valref the blobrefs were taken from
 };
 
 /* Current KVS root.
@@ -89,6 +101,7 @@ static void watcher_destroy (struct watcher *w)
             zlist_destroy (&w->lookups);
         }
         json_decref (w->prev);
+        json_decref (w->append_valref);
         free (w);
         errno = saved_errno;
     }
@@ -98,6 +111,7 @@ static struct watcher *watcher_create (const flux_msg_t *msg, const char *key,
                                        int flags)
 {
     struct watcher *w;
+    int rawval = 0;
 
     if (!(w = calloc (1, sizeof (*w))))
         return NULL;
@@ -110,6 +124,8 @@ static struct watcher *watcher_create (const flux_msg_t *msg, const char *key,
         goto error_nomem;
     w->flags = flags;
     w->rootseq = -1;
+    (void)flux_request_unpack (msg, NULL, "{s:b}", "rawval", &rawval);
+    w->rawval = rawval ? true : false;
     return w;
 error_nomem:
     errno = ENOMEM;
@@ -237,26 +253,68 @@ static void watcher_cleanup (struct ns_monitor *nsm, struct watcher *w)
         zhash_delete (nsm->ctx->namespaces, nsm->ns_name);
 }
 
+static int handle_append_treeobj (flux_t *h,
+                                  struct watcher *w,
+                                  json_t *treeobj,
+                                  const char *rootref,
+                                  int root_seq);
+
+/* Respond to watcher with value 'data', as raw bytes if the requestor
+ * accepts them (see kvs_rawval_encode()), otherwise as a treeobj val.
+ */
+static int respond_val (flux_t *h,
+                        struct watcher *w,
+                        const void *data,
+                        int len)
+{
+    int rc = -1;
+
+    if (w->rawval) {
+        json_t *o;
+        void *payload = NULL;
+        int size;
+
+        if (!(o = json_object ())) {
+            errno = ENOMEM;
+            goto done;
+        }
+        if ((payload = kvs_rawval_encode (o, data, len, &size)))
+            rc = flux_respond_raw (h, w->request, payload, size);
+        ERRNO_SAFE_WRAP (free, payload);
+        ERRNO_SAFE_WRAP (json_decref, o);
+    }
+    else {
+        json_t *val;
+
+        if (!(val = treeobj_create_val (data, len)))
+            goto done;
+        if ((rc = flux_respond_pack (h, w->request, "{ s:o }",
+                                     "val", val)) < 0)
+            ERRNO_SAFE_WRAP (json_decref, val);
+    }
+done:
+    if (rc < 0)
+        flux_log_error (h, "%s: respond", __FUNCTION__);
+    return rc;
+}
+
 static int handle_initial_response (flux_t *h,
                                     struct watcher *w,
                                     json_t *val,
+                                    const char *rootref,
                                     int root_seq)
 {
+    if ((w->flags & FLUX_KVS_WATCH_APPEND)) {
+        w->initial_rootseq = root_seq;
+        return handle_append_treeobj (h, w, val, rootref, root_seq);
+    }
+
     /* this is the first response case, store the first response
      * val */
     if ((w->flags & FLUX_KVS_WATCH_FULL)
         || (w->flags & FLUX_KVS_WATCH_UNIQ))
         w->prev = json_incref (val);
 
-    if ((w->flags & FLUX_KVS_WATCH_APPEND)) {
-        if (treeobj_decode_val (val,
-                                NULL,
-                                &w->append_offset) < 0) {
-            flux_log_error (h, "%s: treeobj_decode_val", __FUNCTION__);
-            return -1;
-        }
-    }
-
     if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
         return -1;
@@ -325,7 +383,6 @@ static int handle_append_response (flux_t *h,
         w->responded = true;
     }
     else {
-        json_t *new_val = NULL;
         void *new_data = NULL;
         int new_offset;
 
@@ -349,22 +406,236 @@ static int handle_append_response (flux_t *h,
             return -1;
         }
 
-        if (!(new_val = treeobj_create_val (new_data + w->append_offset,
-                                            new_offset - w->append_offset))) {
-            free (new_data);
+        if (respond_val (h,
+                         w,
+                         (char *)new_data + w->append_offset,
+                         new_offset - w->append_offset) < 0) {
+            ERRNO_SAFE_WRAP (free, new_data);
             return -1;
         }
 
         free (new_data);
         w->append_offset = new_offset;
+    }
 
-        if (flux_respond_pack (h, w->request, "{ s:o }", "val", new_val) < 0) {
-            json_decref (new_val);
-            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    return 0;
+}
+
+static void lookup_continuation (flux_future_t *f, void *arg);
+static flux_future_t *lookupat (flux_t *h,
+                                struct watcher *w,
+                                const char *blobref,
+                                int root_seq,
+                                const char *ns,
+                                int flags);
+
+/* Insert future 'f' at the head of w->lookups, ahead of the lookups
+ * for any later commits, so that it is handled next.
+ */
+static int lookup_push (struct watcher *w, flux_future_t *f)
+{
+    if (zlist_push (w->lookups, f) < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (flux_future_then (f, -1., lookup_continuation, w) < 0) {
+        zlist_remove (w->lookups, f);
+        return -1;
+    }
+    return 0;
+}
+
+static void append_load_destroy (struct append_load *al)
+{
+    if (al) {
+        int saved_errno = errno;
+        json_decref (al->valref);
+        free (al);
+        errno = saved_errno;
+    }
+}
+
+/* Load blobrefs [start, count) of 'valref' from the content store.
+ */
+static flux_future_t *append_load (flux_t *h,
+                                   json_t *valref,
+                                   int start,
+                                   int count)
+{
+    struct append_load *al;
+    const char **refs;
+    flux_future_t *f = NULL;
+    int saved_errno;
+    int i;
+
+    if (!(refs = calloc (count - start, sizeof (refs[0]))))
+        return NULL;
+    for (i = start; i < count; i++) {
+        if (!(refs[i - start] = treeobj_get_blobref (valref, i)))
+            goto done;
+    }
+    if (!(f = flux_content_load_batch (h, refs, count - start, 0)))
+        goto done;
+    if (!(al = calloc (1, sizeof (*al)))
+        || flux_future_aux_set (f,
+                                "append-load",
+                                al,
+                                (flux_free_f)append_load_destroy) < 0) {
+        append_load_destroy (al);
+        flux_future_destroy (f);
+        f = NULL;
+        goto done;
+    }
+    al->start = start;
+    al->count = count;
+    al->valref = json_incref (valref);
+done:
+    saved_errno = errno;
+    free (refs);
+    errno = saved_errno;
+    return f;
+}
+
+/* Return true if the blobrefs of 'prefix' are the leading blobrefs
+ * of 'valref'.
+ */
+static bool valref_has_prefix (const json_t *valref, const json_t *prefix)
+{
+    int count = treeobj_get_count (prefix);
+    int i;
+
+    if (count < 0 || treeobj_get_count (valref) < count)
+        return false;
+    for (i = 0; i < count; i++) {
+        const char *ref1 = treeobj_get_blobref (valref, i);
+        const char *ref2 = treeobj_get_blobref (prefix, i);
+        if (!ref1 || !ref2 || strcmp (ref1, ref2) != 0)
+            return false;
+    }
+    return true;
+}
+
+/* FLUX_KVS_WATCH_APPEND lookups return the tree object rather than the
+ * value (FLUX_KVS_TREEOBJ), so that only the blobrefs appended since the
+ * last response need be loaded, and the cost of a watch response scales
+ * with the size of the append rather than the size of the value.
+ * The load is pushed onto the head of w->lookups and handled in
+ * handle_append_load_response() once it completes.
+ */
+static int handle_append_treeobj (flux_t *h,
+                                  struct watcher *w,
+                                  json_t *treeobj,
+                                  const char *rootref,
+                                  int root_seq)
+{
+    flux_future_t *f;
+
+    if (treeobj_is_val (treeobj)) {
+        if (handle_append_response (h, w, treeobj) < 0)
+            return -1;
+        json_decref (w->append_valref);
+        w->append_valref = NULL;
+        return 0;
+    }
+    else if (treeobj_is_valref (treeobj)) {
+        int count = treeobj_get_count (treeobj);
+        int start = 0;
+
+        /* An append only adds blobrefs, so if those already sent are
+         * not a prefix of the new valref, the key was overwritten.
+         * If the last response was not from a valref (e.g. the key
+         * held a val), load all blobs and fall back to comparing
+         * offsets, as handle_append_response() does.
+         */
+        if (w->responded && w->append_valref) {
+            if (!valref_has_prefix (treeobj, w->append_valref)) {
+                errno = EINVAL;
+                return -1;
+            }
+            start = treeobj_get_count (w->append_valref);
+        }
+        if (start == count)
+            return respond_val (h, w, NULL, 0);
+        if (!(f = append_load (h, treeobj, start, count)))
+            return -1;
+    }
+    else if (treeobj_is_symlink (treeobj)) {
+        /* FLUX_KVS_TREEOBJ does not follow a symlink in the last path
+         * component, so look up the value itself at the same root.
+         */
+        if (!(f = lookupat (h, w, rootref, root_seq, NULL, w->flags)))
+            return -1;
+        if (flux_future_aux_set (f, "append-value", f, NULL) < 0) {
+            flux_future_destroy (f);
             return -1;
         }
     }
+    else {
+        errno = EISDIR;
+        return -1;
+    }
+    if (lookup_push (w, f) < 0) {
+        flux_future_destroy (f);
+        return -1;
+    }
+    return 0;
+}
 
+/* Blobs requested by append_load() are available in future 'f'.
+ * Respond with their concatenation, which is the whole value if this
+ * is the first response, or the newly appended data otherwise.
+ */
+static int handle_append_load_response (flux_t *h,
+                                        struct watcher *w,
+                                        flux_future_t *f)
+{
+    struct append_load *al = flux_future_aux_get (f, "append-load");
+    char *data = NULL;
+    int len = 0;
+    int offset = 0;
+    int i;
+
+    for (i = 0; i < al->count - al->start; i++) {
+        const void *buf;
+        int size;
+        if (flux_content_load_batch_get (f, i, &buf, &size) < 0)
+            return -1;
+        len += size;
+    }
+    if (!(data = malloc (len > 0 ? len : 1)))
+        return -1;
+    for (i = 0; i < al->count - al->start; i++) {
+        const void *buf;
+        int size;
+        (void)flux_content_load_batch_get (f, i, &buf, &size);
+        memcpy (data + offset, buf, size);
+        offset += size;
+    }
+    if (w->responded && al->start == 0) {
+        /* key was overwritten, see handle_append_response() */
+        if (len < w->append_offset) {
+            free (data);
+            errno = EINVAL;
+            return -1;
+        }
+        offset = w->append_offset;
+        w->append_offset = len;
+    }
+    else {
+        offset = 0;
+        if (!w->responded)
+            w->append_offset = len;
+        else
+            w->append_offset += len;
+    }
+    json_decref (w->append_valref);
+    w->append_valref = json_incref (al->valref);
+    if (respond_val (h, w, data + offset, len - offset) < 0) {
+        ERRNO_SAFE_WRAP (free, data);
+        return -1;
+    }
+    free (data);
+    w->responded = true;
     return 0;
 }
 
@@ -381,12 +652,30 @@ static int handle_normal_response (flux_t *h,
     return 0;
 }
 
+/* Decode a kvs.lookup-plus response, which carries the value as raw
+ * bytes if it was requested by lookupat() and the value is a valref.
+ */
+static int lookup_plus_decode (flux_future_t *f,
+                               json_t **op,
+                               const void **data,
+                               int *len)
+{
+    const void *payload;
+    int size;
+
+    if (flux_rpc_get_raw (f, &payload, &size) < 0)
+        return -1;
+    return kvs_rawval_decode (payload, size, op, data, len);
+}
+
 /* New value of key is available in future 'f' container.
  * Send response to watcher using raw payload from lookup response.
  * Return 0 on success, -1 on error (caller should destroy watcher).
  *
  * Special handling done for FLUX_KVS_WATCH_FULL/UNIQ/APPEND, must do
- * some comparisons before returning.
+ * some comparisons before returning.  For FLUX_KVS_WATCH_APPEND, 'f' may
+ * also be a content load or a value lookup issued by
+ * handle_append_treeobj().
  */
 static void handle_lookup_response (flux_future_t *f,
                                     struct watcher *w)
@@ -394,29 +683,34 @@ static void handle_lookup_response (flux_future_t *f,
     flux_t *h = flux_future_get_flux (f);
     int errnum;
     int root_seq;
-    json_t *val;
-
-    if (flux_future_aux_get (f, "initial")) {
-
-        w->initial_rpc_received = true;
+    const char *rootref;
+    json_t *val = NULL;
+    json_t *o = NULL;
+    const void *data;
+    int len;
 
-        /* First check for ENOENT */
-        if (!flux_rpc_get_unpack (f, "{ s:i s:i }",
-                                  "errno", &errnum,
-                                  "rootseq", &root_seq)) {
-            assert (errnum == ENOENT);
-            if ((w->flags & FLUX_KVS_WAITCREATE)
-                && w->responded == false) {
-                w->initial_rootseq = root_seq;
-                return;
-            }
-            errno = errnum;
+    if (flux_future_aux_get (f, "append-load")) {
+        if (!w->mute && handle_append_load_response (h, w, f) < 0)
+            goto error;
+    }
+    else if (flux_future_aux_get (f, "append-value")) {
+        if (w->mute)
+            return;
+        if (flux_rpc_get_unpack (f, "{ s:o }", "val", &val) < 0) {
+            if (!flux_rpc_get_unpack (f, "{ s:i }", "errno", &errnum))
+                errno = errnum;
             goto error;
         }
+        if (handle_append_response (h, w, val) < 0)
+            goto error;
+        json_decref (w->append_valref);
+        w->append_valref = NULL;
+    }
+    else if (flux_future_aux_get (f, "initial")) {
 
-        if (flux_rpc_get_unpack (f, "{ s:o s:i }",
-                                 "val", &val,
-                                 "rootseq", &root_seq) < 0) {
+        w->initial_rpc_received = true;
+
+        if (lookup_plus_decode (f, &o, &data, &len) < 0) {
             /* It is worth mentioning ENOTSUP error conditions here.
              *
              * Recall that in namespace_monitor(), an initial getroot
@@ -437,37 +731,76 @@ static void handle_lookup_response (flux_future_t *f,
             goto error;
         }
 
-        if (handle_initial_response (h, w, val, root_seq) < 0)
+        /* First check for ENOENT */
+        if (!json_unpack (o, "{ s:i s:i }",
+                          "errno", &errnum,
+                          "rootseq", &root_seq)) {
+            assert (errnum == ENOENT);
+            if ((w->flags & FLUX_KVS_WAITCREATE)
+                && w->responded == false) {
+                w->initial_rootseq = root_seq;
+                goto done;
+            }
+            errno = errnum;
+            goto error;
+        }
+
+        if (json_unpack (o, "{ s:i s:s }",
+                         "rootseq", &root_seq,
+                         "rootref", &rootref) < 0
+            || (!data && json_unpack (o, "{ s:o }", "val", &val) < 0)) {
+            errno = EPROTO;
+            goto error;
+        }
+
+        if (data) {
+            w->initial_rootseq = root_seq;
+            if (respond_val (h, w, data, len) < 0)
+                goto error;
+            w->responded = true;
+        }
+        else if (handle_initial_response (h, w, val, rootref, root_seq) < 0)
             goto error;
     }
     else {
+        if (lookup_plus_decode (f, &o, &data, &len) < 0)
+            goto error;
+
         /* First check for ENOENT */
-        if (!flux_rpc_get_unpack (f, "{ s:i s:i }",
-                                  "errno", &errnum,
-                                  "rootseq", &root_seq)) {
+        if (!json_unpack (o, "{ s:i s:i }",
+                          "errno", &errnum,
+                          "rootseq", &root_seq)) {
             assert (errnum == ENOENT);
             errno = errnum;
             goto error;
         }
 
-        if (flux_rpc_get_unpack (f, "{ s:o s:i }",
-                                 "val", &val,
-                                 "rootseq", &root_seq) < 0)
+        if (json_unpack (o, "{ s:i s:s }",
+                         "rootseq", &root_seq,
+                         "rootref", &rootref) < 0
+            || (!data && json_unpack (o, "{ s:o }", "val", &val) < 0)) {
+            errno = EPROTO;
             goto error;
+        }
 
         /* if we got some setroots before the initial rpc returned,
          * toss them */
         if (root_seq <= w->initial_rootseq)
-            return;
+            goto done;
 
         if (!w->mute) {
-            if ((w->flags & FLUX_KVS_WATCH_FULL)
+            if (data) {
+                if (respond_val (h, w, data, len) < 0)
+                    goto error;
+                w->responded = true;
+            }
+            else if ((w->flags & FLUX_KVS_WATCH_FULL)
                 || (w->flags & FLUX_KVS_WATCH_UNIQ)) {
                 if (handle_compare_response (h, w, val) < 0)
                     goto error;
             }
             else if (w->flags & FLUX_KVS_WATCH_APPEND) {
-                if (handle_append_response (h, w, val) < 0)
+                if (handle_append_treeobj (h, w, val, rootref, root_seq) < 0)
                     goto error;
             }
             else {
@@ -476,12 +809,15 @@ static void handle_lookup_response (flux_future_t *f,
             }
         }
     }
+done:
+    json_decref (o);
     return;
 error:
     if (!w->mute) {
         if (flux_respond_error (h, w->request, errno, NULL) < 0)
             flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
     }
+    json_decref (o);
     w->finished = true;
 }
 
@@ -524,30 +860,43 @@ static flux_future_t *lookupat (flux_t *h,
                                 struct watcher *w,
                                 const char *blobref,
                                 int root_seq,
-                                const char *ns)
+                                const char *ns,
+                                int flags)
 {
     flux_msg_t *msg;
     json_t *o = NULL;
     flux_future_t *f;
+    int rawval;
     int saved_errno;
 
+    /* A value that is passed through to the watcher unmodified may be
+     * requested as raw bytes, if the watcher accepts them too.
+     */
+    rawval = w->rawval
+             && !(flags & (FLUX_KVS_TREEOBJ
+                           | FLUX_KVS_WATCH_FULL
+                           | FLUX_KVS_WATCH_UNIQ
+                           | FLUX_KVS_WATCH_APPEND));
+
     if (!(msg = flux_request_encode ("kvs.lookup-plus", NULL)))
         return NULL;
     if (!w->initial_rpc_sent) {
-        if (flux_msg_pack (msg, "{s:s s:s s:i}",
+        if (flux_msg_pack (msg, "{s:s s:s s:i s:b}",
                            "key", w->key,
                            "namespace", ns,
-                           "flags", w->flags) < 0)
+                           "flags", flags,
+                           "rawval", rawval) < 0)
             goto error;
     }
     else {
         if (!(o = treeobj_create_dirref (blobref)))
             goto error;
-        if (flux_msg_pack (msg, "{s:s s:i s:i s:O}",
+        if (flux_msg_pack (msg, "{s:s s:i s:i s:O s:b}",
                            "key", w->key,
-                           "flags", w->flags,
+                           "flags", flags,
                            "rootseq", root_seq,
-                           "rootdir", o) < 0)
+                           "rootdir", o,
+                           "rawval", rawval) < 0)
             goto error;
     }
     /* N.B. Since this module is authenticated to the shmem:// connector
@@ -582,11 +931,18 @@ error:
 static int process_lookup_response (struct ns_monitor *nsm, struct watcher *w)
 {
     flux_future_t *f;
+    int flags = w->flags;
+
+    /* See handle_append_treeobj() */
+    if ((w->flags & FLUX_KVS_WATCH_APPEND))
+        flags |= FLUX_KVS_TREEOBJ;
+
     if (!(f = lookupat (nsm->ctx->h,
                         w,
                         nsm->commit->rootref,
                         nsm->commit->rootseq,
-                        nsm->ns_name))) {
+                        nsm->ns_name,
+                        flags))) {
         flux_log_error (nsm->ctx->h, "%s: lookupat", __FUNCTION__);
         return -1;
     }
@@ -50,12 +50,32 @@ struct cache_entry {
     int errnum;
     char *blobref;
     int refcount;
+    struct cache *cache;    /* set when inserted in a cache */
+    struct cache_entry *lru_prev;
+    struct cache_entry *lru_next;
 };
 
+/* Entries are kept on a doubly linked list in order of last use, most
+ * recently used first, so expiration can work from the tail and stop
+ * early instead of visiting every entry.
+ */
 struct cache {
     zhashx_t *zhx;
+    struct cache_entry *lru_first;
+    struct cache_entry *lru_last;
+    size_t size;            /* total size of valid entry data */
+    size_t max_size;        /* 0 = unlimited */
+    int evictions;          /* entries removed to stay within max_size */
 };
 
+/* Maximum number of expirable entries examined per call to
+ * cache_expire_entries() or cache_trim(), to bound the work done on each
+ * heartbeat or load.  Pinned entries (dirty, incomplete, or referenced)
+ * are skipped without counting against the limit, so a run of them at
+ * the tail of the LRU list cannot stop eviction.
+ */
+static const int cache_scan_max = 1024;
+
 struct cache_entry *cache_entry_create (const char *ref)
 {
     struct cache_entry *entry;
@@ -188,12 +208,16 @@ int cache_entry_set_raw (struct cache_entry *entry, const void *data, int len)
     entry->data = cpy;
     entry->len = len;
     entry->valid = true;
+    if (entry->cache)
+        entry->cache->size += len;
     if (entry->waitlist_valid) {
         if (wait_runqueue (entry->waitlist_valid) < 0)
             goto reset_invalid;
     }
     return 0;
 reset_invalid:
+    if (entry->cache)
+        entry->cache->size -= len;
     free (entry->data);
     entry->data = NULL;
     entry->len = 0;
@@ -299,12 +323,42 @@ int cache_entry_wait_valid (struct cache_entry *entry, wait_t *wait)
     return 0;
 }
 
+static void lru_remove (struct cache *cache, struct cache_entry *entry)
+{
+    if (entry->lru_prev)
+        entry->lru_prev->lru_next = entry->lru_next;
+    else
+        cache->lru_first = entry->lru_next;
+    if (entry->lru_next)
+        entry->lru_next->lru_prev = entry->lru_prev;
+    else
+        cache->lru_last = entry->lru_prev;
+    entry->lru_prev = entry->lru_next = NULL;
+}
+
+static void lru_push (struct cache *cache, struct cache_entry *entry)
+{
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_first;
+    if (cache->lru_first)
+        cache->lru_first->lru_prev = entry;
+    else
+        cache->lru_last = entry;
+    cache->lru_first = entry;
+}
+
 struct cache_entry *cache_lookup (struct cache *cache, const char *ref,
                                   int current_epoch)
 {
     struct cache_entry *entry = zhashx_lookup (cache->zhx, ref);
-    if (entry && current_epoch > entry->lastuse_epoch)
-        entry->lastuse_epoch = current_epoch;
+    if (entry) {
+        if (current_epoch > entry->lastuse_epoch)
+            entry->lastuse_epoch = current_epoch;
+        if (cache->lru_first != entry) {
+            lru_remove (cache, entry);
+            lru_push (cache, entry);
+        }
+    }
     return entry;
 }
 
@@ -315,6 +369,10 @@ int cache_insert (struct cache *cache, struct cache_entry *entry)
     if (cache && entry) {
         rc = zhashx_insert (cache->zhx, entry->blobref, entry);
         assert (rc == 0);
+        entry->cache = cache;
+        if (entry->valid)
+            cache->size += entry->len;
+        lru_push (cache, entry);
     }
     return 0;
 }
@@ -344,41 +402,108 @@ static int cache_entry_age (struct cache_entry *entry, int current_epoch)
 {
     if (!entry)
         return -1;
-    if (entry->lastuse_epoch == 0)
-        entry->lastuse_epoch = current_epoch;
     return current_epoch - entry->lastuse_epoch;
 }
 
-int cache_expire_entries (struct cache *cache, int current_epoch, int thresh)
+static bool cache_over_max_size (struct cache *cache)
 {
-    zlistx_t *keys;
-    char *ref;
-    struct cache_entry *entry;
+    return (cache->max_size > 0 && cache->size > cache->max_size);
+}
+
+/* Walk the LRU list from the least recently used end, removing entries
+ * that are not dirty, not incomplete, and not referenced, if the cache
+ * is over its size limit, or if 'thresh' is zero, or if the entry was
+ * last used more than 'thresh' epochs ago.  A negative 'thresh' disables
+ * age based expiration.  Stop after 'scan_max' expirable entries
+ * (0 = no limit) or at the first entry too young to expire once within
+ * the size limit, since all entries after it were used more recently.
+ */
+static int cache_expire (struct cache *cache,
+                         int current_epoch,
+                         int thresh,
+                         int scan_max)
+{
+    struct cache_entry *entry = cache->lru_last;
+    int scanned = 0;
     int count = 0;
 
-    /* Do not use zhashx_first()/zhashx_next() or FOREACH_ZHASHX, as
-     * zhashx_delete() call below modifies hash */
-    if (!(keys = zhashx_keys (cache->zhx))) {
-        errno = ENOMEM;
-        return -1;
-    }
-    ref = zlistx_first (keys);
-    while (ref) {
-        if ((entry = zhashx_lookup (cache->zhx, ref))
+    while (entry && (scan_max == 0 || scanned < scan_max)) {
+        struct cache_entry *prev = entry->lru_prev;
+        bool over = cache_over_max_size (cache);
+
+        if (!over && thresh < 0)
+            break;
+        if (cache_entry_get_valid (entry)
             && !cache_entry_get_dirty (entry)
-            && cache_entry_get_valid (entry)
-            && !entry->refcount
-            && (thresh == 0
-                || cache_entry_age (entry, current_epoch) > thresh)) {
-                zhashx_delete (cache->zhx, ref);
+            && !entry->refcount) {
+            scanned++;
+            if (over || thresh == 0) {
+                if (over && thresh != 0)
+                    cache->evictions++;
+                zhashx_delete (cache->zhx, entry->blobref);
+                count++;
+            }
+            else if (entry->lastuse_epoch == 0) {
+                /* Never looked up, so treat as used now.
+                 */
+                entry->lastuse_epoch = current_epoch;
+                lru_remove (cache, entry);
+                lru_push (cache, entry);
+            }
+            else if (cache_entry_age (entry, current_epoch) > thresh) {
+                zhashx_delete (cache->zhx, entry->blobref);
                 count++;
+            }
+            else
+                break;
         }
-        ref = zlistx_next (keys);
+        entry = prev;
     }
-    zlistx_destroy (&keys);
     return count;
 }
 
+int cache_expire_entries (struct cache *cache, int current_epoch, int thresh)
+{
+    if (!cache || thresh < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return cache_expire (cache,
+                         current_epoch,
+                         thresh,
+                         thresh == 0 ? 0 : cache_scan_max);
+}
+
+int cache_trim (struct cache *cache)
+{
+    if (!cache) {
+        errno = EINVAL;
+        return -1;
+    }
+    return cache_expire (cache, 0, -1, cache_scan_max);
+}
+
+void cache_set_max_size (struct cache *cache, size_t max_size)
+{
+    if (cache)
+        cache->max_size = max_size;
+}
+
+size_t cache_get_max_size (struct cache *cache)
+{
+    return cache ? cache->max_size : 0;
+}
+
+size_t cache_get_size (struct cache *cache)
+{
+    return cache ? cache->size : 0;
+}
+
+int cache_count_evictions (struct cache *cache)
+{
+    return cache ? cache->evictions : 0;
+}
+
 int cache_get_stats (struct cache *cache, tstat_t *ts, int *sizep,
                      int *incompletep, int *dirtyp)
 {
@@ -440,11 +565,21 @@ const char *cache_entry_get_blobref (struct cache_entry *entry)
     return entry ? entry->blobref : NULL;
 }
 
+/* Called when an entry is removed from the hash, so also remove it
+ * from the LRU list and its data from the cache size.
+ */
 static void cache_entry_destroy_wrapper (void **arg)
 {
     struct cache_entry **entry = (struct cache_entry **)arg;
-    if (entry)
+    if (entry && *entry) {
+        struct cache *cache = (*entry)->cache;
+        if (cache) {
+            if ((*entry)->valid)
+                cache->size -= (*entry)->len;
+            lru_remove (cache, *entry);
+        }
         cache_entry_destroy (*entry);
+    }
 }
 
 struct cache *cache_create (void)
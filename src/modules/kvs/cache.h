@@ -116,7 +116,8 @@ void cache_destroy (struct cache *cache);
 
 /* Look up a cache entry.
  * Update the entry's "last used" time to 'current_epoch',
- * taking care not to not run backwards.
+ * taking care not to not run backwards, and make it the most
+ * recently used entry.
  */
 struct cache_entry *cache_lookup (struct cache *cache,
                                   const char *ref, int current_epoch);
@@ -137,12 +138,39 @@ int cache_remove_entry (struct cache *cache, const char *ref);
  */
 int cache_count_entries (struct cache *cache);
 
-/* Expire cache entries that are not dirty, not incomplete, and last
- * used more than 'thresh' epoch's ago.
+/* Expire cache entries that are not dirty, not incomplete, not
+ * referenced, and last used more than 'thresh' epoch's ago, or if
+ * 'thresh' is 0, all such entries.  If the cache is over its size limit,
+ * least recently used entries are also removed until it is within it.
+ * Unless 'thresh' is 0, a bounded number of entries is examined per
+ * call, starting with the least recently used.
  * Returns -1 on error, expired count on success.
  */
 int cache_expire_entries (struct cache *cache, int current_epoch, int thresh);
 
+/* Remove least recently used entries that are not dirty, not incomplete,
+ * and not referenced until the cache is within its size limit, examining
+ * a bounded number of entries.
+ * Returns -1 on error, removed count on success.
+ */
+int cache_trim (struct cache *cache);
+
+/* Get/set the limit on the total size of cache entry data, in bytes.
+ * The limit is enforced by cache_expire_entries() and cache_trim(),
+ * not on insert, so it may be exceeded temporarily, or if entries
+ * cannot be removed.  0 (the default) means no limit.
+ */
+void cache_set_max_size (struct cache *cache, size_t max_size);
+size_t cache_get_max_size (struct cache *cache);
+
+/* Return the total size of cache entry data, in bytes.
+ */
+size_t cache_get_size (struct cache *cache);
+
+/* Return the number of entries removed to stay within the size limit.
+ */
+int cache_count_evictions (struct cache *cache);
+
 /* Obtain statistics on the cache.
  * Returns -1 on error, 0 on success
  */
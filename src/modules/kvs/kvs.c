@@ -19,6 +19,7 @@
 #include <libgen.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <stdarg.h>
 #include <sys/time.h>
 #include <czmq.h>
 #include <flux/core.h>
@@ -27,6 +28,8 @@
 #include "src/common/libutil/blobref.h"
 #include "src/common/libutil/monotime.h"
 #include "src/common/libutil/tstat.h"
+#include "src/common/libutil/histogram.h"
+#include "src/common/libutil/errno_safe.h"
 #include "src/common/libkvs/treeobj.h"
 #include "src/common/libkvs/kvs_txn_private.h"
 #include "src/common/libkvs/kvs_util_private.h"
@@ -44,6 +47,12 @@
  */
 const int max_lastuse_age = 5;
 
+/* Limit the total size of cached objects, evicting least recently used
+ * objects beyond it.  This may be overridden with the cache-max-size
+ * module option (0 = unlimited).
+ */
+const size_t default_cache_max_size = 256 * 1024 * 1024;
+
 /* Expire namespaces after 'max_namespace_age' heartbeats.
  *
  * If heartbeats are the default of 2 seconds, 1000 heartbeats is
@@ -55,17 +64,28 @@ const int max_namespace_age = 1000;
  */
 const bool event_includes_rootdir = true;
 
+/* Maximum number of blobs per content.load-batch or content.store-batch
+ * request sent to the content cache.
+ */
+const int content_batch_limit = 256;
+
 typedef struct {
     struct cache *cache;    /* blobref => cache_entry */
     kvsroot_mgr_t *krm;
     int faults;                 /* for kvs.stats.get, etc. */
+    struct histogram *commit_latency;   /* usec, request to response */
+    struct histogram *lookup_latency;   /* usec, request to response */
     flux_t *h;
     uint32_t rank;
     int epoch;              /* tracks current heartbeat epoch */
     flux_watcher_t *prep_w;
     flux_watcher_t *idle_w;
     flux_watcher_t *check_w;
+    flux_watcher_t *content_prep_w; /* sends batched content requests */
+    zlist_t *load_batch;        /* blobrefs to load */
+    zlist_t *store_batch;       /* blobrefs of dirty entries to store */
     int transaction_merge;
+    int hdir_threshold;
     bool events_init;            /* flag */
     const char *hash_name;
     unsigned int seq;           /* for commit transactions */
@@ -85,6 +105,8 @@ static void transaction_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
 static void transaction_check_cb (flux_reactor_t *r, flux_watcher_t *w,
                                   int revents, void *arg);
 static void start_root_remove (kvs_ctx_t *ctx, const char *ns);
+static void content_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
+                             int revents, void *arg);
 
 /*
  * kvs_ctx_t functions
@@ -95,9 +117,16 @@ static void freectx (void *arg)
     if (ctx) {
         cache_destroy (ctx->cache);
         kvsroot_mgr_destroy (ctx->krm);
+        histogram_destroy (ctx->commit_latency);
+        histogram_destroy (ctx->lookup_latency);
         flux_watcher_destroy (ctx->prep_w);
         flux_watcher_destroy (ctx->check_w);
         flux_watcher_destroy (ctx->idle_w);
+        flux_watcher_destroy (ctx->content_prep_w);
+        if (ctx->load_batch)
+            zlist_destroy (&ctx->load_batch);
+        if (ctx->store_batch)
+            zlist_destroy (&ctx->store_batch);
         free (ctx);
     }
 }
@@ -127,10 +156,16 @@ static kvs_ctx_t *getctx (flux_t *h)
             saved_errno = ENOMEM;
             goto error;
         }
+        cache_set_max_size (ctx->cache, default_cache_max_size);
         if (!(ctx->krm = kvsroot_mgr_create (ctx->h, ctx))) {
             saved_errno = ENOMEM;
             goto error;
         }
+        if (!(ctx->commit_latency = histogram_create ())
+            || !(ctx->lookup_latency = histogram_create ())) {
+            saved_errno = ENOMEM;
+            goto error;
+        }
         ctx->h = h;
         if (flux_get_rank (h, &ctx->rank) < 0) {
             saved_errno = errno;
@@ -155,7 +190,22 @@ static kvs_ctx_t *getctx (flux_t *h)
             flux_watcher_start (ctx->prep_w);
             flux_watcher_start (ctx->check_w);
         }
+        ctx->content_prep_w = flux_prepare_watcher_create (r,
+                                                           content_prep_cb,
+                                                           ctx);
+        if (!ctx->content_prep_w) {
+            saved_errno = errno;
+            goto error;
+        }
+        if (!(ctx->load_batch = zlist_new ())
+            || !(ctx->store_batch = zlist_new ())) {
+            saved_errno = ENOMEM;
+            goto error;
+        }
+        zlist_autofree (ctx->load_batch);
+        zlist_autofree (ctx->store_batch);
         ctx->transaction_merge = 1;
+        ctx->hdir_threshold = KVSTXN_HDIR_THRESHOLD;
         if (flux_aux_set (h, "kvssrv", ctx, freectx) < 0) {
             saved_errno = errno;
             goto error;
@@ -339,6 +389,7 @@ static void getroot_completion (flux_future_t *f, void *arg)
             flux_log_error (ctx->h, "%s: kvsroot_mgr_create_root", __FUNCTION__);
             goto error;
         }
+        kvstxn_mgr_set_hdir_threshold (root->ktm, ctx->hdir_threshold);
 
         if (event_subscribe (ctx, ns) < 0) {
             save_errno = errno;
@@ -468,6 +519,16 @@ static void content_load_cache_entry_error (kvs_ctx_t *ctx,
         flux_log (ctx->h, LOG_ERR, "%s: cache_remove_entry", __FUNCTION__);
 }
 
+/* Loaded objects add to the cache size, so evict least recently used
+ * objects if it is over its limit.  Waiters on the loaded objects have
+ * run by now, and any still using an object hold a reference on it.
+ */
+static void cache_trim_entries (kvs_ctx_t *ctx)
+{
+    if (cache_trim (ctx->cache) < 0)
+        flux_log_error (ctx->h, "%s: cache_trim", __FUNCTION__);
+}
+
 static void content_load_completion (flux_future_t *f, void *arg)
 {
     kvs_ctx_t *ctx = arg;
@@ -506,6 +567,7 @@ static void content_load_completion (flux_future_t *f, void *arg)
 
 done:
     flux_future_destroy (f);
+    cache_trim_entries (ctx);
 }
 
 /* Send content load request and setup contination to handle response.
@@ -541,6 +603,23 @@ error:
     return -1;
 }
 
+/* Content load and store requests are not sent immediately.  Instead,
+ * blobrefs are queued on ctx->load_batch or ctx->store_batch, and
+ * content_prep_cb() sends them in content.load-batch/content.store-batch
+ * requests of up to 'content_batch_limit' blobs, just before the reactor
+ * blocks.  Thus all the missing references or dirty cache entries of a
+ * transaction or lookup (or several of them) travel in one message.
+ */
+static int content_batch_add (kvs_ctx_t *ctx, zlist_t *batch, const char *ref)
+{
+    if (zlist_append (batch, (char *)ref) < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    flux_watcher_start (ctx->content_prep_w);
+    return 0;
+}
+
 /* Return 0 on success, -1 on error.  Set stall variable appropriately
  */
 static int load (kvs_ctx_t *ctx, const char *ref, wait_t *wait, bool *stall)
@@ -564,9 +643,9 @@ static int load (kvs_ctx_t *ctx, const char *ref, wait_t *wait, bool *stall)
             cache_entry_destroy (entry);
             return -1;
         }
-        if (content_load_request_send (ctx, ref) < 0) {
+        if (content_batch_add (ctx, ctx->load_batch, ref) < 0) {
             saved_errno = errno;
-            flux_log_error (ctx->h, "%s: content_load_request_send",
+            flux_log_error (ctx->h, "%s: content_batch_add",
                             __FUNCTION__);
             /* cache entry just created, should always work */
             ret = cache_remove_entry (ctx->cache, ref);
@@ -609,18 +688,20 @@ static int load (kvs_ctx_t *ctx, const char *ref, wait_t *wait, bool *stall)
  * store/write
  */
 
-static void content_store_completion (flux_future_t *f, void *arg)
+/* Handle the result of storing a dirty cache entry to the content store.
+ * 'cache_blobref' is the blobref of the cache entry, 'blobref' is the
+ * blobref returned by the content store, or NULL if errnum is nonzero.
+ */
+static void content_store_complete (kvs_ctx_t *ctx,
+                                    const char *cache_blobref,
+                                    const char *blobref,
+                                    int errnum)
 {
-    kvs_ctx_t *ctx = arg;
     struct cache_entry *entry;
-    const char *cache_blobref, *blobref;
     int ret;
 
-    cache_blobref = flux_future_aux_get (f, "cache_blobref");
-    assert (cache_blobref);
-
-    if (flux_content_store_get (f, &blobref) < 0) {
-        flux_log_error (ctx->h, "%s: flux_content_store_get", __FUNCTION__);
+    if (errnum != 0) {
+        errno = errnum;
         goto error;
     }
 
@@ -658,13 +739,9 @@ static void content_store_completion (flux_future_t *f, void *arg)
                         __FUNCTION__);
         goto error;
     }
-
-    flux_future_destroy (f);
     return;
 
 error:
-    flux_future_destroy (f);
-
     /* failure on store, inform all waiters, must destroy entry
      * afterwards, as future loads/stores may believe content is ok.
      * cache_remove_entry() will not work if a waiter is still there.
@@ -700,16 +777,40 @@ error:
         flux_log (ctx->h, LOG_ERR, "%s: cache_remove_entry", __FUNCTION__);
 }
 
+static void content_store_completion (flux_future_t *f, void *arg)
+{
+    kvs_ctx_t *ctx = arg;
+    const char *cache_blobref, *blobref = NULL;
+    int errnum = 0;
+
+    cache_blobref = flux_future_aux_get (f, "cache_blobref");
+    assert (cache_blobref);
+
+    if (flux_content_store_get (f, &blobref) < 0) {
+        flux_log_error (ctx->h, "%s: flux_content_store_get", __FUNCTION__);
+        errnum = errno;
+    }
+    content_store_complete (ctx, cache_blobref, blobref, errnum);
+    flux_future_destroy (f);
+}
+
 static int content_store_request_send (kvs_ctx_t *ctx, const char *blobref,
                                        const void *data, int len)
 {
     flux_future_t *f;
+    char *refcpy;
     int saved_errno, rc = -1;
 
     if (!(f = flux_content_store (ctx->h, data, len, 0)))
         goto error;
-    if (flux_future_aux_set (f, "cache_blobref", (void *)blobref, NULL) < 0) {
+    if (!(refcpy = strdup (blobref))) {
+        flux_future_destroy (f);
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_future_aux_set (f, "cache_blobref", refcpy, free) < 0) {
         saved_errno = errno;
+        free (refcpy);
         flux_future_destroy (f);
         errno = saved_errno;
         goto error;
@@ -726,6 +827,234 @@ error:
     return rc;
 }
 
+/* Batched load/store requests (see content_batch_add() above).
+ */
+
+static void refs_destroy (char **refs)
+{
+    if (refs) {
+        int saved_errno = errno;
+        int i;
+        for (i = 0; refs[i] != NULL; i++)
+            free (refs[i]);
+        free (refs);
+        errno = saved_errno;
+    }
+}
+
+/* Pop up to 'content_batch_limit' blobrefs from 'batch' into a
+ * NULL-terminated array.
+ */
+static char **refs_pop (zlist_t *batch, int *count)
+{
+    char **refs;
+    int n = zlist_size (batch);
+    int i;
+
+    if (n > content_batch_limit)
+        n = content_batch_limit;
+    if (!(refs = calloc (n + 1, sizeof (refs[0])))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    for (i = 0; i < n; i++)
+        refs[i] = zlist_pop (batch);
+    *count = n;
+    return refs;
+}
+
+static void content_load_batch_completion (flux_future_t *f, void *arg)
+{
+    kvs_ctx_t *ctx = arg;
+    char **refs = flux_future_aux_get (f, "refs");
+    int i;
+
+    for (i = 0; refs[i] != NULL; i++) {
+        struct cache_entry *entry;
+        const void *data;
+        int size;
+
+        /* See content_load_completion() */
+        if (!(entry = cache_lookup (ctx->cache, refs[i], ctx->epoch))) {
+            flux_log (ctx->h, LOG_ERR, "%s: cache_lookup", __FUNCTION__);
+            continue;
+        }
+        if (flux_content_load_batch_get (f, i, &data, &size) < 0) {
+            flux_log_error (ctx->h, "%s: flux_content_load_batch_get",
+                            __FUNCTION__);
+            content_load_cache_entry_error (ctx, entry, errno, refs[i]);
+            continue;
+        }
+        if (cache_entry_set_raw (entry, data, size) < 0) {
+            flux_log_error (ctx->h, "%s: cache_entry_set_raw", __FUNCTION__);
+            content_load_cache_entry_error (ctx, entry, errno, refs[i]);
+        }
+    }
+    flux_future_destroy (f);
+    cache_trim_entries (ctx);
+}
+
+/* Send load requests for up to 'content_batch_limit' queued blobrefs.
+ * On failure, waiters on the cache entries are notified of the error
+ * just as if the request had failed.
+ */
+static int content_load_batch_send (kvs_ctx_t *ctx)
+{
+    flux_future_t *f = NULL;
+    char **refs;
+    int count;
+    int saved_errno;
+    int i;
+
+    if (!(refs = refs_pop (ctx->load_batch, &count)))
+        return -1;
+    if (count == 1) {
+        if (content_load_request_send (ctx, refs[0]) < 0)
+            goto error;
+        refs_destroy (refs);
+        return 0;
+    }
+    if (!(f = flux_content_load_batch (ctx->h,
+                                       (const char **)refs,
+                                       count,
+                                       0))
+        || flux_future_then (f, -1., content_load_batch_completion, ctx) < 0
+        || flux_future_aux_set (f,
+                                "refs",
+                                refs,
+                                (flux_free_f)refs_destroy) < 0)
+        goto error;
+    return 0;
+error:
+    saved_errno = errno;
+    flux_future_destroy (f);
+    for (i = 0; i < count; i++) {
+        struct cache_entry *entry;
+        if ((entry = cache_lookup (ctx->cache, refs[i], ctx->epoch)))
+            content_load_cache_entry_error (ctx, entry, saved_errno, refs[i]);
+    }
+    refs_destroy (refs);
+    errno = saved_errno;
+    return -1;
+}
+
+static void content_store_batch_completion (flux_future_t *f, void *arg)
+{
+    kvs_ctx_t *ctx = arg;
+    char **refs = flux_future_aux_get (f, "refs");
+    int i;
+
+    for (i = 0; refs[i] != NULL; i++) {
+        const char *blobref = NULL;
+        int errnum = 0;
+
+        if (flux_content_store_batch_get (f, i, &blobref) < 0) {
+            flux_log_error (ctx->h, "%s: flux_content_store_batch_get",
+                            __FUNCTION__);
+            errnum = errno;
+        }
+        content_store_complete (ctx, refs[i], blobref, errnum);
+    }
+    flux_future_destroy (f);
+}
+
+/* Send store requests for up to 'content_batch_limit' queued blobrefs.
+ * On failure, waiters on the cache entries are notified of the error
+ * just as if the request had failed.
+ */
+static int content_store_batch_send (kvs_ctx_t *ctx)
+{
+    flux_future_t *f = NULL;
+    char **refs;
+    const void **bufs = NULL;
+    int *lens = NULL;
+    int count;
+    int n = 0;
+    int saved_errno;
+    int i;
+
+    if (!(refs = refs_pop (ctx->store_batch, &count)))
+        return -1;
+    bufs = calloc (count, sizeof (bufs[0]));
+    lens = calloc (count, sizeof (lens[0]));
+    if (!bufs || !lens) {
+        errno = ENOMEM;
+        goto error;
+    }
+    /* A cache entry may have been removed by
+     * kvstxn_cleanup_dirty_cache_entry() after it was queued.
+     * If so, drop it here.
+     */
+    for (i = 0; i < count; i++) {
+        struct cache_entry *entry;
+
+        if (!(entry = cache_lookup (ctx->cache, refs[i], ctx->epoch))
+            || !cache_entry_get_dirty (entry)
+            || cache_entry_get_raw (entry, &bufs[n], &lens[n]) < 0) {
+            free (refs[i]);
+            continue;
+        }
+        refs[n++] = refs[i];
+    }
+    refs[n] = NULL;
+    if (n == 1) {
+        if (content_store_request_send (ctx, refs[0], bufs[0], lens[0]) < 0)
+            goto error;
+    }
+    else if (n > 1) {
+        if (!(f = flux_content_store_batch (ctx->h, bufs, lens, n, 0))
+            || flux_future_then (f,
+                                 -1.,
+                                 content_store_batch_completion,
+                                 ctx) < 0
+            || flux_future_aux_set (f,
+                                    "refs",
+                                    refs,
+                                    (flux_free_f)refs_destroy) < 0)
+            goto error;
+        refs = NULL;
+    }
+    refs_destroy (refs);
+    free (bufs);
+    free (lens);
+    return 0;
+error:
+    saved_errno = errno;
+    flux_future_destroy (f);
+    for (i = 0; refs[i] != NULL; i++)
+        content_store_complete (ctx, refs[i], NULL, saved_errno);
+    refs_destroy (refs);
+    free (bufs);
+    free (lens);
+    errno = saved_errno;
+    return -1;
+}
+
+static void content_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
+                             int revents, void *arg)
+{
+    kvs_ctx_t *ctx = arg;
+
+    /* On error, leave the watcher running so that any blobrefs
+     * remaining in the batch are retried on the next loop iteration.
+     */
+    while (zlist_size (ctx->store_batch) > 0) {
+        if (content_store_batch_send (ctx) < 0) {
+            flux_log_error (ctx->h, "%s: content_store_batch_send",
+                            __FUNCTION__);
+            return;
+        }
+    }
+    while (zlist_size (ctx->load_batch) > 0) {
+        if (content_load_batch_send (ctx) < 0) {
+            flux_log_error (ctx->h, "%s: content_load_batch_send",
+                            __FUNCTION__);
+            return;
+        }
+    }
+    flux_watcher_stop (w);
+}
+
 static int kvstxn_load_cb (kvstxn_t *kt, const char *ref, void *data)
 {
     struct kvs_cb_data *cbd = data;
@@ -741,35 +1070,24 @@ static int kvstxn_load_cb (kvstxn_t *kt, const char *ref, void *data)
     return 0;
 }
 
-/* Flush to content cache asynchronously and push wait onto cache
- * object's wait queue.
+/* Queue dirty entry to be flushed to content cache asynchronously
+ * and push wait onto cache object's wait queue.
  */
 static int kvstxn_cache_cb (kvstxn_t *kt, struct cache_entry *entry, void *data)
 {
     struct kvs_cb_data *cbd = data;
     const char *blobref;
-    const void *storedata;
-    int storedatalen = 0;
 
+    assert (cache_entry_get_valid (entry));
     assert (cache_entry_get_dirty (entry));
 
-    if (cache_entry_get_raw (entry, &storedata, &storedatalen) < 0) {
-        flux_log_error (cbd->ctx->h, "%s: cache_entry_get_raw",
-                        __FUNCTION__);
-        kvstxn_cleanup_dirty_cache_entry (kt, entry);
-        return -1;
-    }
-
     /* must be true, otherwise we didn't insert entry in cache */
     blobref = cache_entry_get_blobref (entry);
     assert (blobref);
 
-    if (content_store_request_send (cbd->ctx,
-                                    blobref,
-                                    storedata,
-                                    storedatalen) < 0) {
+    if (content_batch_add (cbd->ctx, cbd->ctx->store_batch, blobref) < 0) {
         cbd->errnum = errno;
-        flux_log_error (cbd->ctx->h, "%s: content_store_request_send",
+        flux_log_error (cbd->ctx->h, "%s: content_batch_add",
                         __FUNCTION__);
         kvstxn_cleanup_dirty_cache_entry (kt, entry);
         return -1;
@@ -1265,6 +1583,34 @@ static void lookup_wait_error_cb (wait_t *w, int errnum, void *arg)
     lookup_set_aux_errnum (lh, errnum);
 }
 
+/* A lookup may stall and be replayed several times before a response
+ * is sent.  The time of the first attempt is saved in the request
+ * message, which is held by the wait_t, so the whole stall is counted.
+ */
+static void lookup_latency_stall (const flux_msg_t *msg, struct timespec t0)
+{
+    struct timespec *tp;
+
+    if (flux_msg_aux_get (msg, "t_start"))
+        return;
+    if (!(tp = malloc (sizeof (*tp))))
+        return;
+    *tp = t0;
+    if (flux_msg_aux_set (msg, "t_start", tp, free) < 0)
+        free (tp);
+}
+
+static void lookup_latency_done (kvs_ctx_t *ctx,
+                                 const flux_msg_t *msg,
+                                 struct timespec t0)
+{
+    struct timespec *tp;
+
+    if ((tp = flux_msg_aux_get (msg, "t_start")))
+        t0 = *tp;
+    (void)histogram_add (ctx->lookup_latency, monotime_since (t0) * 1000);
+}
+
 static lookup_t *lookup_common (flux_t *h, flux_msg_handler_t *mh,
                                 const flux_msg_t *msg, void *arg,
                                 flux_msg_handler_f replay_cb,
@@ -1280,9 +1626,12 @@ static lookup_t *lookup_common (flux_t *h, flux_msg_handler_t *mh,
     const char *root_ref = NULL;
     wait_t *wait = NULL;
     lookup_process_t lret;
+    struct timespec t0;
     int rc = -1;
     int ret;
 
+    monotime (&t0);
+
     /* if lookup_handle exists in msg as aux data, is a replay */
     lh = flux_msg_aux_get (msg, "lookup_handle");
     if (!lh) {
@@ -1418,19 +1767,64 @@ done:
         lookup_destroy (lh);
         json_decref (val);
     }
+    lookup_latency_done (ctx, msg, t0);
     (*stall) = false;
     return (rc == 0) ? lh : NULL;
 
 stall:
+    lookup_latency_stall (msg, t0);
     (*stall) = true;
     return NULL;
 }
 
+/* Clients that can accept a lookup value as raw bytes set "rawval" in
+ * the request (see kvs_rawval_encode()).  Old clients don't, and are
+ * always sent a treeobj val.
+ */
+static bool lookup_want_rawval (const flux_msg_t *msg)
+{
+    int rawval = 0;
+
+    (void)flux_request_unpack (msg, NULL, "{ s:b }", "rawval", &rawval);
+    return rawval ? true : false;
+}
+
+static int respond_rawval (flux_t *h,
+                           const flux_msg_t *msg,
+                           const void *data,
+                           int len,
+                           const char *fmt,
+                           ...)
+{
+    va_list ap;
+    json_t *o;
+    void *payload = NULL;
+    int size;
+    int rc = -1;
+
+    va_start (ap, fmt);
+    o = json_vpack_ex (NULL, 0, fmt, ap);
+    va_end (ap);
+    if (!o) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (!(payload = kvs_rawval_encode (o, data, len, &size)))
+        goto done;
+    rc = flux_respond_raw (h, msg, payload, size);
+done:
+    ERRNO_SAFE_WRAP (free, payload);
+    ERRNO_SAFE_WRAP (json_decref, o);
+    return rc;
+}
+
 static void lookup_request_cb (flux_t *h, flux_msg_handler_t *mh,
                                const flux_msg_t *msg, void *arg)
 {
     lookup_t *lh;
     json_t *val;
+    const void *data;
+    int len;
     bool stall = false;
 
     if (!(lh = lookup_common (h, mh, msg, arg, lookup_request_cb,
@@ -1440,6 +1834,13 @@ static void lookup_request_cb (flux_t *h, flux_msg_handler_t *mh,
         goto error;
     }
 
+    if (lookup_want_rawval (msg)
+        && lookup_get_value_raw (lh, &data, &len) == 0) {
+        if (respond_rawval (h, msg, data, len, "{}") < 0)
+            flux_log_error (h, "%s: respond_rawval", __FUNCTION__);
+        lookup_destroy (lh);
+        return;
+    }
     if (!(val = lookup_get_value (lh))) {
         errno = ENOENT;
         goto error;
@@ -1467,6 +1868,8 @@ static void lookup_plus_request_cb (flux_t *h, flux_msg_handler_t *mh,
 {
     lookup_t *lh;
     json_t *val = NULL;
+    const void *data;
+    int len;
     const char *root_ref;
     int root_seq;
     bool stall = false;
@@ -1483,7 +1886,14 @@ static void lookup_plus_request_cb (flux_t *h, flux_msg_handler_t *mh,
     root_seq = lookup_get_root_seq (lh);
     assert (root_seq >= 0);
 
-    if (!(val = lookup_get_value (lh))) {
+    if (lookup_want_rawval (msg)
+        && lookup_get_value_raw (lh, &data, &len) == 0) {
+        if (respond_rawval (h, msg, data, len, "{ s:i s:s }",
+                            "rootseq", root_seq,
+                            "rootref", root_ref) < 0)
+            flux_log_error (h, "%s: respond_rawval", __FUNCTION__);
+    }
+    else if (!(val = lookup_get_value (lh))) {
         if (flux_respond_pack (h, msg, "{ s:i s:i s:s }",
                                "errno", ENOENT,
                                "rootseq", root_seq,
@@ -1546,6 +1956,10 @@ static void finalize_transaction_bynames (kvs_ctx_t *ctx, struct kvsroot *root,
         }
         nameval = json_string_value (name);
         if ((tr = treq_mgr_lookup_transaction (root->trm, nameval))) {
+            /* One sample per transaction, not per fence participant.
+             */
+            (void)histogram_add (ctx->commit_latency,
+                                 treq_get_age (tr) * 1000);
             treq_iter_request_copies (tr, finalize_transaction_req, &cbd);
             if (treq_mgr_remove_transaction (root->trm, nameval) < 0)
                 flux_log_error (ctx->h, "%s: treq_mgr_remove_transaction",
@@ -2230,6 +2644,8 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
     json_t *tstats = NULL;
     json_t *cstats = NULL;
     json_t *nsstats = NULL;
+    json_t *commit = NULL;
+    json_t *lookup = NULL;
     tstat_t ts = { .min = 0.0, .max = 0.0, .M = 0.0, .S = 0.0, .newM = 0.0,
                    .newS = 0.0, .n = 0 };
     int size = 0, incomplete = 0, dirty = 0;
@@ -2252,11 +2668,15 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
                               "max", tstat_max (&ts)*scale)))
         goto nomem;
 
-    if (!(cstats = json_pack ("{ s:f s:O s:i s:i s:i }",
+    if (!(cstats = json_pack ("{ s:f s:f s:O s:i s:i s:i s:i }",
                               "obj size total (MiB)", (double)size/1048576,
+                              "obj size limit (MiB)",
+                              (double)cache_get_max_size (ctx->cache)/1048576,
                               "obj size (KiB)", tstats,
                               "#obj dirty", dirty,
                               "#obj incomplete", incomplete,
+                              "#obj evicted",
+                              cache_count_evictions (ctx->cache),
                               "#faults", ctx->faults)))
         goto nomem;
 
@@ -2286,14 +2706,23 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
         }
     }
 
+    if (!(commit = histogram_encode (ctx->commit_latency))
+        || !(lookup = histogram_encode (ctx->lookup_latency)))
+        goto nomem;
+
     if (flux_respond_pack (h, msg,
-                           "{ s:O s:O }",
+                           "{ s:O s:O s:{ s:O s:O } }",
                            "cache", cstats,
-                           "namespace", nsstats) < 0)
+                           "namespace", nsstats,
+                           "latency",
+                             "commit", commit,
+                             "lookup", lookup) < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     json_decref (tstats);
     json_decref (cstats);
     json_decref (nsstats);
+    json_decref (commit);
+    json_decref (lookup);
     return;
 nomem:
     errno = ENOMEM;
@@ -2303,6 +2732,8 @@ error:
     json_decref (tstats);
     json_decref (cstats);
     json_decref (nsstats);
+    json_decref (commit);
+    json_decref (lookup);
 }
 
 static int stats_clear_root_cb (struct kvsroot *root, void *arg)
@@ -2314,6 +2745,8 @@ static int stats_clear_root_cb (struct kvsroot *root, void *arg)
 static void stats_clear (kvs_ctx_t *ctx)
 {
     ctx->faults = 0;
+    histogram_reset (ctx->commit_latency);
+    histogram_reset (ctx->lookup_latency);
 
     if (kvsroot_mgr_iter_roots (ctx->krm, stats_clear_root_cb, NULL) < 0)
         flux_log_error (ctx->h, "%s: kvsroot_mgr_iter_roots", __FUNCTION__);
@@ -2366,6 +2799,7 @@ static int namespace_create (kvs_ctx_t *ctx, const char *ns,
         flux_log_error (ctx->h, "%s: kvsroot_mgr_create_root", __FUNCTION__);
         return -1;
     }
+    kvstxn_mgr_set_hdir_threshold (root->ktm, ctx->hdir_threshold);
 
     if (!(rootdir = treeobj_create_dir ())) {
         flux_log_error (ctx->h, "%s: treeobj_create_dir", __FUNCTION__);
@@ -2826,6 +3260,10 @@ static void process_args (kvs_ctx_t *ctx, int ac, char **av)
     for (i = 0; i < ac; i++) {
         if (strncmp (av[i], "transaction-merge=", 13) == 0)
             ctx->transaction_merge = strtoul (av[i]+13, NULL, 10);
+        else if (strncmp (av[i], "hdir-threshold=", 15) == 0)
+            ctx->hdir_threshold = strtoul (av[i]+15, NULL, 10);
+        else if (strncmp (av[i], "cache-max-size=", 15) == 0)
+            cache_set_max_size (ctx->cache, strtoull (av[i]+15, NULL, 10));
         else
             flux_log (ctx->h, LOG_ERR, "Unknown option `%s'", av[i]);
     }
@@ -3002,6 +3440,7 @@ int mod_main (flux_t *h, int argc, char **argv)
                 flux_log_error (h, "kvsroot_mgr_create_root");
                 goto done;
             }
+            kvstxn_mgr_set_hdir_threshold (root->ktm, ctx->hdir_threshold);
         }
 
         setroot (ctx, root, rootref, 0);
@@ -40,6 +40,7 @@ struct kvstxn_mgr {
     const char *ns_name;
     const char *hash_name;
     int noop_stores;            /* for kvs.stats.get, etc.*/
+    int hdir_threshold;         /* shard dirs with more entries than this */
     zlist_t *ready;
     flux_t *h;
     void *aux;
@@ -243,6 +244,11 @@ static void cleanup_dirty_cache_list (kvstxn_t *kt)
  * 'is_raw' indicates this data is a json string w/ base64 value and
  * should be flushed to the content store as raw data after it is
  * decoded.  Otherwise, the json object should be a treeobj.
+ * N.B. unlike lookup responses (see kvs_rawval_encode()), txn ops in
+ * kvs.commit and kvs.fence requests still carry values base64 encoded.
+ * Sending them raw requires a new request encoding in libkvs and care
+ * when ops from several requests are merged into one transaction, so
+ * it is left as follow-up work.
  * Returns -1 on error, 0 on success entry already there, 1 on success
  * entry needs to be flushed to content store
  */
@@ -326,6 +332,9 @@ static int store_cache (kvstxn_t *kt, int current_epoch, json_t *o,
     return -1;
 }
 
+static json_t *kvstxn_unroll_store (kvstxn_t *kt, int current_epoch,
+                                    json_t *o, int level);
+
 /* Store DIRVAL objects, converting them to DIRREFs.
  * Store (large) FILEVAL objects, converting them to FILEREFs.
  * Return 0 on success, -1 on error
@@ -352,20 +361,9 @@ static int kvstxn_unroll (kvstxn_t *kt, int current_epoch, json_t *dir)
      */
     while (iter) {
         dir_entry = json_object_iter_value (iter);
-        if (treeobj_is_dir (dir_entry)) {
-            if (kvstxn_unroll (kt, current_epoch, dir_entry) < 0) /* depth first */
-                return -1;
-            if ((ret = store_cache (kt, current_epoch, dir_entry,
-                                    false, ref, sizeof (ref), &entry)) < 0)
-                return -1;
-            if (ret) {
-                if (zlist_push (kt->dirty_cache_entries_list, entry) < 0) {
-                    kvstxn_cleanup_dirty_cache_entry (kt, entry);
-                    errno = ENOMEM;
-                    return -1;
-                }
-            }
-            if (!(ktmp = treeobj_create_dirref (ref)))
+        if (treeobj_is_dir (dir_entry) || treeobj_is_hdir (dir_entry)) {
+            if (!(ktmp = kvstxn_unroll_store (kt, current_epoch,
+                                              dir_entry, 0)))
                 return -1;
             if (json_object_iter_set_new (dir, iter, ktmp) < 0) {
                 json_decref (ktmp);
@@ -408,6 +406,96 @@ static int kvstxn_unroll (kvstxn_t *kt, int current_epoch, json_t *dir)
     return 0;
 }
 
+/* Unroll the in-memory shards of an hdir, replacing each with a DIRREF.
+ * Shards still held as DIRREFs were not modified and are left alone.
+ * Return 0 on success, -1 on error
+ */
+static int kvstxn_unroll_hdir (kvstxn_t *kt, int current_epoch, json_t *hdir)
+{
+    int level;
+    int i;
+
+    if ((level = treeobj_hdir_get_level (hdir)) < 0)
+        return -1;
+
+    for (i = 0; i < TREEOBJ_HDIR_FANOUT; i++) {
+        json_t *shard;
+        json_t *dirref;
+
+        if (!(shard = treeobj_hdir_get_shard (hdir, i))) {
+            if (errno != ENOENT)
+                return -1;
+            continue;
+        }
+        if (treeobj_is_dirref (shard))
+            continue;
+        if (treeobj_is_dir (shard) && treeobj_get_count (shard) == 0) {
+            if (treeobj_hdir_set_shard (hdir, i, NULL) < 0)
+                return -1;
+            continue;
+        }
+        if (!(dirref = kvstxn_unroll_store (kt, current_epoch,
+                                            shard, level + 1)))
+            return -1;
+        if (treeobj_hdir_set_shard (hdir, i, dirref) < 0) {
+            json_decref (dirref);
+            return -1;
+        }
+        json_decref (dirref);
+    }
+    return 0;
+}
+
+/* Unroll directory object 'o' (dir or hdir), store it, and return a
+ * DIRREF to it.  A dir that has grown past the threshold is first
+ * converted to an hdir of 'level', unless it is already at the deepest
+ * level of an hdir.
+ * Return DIRREF on success, NULL on error
+ */
+static json_t *kvstxn_unroll_store (kvstxn_t *kt, int current_epoch,
+                                    json_t *o, int level)
+{
+    json_t *hdir = NULL;
+    json_t *dirref = NULL;
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    struct cache_entry *entry;
+    int saved_errno, ret;
+
+    if (treeobj_is_dir (o)
+        && kt->ktm->hdir_threshold > 0
+        && level <= TREEOBJ_HDIR_MAXLEVEL
+        && treeobj_get_count (o) > kt->ktm->hdir_threshold) {
+        if (!(hdir = treeobj_hdir_create_from_dir (o, level)))
+            goto error;
+        o = hdir;
+    }
+    if (treeobj_is_hdir (o)) {
+        if (kvstxn_unroll_hdir (kt, current_epoch, o) < 0) /* depth first */
+            goto error;
+    }
+    else if (kvstxn_unroll (kt, current_epoch, o) < 0) /* depth first */
+        goto error;
+    if ((ret = store_cache (kt, current_epoch, o,
+                            false, ref, sizeof (ref), &entry)) < 0)
+        goto error;
+    if (ret) {
+        if (zlist_push (kt->dirty_cache_entries_list, entry) < 0) {
+            kvstxn_cleanup_dirty_cache_entry (kt, entry);
+            errno = ENOMEM;
+            goto error;
+        }
+    }
+    if (!(dirref = treeobj_create_dirref (ref)))
+        goto error;
+    json_decref (hdir);
+    return dirref;
+error:
+    saved_errno = errno;
+    json_decref (hdir);
+    errno = saved_errno;
+    return NULL;
+}
+
 static int kvstxn_val_data_to_cache (kvstxn_t *kt, int current_epoch,
                                      json_t *val, char *ref, int ref_len)
 {
@@ -536,7 +624,8 @@ static int kvstxn_append (kvstxn_t *kt, int current_epoch, json_t *dirent,
         return -1;
     }
     else if (treeobj_is_dir (entry)
-             || treeobj_is_dirref (entry)) {
+             || treeobj_is_dirref (entry)
+             || treeobj_is_hdir (entry)) {
         errno = EISDIR;
         return -1;
     }
@@ -551,6 +640,100 @@ static int kvstxn_append (kvstxn_t *kt, int current_epoch, json_t *dirent,
     return 0;
 }
 
+/* Get a modifiable copy of the directory referenced by 'dirref'.
+ * If it is not in the cache, set 'missing_ref' and return 0 with *cpyp
+ * set to NULL.  Return 0 on success, -1 on error with errno set.
+ */
+static int kvstxn_load_dirref (kvstxn_t *kt, int current_epoch,
+                               const json_t *dirref, json_t **cpyp,
+                               const char **missing_ref)
+{
+    struct cache_entry *entry;
+    const char *ref;
+    const json_t *subdirktmp;
+    int refcount;
+
+    *cpyp = NULL;
+
+    if ((refcount = treeobj_get_count (dirref)) < 0)
+        return -1;
+
+    if (refcount != 1) {
+        flux_log (kt->ktm->h, LOG_ERR, "invalid dirref count: %d", refcount);
+        errno = ENOTRECOVERABLE;
+        return -1;
+    }
+
+    if (!(ref = treeobj_get_blobref (dirref, 0)))
+        return -1;
+
+    if (!(entry = cache_lookup (kt->ktm->cache, ref, current_epoch))
+        || !cache_entry_get_valid (entry)) {
+        *missing_ref = ref;
+        return 0; /* stall */
+    }
+
+    if (!(subdirktmp = cache_entry_get_treeobj (entry))) {
+        errno = ENOTRECOVERABLE;
+        return -1;
+    }
+
+    /* do not corrupt store by modifying orig. */
+    if (!(*cpyp = treeobj_deep_copy (subdirktmp)))
+        return -1;
+    return 0;
+}
+
+/* If 'dir' is an hdir, descend to the dir shard holding 'name', replacing
+ * DIRREF shards along the way with modifiable copies.  A missing shard is
+ * created if 'create' is true, otherwise *dirp is set to NULL.  If a shard
+ * is not in the cache, 'missing_ref' is set.
+ * Return 0 on success, -1 on error with errno set.
+ */
+static int kvstxn_resolve_shard (kvstxn_t *kt, int current_epoch,
+                                 json_t **dirp, const char *name,
+                                 bool create, const char **missing_ref)
+{
+    json_t *dir = *dirp;
+
+    while (treeobj_is_hdir (dir)) {
+        json_t *shard;
+        int index;
+
+        if ((index = treeobj_hdir_index (dir, name)) < 0)
+            return -1;
+        if (!(shard = treeobj_hdir_get_shard (dir, index))) {
+            if (errno != ENOENT)
+                return -1;
+            if (!create) {
+                *dirp = NULL;
+                return 0;
+            }
+            if (!(shard = treeobj_create_dir ()))
+                return -1;
+        }
+        else if (treeobj_is_dirref (shard)) {
+            if (kvstxn_load_dirref (kt, current_epoch, shard,
+                                    &shard, missing_ref) < 0)
+                return -1;
+            if (!shard)
+                return 0; /* stall */
+        }
+        else {
+            dir = shard;
+            continue;
+        }
+        if (treeobj_hdir_set_shard (dir, index, shard) < 0) {
+            json_decref (shard);
+            return -1;
+        }
+        json_decref (shard);
+        dir = shard;
+    }
+    *dirp = dir;
+    return 0;
+}
+
 /* link (key, dirent) into directory 'dir'.
  */
 static int kvstxn_link_dirent (kvstxn_t *kt, int current_epoch,
@@ -586,6 +769,20 @@ static int kvstxn_link_dirent (kvstxn_t *kt, int current_epoch,
     while ((next = strchr (name, '.'))) {
         *next++ = '\0';
 
+        if (kvstxn_resolve_shard (kt,
+                                  current_epoch,
+                                  &dir,
+                                  name,
+                                  !json_is_null (dirent),
+                                  missing_ref) < 0) {
+            saved_errno = errno;
+            goto done;
+        }
+        if (*missing_ref) /* stall */
+            goto success;
+        if (!dir) /* key deletion - it doesn't exist so return */
+            goto success;
+
         if (!treeobj_is_dir (dir)) {
             saved_errno = ENOTRECOVERABLE;
             goto done;
@@ -604,47 +801,19 @@ static int kvstxn_link_dirent (kvstxn_t *kt, int current_epoch,
                 goto done;
             }
             json_decref (subdir);
-        } else if (treeobj_is_dir (dir_entry)) {
+        } else if (treeobj_is_dir (dir_entry) || treeobj_is_hdir (dir_entry)) {
             subdir = dir_entry;
         } else if (treeobj_is_dirref (dir_entry)) {
-            struct cache_entry *entry;
-            const char *ref;
-            const json_t *subdirktmp;
-            int refcount;
-
-            if ((refcount = treeobj_get_count (dir_entry)) < 0) {
-                saved_errno = errno;
-                goto done;
-            }
-
-            if (refcount != 1) {
-                flux_log (kt->ktm->h, LOG_ERR, "invalid dirref count: %d",
-                          refcount);
-                saved_errno = ENOTRECOVERABLE;
-                goto done;
-            }
-
-            if (!(ref = treeobj_get_blobref (dir_entry, 0))) {
+            if (kvstxn_load_dirref (kt,
+                                    current_epoch,
+                                    dir_entry,
+                                    &subdir,
+                                    missing_ref) < 0) {
                 saved_errno = errno;
                 goto done;
             }
-
-            if (!(entry = cache_lookup (kt->ktm->cache, ref, current_epoch))
-                || !cache_entry_get_valid (entry)) {
-                *missing_ref = ref;
+            if (!subdir)
                 goto success; /* stall */
-            }
-
-            if (!(subdirktmp = cache_entry_get_treeobj (entry))) {
-                saved_errno = ENOTRECOVERABLE;
-                goto done;
-            }
-
-            /* do not corrupt store by modifying orig. */
-            if (!(subdir = treeobj_deep_copy (subdirktmp))) {
-                saved_errno = errno;
-                goto done;
-            }
 
             if (treeobj_insert_entry (dir, name, subdir) < 0) {
                 saved_errno = errno;
@@ -707,6 +876,19 @@ static int kvstxn_link_dirent (kvstxn_t *kt, int current_epoch,
     /* This is the final path component of the key.  Add/modify/delete
      * it in the directory.
      */
+    if (kvstxn_resolve_shard (kt,
+                              current_epoch,
+                              &dir,
+                              name,
+                              !json_is_null (dirent),
+                              missing_ref) < 0) {
+        saved_errno = errno;
+        goto done;
+    }
+    if (*missing_ref) /* stall */
+        goto success;
+    if (!dir) /* key deletion - it doesn't exist so return */
+        goto success;
     if (!json_is_null (dirent)) {
         if (flags & FLUX_KVS_APPEND) {
             if (kvstxn_append (kt,
@@ -1122,6 +1304,7 @@ kvstxn_mgr_t *kvstxn_mgr_create (struct cache *cache,
     }
     ktm->h = h;
     ktm->aux = aux;
+    ktm->hdir_threshold = KVSTXN_HDIR_THRESHOLD;
     return ktm;
 
  error:
@@ -1213,6 +1396,11 @@ void kvstxn_mgr_remove_transaction (kvstxn_mgr_t *ktm, kvstxn_t *kt,
     }
 }
 
+void kvstxn_mgr_set_hdir_threshold (kvstxn_mgr_t *ktm, int threshold)
+{
+    ktm->hdir_threshold = threshold;
+}
+
 int kvstxn_mgr_get_noop_stores (kvstxn_mgr_t *ktm)
 {
     return ktm->noop_stores;
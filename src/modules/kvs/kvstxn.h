@@ -16,6 +16,8 @@
 
 #include "cache.h"
 
+#define KVSTXN_HDIR_THRESHOLD 1024
+
 typedef struct kvstxn_mgr kvstxn_mgr_t;
 typedef struct kvstxn kvstxn_t;
 
@@ -175,6 +177,12 @@ kvstxn_t *kvstxn_mgr_get_ready_transaction (kvstxn_mgr_t *ktm);
 void kvstxn_mgr_remove_transaction (kvstxn_mgr_t *ktm, kvstxn_t *kt,
                                     bool fallback);
 
+/* Directories with more than 'threshold' entries are converted to
+ * sharded hdir objects when stored, so that later updates rewrite only
+ * the shards they touch.  A threshold of 0 disables sharding.
+ */
+void kvstxn_mgr_set_hdir_threshold (kvstxn_mgr_t *ktm, int threshold);
+
 int kvstxn_mgr_get_noop_stores (kvstxn_mgr_t *ktm);
 void kvstxn_mgr_clear_noop_stores (kvstxn_mgr_t *ktm);
 
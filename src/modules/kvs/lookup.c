@@ -74,12 +74,25 @@ struct lookup {
     /* potential return values from lookup */
     json_t *val;           /* value of lookup */
 
+    /* raw value of lookup if it was read from valref blobs, so that
+     * it need not be base64-encoded if the requestor can accept it.
+     * lh->val is created from it on demand.
+     */
+    void *val_data;
+    int val_len;
+    bool val_raw;
+
     /* if valref_missing_refs is true, iterate on refs, else
      * return missing_ref string.
      */
     const json_t *valref_missing_refs;
     const char *missing_ref;
 
+    /* if missing_shard_refs is set, iterate on array of refs
+     * needed to read a sharded directory (hdir).
+     */
+    json_t *missing_shard_refs;
+
     /* for namespace callback */
 
     char *missing_namespace;
@@ -409,7 +422,7 @@ static lookup_process_t walk (lookup_t *lh)
                     lh->errnum = ENOTRECOVERABLE;
                 goto error;
             }
-            if (!treeobj_is_dir (dir)) {
+            if (!treeobj_is_dir (dir) && !treeobj_is_hdir (dir)) {
                 /* dirref pointed to non-dir error, special case when
                  * root_dirent is bad, is EINVAL from user.
                  */
@@ -440,6 +453,47 @@ static lookup_process_t walk (lookup_t *lh)
             }
         }
 
+        /* If directory is sharded, descend to the shard holding
+         * path component.  A missing shard means no entry. */
+
+        while (treeobj_is_hdir (dir)) {
+            const json_t *shard;
+            const char *refstr;
+            int index;
+
+            if ((index = treeobj_hdir_index (dir, pathcomp)) < 0) {
+                lh->errnum = errno;
+                goto error;
+            }
+            if (!(shard = treeobj_hdir_peek_shard (dir, index))) {
+                if (errno != ENOENT) {
+                    lh->errnum = errno;
+                    goto error;
+                }
+                goto done;
+            }
+            if (treeobj_is_dirref (shard)) {
+                if (!(refstr = treeobj_get_blobref (shard, 0))) {
+                    lh->errnum = errno;
+                    goto error;
+                }
+                if (!(entry = cache_lookup (lh->cache,
+                                            refstr,
+                                            lh->current_epoch))
+                    || !cache_entry_get_valid (entry)) {
+                    lh->missing_ref = refstr;
+                    return LOOKUP_PROCESS_LOAD_MISSING_REFS;
+                }
+                if (!(shard = cache_entry_get_treeobj (entry))
+                    || (!treeobj_is_dir (shard) && !treeobj_is_hdir (shard))) {
+                    flux_log (lh->h, LOG_ERR, "hdir shard is not a dir");
+                    lh->errnum = ENOTRECOVERABLE;
+                    goto error;
+                }
+            }
+            dir = shard;
+        }
+
         /* Get directory reference of path component from directory */
 
         if (!(dirent_tmp = treeobj_peek_entry (dir, pathcomp))) {
@@ -599,7 +653,9 @@ void lookup_destroy (lookup_t *lh)
         free (lh->root_ref);
         free (lh->path);
         json_decref (lh->val);
+        free (lh->val_data);
         free (lh->missing_namespace);
+        json_decref (lh->missing_shard_refs);
         zlist_destroy (&lh->levels);
         free (lh);
     }
@@ -639,18 +695,48 @@ json_t *lookup_get_value (lookup_t *lh)
 {
     if (lh
         && lh->state == LOOKUP_STATE_FINISHED
-        && lh->errnum == 0)
+        && lh->errnum == 0) {
+        if (!lh->val && lh->val_raw) {
+            if (!(lh->val = treeobj_create_val (lh->val_data, lh->val_len)))
+                return NULL;
+        }
         return json_incref (lh->val);
+    }
     return NULL;
 }
 
+int lookup_get_value_raw (lookup_t *lh, const void **data, int *len)
+{
+    if (!lh
+        || lh->state != LOOKUP_STATE_FINISHED
+        || lh->errnum != 0
+        || !lh->val_raw) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (data)
+        *data = lh->val_data;
+    if (len)
+        *len = lh->val_len;
+    return 0;
+}
+
 int lookup_iter_missing_refs (lookup_t *lh, lookup_ref_f cb, void *data)
 {
     if (lh
         && (lh->state == LOOKUP_STATE_CHECK_ROOT
             || lh->state == LOOKUP_STATE_WALK
             || lh->state == LOOKUP_STATE_VALUE)) {
-        if (lh->valref_missing_refs) {
+        if (lh->missing_shard_refs) {
+            size_t index;
+            json_t *o;
+
+            json_array_foreach (lh->missing_shard_refs, index, o) {
+                if (cb (lh, json_string_value (o), data) < 0)
+                    return -1;
+            }
+        }
+        else if (lh->valref_missing_refs) {
             int refcount, i;
 
             if (!treeobj_is_valref (lh->valref_missing_refs)) {
@@ -784,10 +870,16 @@ static int get_single_blobref_valref_value (lookup_t *lh, bool *stall)
         lh->errnum = ENOTRECOVERABLE;
         return -1;
     }
-    if (!(lh->val = treeobj_create_val (valdata, len))) {
+    /* copy, since the cache entry may be expired before the value
+     * is consumed */
+    if (!(lh->val_data = malloc (len > 0 ? len : 1))) {
         lh->errnum = errno;
         return -1;
     }
+    if (len > 0)
+        memcpy (lh->val_data, valdata, len);
+    lh->val_len = len;
+    lh->val_raw = true;
     (*stall) = false;
     return 0;
 }
@@ -892,10 +984,10 @@ static int get_multi_blobref_valref_value (lookup_t *lh, int refcount,
     if (!(valbuf = get_multi_blobref_valref_data (lh, refcount, total_len)))
         goto done;
 
-    if (!(lh->val = treeobj_create_val (valbuf, total_len))) {
-        lh->errnum = errno;
-        goto done;
-    }
+    lh->val_data = valbuf;
+    lh->val_len = total_len;
+    lh->val_raw = true;
+    valbuf = NULL;
 
     (*stall) = false;
     rc = 0;
@@ -904,6 +996,111 @@ done:
     return rc;
 }
 
+/* Gather the entries of sharded directory 'hdir' into 'dir'.
+ * References to shards that are not yet cached are appended to
+ * 'missing' so they can all be loaded before the lookup is replayed.
+ * Return 0 on success, -1 on failure with lh->errnum set.
+ */
+static int hdir_flatten (lookup_t *lh,
+                         const json_t *hdir,
+                         json_t *dir,
+                         json_t *missing)
+{
+    int i;
+
+    for (i = 0; i < TREEOBJ_HDIR_FANOUT; i++) {
+        struct cache_entry *entry;
+        const json_t *shard;
+        const char *reftmp;
+
+        if (!(shard = treeobj_hdir_peek_shard (hdir, i))) {
+            if (errno == ENOENT)
+                continue;
+            lh->errnum = errno;
+            return -1;
+        }
+        if (treeobj_is_dirref (shard)) {
+            if (!(reftmp = treeobj_get_blobref (shard, 0))) {
+                lh->errnum = errno;
+                return -1;
+            }
+            if (!(entry = cache_lookup (lh->cache, reftmp, lh->current_epoch))
+                || !cache_entry_get_valid (entry)) {
+                json_t *o;
+                if (!(o = json_string (reftmp))
+                    || json_array_append_new (missing, o) < 0) {
+                    json_decref (o);
+                    lh->errnum = ENOMEM;
+                    return -1;
+                }
+                continue;
+            }
+            if (!(shard = cache_entry_get_treeobj (entry))) {
+                flux_log (lh->h, LOG_ERR, "hdir shard is not a treeobj");
+                lh->errnum = ENOTRECOVERABLE;
+                return -1;
+            }
+        }
+        if (treeobj_is_hdir (shard)) {
+            if (hdir_flatten (lh, shard, dir, missing) < 0)
+                return -1;
+        }
+        else if (treeobj_is_dir (shard)) {
+            json_t *data = treeobj_get_data ((json_t *)shard);
+            const char *name;
+            json_t *o;
+
+            json_object_foreach (data, name, o) {
+                if (treeobj_insert_entry_novalidate (dir, name, o) < 0) {
+                    lh->errnum = errno;
+                    return -1;
+                }
+            }
+        }
+        else {
+            flux_log (lh->h, LOG_ERR, "hdir shard is not a dir");
+            lh->errnum = ENOTRECOVERABLE;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Set lh->val to a dir containing all entries of 'hdir'.
+ * return 0 on success, -1 on failure.  On success, stall should be
+ * checked */
+static int get_hdir_value (lookup_t *lh, const json_t *hdir, bool *stall)
+{
+    json_t *dir = NULL;
+    json_t *missing = NULL;
+    int rc = -1;
+
+    json_decref (lh->missing_shard_refs);
+    lh->missing_shard_refs = NULL;
+
+    if (!(dir = treeobj_create_dir ()) || !(missing = json_array ())) {
+        lh->errnum = ENOMEM;
+        goto done;
+    }
+    if (hdir_flatten (lh, hdir, dir, missing) < 0)
+        goto done;
+    if (json_array_size (missing) > 0) {
+        lh->missing_shard_refs = missing;
+        missing = NULL;
+        (*stall) = true;
+    }
+    else {
+        lh->val = dir;
+        dir = NULL;
+        (*stall) = false;
+    }
+    rc = 0;
+done:
+    json_decref (dir);
+    json_decref (missing);
+    return rc;
+}
+
 lookup_process_t lookup (lookup_t *lh)
 {
     const json_t *valtmp = NULL;
@@ -924,6 +1121,14 @@ lookup_process_t lookup (lookup_t *lh)
         && lh->state != LOOKUP_STATE_FINISHED)
         is_replay = true;
 
+    /* Missing refs from a previous stall are stale on replay, and
+     * lookup_iter_missing_refs() must only report those of this pass.
+     */
+    json_decref (lh->missing_shard_refs);
+    lh->missing_shard_refs = NULL;
+    lh->valref_missing_refs = NULL;
+    lh->missing_ref = NULL;
+
     switch (lh->state) {
         case LOOKUP_STATE_INIT:
             lh->state = LOOKUP_STATE_CHECK_NAMESPACE;
@@ -1093,6 +1298,15 @@ lookup_process_t lookup (lookup_t *lh)
                     lh->errnum = ENOTRECOVERABLE;
                     goto error;
                 }
+                if (treeobj_is_hdir (valtmp)) {
+                    bool stall;
+
+                    if (get_hdir_value (lh, valtmp, &stall) < 0)
+                        goto error;
+                    if (stall)
+                        return LOOKUP_PROCESS_LOAD_MISSING_REFS;
+                    break;
+                }
                 if (!treeobj_is_dir (valtmp)) {
                     /* dirref points to not dir */
                     lh->errnum = ENOTRECOVERABLE;
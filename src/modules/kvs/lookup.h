@@ -68,6 +68,13 @@ int lookup_set_aux_errnum (lookup_t *lh, int errnum);
  * memory. */
 json_t *lookup_get_value (lookup_t *lh);
 
+/* Get the resulting value of lookup() as raw bytes, if it was read
+ * from a valref, without creating a treeobj val object.  The data
+ * belongs to the lookup handle.  Returns -1 with errno = EINVAL if
+ * the lookup did not finish with a valref value.
+ */
+int lookup_get_value_raw (lookup_t *lh, const void **data, int *len);
+
 /* On lookup stall b/c of missing reference(s), get missing reference
  * that should be loaded into the KVS cache via callback function.
  *
@@ -12,6 +12,7 @@
 #include "config.h"
 #endif
 #include <stdbool.h>
+#include <stdio.h>
 #include <jansson.h>
 
 #include "src/common/libkvs/treeobj.h"
@@ -557,6 +558,124 @@ void cache_remove_entry_tests (void)
     cache_destroy (cache);
 }
 
+void cache_lru_tests (void)
+{
+    struct cache *cache;
+    struct cache_entry *e1, *e2, *e3, *e4;
+
+    ok ((cache = cache_create ()) != NULL,
+        "cache_create works");
+    ok (cache_get_max_size (cache) == 0,
+        "cache_get_max_size returns 0 (unlimited) by default");
+    ok (cache_get_size (cache) == 0,
+        "cache_get_size returns 0 for empty cache");
+
+    ok ((e1 = cache_entry_create ("xxx1")) != NULL
+        && cache_entry_set_raw (e1, "abcd", 4) == 0
+        && cache_insert (cache, e1) == 0,
+        "inserted entry xxx1 with 4 bytes of data");
+    ok ((e2 = cache_entry_create ("xxx2")) != NULL
+        && cache_entry_set_raw (e2, "efgh", 4) == 0
+        && cache_insert (cache, e2) == 0,
+        "inserted entry xxx2 with 4 bytes of data");
+    ok ((e3 = cache_entry_create ("xxx3")) != NULL
+        && cache_insert (cache, e3) == 0,
+        "inserted entry xxx3 without data");
+    ok (cache_get_size (cache) == 8,
+        "cache_get_size returns 8");
+    ok (cache_entry_set_raw (e3, "ijklmnop", 8) == 0,
+        "cache_entry_set_raw on inserted entry works");
+    ok (cache_get_size (cache) == 16,
+        "cache_get_size returns 16");
+
+    ok (cache_trim (cache) == 0,
+        "cache_trim removes nothing with no size limit");
+
+    cache_set_max_size (cache, 12);
+    ok (cache_get_max_size (cache) == 12,
+        "cache_set_max_size set limit to 12");
+    ok (cache_lookup (cache, "xxx1", 42) != NULL,
+        "cache_lookup of xxx1 makes it most recently used");
+    ok (cache_trim (cache) == 1,
+        "cache_trim removed 1 entry");
+    ok (cache_lookup (cache, "xxx2", 42) == NULL
+        && cache_lookup (cache, "xxx1", 42) != NULL
+        && cache_lookup (cache, "xxx3", 42) != NULL,
+        "least recently used entry xxx2 was removed");
+    ok (cache_get_size (cache) == 12,
+        "cache_get_size returns 12");
+    ok (cache_count_evictions (cache) == 1,
+        "cache_count_evictions returns 1");
+
+    cache_set_max_size (cache, 4);
+    cache_entry_incref (e1);
+    ok (cache_entry_set_dirty (e3, true) == 0,
+        "cache_entry_set_dirty success");
+    ok (cache_trim (cache) == 0,
+        "cache_trim removes nothing if entries are referenced or dirty");
+    ok (cache_expire_entries (cache, 43, 1) == 0,
+        "cache_expire_entries removes nothing if entries are referenced or dirty");
+    cache_entry_decref (e1);
+    ok (cache_entry_set_dirty (e3, false) == 0,
+        "cache_entry_set_dirty success");
+
+    ok ((e4 = cache_entry_create ("xxx4")) != NULL
+        && cache_insert (cache, e4) == 0,
+        "inserted entry xxx4 without data");
+    ok (cache_trim (cache) == 2,
+        "cache_trim removed 2 entries");
+    ok (cache_count_entries (cache) == 1
+        && cache_lookup (cache, "xxx4", 42) != NULL,
+        "only incomplete entry remains");
+    ok (cache_get_size (cache) == 0,
+        "cache_get_size returns 0");
+    ok (cache_count_evictions (cache) == 3,
+        "cache_count_evictions returns 3");
+
+    ok (cache_entry_set_raw (e4, "abcdefgh", 8) == 0,
+        "cache_entry_set_raw on inserted entry works");
+    ok (cache_expire_entries (cache, 43, 1) == 1,
+        "cache_expire_entries removes entry over size limit");
+    ok (cache_get_size (cache) == 0
+        && cache_count_entries (cache) == 0,
+        "cache is empty");
+
+    cache_destroy (cache);
+}
+
+/* A run of pinned entries at the LRU tail, longer than the per-call
+ * scan limit, must not prevent eviction of the entries behind it.
+ */
+void cache_lru_pinned_tests (void)
+{
+    struct cache *cache;
+    struct cache_entry *e;
+    char ref[64];
+    int i;
+
+    ok ((cache = cache_create ()) != NULL,
+        "cache_create works");
+    for (i = 0; i < 4096; i++) {
+        snprintf (ref, sizeof (ref), "pinned%d", i);
+        if (!(e = cache_entry_create (ref)) || cache_insert (cache, e) < 0)
+            BAIL_OUT ("failed to insert incomplete entry");
+    }
+    ok ((e = cache_entry_create ("clean")) != NULL
+        && cache_entry_set_raw (e, "abcd", 4) == 0
+        && cache_insert (cache, e) == 0,
+        "inserted clean entry behind 4096 incomplete entries");
+    cache_set_max_size (cache, 2);
+    ok (cache_trim (cache) == 1,
+        "cache_trim removed clean entry past pinned entries");
+    ok (cache_lookup (cache, "clean", 0) == NULL
+        && cache_get_size (cache) == 0,
+        "cache is within its size limit");
+    ok (cache_count_entries (cache) == 4096,
+        "incomplete entries remain");
+
+    cache_destroy (cache);
+}
+
 void cache_expiration_tests (void)
 {
     struct cache *cache;
@@ -710,6 +829,8 @@ int main (int argc, char *argv[])
     cache_entry_raw_and_treeobj_tests ();
     waiter_tests ();
     cache_expiration_tests ();
+    cache_lru_tests ();
+    cache_lru_pinned_tests ();
     cache_blobref_tests ();
     cache_remove_entry_tests ();
 
@@ -2828,6 +2828,140 @@ void kvstxn_process_giant_dir (void)
     json_decref (root);
 }
 
+/* Verify that the directory "dir" under 'root_ref' was stored as an hdir.
+ */
+void verify_hdir (struct cache *cache, const char *root_ref)
+{
+    struct cache_entry *entry;
+    const json_t *root, *dirref, *hdir;
+    const char *ref;
+
+    ok ((entry = cache_lookup (cache, root_ref, 0)) != NULL
+        && (root = cache_entry_get_treeobj (entry)) != NULL,
+        "root is in the cache");
+    ok ((dirref = treeobj_peek_entry (root, "dir")) != NULL
+        && treeobj_is_dirref (dirref)
+        && (ref = treeobj_get_blobref (dirref, 0)) != NULL,
+        "dir is a dirref");
+    ok ((entry = cache_lookup (cache, ref, 0)) != NULL
+        && (hdir = cache_entry_get_treeobj (entry)) != NULL
+        && treeobj_is_hdir (hdir)
+        && treeobj_hdir_get_level (hdir) == 0,
+        "dir was stored as a level 0 hdir");
+}
+
+void kvstxn_process_hdir (void)
+{
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt;
+    json_t *ops;
+    char rootref[BLOBREF_MAX_STRING_SIZE];
+    char newroot[BLOBREF_MAX_STRING_SIZE];
+    char key[64];
+    char val[64];
+    int i;
+
+    cache = create_cache_with_empty_rootdir (rootref, sizeof (rootref));
+
+    ok ((krm = kvsroot_mgr_create (NULL, NULL)) != NULL,
+        "kvsroot_mgr_create works");
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, rootref);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+
+    /* Use a small threshold so that "dir" is sharded.
+     */
+    kvstxn_mgr_set_hdir_threshold (ktm, 4);
+
+    ops = json_array ();
+    for (i = 0; i < 32; i++) {
+        snprintf (key, sizeof (key), "dir.key%d", i);
+        snprintf (val, sizeof (val), "%d", i);
+        ops_append (ops, key, val, 0);
+    }
+    ok (kvstxn_mgr_add_transaction (ktm, "transaction1", ops, 0) == 0,
+        "kvstxn_mgr_add_transaction works");
+    json_decref (ops);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    ok (kvstxn_process (kt, 1, rootref) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_noop_cb, NULL) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+
+    ok (kvstxn_process (kt, 1, rootref) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+
+    ok (kvstxn_get_newroot_ref (kt) != NULL,
+        "kvstxn_get_newroot_ref returns != NULL when processing complete");
+    strcpy (newroot, kvstxn_get_newroot_ref (kt));
+
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    verify_hdir (cache, newroot);
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key0", "0");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key17", "17");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key31", "31");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key32", NULL);
+
+    /* Update, add, and delete keys in the existing hdir.
+     */
+    strcpy (rootref, newroot);
+
+    ops = json_array ();
+    ops_append (ops, "dir.key5", "foo", 0);
+    ops_append (ops, "dir.key6", NULL, 0);
+    ops_append (ops, "dir.key40", "bar", 0);
+    ops_append (ops, "dir.nokey", NULL, 0);
+    ok (kvstxn_mgr_add_transaction (ktm, "transaction2", ops, 0) == 0,
+        "kvstxn_mgr_add_transaction works");
+    json_decref (ops);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    ok (kvstxn_process (kt, 1, rootref) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_noop_cb, NULL) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+
+    ok (kvstxn_process (kt, 1, rootref) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+
+    ok (kvstxn_get_newroot_ref (kt) != NULL,
+        "kvstxn_get_newroot_ref returns != NULL when processing complete");
+    strcpy (newroot, kvstxn_get_newroot_ref (kt));
+
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    verify_hdir (cache, newroot);
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key5", "foo");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key6", NULL);
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key40", "bar");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key17", "17");
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) == NULL,
+        "kvstxn_mgr_get_ready_transaction returns NULL, no more kvstxns");
+
+    kvstxn_mgr_destroy (ktm);
+    kvsroot_mgr_destroy (krm);
+    cache_destroy (cache);
+}
+
 void kvstxn_process_append (void)
 {
     struct cache *cache;
@@ -3399,6 +3533,7 @@ int main (int argc, char *argv[])
     kvstxn_process_bad_dirrefs ();
     kvstxn_process_big_fileval ();
     kvstxn_process_giant_dir ();
+    kvstxn_process_hdir ();
     kvstxn_process_append ();
     kvstxn_process_append_errors ();
     kvstxn_process_append_no_duplicate ();
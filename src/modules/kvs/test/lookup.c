@@ -668,6 +668,9 @@ void lookup_basic (void) {
     json_t *valref_multi;
     json_t *valref_multi_with_dirref;
     json_t *test;
+    json_t *val;
+    const void *rawdata;
+    int rawlen;
     struct cache *cache;
     kvsroot_mgr_t *krm;
     lookup_t *lh;
@@ -849,6 +852,52 @@ void lookup_basic (void) {
     check_value (lh, test, "lookup dirref.val");
     json_decref (test);
 
+    /* lookup raw value via valref with multiple blobrefs */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "dirref.valref_multi",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create on valref_multi");
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        "lookup valref_multi finished");
+    ok (lookup_get_value_raw (lh, &rawdata, &rawlen) == 0
+        && rawlen == 8
+        && memcmp (rawdata, "abcdefgh", 8) == 0,
+        "lookup_get_value_raw returned raw value of valref_multi");
+    test = treeobj_create_val ("abcdefgh", 8);
+    ok ((val = lookup_get_value (lh)) != NULL
+        && json_equal (val, test),
+        "lookup_get_value returned treeobj val created from raw value");
+    json_decref (val);
+    json_decref (test);
+    lookup_destroy (lh);
+
+    /* raw value is not available for val */
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "dirref.val",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create on path dirref.val");
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        "lookup dirref.val finished");
+    errno = 0;
+    ok (lookup_get_value_raw (lh, &rawdata, &rawlen) < 0
+        && errno == EINVAL,
+        "lookup_get_value_raw fails with EINVAL on val");
+    lookup_destroy (lh);
+
     /* lookup dir via dir */
     ok ((lh = lookup_create (cache,
                              krm,
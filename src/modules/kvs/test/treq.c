@@ -115,6 +115,9 @@ void treq_basic_tests (void)
     ok (treq_get_processed (tr) == true,
         "treq_get_processed returns true");
 
+    ok (treq_get_age (tr) >= 0.,
+        "treq_get_age works");
+
     flux_msg_destroy (request);
 
     treq_destroy (tr);
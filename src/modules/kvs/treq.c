@@ -23,6 +23,7 @@
 #include <jansson.h>
 
 #include "src/common/libutil/errno_safe.h"
+#include "src/common/libutil/monotime.h"
 
 #include "treq.h"
 
@@ -40,6 +41,7 @@ struct treq {
     json_t *ops;
     int flags;
     bool processed;
+    struct timespec t_start;
 };
 
 /*
@@ -201,6 +203,7 @@ static treq_t *treq_create_common (int nprocs, int flags)
     tr->nprocs = nprocs;
     tr->flags = flags;
     tr->processed = false;
+    monotime (&tr->t_start);
 
     return tr;
 error:
@@ -344,6 +347,11 @@ void treq_set_processed (treq_t *tr, bool p)
     tr->processed = p;
 }
 
+double treq_get_age (treq_t *tr)
+{
+    return monotime_since (tr->t_start);
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
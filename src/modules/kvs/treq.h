@@ -91,6 +91,10 @@ int treq_iter_request_copies (treq_t *tr, treq_msg_cb cb, void *data);
 bool treq_get_processed (treq_t *tr);
 void treq_set_processed (treq_t *tr, bool p);
 
+/* Return milliseconds elapsed since the transaction was created
+ */
+double treq_get_age (treq_t *tr);
+
 #endif /* !_FLUX_KVS_TREQ_H */
 
 /*
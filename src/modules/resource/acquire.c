@@ -15,9 +15,9 @@
  * Scheduler makes resource.acquire RPC.  Streaming responses are of the form:
  *
  * First response:
- *   {resources:resource_object up:idset}
+ *   {resources:resource_object up:idset gen:int}
  * Subsequent responses:
- *   {up?:idset down?:idset}
+ *   {up?:idset down?:idset gen:int}
  *
  * Where:
  * - resource_object maps execution target ids to resources
@@ -36,6 +36,14 @@
  * targets from the resource_object are marked "down".  On the next
  * scheduler reload, the resource set will omit those targets.
  *
+ * Subsequent responses carry only the targets whose state changed, as
+ * range-encoded idsets, so their size depends on the change and not on
+ * the size of the instance.  The generation 'gen' is 0 in the first
+ * response and increases by one in each subsequent response.  A client
+ * that sees a gap has lost track of the up set, and may resync by
+ * canceling the request and sending a new one, whose first response
+ * carries the complete up set.
+ *
  * RESOURCE OBJECT
  *
  * The hwloc.by_rank object format is used as a placeholder until
@@ -76,11 +84,16 @@
 #include "monitor.h"
 #include "rutil.h"
 
+enum {
+    DEBUG_DROP_RESPONSE_ONESHOT = 1, /* drop the next update response */
+};
+
 struct acquire_request {
     struct acquire *acquire;
 
     const flux_msg_t *msg;              // orig request
     int response_count;                 // count of response messages sent
+    int generation;                     // 'gen' of current up set
 
     json_t *resources;                  // resource object
     struct idset *valid;                // valid targets
@@ -143,34 +156,116 @@ static int acquire_request_init (struct acquire_request *ar,
     return 0;
 }
 
-/* reslog_cb() says 'name' event occurred.
- * If anything changed with respect to target availability, populate
- * up and/or down idsets with the changes.
- * Replace ar->up with new set of available targets.
+/* Return true if valid target 'id' is currently available.
+ */
+static bool acquire_request_test_up (struct acquire_request *ar,
+                                     unsigned int id)
+{
+    struct resource_ctx *ctx = ar->acquire->ctx;
+    const struct idset *drain = drain_get (ctx->drain);
+    const struct idset *exclude = exclude_get (ctx->exclude);
+
+    if (!idset_test (ar->valid, id))
+        return false;
+    if (drain && idset_test (drain, id))
+        return false;
+    if (exclude && idset_test (exclude, id))
+        return false;
+    return idset_test (monitor_get_up (ctx->monitor), id);
+}
+
+/* Add 'id' to '*ids', creating it if necessary.
+ */
+static int idset_set_create (struct idset **ids, unsigned int id)
+{
+    if (!*ids && !(*ids = idset_create (0, IDSET_FLAG_AUTOGROW)))
+        return -1;
+    return idset_set (*ids, id);
+}
+
+/* Apply changes to 'up' all or nothing.
+ */
+static int idset_update (struct idset *up,
+                         const struct idset *add,
+                         const struct idset *sub)
+{
+    unsigned int id;
+    unsigned int undo;
+
+    id = idset_first (add);
+    while (id != IDSET_INVALID_ID) {
+        if (idset_set (up, id) < 0)
+            goto error;
+        id = idset_next (add, id);
+    }
+    id = idset_first (sub);
+    while (id != IDSET_INVALID_ID) {
+        (void)idset_clear (up, id);
+        id = idset_next (sub, id);
+    }
+    return 0;
+error:
+    undo = idset_first (add);
+    while (undo != id) {
+        (void)idset_clear (up, undo);
+        undo = idset_next (add, undo);
+    }
+    return -1;
+}
+
+/* reslog_cb() says an event changing the availability of the targets
+ * in its context 'idset' occurred.  Re-evaluate only those targets,
+ * so the cost is proportional to the size of the change, not the
+ * instance.  Populate up and/or down idsets with the targets that
+ * changed state (NULL if none).  If there are any, apply them to ar->up
+ * and advance the generation, whether or not the response carrying them
+ * is later sent, so that a lost response leaves a gap the client can
+ * detect.  On failure, ar->up and the generation are unchanged.
  */
 static int acquire_request_update (struct acquire_request *ar,
-                                   const char *name,
+                                   json_t *context,
                                    struct idset **up,
                                    struct idset **dn)
 {
-    struct resource_ctx *ctx = ar->acquire->ctx;
-    struct idset *new_up;
-
-    if (!(new_up = idset_copy (ar->valid)))
+    const char *s;
+    struct idset *ids;
+    struct idset *add = NULL;
+    struct idset *sub = NULL;
+    unsigned int id;
+
+    if (!context || json_unpack (context, "{s:s}", "idset", &s) < 0) {
+        errno = EPROTO;
         return -1;
-    if (rutil_idset_sub (new_up, drain_get (ctx->drain)) < 0)
-        goto error;
-    if (rutil_idset_sub (new_up, monitor_get_down (ctx->monitor)) < 0)
-        goto error;
-    if (rutil_idset_sub (new_up, exclude_get (ctx->exclude)) < 0)
-        goto error;
-    if (rutil_idset_diff (ar->up, new_up, up, dn) < 0)
-        goto error;
-    idset_destroy (ar->up);
-    ar->up = new_up;
+    }
+    if (!(ids = idset_decode (s)))
+        return -1;
+    id = idset_first (ids);
+    while (id != IDSET_INVALID_ID) {
+        bool is_up = acquire_request_test_up (ar, id);
+
+        if (is_up && !idset_test (ar->up, id)) {
+            if (idset_set_create (&add, id) < 0)
+                goto error;
+        }
+        else if (!is_up && idset_test (ar->up, id)) {
+            if (idset_set_create (&sub, id) < 0)
+                goto error;
+        }
+        id = idset_next (ids, id);
+    }
+    if (add || sub) {
+        if (idset_update (ar->up, add, sub) < 0)
+            goto error;
+        ar->generation++;
+    }
+    idset_destroy (ids);
+    *up = add;
+    *dn = sub;
     return 0;
 error:
-    idset_destroy (new_up);
+    ERRNO_SAFE_WRAP (idset_destroy, ids);
+    ERRNO_SAFE_WRAP (idset_destroy, add);
+    ERRNO_SAFE_WRAP (idset_destroy, sub);
     return -1;
 }
 
@@ -187,10 +282,13 @@ static int acquire_respond_first (struct acquire_request *ar)
         goto nomem;
     if (rutil_set_json_idset (o, "up", ar->up) < 0)
         goto error;
+    if (json_object_set_new (o, "gen", json_integer (0)) < 0)
+        goto nomem;
     if (flux_respond_pack (ar->acquire->ctx->h, ar->msg, "O", o) < 0)
         goto error;
     json_decref (o);
     ar->response_count++;
+    ar->generation = 0;
     return 0;
 nomem:
     errno = ENOMEM;
@@ -200,7 +298,8 @@ error:
 }
 
 /* Send a subsequent response to resource.acquire request, driven by
- * reslog_cb().
+ * reslog_cb().  The generation was already advanced by
+ * acquire_request_update().
  */
 static int acquire_respond_next (struct acquire_request *ar,
                                  struct idset *up,
@@ -214,6 +313,8 @@ static int acquire_respond_next (struct acquire_request *ar,
         goto error;
     if (down && rutil_set_json_idset (o, "down", down) < 0)
         goto error;
+    if (json_object_set_new (o, "gen", json_integer (ar->generation)) < 0)
+        goto nomem;
     if (flux_respond_pack (ar->acquire->ctx->h, ar->msg, "O", o) < 0)
         goto error;
     json_decref (o);
@@ -309,7 +410,10 @@ void acquire_disconnect (struct acquire *acquire, const flux_msg_t *msg)
  * FWIW, this function is not called until after the eventlog KVS
  * commit completes.
  */
-static void reslog_cb (struct reslog *reslog, const char *name, void *arg)
+static void reslog_cb (struct reslog *reslog,
+                       const char *name,
+                       json_t *context,
+                       void *arg)
 {
     struct acquire *acquire = arg;
     struct resource_ctx *ctx = acquire->ctx;
@@ -345,12 +449,25 @@ static void reslog_cb (struct reslog *reslog, const char *name, void *arg)
             || !strcmp (name, "drain") || !strcmp (name, "undrain")) {
         if (acquire->request->response_count > 0) {
             struct idset *up, *dn;
-            if (acquire_request_update (acquire->request, name, &up, &dn) < 0) {
+            if (acquire_request_update (acquire->request,
+                                        context,
+                                        &up,
+                                        &dn) < 0) {
                 errmsg = "error preparing resource.acquire update response";
                 goto error;
             }
             if (up || dn) {
-                if (acquire_respond_next (acquire->request, up, dn) < 0) {
+                /* Test hook: when set, drop one update response.
+                 */
+                if (flux_module_debug_test (ctx->h,
+                                            DEBUG_DROP_RESPONSE_ONESHOT,
+                                            true)) {
+                    flux_log (ctx->h,
+                              LOG_ERR,
+                              "resource.acquire gen=%d dropped by debug flag",
+                              acquire->request->generation);
+                }
+                else if (acquire_respond_next (acquire->request, up, dn) < 0) {
                     flux_log_error (ctx->h,
                                     "error responding to resource.acquire (%s)",
                                     name);
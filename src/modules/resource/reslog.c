@@ -33,18 +33,23 @@ struct reslog {
 
 static const char *auxkey = "flux::event_info";
 
-/* Call registered callback, if any, with the event name that just completed.
+/* Call registered callback, if any, with the event name and context
+ * that just completed.
  */
 static void notify_callback (struct reslog *reslog, json_t *event)
 {
     if (reslog->cb) {
         const char *name;
+        json_t *context = NULL;
 
-        if (json_unpack (event, "{s:s}", "name", &name) < 0) {
+        if (json_unpack (event,
+                         "{s:s s?o}",
+                         "name", &name,
+                         "context", &context) < 0) {
             flux_log (reslog->h, LOG_ERR, "error unpacking event for callback");
             return;
         }
-        reslog->cb (reslog, name, reslog->cb_arg);
+        reslog->cb (reslog, name, context, reslog->cb_arg);
     }
 }
 
@@ -27,15 +27,8 @@ int rutil_idset_sub (struct idset *ids1, const struct idset *ids2)
         errno = EINVAL;
         return -1;
     }
-    if (ids2) {
-        unsigned int id;
-        id = idset_first (ids2);
-        while (id != IDSET_INVALID_ID) {
-            if (idset_clear (ids1, id) < 0)
-                return -1;
-            id = idset_next (ids2, id);
-        }
-    }
+    if (ids2)
+        return idset_subtract (ids1, ids2);
     return 0;
 }
 
@@ -45,15 +38,8 @@ int rutil_idset_add (struct idset *ids1, const struct idset *ids2)
         errno = EINVAL;
         return -1;
     }
-    if (ids2) {
-        unsigned int id;
-        id = idset_first (ids2);
-        while (id != IDSET_INVALID_ID) {
-            if (idset_set (ids1, id) < 0)
-                return -1;
-            id = idset_next (ids2, id);
-        }
-    }
+    if (ids2)
+        return idset_add (ids1, ids2);
     return 0;
 }
 
@@ -69,6 +55,28 @@ int rutil_idset_decode_add (struct idset *ids1, const char *s)
     return rc;
 }
 
+/* Return a copy of 'ids1' without the members of 'ids2' (which may be NULL),
+ * or NULL with errno == 0 if nothing remains.
+ */
+static struct idset *idset_diff_nonempty (const struct idset *ids1,
+                                          const struct idset *ids2)
+{
+    struct idset *ids;
+
+    if (ids2)
+        ids = idset_difference (ids1, ids2);
+    else
+        ids = idset_copy (ids1);
+    if (!ids)
+        return NULL;
+    if (idset_count (ids) == 0) {
+        idset_destroy (ids);
+        errno = 0;
+        return NULL;
+    }
+    return ids;
+}
+
 int rutil_idset_diff (const struct idset *ids1,
                       const struct idset *ids2,
                       struct idset **addp,
@@ -76,35 +84,18 @@ int rutil_idset_diff (const struct idset *ids1,
 {
     struct idset *add = NULL;
     struct idset *sub = NULL;
-    unsigned int id;
 
     if (!addp || !subp) {
         errno = EINVAL;
         return -1;
     }
     if (ids1) { // find ids in ids1 but not in ids2, and add to 'sub'
-        id = idset_first (ids1);
-        while (id != IDSET_INVALID_ID) {
-            if (!ids2 || !idset_test (ids2, id)) {
-                if (!sub && !(sub = idset_create (0, IDSET_FLAG_AUTOGROW)))
-                    goto error;
-                if (idset_set (sub, id) < 0)
-                    goto error;
-            }
-            id = idset_next (ids1, id);
-        }
+        if (!(sub = idset_diff_nonempty (ids1, ids2)) && errno != 0)
+            goto error;
     }
     if (ids2) { // find ids in ids2 but not in ids1, and add to 'add'
-        id = idset_first (ids2);
-        while (id != IDSET_INVALID_ID) {
-            if (!ids1 || !idset_test (ids1, id)) {
-                if (!add && !(add = idset_create (0, IDSET_FLAG_AUTOGROW)))
-                    goto error;
-                if (idset_set (add, id) < 0)
-                    goto error;
-            }
-            id = idset_next (ids2, id);
-        }
+        if (!(add = idset_diff_nonempty (ids2, ids1)) && errno != 0)
+            goto error;
     }
     *addp = add;
     *subp = sub;
@@ -149,20 +140,8 @@ struct idset *rutil_idset_from_resobj (const json_t *resobj)
         return NULL;
     if (resobj) {
         json_object_foreach ((json_t *)resobj, key, val) {
-            struct idset *valset;
-            unsigned long id;
-
-            if (!(valset = idset_decode (key)))
+            if (rutil_idset_decode_add (ids, key) < 0)
                 goto error;
-            id = idset_first (valset);
-            while (id != IDSET_INVALID_ID) {
-                if (idset_set (ids, id) < 0) {
-                    idset_destroy (valset);
-                    goto error;
-                }
-                id = idset_next (valset, id);
-            }
-            idset_destroy (valset);
         }
     }
     return ids;
@@ -238,6 +238,24 @@ void test_idset_diff (void)
 
     idset_destroy (ids1);
     idset_destroy (ids2);
+
+    if (!(ids1 = idset_decode ("0-16383")) || !(ids2 = idset_copy (ids1)))
+        BAIL_OUT ("idset_decode/copy failed");
+    if (idset_range_clear (ids2, 100, 199) < 0
+        || idset_range_set (ids2, 16384, 16387) < 0)
+        BAIL_OUT ("idset_range_clear/set failed");
+    add = sub = NULL;
+    ok (rutil_idset_diff (ids1, ids2, &add, &sub) == 0
+        && add != NULL && idset_count (add) == 4
+        && idset_first (add) == 16384
+        && sub != NULL && idset_count (sub) == 100
+        && idset_first (sub) == 100 && idset_last (sub) == 199,
+        "rutil_idset_diff [0-16383] [0-99,200-16387] sets add=[16384-16387] sub=[100-199]");
+    idset_destroy (add);
+    idset_destroy (sub);
+
+    idset_destroy (ids1);
+    idset_destroy (ids2);
 }
 
 void test_set_json_idset (void)
@@ -20,6 +20,7 @@
 #include <jansson.h>
 
 #include "src/common/libidset/idset.h"
+#include "src/common/librlite/rlite.h"
 #include "rnode.h"
 #include "rlist.h"
 #include "libjj.h"
@@ -27,7 +28,12 @@
 void rlist_destroy (struct rlist *rl)
 {
     if (rl) {
+        int i;
+        zhashx_destroy (&rl->rank_index);
         zlistx_destroy (&rl->nodes);
+        for (i = 0; i < rl->avail_index_size; i++)
+            idset_destroy (rl->avail_index[i]);
+        free (rl->avail_index);
         free (rl);
     }
 }
@@ -38,18 +44,114 @@ static void rn_free_fn (void **x)
     *x = NULL;
 }
 
+/* Hash numerical rank in 'key'.
+ * N.B. zhashx_hash_fn signature
+ */
+static size_t rank_hasher (const void *key)
+{
+    const uint32_t *rank = key;
+    return *rank;
+}
+
+#define NUMCMP(a,b) ((a)==(b)?0:((a)<(b)?-1:1))
+
+/* Compare hash keys.
+ * N.B. zhashx_comparator_fn signature
+ */
+static int rank_hash_key_cmp (const void *key1, const void *key2)
+{
+    const uint32_t *rank1 = key1;
+    const uint32_t *rank2 = key2;
+
+    return NUMCMP (*rank1, *rank2);
+}
+
 struct rlist *rlist_create (void)
 {
     struct rlist *rl = calloc (1, sizeof (*rl));
-    if (!(rl->nodes = zlistx_new ()))
+    if (!rl)
+        return NULL;
+    if (!(rl->nodes = zlistx_new ())
+        || !(rl->rank_index = zhashx_new ()))
         goto err;
     zlistx_set_destructor (rl->nodes, rn_free_fn);
+    zhashx_set_key_hasher (rl->rank_index, rank_hasher);
+    zhashx_set_key_comparator (rl->rank_index, rank_hash_key_cmp);
+    zhashx_set_key_duplicator (rl->rank_index, NULL);
+    zhashx_set_key_destructor (rl->rank_index, NULL);
     return (rl);
 err:
     rlist_destroy (rl);
     return (NULL);
 }
 
+/*  Ensure the avail index has a bucket for every possible number of
+ *   available ids on node `n`, and that each of those buckets is large
+ *   enough to hold n->rank, so that later index updates cannot fail.
+ */
+static int rlist_index_reserve (struct rlist *rl, struct rnode *n)
+{
+    int count = rnode_count (n);
+    int i;
+
+    if (count >= rl->avail_index_size) {
+        struct idset **new;
+        if (!(new = realloc (rl->avail_index, (count + 1) * sizeof (*new))))
+            return -1;
+        rl->avail_index = new;
+        while (rl->avail_index_size <= count) {
+            struct idset *bucket = idset_create (0, IDSET_FLAG_AUTOGROW);
+            if (!bucket)
+                return -1;
+            rl->avail_index[rl->avail_index_size++] = bucket;
+        }
+    }
+    for (i = 0; i <= count; i++) {
+        struct idset *bucket = rl->avail_index[i];
+        if (!idset_test (bucket, n->rank)) {
+            if (idset_set (bucket, n->rank) < 0)
+                return -1;
+            idset_clear (bucket, n->rank);
+        }
+    }
+    return 0;
+}
+
+/*  Add node `n` to the avail index according to its current state.
+ *   rlist_index_remove() must be called before any change to the up/down
+ *   state or available ids of `n`, and rlist_index_add() after.
+ */
+static void rlist_index_add (struct rlist *rl, struct rnode *n)
+{
+    if (n->up)
+        idset_set (rl->avail_index[rnode_avail (n)], n->rank);
+}
+
+static void rlist_index_remove (struct rlist *rl, struct rnode *n)
+{
+    if (n->up)
+        idset_clear (rl->avail_index[rnode_avail (n)], n->rank);
+}
+
+/*  Append new node `n` to rlist `rl` and index it.
+ */
+static int rlist_insert_rnode (struct rlist *rl, struct rnode *n)
+{
+    if (rlist_index_reserve (rl, n) < 0)
+        return -1;
+    if (zhashx_insert (rl->rank_index, &n->rank, n) < 0) {
+        errno = EEXIST;
+        return -1;
+    }
+    if (!zlistx_add_end (rl->nodes, n)) {
+        zhashx_delete (rl->rank_index, &n->rank);
+        errno = ENOMEM;
+        return -1;
+    }
+    rlist_index_add (rl, n);
+    return 0;
+}
+
 struct rlist *rlist_copy_empty (const struct rlist *orig)
 {
     struct rnode *n;
@@ -59,8 +161,10 @@ struct rlist *rlist_copy_empty (const struct rlist *orig)
     n = zlistx_first (orig->nodes);
     while (n) {
         n = rnode_create_idset (n->rank, n->ids);
-        if (!n || !zlistx_add_end (rl->nodes, n))
+        if (!n || rlist_insert_rnode (rl, n) < 0) {
+            rnode_destroy (n);
             goto fail;
+        }
         rl->total += rnode_count (n);
         n = zlistx_next (orig->nodes);
     }
@@ -81,8 +185,10 @@ struct rlist *rlist_copy_down (const struct rlist *orig)
     while (n) {
         if (!n->up) {
             n = rnode_create_idset (n->rank, n->ids);
-            if (!n || !zlistx_add_end (rl->nodes, n))
+            if (!n || rlist_insert_rnode (rl, n) < 0) {
+                rnode_destroy (n);
                 goto fail;
+            }
             rl->total += rnode_count (n);
         }
         n = zlistx_next (orig->nodes);
@@ -94,26 +200,10 @@ fail:
     return NULL;
 }
 
-static struct idset *idset_subtract (const struct idset *orig, struct idset *x)
-{
-    struct idset *ids = idset_copy (orig);
-    unsigned int i;
-
-    if (!ids)
-        return NULL;
-
-    i = idset_first (x);
-    while (i != IDSET_INVALID_ID) {
-        idset_clear (ids, i);
-        i = idset_next (x, i);
-    }
-    return ids;
-}
-
 static struct rnode *rnode_create_alloc (const struct rnode *n)
 {
     struct rnode *result;
-    struct idset *ids = idset_subtract (n->ids, n->avail);
+    struct idset *ids = idset_difference (n->ids, n->avail);
     if (!ids)
         return NULL;
     result = rnode_create_idset (n->rank, ids);
@@ -132,8 +222,10 @@ struct rlist *rlist_copy_allocated (const struct rlist *orig)
         int nalloc = idset_count (n->ids) - idset_count (n->avail);
         if (nalloc > 0) {
             n = rnode_create_alloc (n);
-            if (!n || !zlistx_add_end (rl->nodes, n))
+            if (!n || rlist_insert_rnode (rl, n) < 0) {
+                rnode_destroy (n);
                 goto fail;
+            }
             rl->total += nalloc;
         }
         n = zlistx_next (orig->nodes);
@@ -147,13 +239,7 @@ fail:
 
 static struct rnode *rlist_find_rank (struct rlist *rl, uint32_t rank)
 {
-    struct rnode *n = zlistx_first (rl->nodes);
-    while (n) {
-        if (n->rank == rank)
-            return (n);
-        n = zlistx_next (rl->nodes);
-    }
-    return NULL;
+    return zhashx_lookup (rl->rank_index, &rank);
 }
 
 /*  Compare two values from idset_first()/idset_next():
@@ -194,46 +280,29 @@ static int idset_cmp (struct idset *set1, struct idset *set2)
 
 static int idset_add_set (struct idset *set, struct idset *new)
 {
-    unsigned int i = idset_first (new);
-    while (i != IDSET_INVALID_ID) {
-        if (idset_test (set, i)) {
-            errno = EEXIST;
-            return -1;
-        }
-        if (idset_set (set, i) < 0)
-            return -1;
-        i = idset_next (new, i);
-    }
-    return 0;
-}
-
-static int idset_remove_set (struct idset *set, struct idset *remove)
-{
-    unsigned int i = idset_first (remove);
-    while (i != IDSET_INVALID_ID) {
-        if (!idset_test (set, i)) {
-            errno = ENOENT;
-            return -1;
-        }
-        if (idset_clear (set, i) < 0)
-            return -1;
-        i = idset_next (remove, i);
+    if (idset_has_intersection (set, new)) {
+        errno = EEXIST;
+        return -1;
     }
-    return 0;
+    return idset_add (set, new);
 }
 
 static int rlist_add_rnode (struct rlist *rl, struct rnode *n)
 {
     struct rnode *found = rlist_find_rank (rl, n->rank);
     if (found) {
+        int rc;
         if (idset_add_set (found->ids, n->ids) < 0)
             return (-1);
-        if (idset_add_set (found->avail, n->avail) < 0) {
-            idset_remove_set (found->ids, n->ids);
+        rlist_index_remove (rl, found);
+        if ((rc = rlist_index_reserve (rl, found)) < 0
+            || (rc = idset_add_set (found->avail, n->avail)) < 0)
+            idset_subtract (found->ids, n->ids);
+        rlist_index_add (rl, found);
+        if (rc < 0)
             return (-1);
-        }
     }
-    else if (!zlistx_add_end (rl->nodes, n))
+    else if (rlist_insert_rnode (rl, n) < 0)
         return -1;
     rl->total += rnode_count (n);
     if (n->up)
@@ -332,7 +401,7 @@ err:
     return rc;
 }
 
-int rlist_append_idset (struct rlist *rl, int rank, struct idset *idset)
+int rlist_append_idset (struct rlist *rl, int rank, const struct idset *idset)
 {
     struct rnode *n = rnode_create_idset (rank, idset);
     if (!n || rlist_add_rnode (rl, n) < 0) {
@@ -342,50 +411,35 @@ int rlist_append_idset (struct rlist *rl, int rank, struct idset *idset)
     return 0;
 }
 
-static int rlist_append_rank_entry (struct rlist *rl, json_t *entry,
-                                    json_error_t *ep)
-{
-    const char *ranks;
-    const char *cores;
-    if (json_unpack_ex (entry, ep, 0,
-                        "{s:s,s:{s:s}}",
-                        "rank", &ranks,
-                        "children", "core", &cores) < 0) {
-        return -1;
-    }
-    return rlist_append_ranks (rl, ranks, cores);
-}
-
 struct rlist *rlist_from_R (const char *s)
 {
-    int i, version;
     struct rlist *rl = NULL;
-    json_t *entry = NULL;
-    json_t *R_lite = NULL;
-    json_error_t error;
+    struct rlite *R;
+    int i;
 
-    json_t *o = json_loads (s, 0, NULL);
-    if (o == NULL)
+    if (!(R = rlite_create (s, 0, NULL)))
         return NULL;
-    if (!o || json_unpack_ex (o, &error, 0,
-                              "{s:i,s:{s:o}}",
-                              "version", &version,
-                              "execution", "R_lite", &R_lite) < 0) {
-        goto err;
-    }
-    if (version != 1)
-        goto err;
     if (!(rl = rlist_create ()))
         goto err;
-    json_array_foreach (R_lite, i, entry) {
-        if (rlist_append_rank_entry (rl, entry, &error) < 0)
+    for (i = 0; i < rlite_entry_count (R); i++) {
+        const struct idset *ranks = rlite_entry_ranks (R, i);
+        const struct idset *cores = rlite_entry_cores (R, i);
+        unsigned int rank;
+
+        if (idset_count (cores) == 0)   // R_lite entry without cores
             goto err;
+        rank = idset_first (ranks);
+        while (rank != IDSET_INVALID_ID) {
+            if (rlist_append_idset (rl, rank, cores) < 0)
+                goto err;
+            rank = idset_next (ranks, rank);
+        }
     }
-    json_decref (o);
+    rlite_destroy (R);
     return (rl);
 err:
     rlist_destroy (rl);
-    json_decref (o);
+    rlite_destroy (R);
     return (NULL);
 }
 
@@ -607,16 +661,6 @@ static int by_rank (const void *item1, const void *item2)
     return (x->rank - y->rank);
 }
 
-static int by_avail (const void *item1, const void *item2)
-{
-    int n;
-    const struct rnode *x = item1;
-    const struct rnode *y = item2;
-    if ((n = rnode_avail (x) - rnode_avail (y)) == 0)
-        n = by_rank (x, y);
-    return n;
-}
-
 static int by_used (const void *item1, const void *item2)
 {
     int n;
@@ -630,7 +674,13 @@ static int by_used (const void *item1, const void *item2)
 static int rlist_rnode_alloc (struct rlist *rl, struct rnode *n,
                               int count, struct idset **idsetp)
 {
-    if (!n || rnode_alloc (n, count, idsetp) < 0)
+    int rc;
+    if (!n)
+        return -1;
+    rlist_index_remove (rl, n);
+    rc = rnode_alloc (n, count, idsetp);
+    rlist_index_add (rl, n);
+    if (rc < 0)
         return -1;
     rl->avail -= idset_count (*idsetp);
     return 0;
@@ -647,49 +697,88 @@ static uint32_t rlist_rnode_rank (struct rlist *rl)
 }
 #endif
 
-static struct rnode *rlist_first (struct rlist *rl)
+/*  Node selection policies: return the up node with at least `count`
+ *   available ids that sorts first under the policy, or NULL if there is
+ *   no such node. Each policy visits at most one avail index bucket per
+ *   possible number of available ids, independent of the number of nodes.
+ */
+typedef struct rnode * (*rlist_select_f) (struct rlist *rl, int count);
+
+/*  Lowest rank.
+ */
+static struct rnode *rlist_select_first_fit (struct rlist *rl, int count)
 {
-    return zlistx_first (rl->nodes);
+    unsigned int rank = IDSET_INVALID_ID;
+    int i;
+
+    for (i = count; i < rl->avail_index_size; i++) {
+        unsigned int first = idset_first (rl->avail_index[i]);
+        if (first != IDSET_INVALID_ID && (rank == IDSET_INVALID_ID
+                                          || first < rank))
+            rank = first;
+    }
+    if (rank == IDSET_INVALID_ID)
+        return NULL;
+    return rlist_find_rank (rl, rank);
 }
 
-static struct rnode *rlist_next (struct rlist *rl)
+/*  Fewest available ids, then lowest rank.
+ */
+static struct rnode *rlist_select_best_fit (struct rlist *rl, int count)
 {
-    return zlistx_next (rl->nodes);
+    int i;
+
+    for (i = count; i < rl->avail_index_size; i++) {
+        unsigned int rank = idset_first (rl->avail_index[i]);
+        if (rank != IDSET_INVALID_ID)
+            return rlist_find_rank (rl, rank);
+    }
+    return NULL;
+}
+
+/*  Most available ids, then lowest rank.
+ */
+static struct rnode *rlist_select_worst_fit (struct rlist *rl, int count)
+{
+    int i;
+
+    for (i = rl->avail_index_size - 1; i >= count; i--) {
+        unsigned int rank = idset_first (rl->avail_index[i]);
+        if (rank != IDSET_INVALID_ID)
+            return rlist_find_rank (rl, rank);
+    }
+    return NULL;
 }
 
 /*
- *  Allocate the first available N slots of size cores_per_slot from
- *   resource list rl after sorting the nodes with the current sort strategy.
+ *  Allocate N slots of size cores_per_slot from resource list rl,
+ *   filling each node chosen by the selection policy before moving on.
+ *   This places slots exactly as walking the node list sorted by the
+ *   policy would, without sorting the list.
  */
-static struct rlist * rlist_alloc_first_fit (struct rlist *rl,
-                                             int cores_per_slot,
-                                             int slots)
+static struct rlist * rlist_alloc_slots (struct rlist *rl,
+                                         rlist_select_f select,
+                                         int cores_per_slot,
+                                         int slots)
 {
     int rc;
     struct idset *ids = NULL;
     struct rnode *n = NULL;
     struct rlist *result = NULL;
 
-    zlistx_sort (rl->nodes);
-
-    if (!(n = rlist_first (rl)))
-        return NULL;
-
     if (!(result = rlist_create ()))
         return NULL;
 
-    /* 2. assign slots to first nodes where they fit
-     */
-    while (n && slots) {
-        /*  Try to allocate a slot on this node. If we fail with ENOSPC,
-         *   then advance to the next node and try again.
+    while (slots) {
+        /*  Stay on the current node while slots fit, o/w select the
+         *   next node. If there is none, the allocation cannot be satisfied.
          */
-        if ((rc = rlist_rnode_alloc (rl, n, cores_per_slot, &ids)) < 0) {
-            if (errno != ENOSPC)
+        if (!n || rnode_avail (n) < cores_per_slot) {
+            if (!(n = select (rl, cores_per_slot)))
                 goto unwind;
-            n = rlist_next (rl);
-            continue;
         }
+        if (rlist_rnode_alloc (rl, n, cores_per_slot, &ids) < 0)
+            goto unwind;
         /*  Append the allocated cores to the result set and continue
          *   if needed
          */
@@ -699,68 +788,86 @@ static struct rlist * rlist_alloc_first_fit (struct rlist *rl,
             goto unwind;
         slots--;
     }
-    if (slots != 0) {
-unwind:
-        rlist_free (rl, result);
-        rlist_destroy (result);
-        errno = ENOSPC;
-        return NULL;
-    }
     return result;
+unwind:
+    rlist_free (rl, result);
+    rlist_destroy (result);
+    errno = ENOSPC;
+    return NULL;
+}
+
+/*
+ *  Allocate the first available N slots of size cores_per_slot from
+ *   resource list rl in rank order.
+ */
+static struct rlist * rlist_alloc_first_fit (struct rlist *rl,
+                                             int cores_per_slot,
+                                             int slots)
+{
+    return rlist_alloc_slots (rl,
+                              rlist_select_first_fit,
+                              cores_per_slot,
+                              slots);
 }
 
 /*
  *  Allocate `slots` of size cores_per_slot from rlist `rl` and return
- *   the result. Sorts the node list by smallest available first, so that
+ *   the result. Selects nodes with smallest available first, so that
  *   we get something like "best fit". (minimize nodes used)
  */
 static struct rlist * rlist_alloc_best_fit (struct rlist *rl,
                                             int cores_per_slot,
                                             int slots)
 {
-    zlistx_set_comparator (rl->nodes, by_avail);
-    return rlist_alloc_first_fit (rl, cores_per_slot, slots);
+    return rlist_alloc_slots (rl,
+                              rlist_select_best_fit,
+                              cores_per_slot,
+                              slots);
 }
 
 /*
  *  Allocate `slots` of size cores_per_slot from rlist `rl` and return
- *   the result. Sorts the node list by least utilized first, so that
+ *   the result. Selects least utilized nodes first, so that
  *   we get something like "worst fit". (Spread jobs across nodes)
  */
 static struct rlist * rlist_alloc_worst_fit (struct rlist *rl,
                                              int cores_per_slot,
                                              int slots)
 {
-    zlistx_set_comparator (rl->nodes, by_used);
-    return rlist_alloc_first_fit (rl, cores_per_slot, slots);
+    return rlist_alloc_slots (rl,
+                              rlist_select_worst_fit,
+                              cores_per_slot,
+                              slots);
 }
 
-
+/*  Return a list of the `nnodes` least utilized up nodes (see by_used()),
+ *   obtained by walking the avail index from most to least available.
+ */
 static zlistx_t *rlist_get_nnodes (struct rlist *rl, int nnodes)
 {
-    struct rnode *n;
     zlistx_t *l = zlistx_new ();
+    int i;
     if (!l)
         return NULL;
-    n = zlistx_first (rl->nodes);
-    while (nnodes > 0) {
-        if (n == NULL) {
-            errno = ENOSPC;
-            goto err;
-        }
-        if (n->up) {
-            if (zlistx_add_end (l, n) < 0)
+    for (i = rl->avail_index_size - 1; i >= 0 && nnodes > 0; i--) {
+        struct idset *bucket = rl->avail_index[i];
+        unsigned int rank = idset_first (bucket);
+        while (rank != IDSET_INVALID_ID && nnodes > 0) {
+            if (!zlistx_add_end (l, rlist_find_rank (rl, rank)))
                 goto err;
             nnodes--;
+            rank = idset_next (bucket, rank);
         }
-        n = zlistx_next (rl->nodes);
+    }
+    if (nnodes > 0) {
+        errno = ENOSPC;
+        goto err;
     }
     return (l);
 err:
     zlistx_destroy (&l);
     return NULL;
 }
-
 /*  Allocate 'slots' of size 'cores_per_slot' across exactly `nnodes`.
  *  Works by getting the first N least utilized nodes and spreading
  *  the nslots evenly across the result.
@@ -783,12 +890,7 @@ static struct rlist *rlist_alloc_nnodes (struct rlist *rl, int nnodes,
     if (!(result = rlist_create ()))
         return NULL;
 
-    /* 1. sort rank list by used cores ascending:
-     */
-    zlistx_set_comparator (rl->nodes, by_used);
-    zlistx_sort (rl->nodes);
-
-    /* 2. get a list of the first up n nodes
+    /* 1. get a list of the n least utilized up nodes
      */
     if (!(cl = rlist_get_nnodes (rl, nnodes)))
         goto unwind;
@@ -799,7 +901,7 @@ static struct rlist *rlist_alloc_nnodes (struct rlist *rl, int nnodes,
     zlistx_set_comparator (cl, by_used);
 
     /*
-     * 3. divide slots across all nodes, placing each slot
+     * 2. divide slots across all nodes, placing each slot
      *    on most empty node first
      */
     while (slots > 0) {
@@ -849,9 +951,6 @@ static struct rlist *rlist_try_alloc (struct rlist *rl, const char *mode,
         return NULL;
     }
 
-    /*  Reset default sort to order nodes by "rank" */
-    zlistx_set_comparator (rl->nodes, by_rank);
-
     if (nnodes > 0)
         result = rlist_alloc_nnodes (rl, nnodes, cores_per_slot, slots);
     else if (mode == NULL || strcmp (mode, "worst-fit") == 0)
@@ -919,12 +1018,16 @@ struct rlist *rlist_alloc (struct rlist *rl, const char *mode,
 
 static int rlist_free_rnode (struct rlist *rl, struct rnode *n)
 {
+    int rc;
     struct rnode *rnode = rlist_find_rank (rl, n->rank);
     if (!rnode) {
         errno = ENOENT;
         return -1;
     }
-    if (rnode_free_idset (rnode, n->ids) < 0)
+    rlist_index_remove (rl, rnode);
+    rc = rnode_free_idset (rnode, n->ids);
+    rlist_index_add (rl, rnode);
+    if (rc < 0)
         return -1;
     if (rnode->up)
         rl->avail += idset_count (n->ids);
@@ -933,12 +1036,16 @@ static int rlist_free_rnode (struct rlist *rl, struct rnode *n)
 
 static int rlist_alloc_rnode (struct rlist *rl, struct rnode *n)
 {
+    int rc;
     struct rnode *rnode = rlist_find_rank (rl, n->rank);
     if (!rnode) {
         errno = ENOENT;
         return -1;
     }
-    if (rnode_alloc_idset (rnode, n->avail) < 0)
+    rlist_index_remove (rl, rnode);
+    rc = rnode_alloc_idset (rnode, n->avail);
+    rlist_index_add (rl, rnode);
+    if (rc < 0)
         return -1;
     rl->avail -= idset_count (n->avail);
     return 0;
@@ -1012,7 +1119,9 @@ static int rlist_mark_all (struct rlist *rl, bool up)
     while (n) {
         if (n->up != up)
             count += idset_count (n->avail);
+        rlist_index_remove (rl, n);
         n->up = up;
+        rlist_index_add (rl, n);
         n = zlistx_next (rl->nodes);
     }
     return count;
@@ -1030,7 +1139,9 @@ static int rlist_mark_state (struct rlist *rl, bool up, const char *ids)
         struct rnode *n = rlist_find_rank (rl, i);
         if (n->up != up)
             count += idset_count (n->avail);
+        rlist_index_remove (rl, n);
         n->up = up;
+        rlist_index_add (rl, n);
         i = idset_next (idset, i);
     }
     idset_destroy (idset);
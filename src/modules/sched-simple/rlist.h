@@ -24,6 +24,15 @@ struct rlist {
     int total;
     int avail;
     zlistx_t *nodes;
+
+    /* Index of nodes by rank */
+    zhashx_t *rank_index;
+
+    /* Ranks of up nodes, bucketed by number of available ids, i.e.
+     *  avail_index[n] is the set of up ranks with exactly n ids available.
+     */
+    struct idset **avail_index;
+    int avail_index_size;
 };
 
 /*  Create an empty rlist object */
@@ -60,7 +69,7 @@ int rlist_append_rank (struct rlist *rl, unsigned int rank, const char *ids);
 
 /*  Same as rlist_append_rank(), but `ids` is a struct idset
  */
-int rlist_append_idset (struct rlist *rl, int rank, struct idset *ids);
+int rlist_append_idset (struct rlist *rl, int rank, const struct idset *ids);
 
 /*  Return number of resource nodes in resource list `rl`
  */
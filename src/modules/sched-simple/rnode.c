@@ -45,7 +45,7 @@ fail:
     return NULL;
 }
 
-struct rnode *rnode_create_idset (uint32_t rank, struct idset *ids)
+struct rnode *rnode_create_idset (uint32_t rank, const struct idset *ids)
 {
     struct rnode *n = calloc (1, sizeof (*n));
     if (n == NULL)
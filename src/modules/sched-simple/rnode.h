@@ -29,7 +29,7 @@ struct rnode {
 
 /*  Create a resource node object from an existing idset `set`
  */
-struct rnode *rnode_create_idset (uint32_t rank, struct idset *ids);
+struct rnode *rnode_create_idset (uint32_t rank, const struct idset *ids);
 
 /*  Create a resource node from a string representation of an idset.
  */
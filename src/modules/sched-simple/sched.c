@@ -35,6 +35,8 @@ struct jobreq {
 struct simple_sched {
     flux_t *h;
     flux_future_t *acquire_f; /* resource.acquire future */
+    flux_future_t *cancel_f;  /* resource.acquire canceled for resync */
+    int acquire_gen;          /* generation of last acquire response */
 
     char *mode;             /* allocation mode */
     bool single;
@@ -118,6 +120,7 @@ static void simple_sched_destroy (flux_t *h, struct simple_sched *ss)
         job = zlistx_next (ss->queue);
     }
     flux_future_destroy (ss->acquire_f);
+    flux_future_destroy (ss->cancel_f);
     zlistx_destroy (&ss->queue);
     flux_watcher_destroy (ss->prep);
     flux_watcher_destroy (ss->check);
@@ -136,6 +139,7 @@ static struct simple_sched * simple_sched_create (void)
 
     /* Single alloc request mode is default */
     ss->single = true;
+    ss->acquire_gen = -1;
     return ss;
 }
 
@@ -438,28 +442,90 @@ err:
         flux_log_error (h, "flux_respond_error");
 }
 
+static void acquire_continuation (flux_future_t *f, void *arg);
+
+/*  Responses to resource.acquire after the first only carry changes,
+ *  so if one is missed, resource states in rlist can no longer be
+ *  trusted.  Cancel the request and send a new one, whose first
+ *  response carries the complete up set.  The canceled future is kept
+ *  until its ECANCELED response arrives.
+ */
+static int ss_acquire_resync (struct simple_sched *ss)
+{
+    flux_future_t *f;
+    uint32_t matchtag = flux_rpc_get_matchtag (ss->acquire_f);
+
+    if (!(f = flux_rpc_pack (ss->h,
+                             "resource.acquire-cancel",
+                             FLUX_NODEID_ANY,
+                             FLUX_RPC_NORESPONSE,
+                             "{s:i}",
+                             "matchtag", (int)matchtag)))
+        return -1;
+    flux_future_destroy (f);
+
+    if (!(f = flux_rpc (ss->h,
+                        "resource.acquire",
+                        NULL,
+                        FLUX_NODEID_ANY,
+                        FLUX_RPC_STREAMING)))
+        return -1;
+    if (flux_future_then (f, -1., acquire_continuation, ss) < 0) {
+        flux_future_destroy (f);
+        return -1;
+    }
+    flux_future_destroy (ss->cancel_f);
+    ss->cancel_f = ss->acquire_f;
+    ss->acquire_f = f;
+    ss->acquire_gen = -1;
+    return 0;
+}
+
 static int ss_resource_update (struct simple_sched *ss, flux_future_t *f)
 {
     const char *up = NULL;
     const char *down = NULL;
     const char *s;
+    json_t *resources = NULL;
+    int gen = -1;
 
-    int rc = flux_rpc_get_unpack (f, "{s?s s?s}",
+    int rc = flux_rpc_get_unpack (f, "{s?o s?s s?s s?i}",
+                                  "resources", &resources,
                                   "up", &up,
-                                  "down", &down);
+                                  "down", &down,
+                                  "gen", &gen);
     if (rc < 0) {
         flux_log (ss->h, LOG_ERR, "unpacking acquire response failed");
         goto err;
     }
+    if (gen >= 0) {
+        if (gen != ss->acquire_gen + 1) {
+            flux_log (ss->h, LOG_ERR,
+                      "acquire response generation %d, expected %d: resync",
+                      gen, ss->acquire_gen + 1);
+            if (ss_acquire_resync (ss) < 0)
+                flux_log_error (ss->h, "failed to resync resource state");
+            rc = -1;
+            goto err;
+        }
+        ss->acquire_gen = gen;
+    }
 
     flux_rpc_get (f, &s);
     flux_log (ss->h, LOG_INFO, "resource update: %s", s);
 
     /* Update resource states:
+     * - All resources down by default on first response
      */
+    if (resources && rlist_mark_down (ss->rlist, "all") < 0) {
+        flux_log_error (ss->h, "failed to set all resources down");
+        rc = -1;
+        goto err;
+    }
     if ((up && rlist_mark_up (ss->rlist, up) < 0)
         || (down && rlist_mark_down (ss->rlist, down) < 0)) {
         flux_log_error (ss->h, "failed to update resource state");
+        rc = -1;
         goto err;
     }
     rc = 0;
@@ -471,6 +537,19 @@ err:
 static void acquire_continuation (flux_future_t *f, void *arg)
 {
     struct simple_sched *ss = arg;
+
+    /*  Drop responses to a request canceled for resync, up to and
+     *  including the ECANCELED error that terminates it.
+     */
+    if (f == ss->cancel_f) {
+        if (flux_future_get (f, NULL) < 0) {
+            flux_future_destroy (ss->cancel_f);
+            ss->cancel_f = NULL;
+        }
+        else
+            flux_future_reset (f);
+        return;
+    }
     if (flux_future_get (f, NULL) < 0) {
         flux_log (ss->h, LOG_ERR,
                   "exiting due to resource update failure: %s",
@@ -514,14 +593,6 @@ static int ss_acquire_resources (flux_t *h, struct simple_sched *ss)
         goto out;
     }
 
-    /* Update resource states:
-     * - All resources down by default on first response
-     */
-    if (rlist_mark_down (ss->rlist, "all") < 0) {
-        flux_log_error (h, "failed to set all discovered resources down");
-        goto out;
-    }
-
     if (ss_resource_update (ss, f) < 0) {
         flux_log_error (h, "failed to set initial resource state");
         goto out;
@@ -151,6 +151,24 @@ struct rlist_test_entry test_6n_4c[] = {
       "rank[0-2]/core[0-3] rank3/core[0-1]",
       "rank3/core[2-3] rank[4-5]/core[0-3]",
       0, false },
+    { "best-fit: alloc 1 core skips down rank",      "best-fit", "3",
+      { 0, 1, 1 },
+      "rank4/core0",
+      "rank[0-2]/core[0-3] rank3/core[0-1] rank4/core0",
+      "rank4/core[1-3] rank5/core[0-3]",
+      0, false },
+    { "first-fit: alloc 2 slots/size 2 skips down rank", "first-fit", "3",
+      { 0, 2, 2 },
+      "rank4/core[1-2] rank5/core[0-1]",
+      "rank[0-2]/core[0-3] rank[3,5]/core[0-1] rank4/core[0-2]",
+      "rank4/core3 rank5/core[2-3]",
+      0, false },
+    { "worst-fit: alloc 2 slots of 1 core fills one node", "worst-fit", NULL,
+      { 0, 2, 1 },
+      "rank3/core[2-3]",
+      "rank[0-3]/core[0-3] rank4/core[0-2] rank5/core[0-1]",
+      "rank4/core3 rank5/core[2-3]",
+      0, true },
     RLIST_TEST_END,
 };
 
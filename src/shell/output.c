@@ -38,6 +38,10 @@
  * - In standalone mode, output is written to the shell's stdout/stderr not KVS
  * - The number of in-flight write requests on each shell is limited to
  *   shell_output_hwm, to avoid matchtag exhaustion, etc. for chatty tasks.
+ * - Output destined for a file bypasses the json array.  It is staged,
+ *   with any labels, in a buffer per open file, which is written out
+ *   when it fills up, when the flush timer expires, or when all tasks
+ *   have sent EOF.  Thus many small chunks of output cost one write(2).
  */
 
 #if HAVE_CONFIG_H
@@ -68,6 +72,8 @@ enum {
 
 struct shell_output_fd {
     int fd;
+    char *buf;
+    size_t len;
 };
 
 struct shell_output_type_file {
@@ -90,11 +96,16 @@ struct shell_output {
     struct shell_output_type_file stdout_file;
     struct shell_output_type_file stderr_file;
     zhash_t *fds;
+    flux_watcher_t *flush_timer;
+    bool flush_armed;
 };
 
 static const int shell_output_lwm = 100;
 static const int shell_output_hwm = 1000;
 
+static const size_t shell_output_file_bufsize = 65536;
+static const double shell_output_file_timeout = 0.1;
+
 /* Pause/resume output on 'stream' of 'task'.
  */
 static void shell_output_control_task (struct shell_task *task,
@@ -340,56 +351,110 @@ static int shell_output_write_fd (int fd, const void *buf, size_t len)
     return n;
 }
 
-static int shell_output_file (struct shell_output *out)
+/* Write out any output staged for 'fdp'.  Staged output is discarded
+ * on error.
+ */
+static int shell_output_fd_flush (struct shell_output_fd *fdp)
 {
-    json_t *entry;
-    size_t index;
+    int rc = 0;
 
-    json_array_foreach (out->output, index, entry) {
-        json_t *context;
-        const char *name;
-        if (eventlog_entry_parse (entry, NULL, &name, &context) < 0) {
-            shell_log_errno ("eventlog_entry_parse");
+    if (fdp->len > 0) {
+        if (shell_output_write_fd (fdp->fd, fdp->buf, fdp->len) < 0)
+            rc = -1;
+        fdp->len = 0;
+    }
+    return rc;
+}
+
+/* Stage 'data' for 'fdp', flushing first if it does not fit.  Data
+ * too large to be staged is written directly.
+ */
+static int shell_output_fd_append (struct shell_output_fd *fdp,
+                                   const void *data,
+                                   size_t len)
+{
+    if (fdp->len + len > shell_output_file_bufsize) {
+        if (shell_output_fd_flush (fdp) < 0)
             return -1;
+        if (len > shell_output_file_bufsize)
+            return shell_output_write_fd (fdp->fd, data, len);
+    }
+    memcpy (fdp->buf + fdp->len, data, len);
+    fdp->len += len;
+    return 0;
+}
+
+static int shell_output_file_flush (struct shell_output *out)
+{
+    struct shell_output_fd *fdp;
+    int rc = 0;
+
+    if (out->fds) {
+        fdp = zhash_first (out->fds);
+        while (fdp) {
+            if (shell_output_fd_flush (fdp) < 0)
+                rc = -1;
+            fdp = zhash_next (out->fds);
         }
-        if (!strcmp (name, "data")) {
-            struct shell_output_type_file *ofp;
-            int output_type;
-            const char *stream = NULL;
-            const char *rank = NULL;
-            char *data = NULL;
-            int len = 0;
-            if (iodecode (context, &stream, &rank, &data, &len, NULL) < 0) {
-                shell_log_errno ("iodecode");
-                return -1;
-            }
-            if (!strcmp (stream, "stdout")) {
-                output_type = out->stdout_type;
-                ofp = &out->stdout_file;
-            }
-            else {
-                output_type = out->stderr_type;
-                ofp = &out->stderr_file;
-            }
-            if ((output_type == FLUX_OUTPUT_TYPE_FILE) && len > 0) {
-                if (ofp->label) {
-                    char *buf = NULL;
-                    int buflen;
-                    if ((buflen = asprintf (&buf, "%s: ", rank)) < 0)
-                        return -1;
-                    if (shell_output_write_fd (ofp->fdp->fd, buf, buflen) < 0) {
-                        free (buf);
-                        return -1;
-                    }
-                    free (buf);
-                }
-                if (shell_output_write_fd (ofp->fdp->fd, data, len) < 0)
-                    return -1;
-            }
-            free (data);
+    }
+    if (out->flush_armed) {
+        flux_watcher_stop (out->flush_timer);
+        out->flush_armed = false;
+    }
+    return rc;
+}
+
+static void shell_output_flush_cb (flux_reactor_t *r,
+                                   flux_watcher_t *w,
+                                   int revents,
+                                   void *arg)
+{
+    struct shell_output *out = arg;
+
+    out->flush_armed = false;
+    if (shell_output_file_flush (out) < 0)
+        shell_log_errno ("shell_output_file");
+}
+
+/* Stage file output from 'iodecode' object 'o'.
+ */
+static int shell_output_file (struct shell_output *out, json_t *o)
+{
+    struct shell_output_type_file *ofp;
+    const char *stream = NULL;
+    const char *rank = NULL;
+    char *data = NULL;
+    int len = 0;
+    int rc = -1;
+
+    if (iodecode (o, &stream, &rank, &data, &len, NULL) < 0) {
+        shell_log_errno ("iodecode");
+        return -1;
+    }
+    if (len > 0) {
+        if (!strcmp (stream, "stdout"))
+            ofp = &out->stdout_file;
+        else
+            ofp = &out->stderr_file;
+        if (ofp->label) {
+            if (shell_output_fd_append (ofp->fdp, rank, strlen (rank)) < 0
+                || shell_output_fd_append (ofp->fdp, ": ", 2) < 0)
+                goto done;
+        }
+        if (shell_output_fd_append (ofp->fdp, data, len) < 0)
+            goto done;
+        if (!out->flush_armed) {
+            flux_timer_watcher_reset (out->flush_timer,
+                                      shell_output_file_timeout,
+                                      0.);
+            flux_watcher_start (out->flush_timer);
+            out->flush_armed = true;
         }
     }
-    return 0;
+    rc = 0;
+done:
+    free (data);
+    return rc;
 }
 
 /* Convert 'iodecode' object to an valid RFC 24 data event.
@@ -402,13 +467,26 @@ static void shell_output_write_cb (flux_t *h,
 {
     struct shell_output *out = arg;
     bool eof = false;
+    const char *stream;
+    int output_type;
     json_t *o;
     json_t *entry;
 
     if (flux_request_unpack (msg, NULL, "o", &o) < 0)
         goto error;
-    if (iodecode (o, NULL, NULL, NULL, NULL, &eof) < 0)
+    if (iodecode (o, &stream, NULL, NULL, NULL, &eof) < 0)
         goto error;
+    if (!strcmp (stream, "stdout"))
+        output_type = out->stdout_type;
+    else
+        output_type = out->stderr_type;
+    /* File output need not be converted to an eventlog entry.
+     */
+    if (output_type == FLUX_OUTPUT_TYPE_FILE) {
+        if (shell_output_file (out, o) < 0)
+            shell_log_errno ("shell_output_file");
+        goto done;
+    }
     if (!(entry = eventlog_entry_pack (0., "data", "O", o))) // increfs 'o'
         goto error;
     if (json_array_append_new (out->output, entry) < 0) {
@@ -428,15 +506,11 @@ static void shell_output_write_cb (flux_t *h,
         if (shell_output_kvs (out) < 0)
             shell_die_errno (1, "shell_output_kvs");
     }
-    if ((out->stdout_type == FLUX_OUTPUT_TYPE_FILE
-         || (out->stderr_type == FLUX_OUTPUT_TYPE_FILE))) {
-        if (shell_output_file (out) < 0)
-            shell_log_errno ("shell_output_file");
-    }
     if (json_array_clear (out->output) < 0) {
         shell_log_error ("json_array_clear failed");
         goto error;
     }
+done:
     if (eof) {
         if (--out->eof_pending == 0) {
             flux_msg_handler_stop (mh);
@@ -444,6 +518,8 @@ static void shell_output_write_cb (flux_t *h,
                 shell_log_errno ("flux_shell_remove_completion_ref");
             /* no more output is coming, flush the last batch of
              * output */
+            if (shell_output_file_flush (out) < 0)
+                shell_log_errno ("shell_output_file");
             if ((out->stdout_type == FLUX_OUTPUT_TYPE_KVS
                  || (out->stderr_type == FLUX_OUTPUT_TYPE_KVS))) {
                 if (eventlogger_flush (out->ev) < 0)
@@ -538,21 +614,14 @@ void shell_output_destroy (struct shell_output *out)
                 if (shell_output_kvs (out) < 0)
                     shell_log_errno ("shell_output_kvs");
             }
-            if ((out->stdout_type == FLUX_OUTPUT_TYPE_FILE
-                 || (out->stderr_type == FLUX_OUTPUT_TYPE_FILE))) {
-                if (shell_output_file (out) < 0)
-                    shell_log_errno ("shell_output_file");
-            }
         }
+        if (shell_output_file_flush (out) < 0)
+            shell_log_errno ("shell_output_file");
+        flux_watcher_destroy (out->flush_timer);
         json_decref (out->output);
         shell_output_type_file_cleanup (&out->stdout_file);
         shell_output_type_file_cleanup (&out->stderr_file);
         if (out->fds) { // leader only
-            struct shell_output_fd *fdp = zhash_first (out->fds);
-            while (fdp) {
-                close (fdp->fd);
-                fdp = zhash_next (out->fds);
-            }
             zhash_destroy (&out->fds);
         }
         eventlogger_destroy (out->ev);
@@ -764,6 +833,10 @@ static struct shell_output_fd *shell_output_fd_create (int fd)
     struct shell_output_fd *fdp = calloc (1, sizeof (*fdp));
     if (!fdp)
         return NULL;
+    if (!(fdp->buf = malloc (shell_output_file_bufsize))) {
+        free (fdp);
+        return NULL;
+    }
     fdp->fd = fd;
     return fdp;
 }
@@ -773,6 +846,7 @@ static void shell_output_fd_destroy (void *data)
     struct shell_output_fd *fdp = data;
     if (fdp) {
         close (fdp->fd);
+        free (fdp->buf);
         free (fdp);
     }
 }
@@ -941,6 +1015,12 @@ struct shell_output *shell_output_create (flux_shell_t *shell)
                 errno = ENOMEM;
                 goto error;
             }
+            if (!(out->flush_timer = flux_timer_watcher_create (shell->r,
+                                                  shell_output_file_timeout,
+                                                  0.,
+                                                  shell_output_flush_cb,
+                                                  out)))
+                goto error;
             if (out->stdout_type == FLUX_OUTPUT_TYPE_FILE) {
                 if (shell_output_type_file_setup (out, &(out->stdout_file)) < 0)
                     goto error;
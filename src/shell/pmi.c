@@ -45,7 +45,15 @@
  * serviced only from the cache.  Otherwise, the barrier dumps the hash
  * into a Flux KVS txn and commits it with a flux_kvs_fence(), using
  * the number of shells as "nprocs".  Gets are serviced from the cache,
- * with fall-through to a flux_kvs_lookup().
+ * with fall-through to a flux_kvs_lookup().  Only keys put since the
+ * previous barrier are written.
+ *
+ * If the pmi.kvs=exchange shell option is set, each shell instead appends
+ * the keys put since the previous barrier, as one JSON object, to a single
+ * per-cycle KVS key in the fence.  Once the fence completes, each shell
+ * looks up that key and merges every shell's contribution into its cache,
+ * so a barrier costs each shell one fence and one lookup, and gets are
+ * always serviced from the cache.
  *
  * If shell->verbose is true (shell --verbose flag was provided), the
  * protocol engine emits client and server telemetry to stderr, and
@@ -56,8 +64,6 @@
  * - PMI kvsname parameter is ignored
  * - 64-bit Flux job id's are assigned to integer-typed PMI appnum
  * - PMI publish, unpublish, lookup, spawn are not implemented
- * - Although multiple cycles of put / barrier / get are supported, the
- *   the barrier rewrites data from previous cycles to the Flux KVS.
  * - PMI_Abort() is implemented as log message + exit in the client code.
  *   It does not reach this module.
  * - Teardown of the subprocess channel is deferred until task completion,
@@ -70,11 +76,13 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <czmq.h>
+#include <jansson.h>
 #include <assert.h>
 #include <flux/core.h>
 
 #include "src/common/libpmi/simple_server.h"
 #include "src/common/libpmi/clique.h"
+#include "src/common/libutil/errno_safe.h"
 
 #include "builtins.h"
 #include "internal.h"
@@ -87,7 +95,9 @@ struct shell_pmi {
     struct pmi_simple_server *server;
     zhashx_t *kvs;
     zhashx_t *locals;
+    zhashx_t *pending;  // keys put since the last barrier
     int cycle;      // count cycles of put / barrier / get
+    bool exchange;  // pmi.kvs=exchange
 };
 
 static void shell_pmi_abort (void *arg,
@@ -110,6 +120,7 @@ static int shell_pmi_kvs_put (void *arg,
     struct shell_pmi *pmi = arg;
 
     zhashx_update (pmi->kvs, key, (char *)val);
+    zhashx_update (pmi->pending, key, (void *) 0x1);
     return 0;
 }
 
@@ -152,6 +163,7 @@ static int shell_pmi_kvs_key (char *buf,
 /* Lookup a key: first try the local hash.   If that fails and the
  * job spans multiple shells, do a KVS lookup in the job's private
  * KVS namespace and handle the response in kvs_lookup_continuation().
+ * In exchange mode, the local hash already holds every key.
  */
 static int shell_pmi_kvs_get (void *arg,
                               void *cli,
@@ -166,7 +178,7 @@ static int shell_pmi_kvs_get (void *arg,
         pmi_simple_server_kvs_get_complete (pmi->server, cli, val);
         return 0;
     }
-    if (pmi->shell->info->shell_size > 1) {
+    if (pmi->shell->info->shell_size > 1 && !pmi->exchange) {
         char nkey[FQ_KVS_KEY_MAX];
         flux_future_t *f = NULL;
 
@@ -207,21 +219,181 @@ static void kvs_fence_continuation (flux_future_t *f, void *arg)
     flux_future_destroy (f);
 }
 
-static int shell_pmi_barrier_enter (void *arg)
+/* Merge the exchange blob, one JSON object per shell, each terminated
+ * by a newline, into the local hash.
+ */
+static int exchange_merge (struct shell_pmi *pmi, const char *s)
+{
+    while (*s) {
+        const char *nl = strchr (s, '\n');
+        size_t len = nl ? nl - s : strlen (s);
+        json_t *o;
+        const char *key;
+        json_t *val;
+
+        if (!(o = json_loadb (s, len, 0, NULL)))
+            goto eproto;
+        json_object_foreach (o, key, val) {
+            if (!json_is_string (val)) {
+                json_decref (o);
+                goto eproto;
+            }
+            if (!zhashx_lookup (pmi->locals, key))
+                zhashx_update (pmi->kvs, key, (char *)json_string_value (val));
+        }
+        json_decref (o);
+        s += nl ? len + 1 : len;
+    }
+    return 0;
+eproto:
+    errno = EPROTO;
+    return -1;
+}
+
+static void exchange_lookup_continuation (flux_future_t *f, void *arg)
 {
     struct shell_pmi *pmi = arg;
-    flux_kvs_txn_t *txn = NULL;
+    const char *val;
+    int rc = 0;
+
+    if (flux_kvs_lookup_get (f, &val) < 0) {
+        if (errno != ENOENT) { // no shell contributed any keys
+            shell_log_errno ("pmi exchange lookup");
+            rc = -1;
+        }
+    }
+    else if (exchange_merge (pmi, val) < 0) {
+        shell_log_errno ("pmi exchange");
+        rc = -1;
+    }
+    pmi_simple_server_barrier_complete (pmi->server, rc);
+    flux_future_destroy (f);
+}
+
+static void exchange_fence_continuation (flux_future_t *f, void *arg)
+{
+    struct shell_pmi *pmi = arg;
+    const char *nkey = flux_future_aux_get (f, "flux::shell_pmi_key");
+    flux_future_t *f2;
+
+    if (flux_future_get (f, NULL) < 0)
+        goto error;
+    if (!(f2 = flux_kvs_lookup (pmi->shell->h, NULL, 0, nkey))) {
+        shell_log_errno ("flux_kvs_lookup");
+        goto error;
+    }
+    if (flux_future_then (f2, -1., exchange_lookup_continuation, pmi) < 0) {
+        shell_log_errno ("flux_future_then");
+        flux_future_destroy (f2);
+        goto error;
+    }
+    flux_future_destroy (f);
+    return;
+error:
+    pmi_simple_server_barrier_complete (pmi->server, -1);
+    flux_future_destroy (f);
+}
+
+/* Add keys put since the last barrier to 'txn', either individually,
+ * or in exchange mode, as one JSON object appended to 'xkey'.
+ * Keys in pmi->locals are not added to the KVS transaction
+ * because they were locally generated and need not be
+ * shared with the other shells.
+ */
+static int barrier_txn_add (struct shell_pmi *pmi,
+                            flux_kvs_txn_t *txn,
+                            const char *xkey)
+{
+    json_t *o = NULL;
+    char *s = NULL;
+    void *item;
     const char *key;
     const char *val;
+    char nkey[FQ_KVS_KEY_MAX];
+
+    if (pmi->exchange && !(o = json_object ()))
+        goto nomem;
+    item = zhashx_first (pmi->pending);
+    while (item) {
+        key = zhashx_cursor (pmi->pending);
+        if (zhashx_lookup (pmi->locals, key)
+            || !(val = zhashx_lookup (pmi->kvs, key))) {
+            item = zhashx_next (pmi->pending);
+            continue;
+        }
+        if (o) {
+            json_t *v;
+            if (!(v = json_string (val))
+                || json_object_set_new (o, key, v) < 0) {
+                json_decref (v);
+                goto nomem;
+            }
+        }
+        else {
+            if (shell_pmi_kvs_key (nkey,
+                                   sizeof (nkey),
+                                   pmi->shell->jobid,
+                                   key) < 0) {
+                shell_log_errno ("key buffer overflow");
+                goto error;
+            }
+            if (flux_kvs_txn_put (txn, 0, nkey, val) < 0) {
+                shell_log_errno ("flux_kvs_txn_put");
+                goto error;
+            }
+        }
+        item = zhashx_next (pmi->pending);
+    }
+    if (o && json_object_size (o) > 0) {
+        char *ns;
+        if (!(s = json_dumps (o, JSON_COMPACT))
+            || !(ns = realloc (s, strlen (s) + 2)))
+            goto nomem;
+        s = ns;
+        strcat (s, "\n");
+        if (flux_kvs_txn_put (txn, FLUX_KVS_APPEND, xkey, s) < 0) {
+            shell_log_errno ("flux_kvs_txn_put");
+            goto error;
+        }
+    }
+    zhashx_purge (pmi->pending);
+    free (s);
+    json_decref (o);
+    return 0;
+nomem:
+    errno = ENOMEM;
+    shell_log_errno ("pmi exchange");
+error:
+    ERRNO_SAFE_WRAP (free, s);
+    ERRNO_SAFE_WRAP (json_decref, o);
+    return -1;
+}
+
+static int shell_pmi_barrier_enter (void *arg)
+{
+    struct shell_pmi *pmi = arg;
+    flux_kvs_txn_t *txn = NULL;
     char name[64];
     int nprocs = pmi->shell->info->shell_size;
     flux_future_t *f;
-    char nkey[FQ_KVS_KEY_MAX];
+    char xkey[FQ_KVS_KEY_MAX];
+    char *cpy;
 
     if (nprocs == 1) { // all local: no further sync needed
+        zhashx_purge (pmi->pending);
         pmi_simple_server_barrier_complete (pmi->server, 0);
         return 0;
     }
+    if (pmi->exchange) {
+        snprintf (name, sizeof (name), "exchange.%d", pmi->cycle);
+        if (shell_pmi_kvs_key (xkey,
+                               sizeof (xkey),
+                               pmi->shell->jobid,
+                               name) < 0) {
+            shell_log_errno ("key buffer overflow");
+            goto error;
+        }
+    }
     snprintf (name, sizeof (name), "pmi.%ju.%d",
              (uintmax_t)pmi->shell->jobid,
              pmi->cycle++);
@@ -229,36 +401,26 @@ static int shell_pmi_barrier_enter (void *arg)
         shell_log_errno ("flux_kvs_txn_create");
         goto error;
     }
-    val = zhashx_first (pmi->kvs);
-    while (val) {
-        key = zhashx_cursor (pmi->kvs);
-        /* Special case:
-         * Keys in pmi->locals are not added to the KVS transaction
-         * because they were locally generated and need not be
-         * shared with the other shells.
-         */
-        if (zhashx_lookup (pmi->locals, key)) {
-            val = zhashx_next (pmi->kvs);
-            continue;
-        }
-        if (shell_pmi_kvs_key (nkey,
-                               sizeof (nkey),
-                               pmi->shell->jobid,
-                               key) < 0) {
-            shell_log_errno ("key buffer overflow");
-            goto error;
-        }
-        if (flux_kvs_txn_put (txn, 0, nkey, val) < 0) {
-            shell_log_errno ("flux_kvs_txn_put");
-            goto error;
-        }
-        val = zhashx_next (pmi->kvs);
-    }
+    if (barrier_txn_add (pmi, txn, xkey) < 0)
+        goto error;
     if (!(f = flux_kvs_fence (pmi->shell->h, NULL, 0, name, nprocs, txn))) {
         shell_log_errno ("flux_kvs_fence");
         goto error;
     }
-    if (flux_future_then (f, -1., kvs_fence_continuation, pmi) < 0) {
+    if (pmi->exchange) {
+        if (!(cpy = strdup (xkey))
+            || flux_future_aux_set (f, "flux::shell_pmi_key", cpy, free) < 0) {
+            shell_log_errno ("flux_future_aux_set");
+            free (cpy);
+            flux_future_destroy (f);
+            goto error;
+        }
+    }
+    if (flux_future_then (f,
+                          -1.,
+                          pmi->exchange ? exchange_fence_continuation
+                                        : kvs_fence_continuation,
+                          pmi) < 0) {
         shell_log_errno ("flux_future_then");
         flux_future_destroy (f);
         goto error;
@@ -400,6 +562,7 @@ static void pmi_destroy (struct shell_pmi *pmi)
         pmi_simple_server_destroy (pmi->server);
         zhashx_destroy (&pmi->kvs);
         zhashx_destroy (&pmi->locals);
+        zhashx_destroy (&pmi->pending);
         free (pmi);
         errno = saved_errno;
     }
@@ -439,11 +602,22 @@ static struct shell_pmi *pmi_create (flux_shell_t *shell)
     struct shell_info *info = shell->info;
     int flags = shell->verbose ? PMI_SIMPLE_SERVER_TRACE : 0;
     char kvsname[32];
+    const char *kvs = "native";
 
     if (!(pmi = calloc (1, sizeof (*pmi))))
         return NULL;
     pmi->shell = shell;
 
+    if (flux_shell_getopt_unpack (shell, "pmi", "{s?:s}", "kvs", &kvs) < 0)
+        goto error;
+    if (!strcmp (kvs, "exchange"))
+        pmi->exchange = true;
+    else if (strcmp (kvs, "native") != 0) {
+        shell_log_error ("pmi.kvs=%s is not supported", kvs);
+        errno = EINVAL;
+        goto error;
+    }
+
     /* Use F58 representation of jobid for "kvsname", since the broker
      * will pull the kvsname and use it as the broker 'jobid' attribute.
      * This allows the broker attribute to be in the "common" user-facing
@@ -463,7 +637,8 @@ static struct shell_pmi *pmi_create (flux_shell_t *shell)
                                                   pmi)))
         goto error;
     if (!(pmi->kvs = zhashx_new ())
-        || !(pmi->locals = zhashx_new ())) {
+        || !(pmi->locals = zhashx_new ())
+        || !(pmi->pending = zhashx_new ())) {
         errno = ENOMEM;
         goto error;
     }
@@ -0,0 +1,110 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* hashbench - measure blobref_hash() throughput
+ *
+ * Report MB/s and hashes/s of each content hash type for a range of
+ * blob sizes, from small KVS directory objects up to large values.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libutil/sha_x86.h"
+
+static struct optparse_option opts[] =  {
+    { .name = "hash", .key = 'H', .has_arg = 1, .arginfo = "NAME",
+      .usage = "Only benchmark hash type NAME (default all)",
+    },
+    { .name = "bytes", .key = 'b', .has_arg = 1, .arginfo = "N",
+      .usage = "Hash about N bytes of data for each size (default 64M)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static const char *hashtypes[] = { "sha1", "sha256", "blake3", NULL };
+static const int sizes[] = { 64, 256, 1024, 4096, 16384, 65536, 1048576, 0 };
+static const int max_size = 1048576;
+
+static void bench (const char *hashtype, const void *data, int size, long bytes)
+{
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    struct timespec t0;
+    long count = bytes / size;
+    double elapsed;
+    long i;
+
+    if (count < 1)
+        count = 1;
+    monotime (&t0);
+    for (i = 0; i < count; i++) {
+        if (blobref_hash (hashtype, data, size, ref, sizeof (ref)) < 0)
+            log_err_exit ("blobref_hash %s", hashtype);
+    }
+    elapsed = monotime_since (t0) * 1E-3;
+    printf ("%-8s %8d %10.1f MB/s %12.0f hashes/s\n",
+            hashtype,
+            size,
+            elapsed > 0 ? (double)count * size / elapsed / (1024 * 1024) : 0.,
+            elapsed > 0 ? count / elapsed : 0.);
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    const char *hash;
+    long bytes;
+    char *data;
+    int i, j;
+
+    log_init ("hashbench");
+
+    if (!(p = optparse_create ("hashbench"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("error setting up option parsing");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+    hash = optparse_get_str (p, "hash", NULL);
+    bytes = optparse_get_int (p, "bytes", 64 * 1024 * 1024);
+    if (bytes < 1)
+        log_msg_exit ("invalid argument");
+    if (hash && blobref_validate_hashtype (hash) < 0)
+        log_msg_exit ("unknown hash type: %s", hash);
+
+    if (!(data = malloc (max_size)))
+        log_msg_exit ("out of memory");
+    for (i = 0; i < max_size; i++)
+        data[i] = rand ();
+
+    printf ("# SHA extensions %s\n", sha_x86_supported () ? "yes" : "no");
+    for (i = 0; hashtypes[i] != NULL; i++) {
+        if (hash && strcmp (hash, hashtypes[i]) != 0)
+            continue;
+        for (j = 0; sizes[j] != 0; j++)
+            bench (hashtypes[i], data, sizes[j], bytes);
+    }
+
+    free (data);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -29,6 +29,7 @@
 #include "src/common/libutil/fluid.h"
 #include "src/common/libjob/job.h"
 #include "src/common/libutil/read_all.h"
+#include "src/common/libutil/monotime.h"
 
 int cmd_submitbench (optparse_t *p, int argc, char **argv);
 
@@ -47,6 +48,9 @@ static struct optparse_option opts[] =  {
       .flags = OPTPARSE_OPT_AUTOSPLIT,
       .usage = "Set comma-separated flags (e.g. debug)",
     },
+    { .name = "rate", .key = 't', .has_arg = 0,
+      .usage = "Report ingest rate (jobs/s) on stderr",
+    },
 #if HAVE_FLUX_SECURITY
     { .name = "reuse-signature", .key = 'R', .has_arg = 0,
       .usage = "Sign jobspec once and reuse the result for multiple RPCs",
@@ -205,6 +209,7 @@ int cmd_submitbench (optparse_t *p, int argc, char **argv)
     flux_reactor_t *r;
     int optindex = optparse_option_index (p);
     struct submitbench_ctx ctx;
+    struct timespec t0;
 
     memset (&ctx, 0, sizeof (ctx));
 
@@ -256,8 +261,17 @@ int cmd_submitbench (optparse_t *p, int argc, char **argv)
     flux_watcher_start (ctx.prep);
     flux_watcher_start (ctx.check);
 
+    monotime (&t0);
     if (flux_reactor_run (r, 0) < 0)
         log_err_exit ("flux_reactor_run");
+    if (optparse_hasopt (p, "rate")) {
+        double elapsed = monotime_since (t0) * 1E-3;
+        fprintf (stderr,
+                 "submitbench: %d jobs in %.3fs (%.1f jobs/s)\n",
+                 ctx.rxcount,
+                 elapsed,
+                 elapsed > 0 ? ctx.rxcount / elapsed : 0.);
+    }
 #if HAVE_FLUX_SECURITY
     flux_security_destroy (ctx.sec); // invalidates ctx.J
 #endif
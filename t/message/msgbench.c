@@ -0,0 +1,225 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* msgbench - measure flux_msg_t throughput
+ *
+ * Report messages/sec for basic message operations.  Only the public
+ * message API is used, so results may be compared across versions of
+ * the message implementation.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <flux/core.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+
+static struct optparse_option opts[] =  {
+    { .name = "count", .key = 'c', .has_arg = 1, .arginfo = "N",
+      .usage = "Perform N iterations of each operation (default 100000)",
+    },
+    { .name = "size", .key = 's', .has_arg = 1, .arginfo = "N",
+      .usage = "Use N byte raw payload for encode/decode/copy (default 64)",
+    },
+    { .name = "routes", .key = 'r', .has_arg = 1, .arginfo = "N",
+      .usage = "Push N routes for encode/decode/copy/route (default 2)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static int count;
+static int size;
+static int routes;
+
+static void report (const char *name, struct timespec t0)
+{
+    double elapsed = monotime_since (t0) * 1E-3;
+
+    printf ("%-8s %10.0f msgs/s\n",
+            name,
+            elapsed > 0 ? count / elapsed : 0.);
+}
+
+static void push_routes (flux_msg_t *msg)
+{
+    char id[16];
+    int i;
+
+    if (flux_msg_enable_route (msg) < 0)
+        log_err_exit ("flux_msg_enable_route");
+    for (i = 0; i < routes; i++) {
+        snprintf (id, sizeof (id), "%d", i);
+        if (flux_msg_push_route (msg, id) < 0)
+            log_err_exit ("flux_msg_push_route");
+    }
+}
+
+static flux_msg_t *create_test_msg (void)
+{
+    flux_msg_t *msg;
+    void *payload;
+
+    if (!(payload = calloc (1, size > 0 ? size : 1)))
+        log_msg_exit ("out of memory");
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_REQUEST))
+        || flux_msg_set_topic (msg, "msgbench.test") < 0
+        || flux_msg_set_payload (msg, payload, size) < 0)
+        log_err_exit ("error creating test message");
+    push_routes (msg);
+    free (payload);
+    return msg;
+}
+
+static void bench_create (void)
+{
+    struct timespec t0;
+    flux_msg_t *msg;
+    int i;
+
+    monotime (&t0);
+    for (i = 0; i < count; i++) {
+        if (!(msg = flux_msg_create (FLUX_MSGTYPE_REQUEST))
+            || flux_msg_set_topic (msg, "msgbench.test") < 0)
+            log_err_exit ("error creating message");
+        flux_msg_destroy (msg);
+    }
+    report ("create", t0);
+}
+
+static void bench_pack (void)
+{
+    struct timespec t0;
+    flux_msg_t *msg;
+    int i;
+
+    monotime (&t0);
+    for (i = 0; i < count; i++) {
+        if (!(msg = flux_msg_create (FLUX_MSGTYPE_REQUEST))
+            || flux_msg_set_topic (msg, "msgbench.test") < 0
+            || flux_msg_pack (msg, "{s:i s:s}", "i", i, "s", "foo") < 0)
+            log_err_exit ("error packing message");
+        flux_msg_destroy (msg);
+    }
+    report ("pack", t0);
+}
+
+static void bench_encode (flux_msg_t *msg)
+{
+    struct timespec t0;
+    size_t bufsize = flux_msg_encode_size (msg);
+    void *buf;
+    int i;
+
+    if (!(buf = malloc (bufsize)))
+        log_msg_exit ("out of memory");
+    monotime (&t0);
+    for (i = 0; i < count; i++) {
+        if (flux_msg_encode_size (msg) != bufsize
+            || flux_msg_encode (msg, buf, bufsize) < 0)
+            log_err_exit ("flux_msg_encode");
+    }
+    report ("encode", t0);
+    free (buf);
+}
+
+static void bench_decode (flux_msg_t *msg)
+{
+    struct timespec t0;
+    size_t bufsize = flux_msg_encode_size (msg);
+    flux_msg_t *msg2;
+    void *buf;
+    int i;
+
+    if (!(buf = malloc (bufsize)))
+        log_msg_exit ("out of memory");
+    if (flux_msg_encode (msg, buf, bufsize) < 0)
+        log_err_exit ("flux_msg_encode");
+    monotime (&t0);
+    for (i = 0; i < count; i++) {
+        if (!(msg2 = flux_msg_decode (buf, bufsize)))
+            log_err_exit ("flux_msg_decode");
+        flux_msg_destroy (msg2);
+    }
+    report ("decode", t0);
+    free (buf);
+}
+
+static void bench_copy (flux_msg_t *msg)
+{
+    struct timespec t0;
+    flux_msg_t *cpy;
+    int i;
+
+    monotime (&t0);
+    for (i = 0; i < count; i++) {
+        if (!(cpy = flux_msg_copy (msg, true)))
+            log_err_exit ("flux_msg_copy");
+        flux_msg_destroy (cpy);
+    }
+    report ("copy", t0);
+}
+
+static void bench_route (flux_msg_t *msg)
+{
+    struct timespec t0;
+    char *id;
+    int i;
+
+    monotime (&t0);
+    for (i = 0; i < count; i++) {
+        if (flux_msg_push_route (msg, "route") < 0
+            || flux_msg_pop_route (msg, &id) < 0)
+            log_err_exit ("error pushing/popping route");
+        free (id);
+    }
+    report ("route", t0);
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    flux_msg_t *msg;
+
+    log_init ("msgbench");
+
+    if (!(p = optparse_create ("msgbench"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("error setting up option parsing");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+    count = optparse_get_int (p, "count", 100000);
+    size = optparse_get_int (p, "size", 64);
+    routes = optparse_get_int (p, "routes", 2);
+    if (count < 1 || size < 0 || routes < 0)
+        log_msg_exit ("invalid argument");
+
+    msg = create_test_msg ();
+
+    bench_create ();
+    bench_pack ();
+    bench_encode (msg);
+    bench_decode (msg);
+    bench_copy (msg);
+    bench_route (msg);
+
+    flux_msg_destroy (msg);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
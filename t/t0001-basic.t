@@ -352,6 +352,13 @@ test_expect_success 'reactor: reactorcat example program works' '
 	test_must_fail test -s reactorcat.devnull.out
 '
 
+msgbench=${SHARNESS_TEST_DIRECTORY}/message/msgbench
+test_expect_success 'message: msgbench runs and reports all operations' '
+	$msgbench --count=1000 --size=1024 --routes=8 >msgbench.out &&
+	test_debug "cat msgbench.out" &&
+	test $(grep -c "msgs/s" msgbench.out) -eq 6
+'
+
 test_expect_success 'create panic script' '
 	cat >panic.sh <<-EOT &&
 	#!/bin/sh
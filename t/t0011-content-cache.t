@@ -171,6 +171,73 @@ test_expect_success 'rank 0 cache is all valid' '
 	test $VALID -eq $TOTAL
 '
 
+test_expect_success 'load of cached blob on rank 1 counts as a hit' '
+	HASHSTR=`echo foof | $BLOBREF $HASHFUN` &&
+	flux exec -r 1 flux content load ${HASHSTR} >/dev/null &&
+	HIT=`flux exec -r 1 flux module stats --type int --parse load-hit content` &&
+	flux exec -r 1 flux content load ${HASHSTR} >/dev/null &&
+	HIT2=`flux exec -r 1 flux module stats --type int --parse load-hit content` &&
+	test $HIT2 -eq $(($HIT+1))
+'
+
+test_expect_success 'purge counters are reported' '
+	flux module stats --type int --parse purge-scan content &&
+	flux module stats --type int --parse purge-drop content
+'
+
+test_expect_success 'dropcache on rank 1 leaves no valid entries' '
+	flux exec -r 1 flux content dropcache &&
+	VALID=`flux exec -r 1 flux module stats --type int --parse valid content` &&
+	test $VALID -eq 0
+'
+
+rank1_stat() {
+	flux exec -r 1 flux module stats --type int --parse $1 content
+}
+# Succeed if the blob is cached on rank 1, judged by load-hit.
+# N.B. a miss faults the blob back into the rank 1 cache.
+rank1_cached() {
+	local hit=$(rank1_stat load-hit)
+	flux exec -r 1 flux content load $1 >/dev/null &&
+	test $(rank1_stat load-hit) -eq $(($hit+1))
+}
+
+test_expect_success 'fault four blobs into rank 1 cache, then touch the first' '
+	for i in 0 1 2 3; do \
+	    echo lru$i | flux content store >lru$i.hash || return 1; \
+	done &&
+	for i in 0 1 2 3; do \
+	    flux exec -r 1 flux content load $(cat lru$i.hash) >/dev/null \
+	        || return 1; \
+	done &&
+	rank1_cached $(cat lru0.hash)
+'
+
+test_expect_success 'purge on rank 1 drops two LRU entries and stops' '
+	COUNT=$(rank1_stat count) &&
+	DROP=$(rank1_stat purge-drop) &&
+	flux exec -r 1 flux setattr content.purge-old-entry 0 &&
+	flux exec -r 1 flux setattr content.purge-target-entries $(($COUNT-2)) &&
+	for i in $(seq 1 30); do \
+	    test $(rank1_stat purge-drop) -gt $DROP && break; \
+	    sleep 1; \
+	done &&
+	flux exec -r 1 flux setattr content.purge-target-entries 1048576 &&
+	flux exec -r 1 flux setattr content.purge-old-entry 5 &&
+	test $(rank1_stat purge-drop) -eq $(($DROP+2)) &&
+	test $(rank1_stat count) -eq $(($COUNT-2))
+'
+
+test_expect_success 'recently used entries survived the purge' '
+	rank1_cached $(cat lru0.hash) &&
+	rank1_cached $(cat lru3.hash)
+'
+
+test_expect_success 'least recently used entries were purged' '
+	test_must_fail rank1_cached $(cat lru1.hash) &&
+	test_must_fail rank1_cached $(cat lru2.hash)
+'
+
 # Write 8192 blobs, allowing 1024 requests to be outstanding
 test_expect_success 'store 8K blobs from rank 0 using async RPC' '
 	flux content spam 8192 1024 >/dev/null
@@ -181,6 +248,12 @@ test_expect_success 'store 1K blobs from all ranks using async RPC' '
 	flux exec -n flux content spam 1024 256 >/dev/null
 '
 
+test_expect_success 'store blobs from all ranks with flush-batch-bytes=1' '
+	flux exec -n flux setattr content.flush-batch-bytes 1 &&
+	flux exec -n flux content spam 256 64 >/dev/null &&
+	flux exec -n flux setattr content.flush-batch-bytes 16777216
+'
+
 test_expect_success 'load request with empty payload fails with EPROTO(71)' '
 	${RPC} content.load 71 </dev/null
 '
@@ -157,6 +157,83 @@ test_expect_success 'content-backing.load invalid blobref fails' '
         $RPC content-backing.load 2 <bad.blobref 2>load.err
 '
 
+test_expect_success 'content-sqlite module fails to load with bad journal_mode' '
+	flux module remove content-sqlite &&
+	test_must_fail flux module load content-sqlite journal_mode=bogus
+'
+
+test_expect_success 'content-sqlite module fails to load with bad synchronous' '
+	test_must_fail flux module load content-sqlite synchronous=1
+'
+
+test_expect_success 'content-sqlite module fails to load with bad cache_size' '
+	test_must_fail flux module load content-sqlite cache_size=big
+'
+
+test_expect_success 'content-sqlite module fails to load with batch=0' '
+	test_must_fail flux module load content-sqlite batch=0
+'
+
+test_expect_success 'content-sqlite module fails to load with unknown argument' '
+	test_must_fail flux module load content-sqlite foo=bar
+'
+
+test_expect_success 'load content-sqlite module with pragmas and batch size' '
+	flux module load content-sqlite \
+		journal_mode=WAL synchronous=NORMAL cache_size=-4000 batch=16
+'
+
+test_expect_success 'store 100 blobs with small batch size' '
+	store_junk batch 100 &&
+	flux content flush &&
+	NDIRTY=`flux module stats --type int --parse dirty content` &&
+	test ${NDIRTY} -eq 0
+'
+
+test_expect_success 'store/load 4k blob bypassing cache with small batch size' '
+	flux content store --bypass-cache <4k.0.store >4k.1.hash &&
+	test_cmp 4k.0.hash 4k.1.hash &&
+	flux content load --bypass-cache $(cat 4k.1.hash) >4k.1.load &&
+	test_cmp 4k.0.store 4k.1.load
+'
+
+test_expect_success HAVE_JQ 'kvs-checkpoint.get foo still returns baz' '
+	kvs_checkpoint_get foo | jq -r .value >value4.out &&
+	test_cmp value3.exp value4.out
+'
+
+test_expect_success 'store blobs with backing store unloaded' '
+	flux module remove content-sqlite &&
+	flux setattr content.flush-batch-limit 256 &&
+	store_junk txn 64 &&
+	NDIRTY=`flux module stats --type int --parse dirty content` &&
+	test ${NDIRTY} -ge 64
+'
+
+test_expect_success 'flush them to content-sqlite with batch=16' '
+	flux module load content-sqlite batch=16 &&
+	flux content flush &&
+	NDIRTY=`flux module stats --type int --parse dirty content` &&
+	test ${NDIRTY} -eq 0
+'
+
+test_expect_success 'flushed stores shared transactions of up to 16 stores' '
+	NTXN=`flux module stats --type int --parse txn_count content-sqlite` &&
+	NSTORES=`flux module stats --type int --parse txn_stores content-sqlite` &&
+	NMAX=`flux module stats --type int --parse txn_stores_max content-sqlite` &&
+	echo txn_count=${NTXN} txn_stores=${NSTORES} txn_stores_max=${NMAX} &&
+	test ${NSTORES} -ge 64 &&
+	test ${NTXN} -lt ${NSTORES} &&
+	test ${NMAX} -gt 1 &&
+	test ${NMAX} -le 16
+'
+
+test_expect_success 'reload content-sqlite module with batching disabled' '
+	flux module reload content-sqlite batch=1 &&
+	flux content load --bypass-cache $(cat 4k.1.hash) >4k.2.load &&
+	test_cmp 4k.0.store 4k.2.load
+'
+
 test_expect_success 'remove content-sqlite module on rank 0' '
 	flux module remove content-sqlite
 '
@@ -0,0 +1,70 @@
+#!/bin/sh
+
+test_description='Test flux latency histograms'
+
+. `dirname $0`/sharness.sh
+
+test_under_flux 2
+
+test_expect_success 'flux latency works' '
+	flux latency >latency.out &&
+	head -1 latency.out | grep "^NAME" &&
+	grep "^kvs.commit " latency.out &&
+	grep "^kvs.lookup " latency.out &&
+	grep "^content.load " latency.out &&
+	grep "^content.store " latency.out &&
+	grep "^job-manager.alloc-start " latency.out
+'
+test_expect_success HAVE_JQ 'kvs commit and lookup are counted' '
+	flux kvs put test.a=1 &&
+	flux kvs get test.a &&
+	flux latency --json kvs >kvs.json &&
+	jq -e ".[\"kvs.commit\"].count > 0" kvs.json &&
+	jq -e ".[\"kvs.lookup\"].count > 0" kvs.json
+'
+test_expect_success HAVE_JQ 'histogram JSON has percentiles and buckets' '
+	jq -e ".[\"kvs.commit\"] | .p50 <= .p99 and .min <= .max" kvs.json &&
+	jq -e "[.[\"kvs.commit\"].buckets[][2]] | add == $(jq ".[\"kvs.commit\"].count" kvs.json)" kvs.json
+'
+test_expect_success HAVE_JQ 'job alloc to start latency is counted' '
+	flux mini run /bin/true &&
+	flux latency --json job-manager >jm.json &&
+	jq -e ".[\"job-manager.alloc-start\"].count >= 1" jm.json
+'
+test_expect_success HAVE_JQ 'content load and store misses are counted on rank 1' '
+	ref=$(echo latency-test-0 | flux content store) &&
+	flux exec -r 1 flux content load $ref &&
+	flux exec -r 1 sh -c "echo latency-test-1 | flux content store" &&
+	flux latency --rank=1 --json content >content.json &&
+	jq -e ".[\"content.load\"].count > 0" content.json &&
+	jq -e ".[\"content.store\"].count > 0" content.json
+'
+test_expect_success HAVE_JQ 'flux latency --rank=all merges histograms' '
+	flux latency --rank=0 --json kvs >kvs0.json &&
+	flux latency --rank=1 --json kvs >kvs1.json &&
+	flux latency --rank=all --json kvs >kvsall.json &&
+	n0=$(jq ".[\"kvs.lookup\"].count" kvs0.json) &&
+	n1=$(jq ".[\"kvs.lookup\"].count" kvs1.json) &&
+	nall=$(jq ".[\"kvs.lookup\"].count" kvsall.json) &&
+	test $nall -ge $(($n0+$n1))
+'
+test_expect_success 'job-manager is skipped on ranks where it is not loaded' '
+	flux latency --rank=1 job-manager >jm1.out &&
+	test $(wc -l <jm1.out) -eq 1
+'
+test_expect_success HAVE_JQ 'flux module stats --clear resets kvs histograms' '
+	flux module stats --clear kvs &&
+	flux latency --json kvs >kvs.clear.json &&
+	jq -e ".[\"kvs.commit\"].count == 0" kvs.clear.json
+'
+test_expect_success HAVE_JQ 'kvs fence with 8 participants adds one commit sample' '
+	flux module stats --clear kvs &&
+	${FLUX_BUILD_DIR}/t/kvs/fence_api 8 latency &&
+	flux latency --json kvs >kvs.fence.json &&
+	jq -e ".[\"kvs.commit\"].count >= 1" kvs.fence.json &&
+	jq -e ".[\"kvs.commit\"].count < 8" kvs.fence.json
+'
+test_expect_success 'flux latency --rank with invalid idset fails' '
+	test_must_fail flux latency --rank=foo
+'
+test_done
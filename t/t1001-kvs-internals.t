@@ -517,4 +517,37 @@ test_expect_success 'kvs: test invalid lookup rpc' '
         grep "flux_future_get: Protocol error" lookup_invalid_output
 '
 
+#
+# test raw value lookup responses
+#
+
+RPC=${FLUX_BUILD_DIR}/t/request/rpc
+
+test_expect_success 'kvs: store binary value for raw lookup tests' '
+	dd if=/dev/urandom bs=4096 count=1 >rawval.in &&
+	flux kvs put --raw $DIR.rawval=- <rawval.in &&
+	flux kvs get --treeobj $DIR.rawval | grep -q valref
+'
+test_expect_success 'kvs: lookup without rawval returns treeobj val' '
+	echo "{\"key\":\"$DIR.rawval\",\"namespace\":\"primary\",\"flags\":0}" \
+		| $RPC kvs.lookup >rawval.json &&
+	grep -q "\"type\":\"val\"" rawval.json &&
+	test_must_fail grep -q rawval rawval.json
+'
+test_expect_success 'kvs: lookup with rawval returns raw value' '
+	echo "{\"key\":\"$DIR.rawval\",\"namespace\":\"primary\",\"flags\":0,\"rawval\":true}" \
+		| $RPC kvs.lookup >rawval.out &&
+	grep -q -a "\"rawval\":4096" rawval.out &&
+	tail -c 4096 rawval.out >rawval.data &&
+	test_cmp rawval.in rawval.data
+'
+test_expect_success 'kvs: get --raw of binary value works' '
+	flux kvs get --raw $DIR.rawval >rawval.get &&
+	test_cmp rawval.in rawval.get
+'
+test_expect_success 'kvs: get --watch --raw of binary value works' '
+	flux kvs get --watch --count=1 --raw $DIR.rawval >rawval.watch &&
+	test_cmp rawval.in rawval.watch
+'
+
 test_done
@@ -131,4 +131,40 @@ test_expect_success 'kvs: transaction-merge disabling works' '
 	test "$OUTPUT" = "${THREADS}"
 '
 
+# hdir-threshold option test
+test_expect_success 'kvs: large directory is sharded with hdir-threshold' '
+	flux module reload kvs hdir-threshold=16 &&
+	flux kvs put $(for i in $(seq 1 1000); do echo $DIR.hdir.key$i=$i; done) &&
+	test $(flux kvs ls -1 $DIR.hdir | wc -l) = 1000 &&
+	test $(flux kvs get $DIR.hdir.key500) = 500
+'
+
+test_expect_success 'kvs: sharded directory can be updated and walked' '
+	flux kvs put $DIR.hdir.key500=foo &&
+	flux kvs unlink $DIR.hdir.key501 &&
+	test $(flux kvs get $DIR.hdir.key500) = foo &&
+	test_must_fail flux kvs get $DIR.hdir.key501 &&
+	test $(flux kvs dir -R $DIR.hdir | wc -l) = 999
+'
+
+test_expect_success 'kvs: sharded directory can be removed' '
+	flux kvs unlink -R $DIR.hdir &&
+	test_must_fail flux kvs ls $DIR.hdir
+'
+
+# cache-max-size option test
+test_expect_success 'kvs: cache size is limited with cache-max-size' '
+	flux kvs put $(for i in $(seq 1 64); do \
+		echo $DIR.cache.key$i=$(printf "%04096d" $i); done) &&
+	flux module reload kvs cache-max-size=65536 &&
+	for i in $(seq 1 64); do \
+		flux kvs get $DIR.cache.key$i >/dev/null || return 1; \
+	done &&
+	flux module stats --parse "cache.obj size limit (MiB)" kvs \
+		| grep -q "^0.0625" &&
+	test $(flux module stats --parse "cache.#obj evicted" kvs) -gt 0 &&
+	flux module stats --parse "cache.obj size total (MiB)" kvs \
+		| awk "{ exit (\$1 > 0.0625) }"
+'
+
 test_done
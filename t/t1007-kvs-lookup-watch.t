@@ -457,6 +457,62 @@ flux-kvs: test.append.test: Invalid argument
         test_cmp expected append10.out
 '
 
+test_expect_success NO_CHAIN_LINT 'flux kvs get: --append fails on longer overwrite with appended key' '
+        flux kvs unlink -Rf test &&
+        flux kvs put test.append.test="abc" &&
+        flux kvs put test.append.other="xyz" &&
+        flux kvs put --append test.append.other="1" &&
+        flux kvs put --append test.append.other="2" &&
+        flux kvs put --append test.append.other="3" &&
+        flux kvs get --watch --append --count=4 \
+                     test.append.test > append10b.out 2>&1 &
+        pid=$! &&
+        wait_watcherscount_nonzero primary &&
+        flux kvs put --append test.append.test="d" &&
+        flux kvs put --append test.append.test="e" &&
+        flux kvs copy test.append.other test.append.test &&
+        ! wait $pid &&
+	cat >expected <<-EOF &&
+abc
+d
+e
+flux-kvs: test.append.test: Invalid argument
+	EOF
+        test_cmp expected append10b.out
+'
+
+test_expect_success NO_CHAIN_LINT 'flux kvs get: --append works on already appended key' '
+        flux kvs unlink -Rf test &&
+        flux kvs put test.append.test="abc" &&
+        flux kvs put --append test.append.test="d" &&
+        flux kvs get --watch --append --count=3 \
+                     test.append.test > append11.out 2>&1 &
+        pid=$! &&
+        wait_watcherscount_nonzero primary &&
+        flux kvs put --append test.append.test="e" &&
+        flux kvs put --append test.append.test="f" &&
+        wait $pid &&
+	cat >expected <<-EOF &&
+abcd
+e
+f
+	EOF
+        test_cmp expected append11.out
+'
+
+test_expect_success 'flux kvs get: --append follows symlink' '
+        flux kvs unlink -Rf test &&
+        flux kvs put test.append.test="abc" &&
+        flux kvs put --append test.append.test="d" &&
+        flux kvs link test.append.test test.append.link &&
+        flux kvs get --watch --append --count=1 \
+                     test.append.link > append12.out &&
+	cat >expected <<-EOF &&
+abcd
+	EOF
+        test_cmp expected append12.out
+'
+
 # full checks
 
 # in full checks, we create a directory that we will use to
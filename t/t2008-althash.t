@@ -7,6 +7,7 @@ Start a session with a non-default hash type for content/kvs.'
 
 nil1="sha1-da39a3ee5e6b4b0d3255bfef95601890afd80709"
 nil256="sha256-e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"
+nilblake3="blake3-af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"
 
 # Append --logfile option if FLUX_TESTS_LOGFILE is set in environment:
 test -n "$FLUX_TESTS_LOGFILE" && set -- "$@" --logfile
@@ -27,6 +28,34 @@ test_expect_success 'Started instance with content.hash=sha256' '
           flux getattr content.hash) && test "$OUT" = "sha256"
 '
 
+test_expect_success 'Started instance with content.hash=blake3' '
+    OUT=$(flux start -o,-Scontent.hash=blake3 \
+          flux getattr content.hash) && test "$OUT" = "blake3"
+'
+
+test_expect_success 'Content store nil returns correct hash for blake3' '
+    OUT=$(flux start -o,-Scontent.hash=blake3 \
+          flux content store </dev/null) &&
+        test "$OUT" = "$nilblake3"
+'
+
+test_expect_success 'KVS works with content.hash=blake3' '
+    OUT=$(flux start -o,-Scontent.hash=blake3 \
+          sh -c "flux kvs put a.b=42 && flux kvs get --treeobj a") &&
+        echo "$OUT" | grep blake3-
+'
+
+hashbench=${SHARNESS_TEST_DIRECTORY}/content/hashbench
+test_expect_success 'hashbench runs and reports all hash types' '
+    $hashbench --bytes=65536 >hashbench.out &&
+    test_debug "cat hashbench.out" &&
+    test $(grep -c "MB/s" hashbench.out) -eq 21
+'
+
+test_expect_success 'hashbench fails on unknown hash type' '
+    test_must_fail $hashbench --hash=nerf
+'
+
 test_expect_success 'Started instance with content.hash=sha256,content-files' '
     OUT=$(flux start -o,-Scontent.hash=sha256 \
           -o,-Scontent.backing-module=content-files \
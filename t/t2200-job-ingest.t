@@ -49,6 +49,20 @@ test_invalid ()
     return ${rc}
 }
 
+# Submit jobspec on stdin, which must be rejected, and print the errno name
+submit_errno ()
+{
+    flux python -c "
+import sys, errno, flux, flux.job
+try:
+    flux.job.submit(flux.Flux(), sys.stdin.read())
+except OSError as e:
+    print(errno.errorcode[e.errno])
+    sys.exit(0)
+sys.exit(1)
+"
+}
+
 # load|reload ingest modules (in proper order) with specified arguments
 ingest_module ()
 {
@@ -173,6 +187,69 @@ test_expect_success 'submit request with empty payload fails with EPROTO(71)' '
 	${RPC} job-ingest.submit 71 </dev/null
 '
 
+test_expect_success HAVE_JQ 'job-ingest: jobspec was validated in process' '
+	${RPC} job-ingest.stats.get >stats.out &&
+	jq -e ".validate.builtin == true" <stats.out &&
+	jq -e ".validate.builtin_count > 0" <stats.out
+'
+
+test_expect_success 'job-ingest: builtin validator rejects with EPERM' '
+	${Y2J} <${JOBSPEC}/invalid/missing_tasks.yaml >missing_tasks.json &&
+	submit_errno <missing_tasks.json >errno.builtin &&
+	echo EPERM >errno.expected &&
+	test_cmp errno.expected errno.builtin
+'
+
+test_expect_success 'job-ingest: measure ingest rate with builtin validator' '
+	${SUBMITBENCH} --rate -r 500 use_case_2.6.json >/dev/null 2>rate.out &&
+	cat rate.out &&
+	grep "jobs/s" rate.out
+'
+
+test_expect_success 'job-ingest: reload with builtin validator disabled' '
+	ingest_module reload \
+		validator=${BINDINGS_VALIDATOR} builtin-validator=no
+'
+
+test_expect_success 'job-ingest: valid jobspecs accepted by worker' '
+	test_valid ${JOBSPEC}/valid/*
+'
+
+test_expect_success 'job-ingest: invalid jobs rejected by worker' '
+	test_invalid ${JOBSPEC}/invalid/*
+'
+
+test_expect_success 'job-ingest: worker rejects with the same errno' '
+	submit_errno <missing_tasks.json >errno.worker &&
+	test_cmp errno.builtin errno.worker
+'
+
+test_expect_success HAVE_JQ 'job-ingest: jobspec was validated by worker' '
+	${RPC} job-ingest.stats.get >stats2.out &&
+	jq -e ".validate.builtin == false" <stats2.out &&
+	jq -e ".validate.worker_count > 0" <stats2.out
+'
+
+test_expect_success 'job-ingest: measure ingest rate with validator workers' '
+	${SUBMITBENCH} --rate -r 500 use_case_2.6.json >/dev/null 2>rate2.out &&
+	cat rate2.out &&
+	grep "jobs/s" rate2.out
+'
+
+test_expect_success 'job-ingest: invalid validator-workers fails' '
+	test_must_fail flux module reload job-ingest validator-workers=0 &&
+	flux module load job-ingest validator=${BINDINGS_VALIDATOR}
+'
+
+test_expect_success 'job-ingest: reload with one worker' '
+	ingest_module reload validator=${BINDINGS_VALIDATOR} \
+		builtin-validator=no validator-workers=1
+'
+
+test_expect_success 'job-ingest: requests beyond worker queue limit complete' '
+	${SUBMITBENCH} -f 512 -r 512 use_case_2.6.json >/dev/null
+'
+
 test_expect_success 'job-ingest: test validator with version 1 enforced' '
 	ingest_module reload \
 		validator=${BINDINGS_VALIDATOR} validator-args="--require-version,1"
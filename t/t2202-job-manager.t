@@ -187,6 +187,26 @@ test_expect_success HAVE_JQ 'job-manager: max_jobid has not changed' '
 	test_cmp max2.exp max2.out
 '
 
+test_expect_success 'job-manager: active job snapshot was saved' '
+	flux kvs get --raw checkpoint.job-manager-jobs >/dev/null
+'
+
+test_expect_success 'job-manager: queue is reconstructed without snapshot' '
+	flux module remove job-manager &&
+	flux kvs unlink checkpoint.job-manager-jobs &&
+	flux module load job-manager &&
+	${LIST_JOBS} >list_reload_nosnap.out &&
+	test_cmp list10_reordered.out list_reload_nosnap.out
+'
+
+test_expect_success 'job-manager: queue is reconstructed from bad snapshot' '
+	flux module remove job-manager &&
+	echo garbage | flux kvs put --raw checkpoint.job-manager-jobs=- &&
+	flux module load job-manager &&
+	${LIST_JOBS} >list_reload_badsnap.out &&
+	test_cmp list10_reordered.out list_reload_badsnap.out
+'
+
 test_expect_success 'job-manager: cancel jobs' '
 	for jobid in $(cut -f1 <list_reload.out); do \
 		flux job cancel ${jobid}; \
@@ -18,4 +18,11 @@ test_expect_success 'job-manager: all state events received (2 jobs from 4 ranks
 	run_timeout 10 flux exec -r all ${BULK_STATE} 2
 '
 
+test_expect_success HAVE_JQ 'job-manager: stats reports fixed batch mode' '
+	flux module stats job-manager >stats.json &&
+	jq -e ".batch.mode == \"fixed\"" <stats.json &&
+	jq -e ".batch.commits > 0" <stats.json &&
+	jq -e ".batch.size.count == .batch.commits" <stats.json
+'
+
 test_done
@@ -0,0 +1,56 @@
+#!/bin/sh
+
+test_description='Test flux job manager adaptive event batching'
+
+. $(dirname $0)/sharness.sh
+
+if ! test -f batch.toml; then
+	cat <<-EOF >batch.toml
+	[job-manager]
+	batch-adaptive = true
+	EOF
+fi
+
+export FLUX_CONF_DIR=$(pwd)
+test_under_flux 4
+
+flux setattr log-stderr-level 1
+
+BULK_STATE="flux python ${FLUX_SOURCE_DIR}/t/job-manager/bulk-state.py"
+SUBMITBENCH="${FLUX_BUILD_DIR}/t/ingest/submitbench"
+
+test_expect_success HAVE_JQ 'job-manager: adaptive batch mode enabled by config' '
+	flux module stats job-manager | jq -e ".batch.mode == \"adaptive\""
+'
+test_expect_success 'job-manager: all state events received (adaptive batching)' '
+	run_timeout 10 flux exec -r all ${BULK_STATE} 8
+'
+test_expect_success HAVE_JQ 'job-manager: batch stats were recorded' '
+	flux module stats job-manager >stats.json &&
+	jq -e ".batch.commits > 0" <stats.json &&
+	jq -e ".batch.size.count == .batch.commits" <stats.json &&
+	jq -e ".batch.size.max >= 1" <stats.json &&
+	jq -e ".batch.latency.count > 0" <stats.json &&
+	jq -e ".batch[\"max-inflight\"] == 2" <stats.json &&
+	jq -e ".batch.timeout >= 0.01 and .batch.timeout <= 0.16" <stats.json
+'
+test_expect_success HAVE_JQ 'job-manager: record batch stats before burst' '
+	flux module stats job-manager >before.json &&
+	jq -e ".batch.timeout >= 0.01" <before.json
+'
+test_expect_success 'job-manager: submit a burst of 1024 jobs' '
+	flux mini run --dry-run -n1 true >burst.json &&
+	${SUBMITBENCH} -f 1024 -r 1024 burst.json >burst.ids &&
+	flux job cancelall -f
+'
+test_expect_success HAVE_JQ 'job-manager: batch window grew and batches filled under load' '
+	flux module stats job-manager >after.json &&
+	jq -s -e ".[1].batch.commits > .[0].batch.commits" \
+		before.json after.json &&
+	jq -s -e ".[1].batch.size.max >= .[0].batch.size.max" \
+		before.json after.json &&
+	jq -e ".batch.size.max > 1" <after.json &&
+	jq -e ".batch[\"timeout-peak\"] > 0.01" <after.json &&
+	jq -e ".batch[\"timeout-peak\"] <= 0.16" <after.json
+'
+test_done
@@ -399,6 +399,56 @@ test_expect_success HAVE_JQ 'job stats lists jobs in correct state (all inactive
         flux job stats | jq -e ".job_states.total == $(state_count all)"
 '
 
+test_expect_success HAVE_JQ 'list request with after_id pages through jobs' '
+        id=$(id -u) &&
+        flux job list -s inactive | jq .id > list_page.exp &&
+        $jq -j -c -n  "{max_entries:5, userid:${id}, states:0, results:0, attrs:[]}" \
+          | $RPC job-info.list | $jq -c ".jobs[]" | $jq .id > list_page.out &&
+        test $(wc -l < list_page.out) -eq 5 &&
+        while last=$(tail -n 1 list_page.out) && \
+              $jq -j -c -n  "{max_entries:5, userid:${id}, states:0, results:0, attrs:[], after_id:${last}}" \
+                | $RPC job-info.list | $jq -c ".jobs[]" | $jq .id > list_page.next && \
+              test -s list_page.next; do \
+            cat list_page.next >> list_page.out; \
+        done &&
+        test_cmp list_page.exp list_page.out
+'
+
+test_expect_success HAVE_JQ 'list request with after_id and userid=-1 works' '
+        after=$(head -n 3 list_page.exp | tail -n 1) &&
+        tail -n +4 list_page.exp > list_page_all.exp &&
+        $jq -j -c -n  "{max_entries:0, userid:-1, states:0, results:0, attrs:[], after_id:${after}}" \
+          | $RPC job-info.list | $jq -c ".jobs[]" | $jq .id > list_page_all.out &&
+        test_cmp list_page_all.exp list_page_all.out
+'
+
+test_expect_success HAVE_JQ 'list request with since returns only newer inactive jobs' '
+        id=$(id -u) &&
+        timestamp=$(flux job list -s inactive | head -n 8 | tail -n 1 | jq .t_inactive) &&
+        flux job list -s inactive | head -n 7 | jq .id > list_since.exp &&
+        $jq -j -c -n  "{max_entries:0, userid:${id}, states:0, results:0, attrs:[], since:${timestamp}}" \
+          | $RPC job-info.list | $jq -c ".jobs[]" | $jq .id > list_since.out &&
+        test_cmp list_since.exp list_since.out
+'
+
+test_expect_success HAVE_JQ 'list request for another userid returns no jobs' '
+        id=$(($(id -u) + 1)) &&
+        $jq -j -c -n  "{max_entries:0, userid:${id}, states:0, results:0, attrs:[]}" \
+          | $RPC job-info.list | $jq -e ".jobs | length == 0"
+'
+
+test_expect_success HAVE_JQ 'list request with unknown after_id fails with ENOENT(2)' '
+        id=$(id -u) &&
+        $jq -j -c -n  "{max_entries:0, userid:${id}, states:0, results:0, attrs:[], after_id:1}" \
+          | $RPC job-info.list 2
+'
+
+test_expect_success HAVE_JQ 'list request with negative since fails with EPROTO(71)' '
+        id=$(id -u) &&
+        $jq -j -c -n  "{max_entries:0, userid:${id}, states:0, results:0, attrs:[], since:-1.0}" \
+          | $RPC job-info.list 71
+'
+
 # job list-inactive
 
 test_expect_success HAVE_JQ 'flux job list-inactive lists all inactive jobs' '
@@ -97,4 +97,18 @@ test_expect_success 'sched-simple: job is scheduled when resource undrained' '
 	check_nnodes "allocated" 2 &&
 	check_ncores "allocated" 2
 '
+test_expect_success 'sched-simple: resyncs after a lost acquire response' '
+	flux module debug --setbit 0x1 resource &&
+	flux resource undrain 1 &&
+	flux resource drain 0 &&
+	for i in $(seq 1 10); do \
+	    check_rlist "down" "rank0/core[0-3]" && break; \
+	    sleep 0.5; \
+	done &&
+	flux dmesg >resync.dmesg.log &&
+	grep "dropped by debug flag" resync.dmesg.log &&
+	grep "acquire response generation.*resync" resync.dmesg.log &&
+	check_rlist "down" "rank0/core[0-3]" &&
+	check_nnodes "up" 1
+'
 test_done
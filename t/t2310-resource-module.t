@@ -244,6 +244,26 @@ test_expect_success HAVE_JQ,NO_CHAIN_LINT 'undrain/drain rank 1 causes up,down r
 	wait $pid
 '
 
+test_expect_success HAVE_JQ 'acquire responses carry consecutive generations' '
+	jq -e -s "map(.gen) == [0,1,2]" acquire4.out
+'
+
+test_expect_success HAVE_JQ 'acquire update responses contain only changed ranks' '
+	jq -e -s ".[1].up == \"1\" and .[2].down == \"1\"" acquire4.out
+'
+
+test_expect_success HAVE_JQ,NO_CHAIN_LINT 'dropped acquire response leaves a generation gap' '
+	flux module debug --setbit 0x1 resource &&
+	acquire_stream 30 acquire_gap.out down &
+	pid=$! &&
+	$WAITFILE -t 10 -v -p \"resources\" acquire_gap.out &&
+	undrain_idset "1" &&
+	drain_idset "1" &&
+	wait $pid &&
+	flux dmesg | grep "gen=1 dropped by debug flag" &&
+	jq -e -s "map(.gen) == [0,2]" acquire_gap.out
+'
+
 test_expect_success HAVE_JQ,NO_CHAIN_LINT 'add/remove new exclusion causes down/up response' '
 	acquire_stream 30 acquire5.out &
 	pid=$! &&
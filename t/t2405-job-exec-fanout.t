@@ -0,0 +1,67 @@
+#!/bin/sh
+
+test_description='Test flux job execution service TBON fanout launch'
+
+. $(dirname $0)/sharness.sh
+
+skip_all_unless_have jq
+
+#  Configure dummy job shell, and use fanout for all jobs:
+if ! test -f fanout.toml; then
+	cat <<-EOF >fanout.toml
+	[exec]
+	job-shell = "$SHARNESS_TEST_SRCDIR/job-exec/dummy.sh"
+	fanout-threshold = 1
+	EOF
+fi
+
+export FLUX_CONF_DIR=$(pwd)
+test_under_flux 8 job
+
+flux setattr log-stderr-level 1
+
+test_expect_success 'job-exec: fanout service is loaded on all ranks' '
+	flux exec -r all flux module list | grep -c job-exec >count &&
+	test $(cat count) -eq 8
+'
+test_expect_success 'job-exec: fanout launches job shell on all ranks' '
+	id=$(flux jobspec srun -N8 \
+	    "flux kvs put test1.\$BROKER_RANK=\$JOB_SHELL_RANK" \
+	    | flux job submit) &&
+	flux job wait-event $id clean &&
+	kvsdir=$(flux job id --to=kvs $id).guest &&
+	for i in 0 1 2 3 4 5 6 7; do
+		test $(flux kvs get ${kvsdir}.test1.$i) = $i || return 1
+	done
+'
+test_expect_success 'job-exec: fanout relays job shell output from leaves' '
+	id=$(flux jobspec srun -N8 \
+	     "test \$BROKER_RANK = 7 && echo Hello from fanout job \$JOBID" \
+	     | flux job submit) &&
+	flux job wait-event $id clean &&
+	flux dmesg | grep "7: stdout: Hello from fanout job $(flux job id $id)"
+'
+test_expect_success 'job-exec: fanout status is maximum job shell exit code' '
+	id=$(flux jobspec srun -N8 "exit \$JOB_SHELL_RANK" | flux job submit) &&
+	flux job wait-event -vt 10 $id finish | grep status=1792
+'
+test_expect_success 'job-exec: job exception kills fanout job shells' '
+	id=$(flux jobspec srun -N8 sleep 300 | flux job submit) &&
+	flux job wait-event -vt 5 $id start &&
+	flux job cancel $id &&
+	flux job wait-event -vt 5 $id clean &&
+	flux job eventlog $id | grep status=15
+'
+test_expect_success 'job-exec: fanout falls back to rexec without service' '
+	flux exec -r 1 flux module remove job-exec &&
+	id=$(flux jobspec srun -N8 \
+	    "flux kvs put test2.\$BROKER_RANK=\$JOB_SHELL_RANK" \
+	    | flux job submit) &&
+	flux job wait-event $id clean &&
+	kvsdir=$(flux job id --to=kvs $id).guest &&
+	for i in 0 1 2 3 4 5 6 7; do
+		test $(flux kvs get ${kvsdir}.test2.$i) = $i || return 1
+	done &&
+	flux exec -r 1 flux module load job-exec
+'
+test_done
@@ -103,6 +103,34 @@ test_expect_success 'job-shell: PMI KVS works' '
 	flux job attach $id >kvstest.out &&
 	grep "t phase" kvstest.out
 '
+test_expect_success 'job-shell: PMI KVS works over multiple cycles' '
+	flux mini run -N4 -n8 ${KVSTEST} -n -c 3 >kvstest_cycles.out &&
+	test $(grep -c "get phase" kvstest_cycles.out) -eq 3
+'
+test_expect_success 'job-shell: PMI KVS works with pmi.kvs=exchange' '
+	flux mini run -N4 -n8 -o pmi.kvs=exchange \
+		${KVSTEST} -n -c 3 >kvstest_exchange.out &&
+	test $(grep -c "get phase" kvstest_exchange.out) -eq 3
+'
+test_expect_success 'job-shell: pmi.kvs=exchange does not write per-key KVS entries' '
+	id=$(flux mini submit -N4 -o pmi.kvs=exchange ${KVSTEST}) &&
+	flux job attach $id &&
+	kvsdir=$(flux job id --to=kvs $id) &&
+	test_must_fail flux kvs get ${kvsdir}.guest.pmi.kvstest-0-0-0 &&
+	flux kvs get ${kvsdir}.guest.pmi.exchange.0
+'
+test_expect_success 'job-shell: PMI barrier+get time vs shell count' '
+	for mode in native exchange; do \
+		for n in 1 2 3 4; do \
+			printf "%-8s %d: " $mode $n; \
+			flux mini run -N$n -n$((n*2)) -o pmi.kvs=$mode \
+				${KVSTEST} -n -N 16 | grep "get phase" || return 1; \
+		done; \
+	done
+'
+test_expect_success 'job-shell: invalid pmi.kvs value fails' '
+	test_must_fail flux mini run -o pmi.kvs=foo /bin/true
+'
 test_expect_success 'job-exec: decrease kill timeout for tests' '
 	flux module reload job-exec kill-timeout=0.1
 '
@@ -143,6 +143,18 @@ test_expect_success 'job-shell: run 2-task echo job (stdout kvs/stderr file)' '
         grep "1: stderr:baz" err13
 '
 
+test_expect_success 'job-shell: run 4-task job with large labeled output (stdout file)' '
+        flux mini run -n4 \
+             --output=out14 --label-io \
+             seq 1 20000 &&
+        test $(wc -l < out14) -eq 80000 &&
+        seq 1 20000 > out14.exp &&
+        for rank in 0 1 2 3; do \
+            grep "^${rank}: " out14 | cut -d" " -f2 > out14.${rank} && \
+            test_cmp out14.exp out14.${rank} || return 1; \
+        done
+'
+
 #
 # output file mustache tests
 #